@@ -65,13 +65,14 @@ int64_t StreamIOContext::io_seek(int64_t offset, int whence)
         break;
     case AVSEEK_SIZE:
     {
-        auto pos = m_fin.tellg();
-        m_fin.seekg(0, std::ios_base::end);
-        auto pos_end = m_fin.tellg();
-        m_fin.seekg(0, std::ios_base::beg);
-        auto fsize = pos_end - m_fin.tellg();
-        m_fin.seekg(pos);
-        ret = fsize;
+        // the size does not change while we read; only query the stream once
+        if(!m_stream_size) {
+            auto pos = m_fin.tellg();
+            m_fin.seekg(0, std::ios_base::end);
+            m_stream_size = static_cast<int64_t>(m_fin.tellg());
+            m_fin.seekg(pos);
+        }
+        ret = *m_stream_size;
     } break;
     default:
         GHULBUS_UNREACHABLE_MESSAGE("Invalid whence token in seek.");
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <iosfwd>
 #include <memory>
+#include <optional>
 
 struct AVIOContext;
 
@@ -11,6 +12,7 @@ private:
     std::istream& m_fin;
     std::unique_ptr<unsigned char, void(*)(void*)> m_io_buffer;
     std::unique_ptr<AVIOContext, void(*)(AVIOContext*)> m_io_context_storage;
+    std::optional<int64_t> m_stream_size;
 public:
     StreamIOContext(std::istream& stream, std::size_t buffer_size);
     AVIOContext* getContext() const;
@@ -0,0 +1,68 @@
+#include <media_minion/common/binary_io.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace media_minion {
+
+void writeLE(std::vector<unsigned char>& out, std::uint64_t v, std::size_t n_bytes)
+{
+    for (std::size_t i = 0; i < n_bytes; ++i) {
+        out.push_back(static_cast<unsigned char>(v >> (8 * i)));
+    }
+}
+
+std::uint64_t readLE(unsigned char const* p, std::size_t n_bytes)
+{
+    std::uint64_t ret = 0;
+    for (std::size_t i = 0; i < n_bytes; ++i) { ret |= static_cast<std::uint64_t>(p[i]) << (8 * i); }
+    return ret;
+}
+
+std::optional<std::uint64_t> readLE(unsigned char const*& it, unsigned char const* end, std::size_t n_bytes)
+{
+    if (static_cast<std::size_t>(end - it) < n_bytes) { return std::nullopt; }
+    std::uint64_t const ret = readLE(it, n_bytes);
+    it += n_bytes;
+    return ret;
+}
+
+std::uint64_t readBE(unsigned char const* p, std::size_t n_bytes)
+{
+    std::uint64_t ret = 0;
+    for (std::size_t i = 0; i < n_bytes; ++i) { ret = (ret << 8) | p[i]; }
+    return ret;
+}
+
+bool hasId(std::span<unsigned char const> data, std::size_t offset, std::string_view id)
+{
+    return (data.size() >= offset + id.size()) && (std::memcmp(data.data() + offset, id.data(), id.size()) == 0);
+}
+
+bool writeFileAtomically(std::filesystem::path const& filepath, void const* data, std::size_t size)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(filepath.parent_path(), ec);
+    std::filesystem::path tmp_filepath = filepath;
+    tmp_filepath += ".tmp";
+    {
+        std::ofstream fout(tmp_filepath, std::ios_base::binary);
+        fout.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+        if (!fout) {
+            GHULBUS_LOG(Warning, "Unable to write " << tmp_filepath);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp_filepath, filepath, ec);
+    if (ec) {
+        GHULBUS_LOG(Warning, "Unable to replace " << filepath << ": " << ec.message());
+        std::filesystem::remove(tmp_filepath, ec);
+        return false;
+    }
+    return true;
+}
+
+}
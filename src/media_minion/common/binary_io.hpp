@@ -0,0 +1,40 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_COMMON_BINARY_IO_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_COMMON_BINARY_IO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace media_minion {
+
+/** Appends the lowest n_bytes of v in little-endian order.
+ */
+void writeLE(std::vector<unsigned char>& out, std::uint64_t v, std::size_t n_bytes);
+
+/** Reads n_bytes in little-endian order; p must point to at least that many.
+ */
+std::uint64_t readLE(unsigned char const* p, std::size_t n_bytes);
+/** Reads n_bytes in little-endian order and advances it past them.
+ * @return std::nullopt if fewer than n_bytes are left before end; it is not advanced then.
+ */
+std::optional<std::uint64_t> readLE(unsigned char const*& it, unsigned char const* end, std::size_t n_bytes);
+/** Reads n_bytes in big-endian order; p must point to at least that many.
+ */
+std::uint64_t readBE(unsigned char const* p, std::size_t n_bytes);
+
+/** Whether data contains the magic string id at offset; false if data ends before.
+ */
+bool hasId(std::span<unsigned char const> data, std::size_t offset, std::string_view id);
+
+/** Replaces the file at filepath, creating missing directories.
+ * The data is written to a temporary next to it first and renamed into place,
+ * so readers only ever see a complete file, and a failed write leaves the previous one intact.
+ */
+bool writeFileAtomically(std::filesystem::path const& filepath, void const* data, std::size_t size);
+
+}
+#endif
@@ -8,6 +8,7 @@
 #include <boost/asio/connect.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
 #include <boost/beast/websocket/stream.hpp>
 #include <boost/system/error_code.hpp>
@@ -156,6 +157,23 @@ public:
 };
 
 
+class AsyncWait : public BaseAwaitable<void> {
+private:
+    boost::asio::steady_timer& m_timer;
+public:
+    explicit AsyncWait(boost::asio::steady_timer& timer)
+        :m_timer(timer)
+    {}
+
+    void await_suspend(std::experimental::coroutine_handle<> h) {
+        m_timer.async_wait([this, h](boost::system::error_code const& ec) mutable {
+                m_result.error = ec;
+                h.resume();
+            });
+    }
+};
+
+
 }
 
 #endif
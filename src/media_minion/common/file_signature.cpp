@@ -0,0 +1,50 @@
+#include <media_minion/common/file_signature.hpp>
+
+#include <cstdio>
+#include <system_error>
+
+namespace media_minion {
+
+namespace {
+// 64-bit FNV-1a
+std::uint64_t hashBytes(std::uint64_t h, void const* data, std::size_t size)
+{
+    auto const* bytes = static_cast<unsigned char const*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+}
+
+std::string FileSignature::toKey() const
+{
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    h = hashBytes(h, path.data(), path.size());
+    h = hashBytes(h, &file_size, sizeof(file_size));
+    h = hashBytes(h, &last_write_time, sizeof(last_write_time));
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(h));
+    return std::string(buffer);
+}
+
+std::optional<FileSignature> getFileSignature(std::filesystem::path const& filepath)
+{
+    std::error_code ec;
+    auto const canonical_path = std::filesystem::weakly_canonical(filepath, ec);
+    if (ec) { return std::nullopt; }
+    auto const file_size = std::filesystem::file_size(canonical_path, ec);
+    if (ec) { return std::nullopt; }
+    auto const last_write_time = std::filesystem::last_write_time(canonical_path, ec);
+    if (ec) { return std::nullopt; }
+
+    FileSignature ret;
+    auto const u8path = canonical_path.generic_u8string();
+    ret.path.assign(u8path.begin(), u8path.end());
+    ret.file_size = file_size;
+    ret.last_write_time = static_cast<std::int64_t>(last_write_time.time_since_epoch().count());
+    return ret;
+}
+
+}
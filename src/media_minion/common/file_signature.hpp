@@ -0,0 +1,30 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_COMMON_FILE_SIGNATURE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_COMMON_FILE_SIGNATURE_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace media_minion {
+
+/** Identifies a particular version of a file on disk.
+ * Used as key for everything that we derive from a media file and want to keep around between runs.
+ * If the file gets replaced or modified, its signature changes and all cached data becomes stale.
+ */
+struct FileSignature {
+    std::string path;
+    std::uint64_t file_size;
+    std::int64_t last_write_time;
+
+    /** A short string that is suitable as a filename for cache files.
+     */
+    std::string toKey() const;
+
+    friend bool operator==(FileSignature const& lhs, FileSignature const& rhs) = default;
+};
+
+std::optional<FileSignature> getFileSignature(std::filesystem::path const& filepath);
+
+}
+#endif
@@ -0,0 +1,173 @@
+#include <media_minion/common/mapped_file.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <Windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace media_minion {
+
+MappedFile::MappedFile()
+    :m_data(nullptr), m_size(0),
+#ifdef _WIN32
+     m_fileHandle(INVALID_HANDLE_VALUE), m_mappingHandle(nullptr)
+#else
+     m_fd(-1)
+#endif
+{
+}
+
+#ifdef _WIN32
+std::optional<MappedFile> MappedFile::open(std::filesystem::path const& filepath)
+{
+    MappedFile ret;
+    ret.m_fileHandle = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (ret.m_fileHandle == INVALID_HANDLE_VALUE) {
+        GHULBUS_LOG(Error, "Unable to open file " << filepath << " for mapping.");
+        return std::nullopt;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(ret.m_fileHandle, &file_size)) {
+        GHULBUS_LOG(Error, "Unable to determine size of file " << filepath << ".");
+        return std::nullopt;
+    }
+    ret.m_size = static_cast<std::uint64_t>(file_size.QuadPart);
+    if (ret.m_size == 0) { return ret; }
+
+    ret.m_mappingHandle = CreateFileMappingW(ret.m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!ret.m_mappingHandle) {
+        GHULBUS_LOG(Error, "Unable to create file mapping for " << filepath << ".");
+        return std::nullopt;
+    }
+    ret.m_data = static_cast<unsigned char const*>(MapViewOfFile(ret.m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!ret.m_data) {
+        GHULBUS_LOG(Error, "Unable to map view of file " << filepath << ".");
+        return std::nullopt;
+    }
+    return ret;
+}
+
+void MappedFile::close()
+{
+    if (m_data) { UnmapViewOfFile(m_data); }
+    if (m_mappingHandle) { CloseHandle(m_mappingHandle); }
+    if (m_fileHandle != INVALID_HANDLE_VALUE) { CloseHandle(m_fileHandle); }
+    m_data = nullptr;
+    m_mappingHandle = nullptr;
+    m_fileHandle = INVALID_HANDLE_VALUE;
+    m_size = 0;
+}
+
+void MappedFile::adviseSequential()
+{
+    // FILE_FLAG_SEQUENTIAL_SCAN was already passed on open
+}
+
+void MappedFile::adviseWillNeed(std::uint64_t, std::uint64_t)
+{
+    // PrefetchVirtualMemory requires Windows 8
+}
+#else
+std::optional<MappedFile> MappedFile::open(std::filesystem::path const& filepath)
+{
+    MappedFile ret;
+    ret.m_fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (ret.m_fd == -1) {
+        GHULBUS_LOG(Error, "Unable to open file " << filepath << " for mapping.");
+        return std::nullopt;
+    }
+    struct stat file_stat;
+    if (fstat(ret.m_fd, &file_stat) != 0) {
+        GHULBUS_LOG(Error, "Unable to determine size of file " << filepath << ".");
+        return std::nullopt;
+    }
+    ret.m_size = static_cast<std::uint64_t>(file_stat.st_size);
+    if (ret.m_size == 0) { return ret; }
+
+    void* const mapping = mmap(nullptr, static_cast<std::size_t>(ret.m_size), PROT_READ, MAP_SHARED, ret.m_fd, 0);
+    if (mapping == MAP_FAILED) {
+        GHULBUS_LOG(Error, "Unable to map file " << filepath << ".");
+        return std::nullopt;
+    }
+    ret.m_data = static_cast<unsigned char const*>(mapping);
+    return ret;
+}
+
+void MappedFile::close()
+{
+    if (m_data) { munmap(const_cast<unsigned char*>(m_data), static_cast<std::size_t>(m_size)); }
+    if (m_fd != -1) { ::close(m_fd); }
+    m_data = nullptr;
+    m_fd = -1;
+    m_size = 0;
+}
+
+void MappedFile::adviseSequential()
+{
+    if (!m_data) { return; }
+    posix_madvise(const_cast<unsigned char*>(m_data), static_cast<std::size_t>(m_size), POSIX_MADV_SEQUENTIAL);
+}
+
+void MappedFile::adviseWillNeed(std::uint64_t offset, std::uint64_t length)
+{
+    if (!m_data || (offset >= m_size)) { return; }
+    // madvise requires a page aligned start address
+    static long const page_size = sysconf(_SC_PAGESIZE);
+    std::uint64_t const aligned_offset = offset - (offset % static_cast<std::uint64_t>(page_size));
+    std::uint64_t const aligned_length = std::min(length + (offset - aligned_offset), m_size - aligned_offset);
+    posix_madvise(const_cast<unsigned char*>(m_data) + aligned_offset, static_cast<std::size_t>(aligned_length),
+                  POSIX_MADV_WILLNEED);
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept
+    :MappedFile()
+{
+    *this = std::move(rhs);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+{
+    if (this != &rhs) {
+        close();
+        m_data = std::exchange(rhs.m_data, nullptr);
+        m_size = std::exchange(rhs.m_size, 0);
+#ifdef _WIN32
+        m_fileHandle = std::exchange(rhs.m_fileHandle, INVALID_HANDLE_VALUE);
+        m_mappingHandle = std::exchange(rhs.m_mappingHandle, nullptr);
+#else
+        m_fd = std::exchange(rhs.m_fd, -1);
+#endif
+    }
+    return *this;
+}
+
+unsigned char const* MappedFile::data() const
+{
+    return m_data;
+}
+
+std::uint64_t MappedFile::size() const
+{
+    return m_size;
+}
+
+}
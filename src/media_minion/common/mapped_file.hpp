@@ -0,0 +1,50 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_COMMON_MAPPED_FILE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_COMMON_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+namespace media_minion {
+
+/** A read-only mapping of a complete file into memory.
+ */
+class MappedFile {
+private:
+    unsigned char const* m_data;
+    std::uint64_t m_size;
+#ifdef _WIN32
+    void* m_fileHandle;
+    void* m_mappingHandle;
+#else
+    int m_fd;
+#endif
+public:
+    static std::optional<MappedFile> open(std::filesystem::path const& filepath);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    MappedFile(MappedFile&& rhs) noexcept;
+    MappedFile& operator=(MappedFile&& rhs) noexcept;
+
+    unsigned char const* data() const;
+    std::uint64_t size() const;
+
+    /** Hint that the mapping will be read front to back.
+     * This allows the OS to read ahead aggressively and to drop pages behind the read position early.
+     */
+    void adviseSequential();
+
+    /** Hint that the given range will be accessed in the near future.
+     */
+    void adviseWillNeed(std::uint64_t offset, std::uint64_t length);
+private:
+    MappedFile();
+    void close();
+};
+
+}
+#endif
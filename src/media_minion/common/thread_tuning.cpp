@@ -0,0 +1,179 @@
+#include <media_minion/common/thread_tuning.hpp>
+
+#include <rapidjson/rapidjson.h>
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 5054)
+#endif
+#include <rapidjson/document.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <gbBase/Log.hpp>
+#include <gbBase/UnusedVariable.hpp>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <Windows.h>
+#else
+#   include <pthread.h>
+#   include <sched.h>
+#   include <sys/mman.h>
+#   include <sys/resource.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+namespace media_minion {
+
+namespace {
+#ifndef _WIN32
+// the highest priority that an unprivileged thread may usually raise itself to, given a suitable RLIMIT_NICE
+constexpr int g_fallbackNiceValue = -10;
+#endif
+
+TuningOutcome applyAffinity(std::vector<unsigned int> const& cpus)
+{
+    if (cpus.empty()) { return TuningOutcome::NotRequested; }
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (auto const cpu : cpus) {
+        if (cpu < sizeof(DWORD_PTR) * 8) { mask |= (DWORD_PTR(1) << cpu); }
+    }
+    if ((mask == 0) || (SetThreadAffinityMask(GetCurrentThread(), mask) == 0)) { return TuningOutcome::Failed; }
+    return TuningOutcome::Applied;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto const cpu : cpus) {
+        if (cpu < CPU_SETSIZE) { CPU_SET(cpu, &set); }
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) { return TuningOutcome::Failed; }
+    return TuningOutcome::Applied;
+#else
+    return TuningOutcome::Failed;
+#endif
+}
+
+TuningOutcome applyScheduling(SchedulingPolicy policy, int priority)
+{
+    if (policy == SchedulingPolicy::Default) { return TuningOutcome::NotRequested; }
+#ifdef _WIN32
+    // time critical is available to every process outside of the real-time priority class
+    GHULBUS_UNUSED_VARIABLE(priority);
+    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) { return TuningOutcome::Applied; }
+    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST)) { return TuningOutcome::FellBack; }
+    return TuningOutcome::Failed;
+#else
+    int const native_policy = (policy == SchedulingPolicy::Fifo) ? SCHED_FIFO : SCHED_RR;
+    int const min_priority = sched_get_priority_min(native_policy);
+    int const max_priority = sched_get_priority_max(native_policy);
+    sched_param param{};
+    param.sched_priority = (priority == 0) ? ((min_priority + max_priority) / 2) :
+                                             std::clamp(priority, min_priority, max_priority);
+    if (pthread_setschedparam(pthread_self(), native_policy, &param) == 0) { return TuningOutcome::Applied; }
+#   ifdef __linux__
+    // on Linux, the nice value of a thread id only affects that thread
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), g_fallbackNiceValue) == 0) {
+        return TuningOutcome::FellBack;
+    }
+#   endif
+    return TuningOutcome::Failed;
+#endif
+}
+
+void logOutcome(std::string_view thread_name, char const* setting, TuningOutcome outcome)
+{
+    if (outcome == TuningOutcome::Applied) {
+        GHULBUS_LOG(Info, "Applied " << setting << " to " << thread_name << " thread.");
+    } else if (outcome == TuningOutcome::FellBack) {
+        GHULBUS_LOG(Warning, "Requested " << setting << " for " << thread_name << " thread is not permitted; " <<
+                             "using the highest permitted setting instead.");
+    } else if (outcome == TuningOutcome::Failed) {
+        GHULBUS_LOG(Warning, "Unable to apply " << setting << " to " << thread_name << " thread.");
+    }
+}
+}
+
+std::optional<ThreadTuning> parseThreadTuning(rapidjson::Value const& obj, std::string_view thread_name)
+{
+    ThreadTuning ret;
+    if (obj.HasMember("cpus")) {
+        if (!obj["cpus"].IsArray()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'threads." << thread_name << ".cpus'");
+            return std::nullopt;
+        }
+        for (auto const& cpu : obj["cpus"].GetArray()) {
+            if (!cpu.IsUint()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'threads." << thread_name << ".cpus'");
+                return std::nullopt;
+            }
+            ret.cpus.push_back(cpu.GetUint());
+        }
+    }
+    if (obj.HasMember("policy")) {
+        std::string_view const policy = obj["policy"].IsString() ? obj["policy"].GetString() : "";
+        if (policy == "default") {
+            ret.policy = SchedulingPolicy::Default;
+        } else if (policy == "fifo") {
+            ret.policy = SchedulingPolicy::Fifo;
+        } else if (policy == "round_robin") {
+            ret.policy = SchedulingPolicy::RoundRobin;
+        } else {
+            GHULBUS_LOG(Error, "Invalid value for option 'threads." << thread_name << ".policy'");
+            return std::nullopt;
+        }
+    }
+    if (obj.HasMember("priority")) {
+        if (!obj["priority"].IsInt()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'threads." << thread_name << ".priority'");
+            return std::nullopt;
+        }
+        ret.priority = obj["priority"].GetInt();
+    }
+    return ret;
+}
+
+ThreadTuningResult tuneCurrentThread(std::string_view thread_name, ThreadTuning const& tuning)
+{
+    ThreadTuningResult ret;
+    ret.affinity = applyAffinity(tuning.cpus);
+    logOutcome(thread_name, "cpu affinity", ret.affinity);
+    ret.scheduling = applyScheduling(tuning.policy, tuning.priority);
+    logOutcome(thread_name, "real-time scheduling", ret.scheduling);
+    return ret;
+}
+
+TuningOutcome lockProcessMemory()
+{
+#ifdef _WIN32
+    // the working set of a process can only be locked page range by page range
+    GHULBUS_LOG(Warning, "Locking process memory is not supported on this platform.");
+    return TuningOutcome::Failed;
+#else
+    if (mlockall(MCL_CURRENT) != 0) {
+        GHULBUS_LOG(Warning, "Unable to lock process memory; the memlock limit may be too low.");
+        return TuningOutcome::Failed;
+    }
+    GHULBUS_LOG(Info, "Locked process memory.");
+    return TuningOutcome::Applied;
+#endif
+}
+
+char const* toString(TuningOutcome outcome)
+{
+    switch (outcome) {
+    case TuningOutcome::NotRequested: return "not_requested";
+    case TuningOutcome::Applied: return "applied";
+    case TuningOutcome::FellBack: return "fell_back";
+    case TuningOutcome::Failed: return "failed";
+    }
+    return "";
+}
+
+}
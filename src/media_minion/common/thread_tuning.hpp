@@ -0,0 +1,57 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_COMMON_THREAD_TUNING_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_COMMON_THREAD_TUNING_HPP_
+
+#include <rapidjson/fwd.h>
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace media_minion {
+
+enum class SchedulingPolicy {
+    Default,
+    Fifo,               ///< real-time, runs until it blocks or a thread of higher priority becomes ready
+    RoundRobin          ///< real-time, like Fifo but shares time slices with threads of the same priority
+};
+
+/** How a latency critical thread is to be scheduled, so that other load on the machine does not delay it.
+ */
+struct ThreadTuning {
+    std::vector<unsigned int> cpus;         ///< the thread only runs on these cores; empty for all of them
+    SchedulingPolicy policy = SchedulingPolicy::Default;
+    int priority = 0;                       ///< for the real-time policies; 0 for the middle of the range
+};
+
+enum class TuningOutcome {
+    NotRequested,
+    Applied,
+    FellBack,           ///< not permitted; a weaker setting that is permitted was applied instead
+    Failed
+};
+
+struct ThreadTuningResult {
+    TuningOutcome affinity = TuningOutcome::NotRequested;
+    TuningOutcome scheduling = TuningOutcome::NotRequested;
+};
+
+/** Parses the tuning of a thread from the object of that thread in the 'threads' section of a config file.
+ * @return std::nullopt if any of the options is invalid; the error has been logged.
+ */
+std::optional<ThreadTuning> parseThreadTuning(rapidjson::Value const& obj, std::string_view thread_name);
+
+/** Applies tuning to the calling thread and logs which of the requested settings took effect.
+ * Real-time scheduling usually needs privileges (CAP_SYS_NICE or an rtprio limit on Linux); without them,
+ * the thread falls back to the highest priority it may raise itself to.
+ */
+ThreadTuningResult tuneCurrentThread(std::string_view thread_name, ThreadTuning const& tuning);
+
+/** Locks all memory currently mapped by the process, so that it cannot be paged out.
+ * Memory allocated later is not affected; otherwise every file mapping would have to fit into physical memory.
+ */
+TuningOutcome lockProcessMemory();
+
+char const* toString(TuningOutcome outcome);
+
+}
+#endif
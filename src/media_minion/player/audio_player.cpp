@@ -1,57 +1,217 @@
 #include <media_minion/player/audio_player.hpp>
 
-#include <gbAudio/Audio.hpp>
+#include <media_minion/player/playback_sync.hpp>
+#include <media_minion/player/telemetry.hpp>
 
 #include <gbBase/Log.hpp>
 
+#include <gbBase/Assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <variant>
+
 namespace media_minion::player {
 
-AudioPlayer::AudioPlayer()
-    :m_device(GhulbusAudio::AudioDevice::create()), m_source(m_device->createQueuedSource())
+namespace {
+constexpr std::size_t g_maxCorrectionRatio = 1000;
+// until the first data arrives; the chunk is rebuilt for the actual sampling frequency
+constexpr std::uint32_t g_defaultSamplingFrequency = 48000;
+
+std::chrono::duration<double, std::micro> getDuration(GhulbusAudio::DataVariant const& data)
 {
-    for (auto& b : m_buffers) {
-        b = m_device->createBuffer();
-    }
+    return std::visit([](auto const& d) {
+            return std::chrono::duration<double, std::micro>(1e6 * static_cast<double>(d.getNumberOfSamples()) /
+                                                             static_cast<double>(d.getSamplingFrequency()));
+        }, data);
+}
 }
 
-void AudioPlayer::play()
+AudioPlayer::AudioPlayer(std::unique_ptr<AudioSink> sink, LatencyProfile const& latency_profile,
+                         Telemetry* telemetry)
+    :m_sink(std::move(sink)), m_chunkDuration(latency_profile.buffer_duration),
+     m_chunk(GhulbusAudio::DataStereo16Bit{ g_defaultSamplingFrequency }), m_carryOverFrequency(0),
+     m_telemetry(telemetry), m_queuedBuffers(0), m_finishedBuffers(0), m_dataExhausted(false),
+     m_playedDuration(0), m_pendingCorrection(0), m_correctionAllowance(0.0)
 {
-    for (auto& b : m_buffers) {
-        auto const data = onDataRequest();
-        if (!data) { break; }
-        b->setData(*data);
-        m_source->enqueueBuffer(*b, [this](GhulbusAudio::Buffer& b) -> GhulbusAudio::QueuedSource::BufferAction {
-                auto const data = onDataRequest();
-                if (data) {
-                    b.setData(*data);
-                    return GhulbusAudio::QueuedSource::BufferAction::Reinsert;
-                }
-                return GhulbusAudio::QueuedSource::BufferAction::Drop;
-            });
-    }
+    GHULBUS_PRECONDITION(m_chunkDuration.count() > 0);
+    m_sink->onBufferFinished = [this]() { return refillBuffer(); };
+}
+
+void AudioPlayer::preload()
+{
+    fillQueue();
+}
 
-    m_source->play();
+void AudioPlayer::play()
+{
+    fillQueue();
+    m_sink->play();
+    if ((m_queuedBuffers == 0) && onPlaybackFinished) { onPlaybackFinished(); }
 }
 
 void AudioPlayer::pause()
 {
-    m_source->pause();
+    m_sink->pause();
+}
+
+void AudioPlayer::resume()
+{
+    m_sink->play();
 }
 
 void AudioPlayer::stop()
 {
-    m_source->stop();
+    m_sink->stop();
 }
 
 void AudioPlayer::clear()
 {
-    m_source->stop();
-    m_source->clearQueue();
+    m_sink->clear();
+    m_carryOver.clear();
+    m_queuedBuffers = 0;
+    m_queuedDurations.clear();
+    m_playedDuration = std::chrono::microseconds(0);
+    m_pendingCorrection = std::chrono::microseconds(0);
+    m_correctionAllowance = 0.0;
 }
 
 void AudioPlayer::pump()
 {
-    m_source->pump();
+    std::size_t const queued_buffers = m_queuedBuffers;
+    m_finishedBuffers = 0;
+    m_sink->pump();
+    if (m_telemetry && (queued_buffers > 0)) {
+        std::size_t const depth = queued_buffers - std::min(m_finishedBuffers, queued_buffers);
+        m_telemetry->recordQueueDepth(depth, m_sink->getCapacity());
+        // the device ran dry even though there was more to play; sinks that are not bound
+        // to the sampling rate empty their queue on every pump
+        if ((depth == 0) && !m_dataExhausted && m_sink->isRealTime()) { m_telemetry->recordUnderrun(); }
+    }
+    if ((queued_buffers > 0) && (m_queuedBuffers == 0) && m_dataExhausted && onPlaybackFinished) {
+        onPlaybackFinished();
+    }
+}
+
+std::chrono::microseconds AudioPlayer::getPlayedDuration() const
+{
+    return m_playedDuration;
+}
+
+std::chrono::microseconds AudioPlayer::getQueuedDuration() const
+{
+    if (!m_sink->isRealTime()) { return std::chrono::microseconds(0); }
+    return std::accumulate(m_queuedDurations.begin(), m_queuedDurations.end(), std::chrono::microseconds(0));
+}
+
+void AudioPlayer::correctPosition(std::chrono::microseconds amount)
+{
+    m_pendingCorrection = amount;
+}
+
+bool AudioPlayer::isCorrecting() const
+{
+    return m_pendingCorrection.count() != 0.0;
+}
+
+void AudioPlayer::fillQueue()
+{
+    m_dataExhausted = false;
+    while (m_queuedBuffers < m_sink->getCapacity()) {
+        auto const* data = nextChunk();
+        if (!data) {
+            m_dataExhausted = true;
+            break;
+        }
+        m_sink->enqueue(*data);
+        ++m_queuedBuffers;
+    }
+}
+
+GhulbusAudio::DataVariant const* AudioPlayer::refillBuffer()
+{
+    ++m_finishedBuffers;
+    if (!m_queuedDurations.empty()) {
+        m_playedDuration += m_queuedDurations.front();
+        m_queuedDurations.pop_front();
+    }
+    Stopwatch refill_time;
+    auto const* data = nextChunk();
+    if (m_telemetry) { m_telemetry->recordRefill(refill_time.elapsed()); }
+    if (!data) {
+        m_dataExhausted = true;
+        --m_queuedBuffers;
+    }
+    return data;
+}
+
+GhulbusAudio::DataStereo16Bit& AudioPlayer::getChunk(std::uint32_t sampling_frequency)
+{
+    auto* chunk = std::get_if<GhulbusAudio::DataStereo16Bit>(&m_chunk);
+    if (!chunk || (chunk->getSamplingFrequency() != sampling_frequency)) {
+        m_chunk = GhulbusAudio::DataStereo16Bit{ sampling_frequency };
+        chunk = &std::get<GhulbusAudio::DataStereo16Bit>(m_chunk);
+    }
+    return *chunk;
+}
+
+GhulbusAudio::DataVariant const* AudioPlayer::nextChunk()
+{
+    std::uint32_t sampling_frequency = m_carryOver.empty() ?
+        std::visit([](auto const& d) { return d.getSamplingFrequency(); }, m_chunk) : m_carryOverFrequency;
+    std::size_t n_frames = 0;
+    for (bool restart = true; restart;) {
+        restart = false;
+        auto& chunk = getChunk(sampling_frequency);
+        std::size_t const n_target = framesForDuration(sampling_frequency, m_chunkDuration);
+        chunk.resize(n_target);
+        n_frames = std::min(m_carryOver.size(), n_target);
+        std::copy_n(m_carryOver.begin(), n_frames, &chunk[0]);
+        m_carryOver.erase(m_carryOver.begin(), m_carryOver.begin() + n_frames);
+        while ((n_frames < n_target) && onDataRequest) {
+            std::span<PlaybackSample> const frames(&chunk[n_frames], n_target - n_frames);
+            PcmRead const read = onDataRequest(frames);
+            if (read.frames == 0) { break; }
+            if (read.sampling_frequency != sampling_frequency) {
+                // a chunk holds a single sampling frequency; the new one starts the next chunk
+                m_carryOver.insert(m_carryOver.end(), frames.begin(), frames.begin() + read.frames);
+                m_carryOverFrequency = read.sampling_frequency;
+                if (n_frames == 0) {
+                    sampling_frequency = read.sampling_frequency;
+                    restart = true;
+                }
+                break;
+            }
+            n_frames += read.frames;
+        }
+        chunk.resize(n_frames);
+    }
+    if (n_frames == 0) { return nullptr; }
+
+    GhulbusAudio::DataVariant* ret = &m_chunk;
+    auto const content = getDuration(*ret);
+    if (isCorrecting()) {
+        double const frame_duration = content.count() / static_cast<double>(n_frames);
+        // each chunk adds its share of the allowance; chunks below a thousand frames save up for a later one.
+        // an unused allowance is not saved beyond a single chunk, so corrections never come in bursts
+        double const chunk_allowance = static_cast<double>(n_frames) / static_cast<double>(g_maxCorrectionRatio);
+        m_correctionAllowance = std::min(m_correctionAllowance + chunk_allowance, std::max(chunk_allowance, 1.0));
+        auto const max_frames = static_cast<std::int64_t>(
+            std::min(m_correctionAllowance, static_cast<double>(n_frames - 1)));
+        std::int64_t const wanted = std::llround(m_pendingCorrection.count() / frame_duration);
+        std::int64_t const frames = std::clamp<std::int64_t>(wanted, -max_frames, max_frames);
+        if (frames != 0) { adjustFrameCount(*ret, frames); }
+        m_correctionAllowance -= static_cast<double>(std::abs(frames));
+        m_pendingCorrection -= std::chrono::duration<double, std::micro>(static_cast<double>(frames) * frame_duration);
+        // below half a frame there is nothing left to correct
+        if ((wanted == 0) || (std::abs(m_pendingCorrection.count()) < frame_duration / 2)) {
+            m_pendingCorrection = std::chrono::microseconds(0);
+            m_correctionAllowance = 0.0;
+        }
+    }
+    m_queuedDurations.push_back(std::chrono::duration_cast<std::chrono::microseconds>(content));
+    return ret;
 }
 
 }
@@ -1,35 +1,89 @@
 #ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_AUDIO_PLAYER_HPP_
 #define MEDIA_MINION_INCLUDE_GUARD_PLAYER_AUDIO_PLAYER_HPP_
 
-#include <gbAudio/AudioDevice.hpp>
-#include <gbAudio/Buffer.hpp>
-#include <gbAudio/QueuedSource.hpp>
+#include <media_minion/player/audio_sink.hpp>
+#include <media_minion/player/configuration.hpp>
+#include <media_minion/player/media_source.hpp>
 
-#include <array>
+#include <gbAudio/Data.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <functional>
-#include <optional>
+#include <memory>
+#include <span>
+#include <vector>
 
 namespace media_minion::player {
 
+class Telemetry;
+
 class AudioPlayer {
 private:
-    GhulbusAudio::AudioDevicePtr m_device;
-    std::array<GhulbusAudio::BufferPtr, 16> m_buffers;
-    GhulbusAudio::QueuedSourcePtr m_source;
+    std::unique_ptr<AudioSink> m_sink;
+    std::chrono::milliseconds m_chunkDuration;
+    GhulbusAudio::DataVariant m_chunk;                      ///< reused for every chunk handed to the sink
+    std::vector<PlaybackSample> m_carryOver;                ///< read at a new sampling frequency; starts the next chunk
+    std::uint32_t m_carryOverFrequency;
+    Telemetry* m_telemetry;
+    std::size_t m_queuedBuffers;
+    std::size_t m_finishedBuffers;          ///< buffers that finished playing during the current pump
+    bool m_dataExhausted;
+    std::deque<std::chrono::microseconds> m_queuedDurations;    ///< content of the queued buffers, oldest first
+    std::chrono::microseconds m_playedDuration;
+    std::chrono::duration<double, std::micro> m_pendingCorrection;  ///< positive to skip ahead
+    double m_correctionAllowance;           ///< frames the correction may still adjust; saved up by short chunks
 public:
-    AudioPlayer();
+    /** @param[in] telemetry Optional; receives queue depth, underruns and refill timings.
+     */
+    AudioPlayer(std::unique_ptr<AudioSink> sink, LatencyProfile const& latency_profile,
+                Telemetry* telemetry = nullptr);
 
     AudioPlayer(AudioPlayer const&) = delete;
     AudioPlayer(AudioPlayer&&) = delete;
 
+    /** Fills the queue without starting playback, so that a following play() starts right away.
+     */
+    void preload();
     void play();
     void pause();
+    /** Continues after pause(); play() would queue up the buffers a second time.
+     */
+    void resume();
     void stop();
 
     void clear();
     void pump();
 
-    std::function<std::optional<GhulbusAudio::DataVariant>()> onDataRequest;
+    /** Amount of source content that finished playing since the last clear().
+     */
+    std::chrono::microseconds getPlayedDuration() const;
+    /** Content queued for the device that did not finish playing yet, the chunk that is playing included;
+     * 0 for sinks that are not real-time.
+     */
+    std::chrono::microseconds getQueuedDuration() const;
+    /** Moves the playback position ahead (positive) or back by the given amount without an audible skip.
+     * Single frames spread over the coming chunks are dropped or repeated, at most one in a thousand.
+     * Replaces a correction that is still in progress.
+     */
+    void correctPosition(std::chrono::microseconds amount);
+    bool isCorrecting() const;
+
+    /** Fills the given frames; may return fewer, down to 0 at the end of the data.
+     */
+    std::function<PcmRead(std::span<PlaybackSample>)> onDataRequest;
+    /** Invoked once everything was played after onDataRequest ran out of data;
+     * from pump(), or from play() if there was nothing to play at all.
+     */
+    std::function<void()> onPlaybackFinished;
+private:
+    void fillQueue();
+    GhulbusAudio::DataStereo16Bit& getChunk(std::uint32_t sampling_frequency);
+    /** @return nullptr at the end of the data; otherwise m_chunk, valid until the next call.
+     */
+    GhulbusAudio::DataVariant const* nextChunk();
+    GhulbusAudio::DataVariant const* refillBuffer();
 };
 
 }
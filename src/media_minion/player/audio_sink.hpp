@@ -0,0 +1,46 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_AUDIO_SINK_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_AUDIO_SINK_HPP_
+
+#include <gbAudio/Data.hpp>
+
+#include <functional>
+
+namespace media_minion::player {
+
+/** Destination of the decoded audio; a queue of chunks that is played back in order.
+ * All functions, including the callback, are used from a single thread.
+ */
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+
+    /** Maximum number of chunks that can be queued at the same time.
+     */
+    virtual std::size_t getCapacity() const = 0;
+    /** False if the sink consumes audio as fast as it is delivered instead of at the sampling rate.
+     */
+    virtual bool isRealTime() const = 0;
+
+    /** Appends a chunk to the queue. At most getCapacity() chunks may be queued.
+     */
+    virtual void enqueue(GhulbusAudio::DataVariant const& data) = 0;
+
+    virtual void play() = 0;
+    virtual void pause() = 0;
+    virtual void stop() = 0;
+    /** Stops playback and drops all queued chunks.
+     */
+    virtual void clear() = 0;
+    /** Retires the chunks that finished playing; needs to be called regularly.
+     */
+    virtual void pump() = 0;
+
+    /** Invoked from pump() for every chunk that finished playing.
+     * The returned chunk is queued in its place; returning nullptr shrinks the queue.
+     * The chunk only stays valid until the call returns; the sink copies it.
+     */
+    std::function<GhulbusAudio::DataVariant const*()> onBufferFinished;
+};
+
+}
+#endif
@@ -0,0 +1,224 @@
+#include <media_minion/player/cached_pcm_source.hpp>
+
+#include <media_minion/common/file_signature.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+
+namespace media_minion::player {
+
+std::string getPcmCacheKey(std::filesystem::path const& location)
+{
+    std::u8string const location_str = location.generic_u8string();
+    std::string ret(location_str.begin(), location_str.end());
+    if (auto const signature = getFileSignature(location); signature) {
+        ret += '@';
+        ret += signature->toKey();
+    }
+    return ret;
+}
+
+CachedPcmSource::CachedPcmSource(PcmCache* cache, std::filesystem::path location,
+                                 FfmpegStreamOptions const& stream_options)
+    :m_cache(cache), m_location(std::move(location)), m_streamOptions(stream_options),
+     m_cacheKey(cache ? getPcmCacheKey(m_location) : std::string{}), m_streamFailed(false), m_position(0),
+     m_decoding(cache == nullptr), m_endReached(false), m_currentBlockIndex(0), m_pendingBlockIndex(0)
+{
+}
+
+CachedPcmSource::~CachedPcmSource()
+{
+}
+
+bool CachedPcmSource::isPlayable()
+{
+    if (m_cache && m_cache->contains(m_cacheKey, 0)) { return true; }
+    return ensureStream();
+}
+
+std::size_t CachedPcmSource::read(std::span<PlaybackSample> frames)
+{
+    std::size_t ret = 0;
+    while ((ret < frames.size()) && !m_endReached) {
+        if (!m_decoding) {
+            std::size_t const n_cached = readCached(frames.subspan(ret));
+            ret += n_cached;
+            if ((n_cached > 0) || m_endReached) { continue; }
+            // cache miss; continue from the file
+            if (!positionStream(m_position)) {
+                m_endReached = true;
+                break;
+            }
+            m_decoding = true;
+            m_currentBlock.reset();
+            m_pendingBlock.reset();
+        }
+        ret += readDecoded(frames.subspan(ret));
+    }
+    return ret;
+}
+
+std::size_t CachedPcmSource::readCached(std::span<PlaybackSample> frames)
+{
+    std::uint64_t const block_index = m_position / PcmCache::block_frames;
+    if (!m_currentBlock || (m_currentBlockIndex != block_index)) {
+        m_currentBlock = m_cache->lookup(m_cacheKey, block_index);
+        m_currentBlockIndex = block_index;
+        if (!m_currentBlock) { return 0; }
+    }
+    auto const& data = m_currentBlock->data;
+    m_samplingFrequency = data.getSamplingFrequency();
+    std::size_t const offset = static_cast<std::size_t>(m_position % PcmCache::block_frames);
+    std::size_t const block_size = data.getNumberOfSamples();
+    if (offset >= block_size) {
+        m_endReached = m_currentBlock->is_last;
+        m_currentBlock.reset();
+        return 0;
+    }
+    std::size_t const n_frames = std::min(frames.size(), block_size - offset);
+    std::copy_n(&data[offset], n_frames, frames.begin());
+    m_position += n_frames;
+    if (offset + n_frames == block_size) {
+        m_endReached = m_currentBlock->is_last;
+        m_currentBlock.reset();
+    }
+    return n_frames;
+}
+
+std::size_t CachedPcmSource::readDecoded(std::span<PlaybackSample> frames)
+{
+    if (!ensureStream()) {
+        m_endReached = true;
+        return 0;
+    }
+    std::size_t const n_frames = m_stream->read(frames);
+    // the cache only holds data of the sampling frequency that the cached part of the track was played with
+    bool const cacheable = m_cache && (*m_samplingFrequency == m_stream->getSamplingFrequency());
+    if (!cacheable) { m_pendingBlock.reset(); }
+    std::size_t offset = 0;
+    if (!m_pendingBlock && cacheable) {
+        // decoding started in the middle of a block; caching starts with the next complete block
+        std::uint64_t const next_block = (m_position + PcmCache::block_frames - 1) / PcmCache::block_frames;
+        std::uint64_t const block_start = next_block * PcmCache::block_frames;
+        if (block_start < m_position + n_frames) {
+            offset = static_cast<std::size_t>(block_start - m_position);
+            m_pendingBlockIndex = next_block;
+            m_pendingBlock.emplace(*m_samplingFrequency);
+        }
+    }
+    if (m_pendingBlock) { addToPendingBlock(frames.first(n_frames), offset); }
+    m_position += n_frames;
+    m_streamPosition = m_position;
+    if (n_frames < frames.size()) {
+        finishPendingBlock(true);
+        m_endReached = true;
+    }
+    return n_frames;
+}
+
+void CachedPcmSource::addToPendingBlock(std::span<PlaybackSample const> frames, std::size_t offset)
+{
+    while (offset < frames.size()) {
+        std::size_t const block_size = m_pendingBlock->getNumberOfSamples();
+        std::size_t const n = std::min(frames.size() - offset, PcmCache::block_frames - block_size);
+        m_pendingBlock->resize(block_size + n);
+        std::copy_n(frames.begin() + offset, n, &(*m_pendingBlock)[block_size]);
+        offset += n;
+        if (m_pendingBlock->getNumberOfSamples() == PcmCache::block_frames) {
+            finishPendingBlock(false);
+            ++m_pendingBlockIndex;
+            // the cache keeps a copy; the storage of the block is reused for the next one
+            m_pendingBlock->resize(0);
+        }
+    }
+}
+
+void CachedPcmSource::finishPendingBlock(bool is_last)
+{
+    if (!m_pendingBlock || !m_cache) { return; }
+    m_cache->insert(m_cacheKey, m_pendingBlockIndex, *m_pendingBlock, is_last);
+    if (is_last) { m_pendingBlock.reset(); }
+}
+
+bool CachedPcmSource::seek(std::chrono::microseconds position)
+{
+    if (!m_samplingFrequency) {
+        // nothing was read yet; take the sampling frequency from the first cached block or from the file
+        if (m_cache) {
+            if (auto block = m_cache->lookup(m_cacheKey, 0); block) {
+                m_samplingFrequency = block->data.getSamplingFrequency();
+            }
+        }
+        if (!m_samplingFrequency && !ensureStream()) { return false; }
+    }
+    return seekToFrame(framesForPosition(*m_samplingFrequency, position));
+}
+
+bool CachedPcmSource::seekToFrame(std::uint64_t frame)
+{
+    m_position = frame;
+    m_endReached = false;
+    m_decoding = (m_cache == nullptr);
+    m_currentBlock.reset();
+    m_pendingBlock.reset();
+    if (!m_cache) { return positionStream(frame); }
+    return true;
+}
+
+void CachedPcmSource::prepareDecoder()
+{
+    if (!m_cache || m_decoding || m_endReached) { return; }
+    std::uint64_t block_index = m_position / PcmCache::block_frames;
+    while (m_cache->contains(m_cacheKey, block_index)) { ++block_index; }
+    if (!m_samplingFrequency) {
+        if (auto block = m_cache->lookup(m_cacheKey, 0); block) {
+            m_samplingFrequency = block->data.getSamplingFrequency();
+        }
+    }
+    if (m_samplingFrequency) {
+        positionStream(block_index * PcmCache::block_frames);
+    } else {
+        ensureStream();
+    }
+}
+
+std::uint64_t CachedPcmSource::getPositionFrames() const
+{
+    return m_position;
+}
+
+std::optional<std::uint32_t> CachedPcmSource::getSamplingFrequency() const
+{
+    return m_samplingFrequency;
+}
+
+bool CachedPcmSource::ensureStream()
+{
+    if (m_stream) { return true; }
+    if (m_streamFailed) { return false; }
+    m_stream = std::make_unique<FfmpegStream>(m_location, m_streamOptions);
+    if (!m_stream->isOpen()) {
+        m_stream.reset();
+        m_streamFailed = true;
+        return false;
+    }
+    m_streamPosition = 0;
+    if (!m_samplingFrequency) { m_samplingFrequency = m_stream->getSamplingFrequency(); }
+    return true;
+}
+
+bool CachedPcmSource::positionStream(std::uint64_t frame)
+{
+    if (!ensureStream()) { return false; }
+    if (m_streamPosition && (*m_streamPosition == frame)) { return true; }
+    if (!m_samplingFrequency) { return false; }
+    if (!m_stream->seek(positionForFrames(*m_samplingFrequency, frame))) {
+        m_streamPosition.reset();
+        return false;
+    }
+    m_streamPosition = frame;
+    return true;
+}
+
+}
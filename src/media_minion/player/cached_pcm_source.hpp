@@ -0,0 +1,90 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_CACHED_PCM_SOURCE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_CACHED_PCM_SOURCE_HPP_
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/pcm_cache.hpp>
+
+#include <gbAudio/Data.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace media_minion::player {
+
+/** Reads a track through a PcmCache.
+ * Blocks that are in the cache are served from memory. On the first missing block, the source switches to
+ * decoding from the file, starting at the missing position, and adds the decoded blocks to the cache.
+ * The file is only opened once it is actually needed.
+ * Without a cache, this is a plain FfmpegStream.
+ */
+class CachedPcmSource {
+private:
+    PcmCache* m_cache;
+    std::filesystem::path m_location;
+    FfmpegStreamOptions m_streamOptions;
+    std::string m_cacheKey;
+
+    std::unique_ptr<FfmpegStream> m_stream;
+    bool m_streamFailed;
+    std::optional<std::uint64_t> m_streamPosition;     ///< frame the stream will decode next, if known
+
+    std::optional<std::uint32_t> m_samplingFrequency;
+    std::uint64_t m_position;                           ///< next frame handed out by read()
+    bool m_decoding;
+    bool m_endReached;
+
+    std::optional<PcmCache::Block> m_currentBlock;      ///< cached block that read() is copying from
+    std::uint64_t m_currentBlockIndex;
+    std::optional<GhulbusAudio::DataStereo16Bit> m_pendingBlock;   ///< block being assembled from decoded data
+    std::uint64_t m_pendingBlockIndex;
+public:
+    CachedPcmSource(PcmCache* cache, std::filesystem::path location, FfmpegStreamOptions const& stream_options);
+    ~CachedPcmSource();
+
+    CachedPcmSource(CachedPcmSource const&) = delete;
+    CachedPcmSource& operator=(CachedPcmSource const&) = delete;
+
+    /** Checks that the track can be played at all, opening the file if the start of it is not cached.
+     */
+    bool isPlayable();
+
+    /** Fills frames from the current position.
+     * @return Number of frames written; less than frames.size() only at the end of the track.
+     */
+    std::size_t read(std::span<PlaybackSample> frames);
+
+    /** Moves the read position. Cached positions are available instantly, without touching the file.
+     */
+    bool seek(std::chrono::microseconds position);
+    bool seekToFrame(std::uint64_t frame);
+
+    /** Opens the file and positions it at the end of the cached range after the current position.
+     * Moves the cost of opening and seeking to a convenient time, so that the switch from cached to decoded
+     * data does not stall the caller of read().
+     */
+    void prepareDecoder();
+
+    std::uint64_t getPositionFrames() const;
+    std::optional<std::uint32_t> getSamplingFrequency() const;
+private:
+    bool ensureStream();
+    bool positionStream(std::uint64_t frame);
+    std::size_t readCached(std::span<PlaybackSample> frames);
+    std::size_t readDecoded(std::span<PlaybackSample> frames);
+    void addToPendingBlock(std::span<PlaybackSample const> frames, std::size_t offset);
+    void finishPendingBlock(bool is_last);
+};
+
+/** Key under which the decoded audio of a track is cached.
+ * Includes the signature of local files, so that modified files do not get served stale data.
+ */
+std::string getPcmCacheKey(std::filesystem::path const& location);
+
+}
+#endif
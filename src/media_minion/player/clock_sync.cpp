@@ -0,0 +1,131 @@
+#include <media_minion/player/clock_sync.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::size_t g_maxSamples = 64;
+constexpr std::size_t g_minSamples = 4;
+// samples with a round trip this much longer than the best one were delayed on one of the ways
+constexpr double g_roundTripTolerance = 1.5;
+constexpr std::chrono::microseconds g_roundTripJitter(200);
+// below this span, the noise of the samples outweighs the drift of any reasonable clock
+constexpr std::chrono::seconds g_minDriftSpan(30);
+// quartz oscillators stay well within this; anything larger is a measurement artifact
+constexpr double g_maxDrift = 500e-6;
+
+double toMicrosecondsDouble(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+}
+
+void ClockSync::addSample(std::chrono::steady_clock::time_point t0, std::chrono::microseconds t1,
+                          std::chrono::microseconds t2, std::chrono::steady_clock::time_point t3)
+{
+    auto const local_round_trip = std::chrono::duration_cast<std::chrono::microseconds>(t3 - t0);
+    auto const round_trip = local_round_trip - (t2 - t1);
+    if ((round_trip.count() < 0) || (t2 < t1)) { return; }
+    // the server time at the midpoint of the exchange, assuming both ways took equally long
+    auto const offset = ((t1 - toMicroseconds(t0)) + (t2 - toMicroseconds(t3))) / 2;
+
+    std::lock_guard lk(m_mtx);
+    m_samples.push_back(Sample{ t0 + (t3 - t0) / 2, offset, round_trip });
+    if (m_samples.size() > g_maxSamples) { m_samples.pop_front(); }
+    updateEstimate();
+}
+
+void ClockSync::reset()
+{
+    std::lock_guard lk(m_mtx);
+    m_samples.clear();
+    m_estimate.reset();
+}
+
+bool ClockSync::isSynchronized() const
+{
+    std::lock_guard lk(m_mtx);
+    return m_estimate.has_value();
+}
+
+std::optional<std::chrono::microseconds>
+ClockSync::toServerTime(std::chrono::steady_clock::time_point local_time) const
+{
+    std::lock_guard lk(m_mtx);
+    if (!m_estimate) { return std::nullopt; }
+    double const elapsed = toMicrosecondsDouble(local_time - m_estimate->reference);
+    double const offset = m_estimate->offset_us + m_estimate->drift * elapsed;
+    return toMicroseconds(local_time) + std::chrono::microseconds(std::llround(offset));
+}
+
+std::optional<std::chrono::steady_clock::time_point>
+ClockSync::toLocalTime(std::chrono::microseconds server_time) const
+{
+    std::lock_guard lk(m_mtx);
+    if (!m_estimate) { return std::nullopt; }
+    auto const reference = toMicroseconds(m_estimate->reference);
+    double const server_elapsed = static_cast<double>((server_time - reference).count()) - m_estimate->offset_us;
+    double const local_elapsed = server_elapsed / (1.0 + m_estimate->drift);
+    return m_estimate->reference +
+           std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+               std::chrono::duration<double, std::micro>(local_elapsed));
+}
+
+std::chrono::microseconds ClockSync::toMicroseconds(std::chrono::steady_clock::time_point local_time)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(local_time.time_since_epoch());
+}
+
+std::chrono::steady_clock::time_point ClockSync::fromMicroseconds(std::chrono::microseconds local_time)
+{
+    return std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(local_time));
+}
+
+void ClockSync::updateEstimate()
+{
+    if (m_samples.size() < g_minSamples) { return; }
+    auto const it_best = std::min_element(begin(m_samples), end(m_samples), [](Sample const& lhs, Sample const& rhs) {
+            return lhs.round_trip < rhs.round_trip;
+        });
+    double const max_round_trip = static_cast<double>(it_best->round_trip.count()) * g_roundTripTolerance +
+                                  static_cast<double>(g_roundTripJitter.count());
+
+    std::vector<Sample const*> good;
+    for (auto const& s : m_samples) {
+        if (static_cast<double>(s.round_trip.count()) <= max_round_trip) { good.push_back(&s); }
+    }
+    auto const span = good.back()->local_time - good.front()->local_time;
+    if ((good.size() < g_minSamples) || (span < g_minDriftSpan)) {
+        m_estimate = Estimate{ it_best->local_time, static_cast<double>(it_best->offset.count()),
+                               m_estimate ? m_estimate->drift : 0.0 };
+        return;
+    }
+
+    // least squares line through the good samples; it passes through their mean
+    auto const reference = good.front()->local_time;
+    double mean_x = 0.0;
+    double mean_y = 0.0;
+    for (auto const* s : good) {
+        mean_x += toMicrosecondsDouble(s->local_time - reference);
+        mean_y += static_cast<double>(s->offset.count());
+    }
+    mean_x /= static_cast<double>(good.size());
+    mean_y /= static_cast<double>(good.size());
+    double sxx = 0.0;
+    double sxy = 0.0;
+    for (auto const* s : good) {
+        double const dx = toMicrosecondsDouble(s->local_time - reference) - mean_x;
+        sxx += dx * dx;
+        sxy += dx * (static_cast<double>(s->offset.count()) - mean_y);
+    }
+    double const drift = (sxx > 0.0) ? std::clamp(sxy / sxx, -g_maxDrift, g_maxDrift) : 0.0;
+    m_estimate = Estimate{ reference + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                           std::chrono::duration<double, std::micro>(mean_x)),
+                           mean_y, drift };
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_CLOCK_SYNC_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_CLOCK_SYNC_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace media_minion::player {
+
+/** Estimates the offset and drift of the server clock relative to the local steady clock.
+ * Works like the NTP clock filter: each exchange yields an offset sample whose error is bounded by half its
+ * round trip time, so the estimate is based on the samples with the shortest round trips. The drift is the
+ * slope of a least squares fit through those samples once they span a long enough time.
+ * Server times are microseconds on the server's steady clock. Access is thread-safe.
+ */
+class ClockSync {
+private:
+    struct Sample {
+        std::chrono::steady_clock::time_point local_time;   ///< midpoint of the exchange
+        std::chrono::microseconds offset;                   ///< server time minus local time
+        std::chrono::microseconds round_trip;
+    };
+    struct Estimate {
+        std::chrono::steady_clock::time_point reference;
+        double offset_us;
+        double drift;                                       ///< server seconds gained per local second
+    };
+    mutable std::mutex m_mtx;
+    std::deque<Sample> m_samples;
+    std::optional<Estimate> m_estimate;
+public:
+    /** Adds the result of one exchange.
+     * @param[in] t0 Local time at which the request was sent.
+     * @param[in] t1 Server time at which the request was received.
+     * @param[in] t2 Server time at which the response was sent.
+     * @param[in] t3 Local time at which the response was received.
+     */
+    void addSample(std::chrono::steady_clock::time_point t0, std::chrono::microseconds t1,
+                   std::chrono::microseconds t2, std::chrono::steady_clock::time_point t3);
+
+    /** Forgets all samples, e.g. after connecting to a server that may have been restarted.
+     */
+    void reset();
+
+    bool isSynchronized() const;
+
+    /** @return std::nullopt if not synchronized yet.
+     */
+    std::optional<std::chrono::microseconds> toServerTime(std::chrono::steady_clock::time_point local_time) const;
+    std::optional<std::chrono::steady_clock::time_point> toLocalTime(std::chrono::microseconds server_time) const;
+
+    /** Microseconds on the local steady clock, as they appear in the messages of the time exchange.
+     */
+    static std::chrono::microseconds toMicroseconds(std::chrono::steady_clock::time_point local_time);
+    static std::chrono::steady_clock::time_point fromMicroseconds(std::chrono::microseconds local_time);
+private:
+    void updateEstimate();
+};
+
+}
+#endif
@@ -0,0 +1,59 @@
+#include <media_minion/player/command_bus.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace media_minion::player {
+
+namespace {
+std::size_t getSlotCount(std::size_t capacity)
+{
+    return std::bit_ceil(std::max<std::size_t>(capacity, 2));
+}
+}
+
+CommandBus::CommandBus(std::size_t capacity)
+    :m_slots(std::make_unique<Slot[]>(getSlotCount(capacity))), m_mask(getSlotCount(capacity) - 1),
+     m_pushPosition(0), m_popPosition(0)
+{
+    for (std::size_t i = 0; i <= m_mask; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool CommandBus::push(EngineCommand command)
+{
+    std::size_t position = m_pushPosition.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = m_slots[position & m_mask];
+        std::size_t const sequence = slot.sequence.load(std::memory_order_acquire);
+        auto const diff = static_cast<std::ptrdiff_t>(sequence - position);
+        if (diff == 0) {
+            // the slot is free; claim it unless another producer was faster
+            if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.command.emplace(std::move(command));
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // the consumer has not yet emptied the slot from the previous round
+            return false;
+        } else {
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+std::optional<EngineCommand> CommandBus::pop()
+{
+    Slot& slot = m_slots[m_popPosition & m_mask];
+    if (slot.sequence.load(std::memory_order_acquire) != m_popPosition + 1) { return std::nullopt; }
+    std::optional<EngineCommand> ret = std::move(slot.command);
+    slot.command.reset();
+    slot.sequence.store(m_popPosition + m_mask + 1, std::memory_order_release);
+    ++m_popPosition;
+    return ret;
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_COMMAND_BUS_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_COMMAND_BUS_HPP_
+
+#include <media_minion/player/control_protocol.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace media_minion::player {
+
+enum class CommandOrigin {
+    Remote,         ///< received from the server; acknowledged back to it
+    Local           ///< issued by a control of the player itself, like the tray icon
+};
+
+struct EngineCommand {
+    PlayerCommand command;
+    CommandOrigin origin;
+    std::uint64_t ticket;           ///< identifies the command in its completion notification
+};
+
+struct CommandCompletion {
+    std::uint64_t ticket;
+    PlayerCommandType type;
+    CommandOrigin origin;
+    PlaybackState state;            ///< after the command took effect
+};
+
+/** Bounded queue that carries commands from any number of threads to the playback thread.
+ * Neither side ever blocks or takes a lock: push() fails if the queue is full, pop() returns nothing if it
+ * is empty. Each slot has a sequence number that tells whether it is free for the producer at a given
+ * position or filled for the consumer.
+ */
+class CommandBus {
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        std::optional<EngineCommand> command;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_mask;
+    alignas(64) std::atomic<std::size_t> m_pushPosition;
+    alignas(64) std::size_t m_popPosition;      ///< only touched by the consumer
+public:
+    /** @param[in] capacity Rounded up to the next power of two.
+     */
+    explicit CommandBus(std::size_t capacity);
+
+    CommandBus(CommandBus const&) = delete;
+    CommandBus& operator=(CommandBus const&) = delete;
+
+    /** Thread-safe.
+     * @return false if the queue is full; the command is dropped in that case.
+     */
+    bool push(EngineCommand command);
+
+    /** Must only be called from the consuming thread.
+     */
+    std::optional<EngineCommand> pop();
+};
+
+}
+#endif
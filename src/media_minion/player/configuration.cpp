@@ -13,10 +13,139 @@
 #include <gbBase/Assert.hpp>
 #include <gbBase/Log.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <iterator>
+#include <string_view>
 
 namespace media_minion::player {
 
+namespace {
+std::chrono::milliseconds defaultPumpInterval(std::size_t buffer_count, std::chrono::milliseconds buffer_duration)
+{
+    // pump often enough that a quarter of the queue is the most that can drain between two refills
+    auto const interval = buffer_duration * static_cast<int>(buffer_count) / 4;
+    return std::clamp<std::chrono::milliseconds>(interval, std::chrono::milliseconds(5), std::chrono::milliseconds(1000));
+}
+
+LatencyProfile makeLatencyProfile(std::string name, std::size_t buffer_count, std::chrono::milliseconds buffer_duration)
+{
+    return LatencyProfile{ std::move(name), buffer_count, buffer_duration,
+                           defaultPumpInterval(buffer_count, buffer_duration) };
+}
+
+template<typename JsonObject>
+std::optional<CrossfadeSettings> parseCrossfadeSettings(JsonObject const& obj)
+{
+    CrossfadeSettings ret;
+    if (obj.HasMember("duration_ms")) {
+        if (!obj["duration_ms"].IsUint()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'audio.crossfade.duration_ms'");
+            return std::nullopt;
+        }
+        ret.duration = std::chrono::milliseconds(obj["duration_ms"].GetUint());
+    }
+    if (obj.HasMember("curve")) {
+        std::string_view const curve = obj["curve"].IsString() ? obj["curve"].GetString() : "";
+        if (curve == "linear") {
+            ret.curve = CrossfadeCurve::Linear;
+        } else if (curve == "equal_power") {
+            ret.curve = CrossfadeCurve::EqualPower;
+        } else if (curve == "s_curve") {
+            ret.curve = CrossfadeCurve::SCurve;
+        } else {
+            GHULBUS_LOG(Error, "Invalid value for option 'audio.crossfade.curve'");
+            return std::nullopt;
+        }
+    }
+    if (obj.HasMember("silence_aware")) {
+        if (!obj["silence_aware"].IsBool()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'audio.crossfade.silence_aware'");
+            return std::nullopt;
+        }
+        ret.silence_aware = obj["silence_aware"].GetBool();
+    }
+    if (obj.HasMember("silence_threshold_db")) {
+        if (!obj["silence_threshold_db"].IsNumber() || (obj["silence_threshold_db"].GetDouble() > 0.0)) {
+            GHULBUS_LOG(Error, "Invalid value for option 'audio.crossfade.silence_threshold_db'");
+            return std::nullopt;
+        }
+        ret.silence_threshold_db = static_cast<float>(obj["silence_threshold_db"].GetDouble());
+    }
+    return ret;
+}
+
+template<typename JsonObject>
+std::optional<ZoneSettings> parseZoneSettings(JsonObject const& obj)
+{
+    ZoneSettings ret{ "", "main", 0.0, std::chrono::milliseconds(0) };
+    if (!obj.HasMember("name") || !obj["name"].IsString()) {
+        GHULBUS_LOG(Error, "Invalid value for option 'zones.name'");
+        return std::nullopt;
+    }
+    ret.name = obj["name"].GetString();
+    if (obj.HasMember("stream")) {
+        if (!obj["stream"].IsString()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'zones." << ret.name << ".stream'");
+            return std::nullopt;
+        }
+        ret.stream = obj["stream"].GetString();
+    }
+    if (obj.HasMember("volume_db")) {
+        if (!obj["volume_db"].IsNumber()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'zones." << ret.name << ".volume_db'");
+            return std::nullopt;
+        }
+        ret.volume_db = obj["volume_db"].GetDouble();
+    }
+    if (obj.HasMember("delay_ms")) {
+        if (!obj["delay_ms"].IsUint()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'zones." << ret.name << ".delay_ms'");
+            return std::nullopt;
+        }
+        ret.delay = std::chrono::milliseconds(obj["delay_ms"].GetUint());
+    }
+    return ret;
+}
+
+template<typename JsonObject>
+std::optional<LatencyProfile> parseLatencyProfile(std::string name, JsonObject const& obj)
+{
+    if (!obj.HasMember("buffer_count") || !obj["buffer_count"].IsUint() || obj["buffer_count"].GetUint() < 2) {
+        GHULBUS_LOG(Error, "Invalid value for option 'audio.latency_profiles." << name << ".buffer_count'");
+        return std::nullopt;
+    }
+    std::size_t const buffer_count = obj["buffer_count"].GetUint();
+
+    if (!obj.HasMember("buffer_duration_ms") || !obj["buffer_duration_ms"].IsUint() ||
+        obj["buffer_duration_ms"].GetUint() == 0)
+    {
+        GHULBUS_LOG(Error, "Invalid value for option 'audio.latency_profiles." << name << ".buffer_duration_ms'");
+        return std::nullopt;
+    }
+    std::chrono::milliseconds const buffer_duration(obj["buffer_duration_ms"].GetUint());
+
+    LatencyProfile ret = makeLatencyProfile(std::move(name), buffer_count, buffer_duration);
+    if (obj.HasMember("pump_interval_ms")) {
+        if (!obj["pump_interval_ms"].IsUint() || obj["pump_interval_ms"].GetUint() == 0) {
+            GHULBUS_LOG(Error, "Invalid value for option 'audio.latency_profiles." << ret.name << ".pump_interval_ms'");
+            return std::nullopt;
+        }
+        ret.pump_interval = std::chrono::milliseconds(obj["pump_interval_ms"].GetUint());
+    }
+    return ret;
+}
+}
+
+std::vector<LatencyProfile> getBuiltinLatencyProfiles()
+{
+    return {
+        makeLatencyProfile("low_latency", 4, std::chrono::milliseconds(10)),
+        makeLatencyProfile("balanced", 8, std::chrono::milliseconds(50)),
+        makeLatencyProfile("power_save", 8, std::chrono::milliseconds(500)),
+    };
+}
+
 std::optional<Configuration> parsePlayerConfig(std::filesystem::path const& config_filepath)
 {
     GHULBUS_PRECONDITION(!config_filepath.empty());
@@ -70,8 +199,247 @@ std::optional<Configuration> parsePlayerConfig(std::filesystem::path const& conf
     }
     config.server_port = static_cast<std::uint16_t>(port_number);
 
+    config.player_name = "mm_player";
+    if (config_doc.HasMember("name")) {
+        if (!config_doc["name"].IsString()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'name'");
+            return std::nullopt;
+        }
+        config.player_name = config_doc["name"].GetString();
+    }
+
+    config.cache_directory = "mm_player_cache";
+    if (config_doc.HasMember("cache_directory")) {
+        if (!config_doc["cache_directory"].IsString()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'cache_directory'");
+            return std::nullopt;
+        }
+        config.cache_directory = config_doc["cache_directory"].GetString();
+    }
+
+    config.io_mode = IOMode::MemoryMapped;
+    if (config_doc.HasMember("io_mode")) {
+        std::string_view const io_mode = config_doc["io_mode"].IsString() ? config_doc["io_mode"].GetString() : "";
+        if (io_mode == "mmap") {
+            config.io_mode = IOMode::MemoryMapped;
+        } else if (io_mode == "stream") {
+            config.io_mode = IOMode::Stream;
+        } else if (io_mode == "readahead") {
+            config.io_mode = IOMode::ReadAhead;
+        } else {
+            GHULBUS_LOG(Error, "Invalid value for option 'io_mode'");
+            return std::nullopt;
+        }
+    }
+
+    config.pcm_cache = PcmCacheSettings{ 256u << 20, true, std::chrono::seconds(20) };
+    if (config_doc.HasMember("pcm_cache")) {
+        if (!config_doc["pcm_cache"].IsObject()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'pcm_cache'");
+            return std::nullopt;
+        }
+        auto const config_pcm_cache = config_doc["pcm_cache"].GetObject();
+        if (config_pcm_cache.HasMember("budget_mb")) {
+            if (!config_pcm_cache["budget_mb"].IsUint()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'pcm_cache.budget_mb'");
+                return std::nullopt;
+            }
+            config.pcm_cache.budget_bytes = static_cast<std::size_t>(config_pcm_cache["budget_mb"].GetUint()) << 20;
+        }
+        if (config_pcm_cache.HasMember("compress")) {
+            if (!config_pcm_cache["compress"].IsBool()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'pcm_cache.compress'");
+                return std::nullopt;
+            }
+            config.pcm_cache.compress = config_pcm_cache["compress"].GetBool();
+        }
+        if (config_pcm_cache.HasMember("prefetch_seconds")) {
+            if (!config_pcm_cache["prefetch_seconds"].IsUint()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'pcm_cache.prefetch_seconds'");
+                return std::nullopt;
+            }
+            config.pcm_cache.prefetch_duration = std::chrono::seconds(config_pcm_cache["prefetch_seconds"].GetUint());
+        }
+    }
+
+    if (config_doc.HasMember("decoder")) {
+        if (!config_doc["decoder"].IsObject()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'decoder'");
+            return std::nullopt;
+        }
+        auto opt_decoder = parseDecoderOptions(config_doc["decoder"]);
+        if (!opt_decoder) { return std::nullopt; }
+        config.decoder = *opt_decoder;
+    }
+
+    if (config_doc.HasMember("playlist")) {
+        if (!config_doc["playlist"].IsArray()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'playlist'");
+            return std::nullopt;
+        }
+        for (auto const& entry : config_doc["playlist"].GetArray()) {
+            if (!entry.IsString()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'playlist'");
+                return std::nullopt;
+            }
+            std::string_view const location = entry.GetString();
+            config.playlist.emplace_back(std::u8string(location.begin(), location.end()));
+        }
+    }
+
+    if (config_doc.HasMember("zones")) {
+        if (!config_doc["zones"].IsArray()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'zones'");
+            return std::nullopt;
+        }
+        for (auto const& entry : config_doc["zones"].GetArray()) {
+            if (!entry.IsObject()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'zones'");
+                return std::nullopt;
+            }
+            auto opt_zone = parseZoneSettings(entry.GetObject());
+            if (!opt_zone) { return std::nullopt; }
+            config.zones.emplace_back(std::move(*opt_zone));
+        }
+    }
+    if (config.zones.empty()) {
+        config.zones.push_back(ZoneSettings{ config.player_name, "main", 0.0, std::chrono::milliseconds(0) });
+    }
+
+    config.threads.lock_memory = false;
+    if (config_doc.HasMember("threads")) {
+        if (!config_doc["threads"].IsObject()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'threads'");
+            return std::nullopt;
+        }
+        auto const config_threads = config_doc["threads"].GetObject();
+        for (auto [thread_name, tuning] : { std::pair{ "audio", &config.threads.audio },
+                                            std::pair{ "decoder", &config.threads.decoder },
+                                            std::pair{ "network", &config.threads.network } })
+        {
+            if (!config_threads.HasMember(thread_name)) { continue; }
+            if (!config_threads[thread_name].IsObject()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'threads." << thread_name << "'");
+                return std::nullopt;
+            }
+            auto opt_tuning = parseThreadTuning(config_threads[thread_name], thread_name);
+            if (!opt_tuning) { return std::nullopt; }
+            *tuning = std::move(*opt_tuning);
+        }
+        if (config_threads.HasMember("lock_memory")) {
+            if (!config_threads["lock_memory"].IsBool()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'threads.lock_memory'");
+                return std::nullopt;
+            }
+            config.threads.lock_memory = config_threads["lock_memory"].GetBool();
+        }
+    }
+
+    std::vector<LatencyProfile> profiles = getBuiltinLatencyProfiles();
+    std::string profile_name = "balanced";
+    config.replaygain_mode = ReplayGainMode::Off;
+    config.replaygain_preamp_db = 0.0;
+    if (config_doc.HasMember("audio")) {
+        if (!config_doc["audio"].IsObject()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'audio'");
+            return std::nullopt;
+        }
+        auto const config_audio = config_doc["audio"].GetObject();
+        if (config_audio.HasMember("latency_profiles")) {
+            if (!config_audio["latency_profiles"].IsObject()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'audio.latency_profiles'");
+                return std::nullopt;
+            }
+            for (auto const& p : config_audio["latency_profiles"].GetObject()) {
+                if (!p.value.IsObject()) {
+                    GHULBUS_LOG(Error, "Invalid value for option 'audio.latency_profiles." << p.name.GetString() << "'");
+                    return std::nullopt;
+                }
+                auto opt_profile = parseLatencyProfile(p.name.GetString(), p.value.GetObject());
+                if (!opt_profile) { return std::nullopt; }
+                auto const it = std::find_if(begin(profiles), end(profiles),
+                                             [&](LatencyProfile const& lp) { return lp.name == opt_profile->name; });
+                if (it != end(profiles)) {
+                    *it = std::move(*opt_profile);
+                } else {
+                    profiles.emplace_back(std::move(*opt_profile));
+                }
+            }
+        }
+        if (config_audio.HasMember("latency_profile")) {
+            if (!config_audio["latency_profile"].IsString()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'audio.latency_profile'");
+                return std::nullopt;
+            }
+            profile_name = config_audio["latency_profile"].GetString();
+        }
+        if (config_audio.HasMember("replaygain")) {
+            std::string_view const mode =
+                config_audio["replaygain"].IsString() ? config_audio["replaygain"].GetString() : "";
+            if (mode == "off") {
+                config.replaygain_mode = ReplayGainMode::Off;
+            } else if (mode == "track") {
+                config.replaygain_mode = ReplayGainMode::Track;
+            } else if (mode == "album") {
+                config.replaygain_mode = ReplayGainMode::Album;
+            } else {
+                GHULBUS_LOG(Error, "Invalid value for option 'audio.replaygain'");
+                return std::nullopt;
+            }
+        }
+        if (config_audio.HasMember("crossfade")) {
+            if (!config_audio["crossfade"].IsObject()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'audio.crossfade'");
+                return std::nullopt;
+            }
+            auto opt_crossfade = parseCrossfadeSettings(config_audio["crossfade"].GetObject());
+            if (!opt_crossfade) { return std::nullopt; }
+            config.crossfade = *opt_crossfade;
+        }
+        if (config_audio.HasMember("replaygain_preamp_db")) {
+            if (!config_audio["replaygain_preamp_db"].IsNumber()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'audio.replaygain_preamp_db'");
+                return std::nullopt;
+            }
+            config.replaygain_preamp_db = config_audio["replaygain_preamp_db"].GetDouble();
+        }
+    }
+    auto const it_profile = std::find_if(begin(profiles), end(profiles),
+                                         [&](LatencyProfile const& lp) { return lp.name == profile_name; });
+    if (it_profile == end(profiles)) {
+        GHULBUS_LOG(Error, "Unknown latency profile '" << profile_name << "'");
+        return std::nullopt;
+    }
+    config.latency_profile = *it_profile;
+    GHULBUS_LOG(Info, "Using latency profile '" << config.latency_profile.name << "': " <<
+                      config.latency_profile.buffer_count << " x " << config.latency_profile.buffer_duration.count() <<
+                      "ms buffers.");
+
     return config;
 }
 
+std::vector<Configuration> splitStreams(Configuration const& config)
+{
+    std::vector<Configuration> ret;
+    for (auto const& zone : config.zones) {
+        auto it = std::find_if(begin(ret), end(ret),
+                               [&zone](Configuration const& c) { return c.zones.front().stream == zone.stream; });
+        if (it == end(ret)) {
+            Configuration stream_config = config;
+            stream_config.zones.clear();
+            ret.push_back(std::move(stream_config));
+            it = std::prev(end(ret));
+        }
+        it->zones.push_back(zone);
+    }
+    if (ret.size() > 1) {
+        for (auto& c : ret) {
+            c.player_name += " (" + c.zones.front().stream + ")";
+            c.pcm_cache.budget_bytes /= ret.size();
+        }
+    }
+    return ret;
+}
+
 }
 
@@ -1,19 +1,90 @@
 #ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_CONFIGURATION_HPP_
 #define MEDIA_MINION_INCLUDE_GUARD_PLAYER_CONFIGURATION_HPP_
 
+#include <media_minion/player/crossfader.hpp>
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/media_io_context.hpp>
+#include <media_minion/player/replay_gain.hpp>
+
+#include <media_minion/common/thread_tuning.hpp>
+
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace media_minion::player {
 
+/** Determines the shape of the audio output queue.
+ * The total output latency is roughly buffer_count * buffer_duration. Short profiles react quickly
+ * to seeks and control commands, long profiles wake up less often.
+ */
+struct LatencyProfile {
+    std::string name;
+    std::size_t buffer_count;
+    std::chrono::milliseconds buffer_duration;
+    std::chrono::milliseconds pump_interval;
+};
+
+struct PcmCacheSettings {
+    std::size_t budget_bytes;               ///< 0 disables the cache
+    bool compress;
+    std::chrono::seconds prefetch_duration; ///< decoded ahead of time for each of the next few tracks
+};
+
+/** An output of the player. Zones that name the same stream play the same audio from a single decoder;
+ * each distinct stream shows up as a player of its own towards the server.
+ * The audio device only supports a single zone, as there is no way to choose the device per zone yet.
+ */
+struct ZoneSettings {
+    std::string name;
+    std::string stream;
+    double volume_db;
+    std::chrono::milliseconds delay;        ///< added to the output to line it up with zones of higher latency
+};
+
+/** Scheduling of the threads that keep the output fed. Pinning them to cores that nothing else is
+ * pinned to keeps other load on the machine, like a build, from delaying them.
+ */
+struct ThreadSettings {
+    ThreadTuning audio;                     ///< pumps the outputs and decodes the current track
+    ThreadTuning decoder;                   ///< prepares the upcoming tracks
+    ThreadTuning network;                   ///< connection to the server
+    bool lock_memory;                       ///< keeps the memory mapped once playback runs from being paged out
+};
+
+/** The profiles that are available even if the config file does not define any.
+ */
+std::vector<LatencyProfile> getBuiltinLatencyProfiles();
+
 struct Configuration {
+    std::string player_name;                ///< identifies this player towards the server
     std::string server_host;
     std::uint16_t server_port;
+    LatencyProfile latency_profile;
+    ReplayGainMode replaygain_mode;
+    double replaygain_preamp_db;
+    CrossfadeSettings crossfade;
+    std::filesystem::path cache_directory;
+    IOMode io_mode;
+    PcmCacheSettings pcm_cache;
+    DecoderOptions decoder;
+    std::vector<ZoneSettings> zones;        ///< never empty
+    ThreadSettings threads;
+    /** Tracks to play on startup; local paths or http:// locations on the media server.
+     */
+    std::vector<std::filesystem::path> playlist;
 };
 
 std::optional<Configuration> parsePlayerConfig(std::filesystem::path const& config_filepath);
 
+/** One configuration per stream, holding only the zones of that stream, in order of first appearance.
+ * With more than one stream, the player name gets the stream name appended and the pcm cache budget
+ * is split evenly.
+ */
+std::vector<Configuration> splitStreams(Configuration const& config);
+
 }
 #endif
@@ -0,0 +1,309 @@
+#include <media_minion/player/control_protocol.hpp>
+
+#include <rapidjson/rapidjson.h>
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 5054)
+#endif
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::array<std::pair<PlayerCommandType, std::string_view>, 10> g_commandNames = {{
+    { PlayerCommandType::Play,    "play" },
+    { PlayerCommandType::Pause,   "pause" },
+    { PlayerCommandType::Stop,    "stop" },
+    { PlayerCommandType::Seek,    "seek" },
+    { PlayerCommandType::Next,    "next" },
+    { PlayerCommandType::Restart, "restart" },
+    { PlayerCommandType::Enqueue, "enqueue" },
+    { PlayerCommandType::Clear,   "clear" },
+    { PlayerCommandType::Repeat,  "repeat" },
+    { PlayerCommandType::Loop,    "loop" },
+}};
+
+std::string toUtf8String(std::filesystem::path const& p)
+{
+    std::u8string const str = p.generic_u8string();
+    return std::string(str.begin(), str.end());
+}
+
+template<typename Writer>
+void writeString(Writer& writer, std::string_view str)
+{
+    writer.String(str.data(), static_cast<rapidjson::SizeType>(str.size()));
+}
+
+template<typename Writer>
+void writeTiming(Writer& writer, std::string_view name, TimingStatistics const& t)
+{
+    writeString(writer, std::string(name) + "_avg_us");
+    writer.Int64(t.average().count());
+    writeString(writer, std::string(name) + "_max_us");
+    writer.Int64(t.max.count());
+}
+}
+
+std::optional<PlayerCommand> parsePlayerCommand(std::string_view msg)
+{
+    rapidjson::Document doc;
+    doc.Parse(msg.data(), msg.size());
+    if (doc.HasParseError() || !doc.IsObject()) {
+        GHULBUS_LOG(Warning, "Received malformed message.");
+        return std::nullopt;
+    }
+    if (!doc.HasMember("type") || !doc["type"].IsString() || (std::string_view(doc["type"].GetString()) != "command")) {
+        return std::nullopt;
+    }
+    if (!doc.HasMember("command") || !doc["command"].IsString()) {
+        GHULBUS_LOG(Warning, "Received command without a command name.");
+        return std::nullopt;
+    }
+
+    std::string_view const name = doc["command"].GetString();
+    auto const it = std::find_if(g_commandNames.begin(), g_commandNames.end(),
+                                 [name](auto const& p) { return p.second == name; });
+    if (it == g_commandNames.end()) {
+        GHULBUS_LOG(Warning, "Received unknown command '" << name << "'.");
+        return std::nullopt;
+    }
+
+    PlayerCommand ret{ it->first, std::nullopt, std::chrono::milliseconds(0), {}, {}, std::nullopt, false,
+                       std::nullopt };
+    if (doc.HasMember("id")) {
+        if (doc["id"].IsString()) {
+            ret.id = doc["id"].GetString();
+        } else if (doc["id"].IsUint64()) {
+            ret.id = std::to_string(doc["id"].GetUint64());
+        }
+    }
+    if (ret.type == PlayerCommandType::Seek) {
+        if (!doc.HasMember("position_ms") || !doc["position_ms"].IsUint64()) {
+            GHULBUS_LOG(Warning, "Received seek command without a valid position.");
+            return std::nullopt;
+        }
+        ret.position = std::chrono::milliseconds(doc["position_ms"].GetUint64());
+    } else if (ret.type == PlayerCommandType::Enqueue) {
+        if (!doc.HasMember("location") || !doc["location"].IsString()) {
+            GHULBUS_LOG(Warning, "Received enqueue command without a valid location.");
+            return std::nullopt;
+        }
+        std::string_view const location = doc["location"].GetString();
+        ret.location = std::u8string(location.begin(), location.end());
+    } else if (ret.type == PlayerCommandType::Repeat) {
+        if (!doc.HasMember("enabled") || !doc["enabled"].IsBool()) {
+            GHULBUS_LOG(Warning, "Received repeat command without a valid flag.");
+            return std::nullopt;
+        }
+        ret.repeat = doc["enabled"].GetBool();
+    } else if ((ret.type == PlayerCommandType::Loop) && (doc.HasMember("begin_ms") || doc.HasMember("end_ms"))) {
+        if (!doc.HasMember("begin_ms") || !doc["begin_ms"].IsUint64() ||
+            !doc.HasMember("end_ms") || !doc["end_ms"].IsUint64())
+        {
+            GHULBUS_LOG(Warning, "Received loop command with an invalid section.");
+            return std::nullopt;
+        }
+        ret.loop.emplace(std::chrono::milliseconds(doc["begin_ms"].GetUint64()),
+                         std::chrono::milliseconds(doc["end_ms"].GetUint64()));
+    }
+    if (doc.HasMember("start_at_us")) {
+        if (!doc["start_at_us"].IsInt64()) {
+            GHULBUS_LOG(Warning, "Received command with an invalid start time.");
+            return std::nullopt;
+        }
+        ret.start_at = std::chrono::microseconds(doc["start_at_us"].GetInt64());
+    }
+    return ret;
+}
+
+std::optional<TimeResponse> parseTimeResponse(std::string_view msg)
+{
+    rapidjson::Document doc;
+    doc.Parse(msg.data(), msg.size());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("type") || !doc["type"].IsString() ||
+        (std::string_view(doc["type"].GetString()) != "time_response"))
+    {
+        return std::nullopt;
+    }
+    for (char const* field : { "t0", "t1", "t2" }) {
+        if (!doc.HasMember(field) || !doc[field].IsInt64()) {
+            GHULBUS_LOG(Warning, "Received malformed time response.");
+            return std::nullopt;
+        }
+    }
+    return TimeResponse{ std::chrono::microseconds(doc["t0"].GetInt64()),
+                         std::chrono::microseconds(doc["t1"].GetInt64()),
+                         std::chrono::microseconds(doc["t2"].GetInt64()) };
+}
+
+char const* toString(PlayerCommandType t)
+{
+    for (auto const& [type, name] : g_commandNames) {
+        if (type == t) { return name.data(); }
+    }
+    return "";
+}
+
+char const* toString(PlaybackState s)
+{
+    switch (s) {
+    case PlaybackState::Stopped: return "stopped";
+    case PlaybackState::Playing: return "playing";
+    case PlaybackState::Paused:  return "paused";
+    }
+    return "";
+}
+
+std::string serializeHello(std::string_view player_name)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("type");
+    writer.String("hello");
+    writer.Key("role");
+    writer.String("player");
+    writer.Key("name");
+    writeString(writer, player_name);
+    writer.EndObject();
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+std::string serializePlayerState(PlayerState const& state)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("type");
+    writer.String("player_state");
+    writer.Key("state");
+    writer.String(toString(state.state));
+    if (state.track) {
+        writer.Key("track");
+        writeString(writer, toUtf8String(*state.track));
+    }
+    writer.Key("queued");
+    writer.Uint64(state.queued);
+    writer.EndObject();
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+std::string serializeCommandAck(PlayerCommand const& command, CommandLatency const& latency)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("type");
+    writer.String("command_ack");
+    if (command.id) {
+        writer.Key("id");
+        writeString(writer, *command.id);
+    }
+    writer.Key("command");
+    writer.String(toString(command.type));
+    writer.Key("processing_us");
+    writer.Int64(latency.processing.count());
+    writer.Key("queued_output_us");
+    writer.Int64(latency.queued_output.count());
+    if (latency.network_rtt) {
+        writer.Key("network_rtt_us");
+        writer.Int64(latency.network_rtt->count());
+    }
+    writer.EndObject();
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+std::string serializeTelemetryReport(TelemetryReport const& report)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("type");
+    writer.String("telemetry");
+    writer.Key("interval_ms");
+    writer.Int64(report.interval.count());
+
+    writer.Key("output");
+    writer.StartObject();
+    writer.Key("queue_capacity");
+    writer.Uint64(report.queue_capacity);
+    writer.Key("queue_depth_min");
+    writer.Uint64(report.queue_depth_min);
+    writer.Key("queue_depth_avg");
+    writer.Double((report.queue_depth_samples == 0) ? 0.0 :
+                  (static_cast<double>(report.queue_depth_sum) / static_cast<double>(report.queue_depth_samples)));
+    writer.Key("underruns");
+    writer.Uint64(report.underruns);
+    writeTiming(writer, "refill", report.refill);
+    writer.EndObject();
+
+    writer.Key("decode");
+    writer.StartObject();
+    writer.Key("packets");
+    writer.Uint64(report.packets);
+    writer.Key("bytes_read");
+    writer.Uint64(report.bytes_read);
+    writeTiming(writer, "disk_read", report.disk_read);
+    writeTiming(writer, "network_read", report.network_read);
+    writeTiming(writer, "decode", report.decode);
+    writer.EndObject();
+
+    writer.Key("pump");
+    writer.StartObject();
+    writeTiming(writer, "lateness", report.pump_lateness);
+    writeTiming(writer, "duration", report.pump_duration);
+    writer.EndObject();
+
+    writer.Key("network");
+    writer.StartObject();
+    if (report.network_rtt) {
+        writer.Key("rtt_us");
+        writer.Int64(report.network_rtt->count());
+    }
+    writer.EndObject();
+
+    writer.Key("tuning");
+    writer.StartObject();
+    writer.Key("memory_lock");
+    writer.String(toString(report.memory_lock));
+    for (auto const& [thread_name, result] : report.thread_tuning) {
+        writer.Key(thread_name.c_str(), static_cast<rapidjson::SizeType>(thread_name.size()));
+        writer.StartObject();
+        writer.Key("affinity");
+        writer.String(toString(result.affinity));
+        writer.Key("scheduling");
+        writer.String(toString(result.scheduling));
+        writer.EndObject();
+    }
+    writer.EndObject();
+
+    writer.EndObject();
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+std::string serializeTimeRequest(std::chrono::microseconds t0)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("type");
+    writer.String("time_request");
+    writer.Key("t0");
+    writer.Int64(t0.count());
+    writer.EndObject();
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_CONTROL_PROTOCOL_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_CONTROL_PROTOCOL_HPP_
+
+#include <media_minion/player/telemetry.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace media_minion::player {
+
+/** Messages exchanged with remote controls through the websocket of mm_server.
+ * All messages are json objects with a "type" field:
+ *  - {"type":"hello","role":"player","name":"Kitchen"}         sent by the player after connecting
+ *  - {"type":"command","command":"seek","id":"17","position_ms":5000}
+ *                                                              sent by remote controls; id is optional
+ *  - {"type":"player_state","state":"playing","track":"...","queued":3}
+ *                                                              sent by the player on every state change
+ *  - {"type":"command_ack","id":"17","command":"repeat","processing_us":310840,"queued_output_us":310000,
+ *     "network_rtt_us":1200}
+ *                                                              sent by the player once a command took effect
+ *  - {"type":"telemetry","interval_ms":10000,"output":{...},"decode":{...},"pump":{...},"network":{...},
+ *     "tuning":{...}}
+ *                                                              sent by the player periodically
+ *  - {"type":"time_request","t0":81234567}                     sent by the player to measure the clock offset
+ *  - {"type":"time_response","t0":81234567,"t1":5012345,"t2":5012360}
+ *                                                              answered by the server to the requesting player
+ *                                                              only; t1 and t2 are receive and send time on the
+ *                                                              server clock, all times in microseconds
+ *  - {"type":"command","command":"repeat","enabled":true}      repeats the current track while enabled
+ *  - {"type":"command","command":"loop","begin_ms":1000,"end_ms":5000}
+ *                                                              loops a section of the current track; without
+ *                                                              begin_ms and end_ms, removes the loop again
+ * Commands that restart playback (play, seek, next, restart) may carry "start_at_us", a time on the server clock
+ * at which the output starts on all players alike. Remote controls set "synchronized":true instead and leave
+ * it to the server to pick a time.
+ * Apart from time requests, the server relays every message to all other connected clients.
+ */
+enum class PlayerCommandType {
+    Play,
+    Pause,
+    Stop,
+    Seek,           ///< position
+    Next,
+    Restart,
+    Enqueue,        ///< location
+    Clear,
+    Repeat,         ///< repeat
+    Loop            ///< loop
+};
+
+struct PlayerCommand {
+    PlayerCommandType type;
+    std::optional<std::string> id;
+    std::chrono::milliseconds position;
+    std::filesystem::path location;
+    std::chrono::steady_clock::time_point received;     ///< set by the receiver, for latency measurement
+    std::optional<std::chrono::microseconds> start_at;  ///< on the server clock
+    bool repeat;
+    std::optional<std::pair<std::chrono::milliseconds, std::chrono::milliseconds>> loop;   ///< [begin, end)
+};
+
+enum class PlaybackState {
+    Stopped,
+    Playing,
+    Paused
+};
+
+struct PlayerState {
+    PlaybackState state;
+    std::optional<std::filesystem::path> track;
+    std::size_t queued;
+};
+
+struct CommandLatency {
+    /** From receiving the command until its effect is audible, including the audio queued for the device.
+     */
+    std::chrono::microseconds processing;
+    /** Share of processing spent on audio queued ahead of the effect; 0 for commands that flush the outputs or act
+     * on them directly.
+     */
+    std::chrono::microseconds queued_output;
+    std::optional<std::chrono::microseconds> network_rtt;
+};
+
+struct TimeResponse {
+    std::chrono::microseconds t0;       ///< local time of the request, echoed back
+    std::chrono::microseconds t1;
+    std::chrono::microseconds t2;
+};
+
+/** @return std::nullopt if msg is not a valid command; messages of other types are silently ignored.
+ */
+std::optional<PlayerCommand> parsePlayerCommand(std::string_view msg);
+/** @return std::nullopt if msg is not a time response.
+ */
+std::optional<TimeResponse> parseTimeResponse(std::string_view msg);
+
+char const* toString(PlayerCommandType t);
+char const* toString(PlaybackState s);
+
+std::string serializeHello(std::string_view player_name);
+std::string serializePlayerState(PlayerState const& state);
+std::string serializeCommandAck(PlayerCommand const& command, CommandLatency const& latency);
+std::string serializeTelemetryReport(TelemetryReport const& report);
+std::string serializeTimeRequest(std::chrono::microseconds t0);
+
+}
+#endif
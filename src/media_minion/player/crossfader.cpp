@@ -0,0 +1,89 @@
+#include <media_minion/player/crossfader.hpp>
+
+#include <media_minion/player/gain_stage.hpp>
+#include <media_minion/player/pcm_buffer.hpp>
+
+#include <gbBase/Assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace media_minion::player {
+
+namespace {
+constexpr float g_pi = 3.14159265358979f;
+
+int silenceThreshold(float threshold_db)
+{
+    return static_cast<int>(32767.f * std::pow(10.f, threshold_db / 20.f));
+}
+
+bool isSilent(GhulbusAudio::SampleStereo16Bit const& s, int threshold)
+{
+    return (std::abs(static_cast<int>(s.left)) <= threshold) && (std::abs(static_cast<int>(s.right)) <= threshold);
+}
+
+/** Gain of the incoming track at position x of the transition, with x in [0, 1].
+ * The outgoing track uses the mirrored curve.
+ */
+float fadeInGain(CrossfadeCurve curve, float x)
+{
+    switch (curve) {
+    case CrossfadeCurve::Linear:     return x;
+    case CrossfadeCurve::EqualPower: return std::sin(x * g_pi / 2.f);
+    case CrossfadeCurve::SCurve:     return x * x * (3.f - 2.f * x);
+    }
+    GHULBUS_UNREACHABLE_MESSAGE("Invalid crossfade curve.");
+}
+}
+
+std::size_t countLeadingSilence(std::span<PlaybackSample const> frames, float threshold_db)
+{
+    int const threshold = silenceThreshold(threshold_db);
+    std::size_t i = 0;
+    while ((i < frames.size()) && isSilent(frames[i], threshold)) { ++i; }
+    return i;
+}
+
+std::size_t countTrailingSilence(std::span<PlaybackSample const> frames, float threshold_db)
+{
+    int const threshold = silenceThreshold(threshold_db);
+    std::size_t i = frames.size();
+    while ((i > 0) && isSilent(frames[i - 1], threshold)) { --i; }
+    return frames.size() - i;
+}
+
+void crossfade(std::span<PlaybackSample const> tail, std::span<PlaybackSample const> head,
+               std::uint32_t sampling_frequency, CrossfadeSettings const& settings, PcmBuffer& out)
+{
+    std::size_t tail_end = tail.size();
+    std::size_t head_begin = 0;
+    if (settings.silence_aware) {
+        tail_end -= countTrailingSilence(tail, settings.silence_threshold_db);
+        head_begin = countLeadingSilence(head, settings.silence_threshold_db);
+    }
+    std::size_t const overlap = std::min({ tail_end, head.size() - head_begin,
+                                           framesForDuration(sampling_frequency, settings.duration) });
+    std::size_t const tail_only = tail_end - overlap;
+    std::size_t const head_only = head.size() - head_begin - overlap;
+
+    auto const ret = out.prepare(tail_only + overlap + head_only);
+    std::copy_n(tail.begin(), tail_only, ret.begin());
+    if (overlap > 0) {
+        std::vector<float> gain_out(overlap);
+        std::vector<float> gain_in(overlap);
+        for (std::size_t i = 0; i < overlap; ++i) {
+            float const x = (static_cast<float>(i) + 0.5f) / static_cast<float>(overlap);
+            gain_in[i] = fadeInGain(settings.curve, x);
+            gain_out[i] = fadeInGain(settings.curve, 1.f - x);
+        }
+        mixWithGainRamps(&tail[tail_only].left, gain_out.data(), &head[head_begin].left, gain_in.data(),
+                         &ret[tail_only].left, overlap);
+    }
+    std::copy_n(head.begin() + head_begin + overlap, head_only, ret.begin() + tail_only + overlap);
+    out.commit(ret.size());
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_CROSSFADER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_CROSSFADER_HPP_
+
+#include <media_minion/player/media_source.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace media_minion::player {
+
+class PcmBuffer;
+
+enum class CrossfadeCurve {
+    Linear,
+    EqualPower,     ///< constant power across the transition; no dip in loudness for uncorrelated material
+    SCurve,         ///< slow start and end; keeps more of both tracks at full volume
+};
+
+struct CrossfadeSettings {
+    /** Length of the overlap between two tracks. Zero disables crossfading; tracks are then played gapless.
+     */
+    std::chrono::milliseconds duration = std::chrono::milliseconds(0);
+    CrossfadeCurve curve = CrossfadeCurve::EqualPower;
+    /** Skip silence at the end of the outgoing and at the start of the incoming track before overlapping.
+     */
+    bool silence_aware = true;
+    float silence_threshold_db = -60.f;
+};
+
+/** Joins the end of one track with the start of the next.
+ * The last part of tail gets overlapped with the first part of head for the configured duration,
+ * or less if either of them is shorter. The result contains the non-overlapping parts of both as well.
+ * Both inputs are at sampling_frequency; the result is appended to out, which may alias neither input.
+ */
+void crossfade(std::span<PlaybackSample const> tail, std::span<PlaybackSample const> head,
+               std::uint32_t sampling_frequency, CrossfadeSettings const& settings, PcmBuffer& out);
+
+/** Number of frames at the start of frames that are below the silence threshold.
+ */
+std::size_t countLeadingSilence(std::span<PlaybackSample const> frames, float threshold_db);
+
+/** Number of frames at the end of frames that are below the silence threshold.
+ */
+std::size_t countTrailingSilence(std::span<PlaybackSample const> frames, float threshold_db);
+
+}
+#endif
@@ -0,0 +1,415 @@
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/media_io_context.hpp>
+
+#include <media_minion/common/logging.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <rapidjson/rapidjson.h>
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 5054)
+#endif
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+extern "C" {
+#   include <libavutil/avutil.h>
+}
+
+#ifdef _WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <Windows.h>
+#   include <psapi.h>
+#else
+#   include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/** Decodes a corpus of audio files as fast as possible on a number of threads, using the same decoding path
+ * as the player, and reports the throughput per codec. The json output is meant for tracking the numbers across
+ * hardware and ffmpeg versions.
+ *
+ * Allocations are counted through the global operator new, so they cover everything outside of ffmpeg's own
+ * allocator; libav internals are only visible in the peak resident set size.
+ */
+
+namespace {
+thread_local std::uint64_t t_allocations = 0;
+thread_local std::uint64_t t_allocatedBytes = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    ++t_allocations;
+    t_allocatedBytes += size;
+    if (void* p = std::malloc((size > 0) ? size : 1); p) { return p; }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+using media_minion::player::DecoderOptions;
+using media_minion::player::FfmpegStream;
+using media_minion::player::FfmpegStreamOptions;
+using media_minion::player::IOMode;
+using media_minion::player::PlaybackSample;
+
+constexpr std::size_t g_readFrames = 16384;
+
+struct Options {
+    std::vector<std::filesystem::path> inputs;
+    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u);
+    IOMode io_mode = IOMode::MemoryMapped;
+    std::size_t decoder_threads = 1;
+    std::optional<std::filesystem::path> json_output;
+};
+
+struct FileResult {
+    bool ok = false;
+    std::string codec;
+    std::uint64_t input_bytes = 0;
+    std::uint64_t frames = 0;
+    std::chrono::microseconds audio_duration{ 0 };
+    std::chrono::microseconds decode_time{ 0 };     ///< including opening and probing the file
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+};
+
+struct CodecSummary {
+    std::uint64_t files = 0;
+    std::uint64_t input_bytes = 0;
+    std::chrono::microseconds audio_duration{ 0 };
+    std::chrono::microseconds decode_time{ 0 };
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+
+    void add(FileResult const& r) {
+        ++files;
+        input_bytes += r.input_bytes;
+        audio_duration += r.audio_duration;
+        decode_time += r.decode_time;
+        allocations += r.allocations;
+        allocated_bytes += r.allocated_bytes;
+    }
+
+    double realtimeFactor() const {
+        return (decode_time.count() > 0) ?
+            (static_cast<double>(audio_duration.count()) / static_cast<double>(decode_time.count())) : 0.0;
+    }
+
+    double megabytesPerSecond() const {
+        return (decode_time.count() > 0) ?
+            (static_cast<double>(input_bytes) / static_cast<double>(decode_time.count())) : 0.0;
+    }
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: mm_decode_bench [options] <file|directory>...\n"
+                 "  --list <file>        read additional input paths from a text file, one per line\n"
+                 "  --threads <n>        number of decoding threads (default: number of cores)\n"
+                 "  --decoder-threads <n> codec threads per file; 0 for automatic (default: 1)\n"
+                 "  --io <mode>          mmap, stream or readahead (default: mmap)\n"
+                 "  --json <file>        write the results as json; '-' for stdout, which moves the table to stderr\n"
+                 "Directories are searched recursively for audio files.\n";
+}
+
+std::optional<Options> parseOptions(int argc, char* argv[])
+{
+    Options ret;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg = argv[i];
+        bool const has_value = (i + 1 < argc);
+        if ((arg == "--list") && has_value) {
+            std::ifstream fin(argv[++i]);
+            if (!fin) { return std::nullopt; }
+            for (std::string line; std::getline(fin, line);) {
+                if (!line.empty() && (line.back() == '\r')) { line.pop_back(); }
+                if (!line.empty()) { ret.inputs.emplace_back(std::u8string(line.begin(), line.end())); }
+            }
+        } else if ((arg == "--threads") && has_value) {
+            std::string_view const value = argv[++i];
+            auto const [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), ret.threads);
+            if ((ec != std::errc{}) || (ptr != value.data() + value.size()) || (ret.threads == 0)) {
+                return std::nullopt;
+            }
+        } else if ((arg == "--decoder-threads") && has_value) {
+            std::string_view const value = argv[++i];
+            auto const [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), ret.decoder_threads);
+            if ((ec != std::errc{}) || (ptr != value.data() + value.size())) { return std::nullopt; }
+        } else if ((arg == "--io") && has_value) {
+            std::string_view const mode = argv[++i];
+            if (mode == "mmap") {
+                ret.io_mode = IOMode::MemoryMapped;
+            } else if (mode == "stream") {
+                ret.io_mode = IOMode::Stream;
+            } else if (mode == "readahead") {
+                ret.io_mode = IOMode::ReadAhead;
+            } else {
+                return std::nullopt;
+            }
+        } else if ((arg == "--json") && has_value) {
+            ret.json_output = argv[++i];
+        } else if (arg.substr(0, 2) == "--") {
+            return std::nullopt;
+        } else {
+            ret.inputs.emplace_back(std::u8string(arg.begin(), arg.end()));
+        }
+    }
+    if (ret.inputs.empty()) { return std::nullopt; }
+    return ret;
+}
+
+std::vector<std::filesystem::path> collectFiles(std::vector<std::filesystem::path> const& inputs)
+{
+    std::vector<std::filesystem::path> ret;
+    for (auto const& input : inputs) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(input, ec)) {
+            for (auto const& entry : std::filesystem::recursive_directory_iterator(input, ec)) {
+                if (entry.is_regular_file(ec) && FfmpegStream::hasAudioFileExtension(entry.path())) { ret.push_back(entry.path()); }
+            }
+        } else {
+            ret.push_back(input);
+        }
+    }
+    // biggest files first, so that no thread is left with a long file at the end
+    std::vector<std::pair<std::uintmax_t, std::filesystem::path>> sized;
+    for (auto& p : ret) {
+        std::error_code ec;
+        auto const size = std::filesystem::file_size(p, ec);
+        sized.emplace_back(ec ? 0 : size, std::move(p));
+    }
+    std::stable_sort(begin(sized), end(sized), [](auto const& lhs, auto const& rhs) { return lhs.first > rhs.first; });
+    ret.clear();
+    for (auto& [size, p] : sized) { ret.push_back(std::move(p)); }
+    return ret;
+}
+
+FileResult decodeFile(std::filesystem::path const& filepath, FfmpegStreamOptions const& options)
+{
+    FileResult ret;
+    std::error_code ec;
+    ret.input_bytes = std::filesystem::file_size(filepath, ec);
+    std::uint64_t const allocations_before = t_allocations;
+    std::uint64_t const allocated_bytes_before = t_allocatedBytes;
+    auto const t_start = std::chrono::steady_clock::now();
+    {
+        FfmpegStream stream(filepath, options);
+        if (!stream.isOpen()) { return ret; }
+        ret.codec = stream.getCodecName();
+        // counted as part of decoding, like the buffers of the playback pipeline
+        std::vector<PlaybackSample> buffer(g_readFrames);
+        while (std::size_t const n_frames = stream.read(buffer)) {
+            ret.frames += n_frames;
+        }
+        std::uint32_t const sampling_frequency = stream.getSamplingFrequency();
+        if (sampling_frequency > 0) {
+            ret.audio_duration = std::chrono::microseconds(ret.frames * 1'000'000 / sampling_frequency);
+        }
+    }
+    ret.decode_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_start);
+    ret.allocations = t_allocations - allocations_before;
+    ret.allocated_bytes = t_allocatedBytes - allocated_bytes_before;
+    ret.ok = true;
+    return ret;
+}
+
+std::optional<std::uint64_t> getPeakResidentSetSize()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) { return std::nullopt; }
+    return static_cast<std::uint64_t>(pmc.PeakWorkingSetSize);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return std::nullopt; }
+#   ifdef __APPLE__
+    return static_cast<std::uint64_t>(usage.ru_maxrss);
+#   else
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#   endif
+#endif
+}
+
+template<typename Writer>
+void writeSummary(Writer& writer, CodecSummary const& s)
+{
+    writer.StartObject();
+    writer.Key("files");
+    writer.Uint64(s.files);
+    writer.Key("input_bytes");
+    writer.Uint64(s.input_bytes);
+    writer.Key("audio_ms");
+    writer.Int64(s.audio_duration.count() / 1000);
+    writer.Key("decode_ms");
+    writer.Int64(s.decode_time.count() / 1000);
+    writer.Key("realtime_factor");
+    writer.Double(s.realtimeFactor());
+    writer.Key("mb_per_second");
+    writer.Double(s.megabytesPerSecond());
+    writer.Key("allocations");
+    writer.Uint64(s.allocations);
+    writer.Key("allocated_bytes");
+    writer.Uint64(s.allocated_bytes);
+    writer.EndObject();
+}
+
+void printSummary(std::ostream& os, std::string_view name, CodecSummary const& s)
+{
+    os << std::left << std::setw(12) << name << std::right << std::setw(7) << s.files <<
+                 std::setw(12) << std::fixed << std::setprecision(1) << (static_cast<double>(s.input_bytes) / 1e6) <<
+                 std::setw(12) << (static_cast<double>(s.audio_duration.count()) / 1e6) <<
+                 std::setw(12) << (static_cast<double>(s.decode_time.count()) / 1e6) <<
+                 std::setw(10) << s.realtimeFactor() << "x" <<
+                 std::setw(10) << s.megabytesPerSecond() <<
+                 std::setw(14) << s.allocations << "\n";
+}
+}
+
+int main(int argc, char* argv[])
+{
+    auto const guard_logging = media_minion::init_logging("mm_decode_bench.log");
+
+    auto const opt_options = parseOptions(argc, argv);
+    if (!opt_options) {
+        printUsage();
+        return 1;
+    }
+    Options const& options = *opt_options;
+
+    std::vector<std::filesystem::path> const files = collectFiles(options.inputs);
+    if (files.empty()) {
+        GHULBUS_LOG(Critical, "No input files.");
+        return 1;
+    }
+    FfmpegStream::initializeFfmpeg();
+    DecoderOptions decoder;
+    decoder.thread_count = options.decoder_threads;
+    FfmpegStreamOptions const stream_options{ options.io_mode, {}, nullptr, decoder };
+
+    unsigned int const n_threads = std::min<unsigned int>(options.threads, static_cast<unsigned int>(files.size()));
+    std::vector<FileResult> results(files.size());
+    std::atomic<std::size_t> next_file = 0;
+    auto const t_start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::thread> workers;
+        for (unsigned int i = 0; i < n_threads; ++i) {
+            workers.emplace_back([&]() {
+                    for (std::size_t idx = next_file++; idx < files.size(); idx = next_file++) {
+                        results[idx] = decodeFile(files[idx], stream_options);
+                    }
+                });
+        }
+        for (auto& t : workers) { t.join(); }
+    }
+    auto const wall_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t_start);
+
+    std::map<std::string, CodecSummary> codecs;
+    CodecSummary total;
+    std::uint64_t failed = 0;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (!results[i].ok) {
+            GHULBUS_LOG(Warning, "Unable to decode " << files[i] << ".");
+            ++failed;
+            continue;
+        }
+        codecs[results[i].codec].add(results[i]);
+        total.add(results[i]);
+    }
+    auto const peak_rss = getPeakResidentSetSize();
+    double const throughput = (wall_time.count() > 0) ?
+        (static_cast<double>(total.audio_duration.count()) / static_cast<double>(wall_time.count())) : 0.0;
+
+    // keeps stdout parseable when the json goes there
+    std::ostream& table = (options.json_output && (*options.json_output == "-")) ? std::cerr : std::cout;
+    table << "ffmpeg " << av_version_info() << ", " << n_threads << " threads\n";
+    table << std::left << std::setw(12) << "codec" << std::right << std::setw(7) << "files" << std::setw(12) <<
+             "MB" << std::setw(12) << "audio s" << std::setw(12) << "decode s" << std::setw(11) << "realtime" <<
+             std::setw(10) << "MB/s" << std::setw(14) << "allocations" << "\n";
+    for (auto const& [codec, summary] : codecs) { printSummary(table, codec, summary); }
+    printSummary(table, "total", total);
+    table << "Wall time " << (static_cast<double>(wall_time.count()) / 1e6) << "s, " << throughput <<
+             "x realtime across all threads";
+    if (peak_rss) { table << ", peak rss " << (*peak_rss >> 20) << " MiB"; }
+    if (failed > 0) { table << ", " << failed << " files failed"; }
+    table << "." << std::endl;
+
+    if (options.json_output) {
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+        writer.StartObject();
+        writer.Key("ffmpeg_version");
+        writer.String(av_version_info());
+        writer.Key("threads");
+        writer.Uint(n_threads);
+        writer.Key("decoder_threads");
+        writer.Uint64(options.decoder_threads);
+        writer.Key("files");
+        writer.Uint64(files.size());
+        writer.Key("failed");
+        writer.Uint64(failed);
+        writer.Key("wall_ms");
+        writer.Int64(wall_time.count() / 1000);
+        writer.Key("throughput_realtime_factor");
+        writer.Double(throughput);
+        if (peak_rss) {
+            writer.Key("peak_rss_bytes");
+            writer.Uint64(*peak_rss);
+        }
+        writer.Key("total");
+        writeSummary(writer, total);
+        writer.Key("codecs");
+        writer.StartObject();
+        for (auto const& [codec, summary] : codecs) {
+            writer.Key(codec.c_str(), static_cast<rapidjson::SizeType>(codec.size()));
+            writeSummary(writer, summary);
+        }
+        writer.EndObject();
+        writer.EndObject();
+
+        if (*options.json_output == "-") {
+            std::cout << buffer.GetString() << std::endl;
+        } else {
+            std::ofstream fout(*options.json_output, std::ios_base::binary);
+            fout.write(buffer.GetString(), buffer.GetSize());
+            if (!fout) {
+                GHULBUS_LOG(Error, "Unable to write " << *options.json_output << ".");
+                return 1;
+            }
+        }
+    }
+    return (failed > 0) ? 2 : 0;
+}
@@ -0,0 +1,52 @@
+#include <media_minion/player/decoder_options.hpp>
+
+#include <rapidjson/rapidjson.h>
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 5054)
+#endif
+#include <rapidjson/document.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <gbBase/Log.hpp>
+
+#include <string_view>
+
+namespace media_minion::player {
+
+std::optional<DecoderOptions> parseDecoderOptions(rapidjson::Value const& obj)
+{
+    DecoderOptions ret;
+    if (obj.HasMember("threads")) {
+        if (!obj["threads"].IsUint()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'decoder.threads'");
+            return std::nullopt;
+        }
+        ret.thread_count = obj["threads"].GetUint();
+    }
+    if (obj.HasMember("threading")) {
+        std::string_view const threading = obj["threading"].IsString() ? obj["threading"].GetString() : "";
+        if (threading == "frame") {
+            ret.threading = DecoderThreading::Frame;
+        } else if (threading == "slice") {
+            ret.threading = DecoderThreading::Slice;
+        } else if (threading == "frame_and_slice") {
+            ret.threading = DecoderThreading::FrameAndSlice;
+        } else {
+            GHULBUS_LOG(Error, "Invalid value for option 'decoder.threading'");
+            return std::nullopt;
+        }
+    }
+    if (obj.HasMember("discard_other_streams")) {
+        if (!obj["discard_other_streams"].IsBool()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'decoder.discard_other_streams'");
+            return std::nullopt;
+        }
+        ret.discard_other_streams = obj["discard_other_streams"].GetBool();
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_DECODER_OPTIONS_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_DECODER_OPTIONS_HPP_
+
+#include <rapidjson/fwd.h>
+
+#include <cstddef>
+#include <optional>
+
+namespace media_minion::player {
+
+enum class DecoderThreading {
+    Frame,              ///< several frames decode in parallel; adds a few frames of decoder delay
+    Slice,              ///< single frames get split between threads
+    FrameAndSlice,      ///< whatever the codec supports
+};
+
+struct DecoderOptions {
+    /** 0 picks one thread per core. Only codecs with threading support (like flac or wavpack) make use of it,
+     * which makes loudness and fingerprint scans a lot faster.
+     */
+    std::size_t thread_count = 0;
+    DecoderThreading threading = DecoderThreading::FrameAndSlice;
+    /** Makes the demuxer drop the packets of video (cover art) and other streams instead of returning them.
+     */
+    bool discard_other_streams = true;
+};
+
+/** Parses the 'decoder' section of a config file; options that are not given keep their defaults.
+ * @return std::nullopt if any of the options is invalid; the error has been logged.
+ */
+std::optional<DecoderOptions> parseDecoderOptions(rapidjson::Value const& obj);
+
+}
+#endif
@@ -0,0 +1,75 @@
+#include <media_minion/player/device_audio_sink.hpp>
+
+#include <gbBase/Assert.hpp>
+
+namespace media_minion::player {
+
+DeviceAudioSink::DeviceAudioSink(std::size_t buffer_count)
+    :m_device(GhulbusAudio::AudioDevice::create()), m_buffers(buffer_count),
+     m_source(m_device->createQueuedSource())
+{
+    for (auto& b : m_buffers) {
+        b = m_device->createBuffer();
+        m_freeBuffers.push_back(b.get());
+    }
+}
+
+std::size_t DeviceAudioSink::getCapacity() const
+{
+    return m_buffers.size();
+}
+
+bool DeviceAudioSink::isRealTime() const
+{
+    return true;
+}
+
+void DeviceAudioSink::enqueue(GhulbusAudio::DataVariant const& data)
+{
+    GHULBUS_PRECONDITION(!m_freeBuffers.empty());
+    GhulbusAudio::Buffer& b = *m_freeBuffers.back();
+    m_freeBuffers.pop_back();
+    b.setData(data);
+    m_source->enqueueBuffer(b, [this](GhulbusAudio::Buffer& b) { return refillBuffer(b); });
+}
+
+void DeviceAudioSink::play()
+{
+    m_source->play();
+}
+
+void DeviceAudioSink::pause()
+{
+    m_source->pause();
+}
+
+void DeviceAudioSink::stop()
+{
+    m_source->stop();
+}
+
+void DeviceAudioSink::clear()
+{
+    m_source->stop();
+    m_source->clearQueue();
+    m_freeBuffers.clear();
+    for (auto const& b : m_buffers) { m_freeBuffers.push_back(b.get()); }
+}
+
+void DeviceAudioSink::pump()
+{
+    m_source->pump();
+}
+
+GhulbusAudio::QueuedSource::BufferAction DeviceAudioSink::refillBuffer(GhulbusAudio::Buffer& b)
+{
+    auto const* data = onBufferFinished ? onBufferFinished() : nullptr;
+    if (data) {
+        b.setData(*data);
+        return GhulbusAudio::QueuedSource::BufferAction::Reinsert;
+    }
+    m_freeBuffers.push_back(&b);
+    return GhulbusAudio::QueuedSource::BufferAction::Drop;
+}
+
+}
@@ -0,0 +1,43 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_DEVICE_AUDIO_SINK_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_DEVICE_AUDIO_SINK_HPP_
+
+#include <media_minion/player/audio_sink.hpp>
+
+#include <gbAudio/AudioDevice.hpp>
+#include <gbAudio/Buffer.hpp>
+#include <gbAudio/QueuedSource.hpp>
+
+#include <vector>
+
+namespace media_minion::player {
+
+/** Plays back through the default audio device.
+ */
+class DeviceAudioSink : public AudioSink {
+private:
+    GhulbusAudio::AudioDevicePtr m_device;
+    std::vector<GhulbusAudio::BufferPtr> m_buffers;
+    std::vector<GhulbusAudio::Buffer*> m_freeBuffers;
+    GhulbusAudio::QueuedSourcePtr m_source;
+public:
+    explicit DeviceAudioSink(std::size_t buffer_count);
+
+    DeviceAudioSink(DeviceAudioSink const&) = delete;
+    DeviceAudioSink& operator=(DeviceAudioSink const&) = delete;
+
+    std::size_t getCapacity() const override;
+    bool isRealTime() const override;
+
+    void enqueue(GhulbusAudio::DataVariant const& data) override;
+
+    void play() override;
+    void pause() override;
+    void stop() override;
+    void clear() override;
+    void pump() override;
+private:
+    GhulbusAudio::QueuedSource::BufferAction refillBuffer(GhulbusAudio::Buffer& b);
+};
+
+}
+#endif
@@ -1,6 +1,12 @@
 #include <media_minion/player/ffmpeg_stream.hpp>
 
-#include <media_minion/common/result.hpp>
+#include <media_minion/player/http_range_io_context.hpp>
+#include <media_minion/player/media_io_context.hpp>
+#include <media_minion/player/probe_info.hpp>
+#include <media_minion/player/seek_table.hpp>
+#include <media_minion/player/telemetry.hpp>
+
+#include <media_minion/common/file_signature.hpp>
 
 #include <gbBase/Log.hpp>
 #include <gbBase/Finally.hpp>
@@ -19,10 +25,15 @@ extern "C" {
 #endif
 
 #include <algorithm>
-#include <fstream>
+#include <cctype>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <variant>
 
 namespace {
 void ffmpegLogHandler(void* avcl, int level, char const* fmt, va_list vl)
@@ -67,209 +78,48 @@ std::string translateErrorCode(int ec)
     return std::string(buffer);
 }
 
-class StreamIOContext {
-private:
-    std::istream& m_fin;
-    std::unique_ptr<unsigned char, void(*)(void*)> m_io_buffer;
-    std::unique_ptr<AVIOContext, void(*)(AVIOContext*)> m_io_context_storage;
-public:
-    StreamIOContext(std::istream& stream, std::size_t buffer_size);
-    AVIOContext* getContext() const;
-private:
-    static int static_io_read_packet(void* fstr, uint8_t* buf, int buf_size);
-    static int64_t static_io_seek(void* fstr, int64_t offset, int whence);
-    int io_read_packet(uint8_t* buf, int buf_size);
-    int64_t io_seek(int64_t offset, int whence);
-};
-
-StreamIOContext::StreamIOContext(std::istream& stream, std::size_t buffer_size)
-    :m_fin(stream),
-    m_io_buffer(static_cast<unsigned char*>(av_malloc(buffer_size)), [](void*) { /* will be freed by the io_context */ }),
-    m_io_context_storage(avio_alloc_context(m_io_buffer.get(), static_cast<int>(buffer_size), 0, this,
-        StreamIOContext::static_io_read_packet, nullptr,
-        StreamIOContext::static_io_seek),
-        [](AVIOContext* ctx) { av_free(ctx->buffer); av_free(ctx); })
-{
-}
-
-AVIOContext* StreamIOContext::getContext() const
-{
-    return m_io_context_storage.get();
-}
-
-int StreamIOContext::static_io_read_packet(void* fstr, uint8_t* buf, int buf_size)
-{
-    if (buf_size == 0) { return 0; }
-    auto* self = static_cast<StreamIOContext*>(fstr);
-    return self->io_read_packet(buf, buf_size);
-};
-
-int StreamIOContext::io_read_packet(uint8_t* buf, int buf_size)
+bool isSupportedSampleFormat(AVSampleFormat format)
 {
-    m_fin.read(reinterpret_cast<char*>(buf), buf_size);
-    if (m_fin.fail() && !m_fin.eof()) {
-        return -1;
-    }
-    int ret = static_cast<int>(m_fin.gcount());
-    return ret;
+    return (format == AV_SAMPLE_FMT_S16P) || (format == AV_SAMPLE_FMT_S32) || (format == AV_SAMPLE_FMT_FLTP);
 }
 
-int64_t StreamIOContext::static_io_seek(void* fstr, int64_t offset, int whence)
+/** Converts the frames [offset, offset + dst.size()) of a decoded frame straight into the caller's buffer.
+ * @pre format is supported.
+ */
+void convertFrames(AVFrame const& frame, AVSampleFormat format, std::size_t offset,
+                   std::span<media_minion::player::PlaybackSample> dst)
 {
-    auto* self = static_cast<StreamIOContext*>(fstr);
-    return self->io_seek(offset, whence);
-};
-
-int64_t StreamIOContext::io_seek(int64_t offset, int whence)
-{
-    int64_t ret;
-    switch (whence)
+    switch (format)
     {
-    case SEEK_SET:
-        m_fin.seekg(offset, std::ios_base::beg);
-        ret = m_fin.tellg();
-        break;
-    case SEEK_CUR:
-        m_fin.seekg(offset, std::ios_base::cur);
-        ret = m_fin.tellg();
-        break;
-    case SEEK_END:
-        m_fin.seekg(offset, std::ios_base::end);
-        ret = m_fin.tellg();
-        break;
-    case AVSEEK_SIZE:
-    {
-        auto pos = m_fin.tellg();
-        m_fin.seekg(0, std::ios_base::end);
-        auto pos_end = m_fin.tellg();
-        m_fin.seekg(0, std::ios_base::beg);
-        auto fsize = pos_end - m_fin.tellg();
-        m_fin.seekg(pos);
-        ret = fsize;
-    } break;
-    default:
-        GHULBUS_UNREACHABLE_MESSAGE("Invalid whence token in seek.");
-    }
-    if (m_fin.fail()) { return -1; }
-    return ret;
-}
-
-media_minion::Result<GhulbusAudio::DataStereo16Bit> decode_frame_s16p(AVCodecContext* codec_context, AVFrame* frame)
-{
-    GHULBUS_PRECONDITION(codec_context->sample_rate > 0);
-    GhulbusAudio::DataStereo16Bit audio_data{ static_cast<uint32_t>(codec_context->sample_rate) };
-    for (;;) {
-        int res = avcodec_receive_frame(codec_context, frame);
-        if (res != 0) {
-            if (res == AVERROR(EAGAIN)) {
-                // everything we read before was decoded; read more stuff and call send_packet again
-                break;
-            } else if (res == AVERROR_EOF) {
-                GHULBUS_LOG(Info, "Done decoding.");
-                break;
-            } else {
-                GHULBUS_LOG(Error, "Codec receive frame error: " << res);
-                return make_error_code(media_minion::errc::decode_error);
-            }
-        }
-        GHULBUS_ASSERT(av_get_bytes_per_sample(codec_context->sample_fmt) == sizeof(int16_t));
-        std::size_t const idx_base = audio_data.getNumberOfSamples();
-        audio_data.resize(audio_data.getNumberOfSamples() + frame->nb_samples);
-        for (int sample_idx = 0; sample_idx < frame->nb_samples; ++sample_idx) {
-            std::memcpy(&audio_data[idx_base+ sample_idx].left,
-                frame->extended_data[0] + sizeof(int16_t) * sample_idx, sizeof(int16_t));
-            std::memcpy(&audio_data[idx_base+ sample_idx].right,
-                frame->extended_data[1] + sizeof(int16_t) * sample_idx, sizeof(int16_t));
+    case AV_SAMPLE_FMT_S16P:
+        for (std::size_t i = 0; i < dst.size(); ++i) {
+            std::size_t const sample_idx = offset + i;
+            std::memcpy(&dst[i].left, frame.extended_data[0] + sizeof(int16_t) * sample_idx, sizeof(int16_t));
+            std::memcpy(&dst[i].right, frame.extended_data[1] + sizeof(int16_t) * sample_idx, sizeof(int16_t));
         }
-    }
-    return audio_data;
-}
-
-media_minion::Result<GhulbusAudio::DataStereo16Bit> decode_frame_s32(AVCodecContext* codec_context, AVFrame* frame)
-{
-    GHULBUS_PRECONDITION(codec_context->sample_rate > 0);
-    GhulbusAudio::DataStereo16Bit audio_data{ static_cast<uint32_t>(codec_context->sample_rate) };
-    for (;;) {
-        int res = avcodec_receive_frame(codec_context, frame);
-        if (res != 0) {
-            if (res == AVERROR(EAGAIN)) {
-                // everything we read before was decoded; read more stuff and call send_packet again
-                break;
-            } else if (res == AVERROR_EOF) {
-                GHULBUS_LOG(Info, "Done decoding.");
-                break;
-            } else {
-                GHULBUS_LOG(Error, "Codec receive frame error: " << res);
-                return make_error_code(media_minion::errc::decode_error);
-            }
-        }
-        GHULBUS_ASSERT(av_get_bytes_per_sample(codec_context->sample_fmt) == sizeof(int32_t));
-        std::size_t const idx_base = audio_data.getNumberOfSamples();
-        audio_data.resize(audio_data.getNumberOfSamples() + frame->nb_samples);
-        for (int sample_idx = 0; sample_idx < frame->nb_samples; ++sample_idx) {
+        break;
+    case AV_SAMPLE_FMT_S32:
+        for (std::size_t i = 0; i < dst.size(); ++i) {
             int32_t s[2];
-            std::memcpy(s, frame->extended_data[0] + sizeof(int32_t) * 2 * sample_idx, 2 * sizeof(int32_t));
-            audio_data[sample_idx].left = s[0] >> 16;
-            audio_data[sample_idx].right = s[1] >> 16;
-        }
-    }
-    return audio_data;
-}
-
-media_minion::Result<GhulbusAudio::DataStereo16Bit> decode_frame_flp(AVCodecContext* codec_context, AVFrame* frame)
-{
-    GHULBUS_PRECONDITION(codec_context->sample_rate > 0);
-    GhulbusAudio::DataStereo16Bit audio_data{ static_cast<uint32_t>(codec_context->sample_rate) };
-    for (;;) {
-        int res = avcodec_receive_frame(codec_context, frame);
-        if (res != 0) {
-            if (res == AVERROR(EAGAIN)) {
-                // everything we read before was decoded; read more stuff and call send_packet again
-                break;
-            } else if (res == AVERROR_EOF) {
-                GHULBUS_LOG(Info, "Done decoding.");
-                break;
-            } else {
-                GHULBUS_LOG(Error, "Codec receive frame error: " << res);
-                return make_error_code(media_minion::errc::decode_error);
-            }
+            std::memcpy(s, frame.extended_data[0] + sizeof(int32_t) * 2 * (offset + i), 2 * sizeof(int32_t));
+            dst[i].left = static_cast<int16_t>(s[0] >> 16);
+            dst[i].right = static_cast<int16_t>(s[1] >> 16);
         }
-        GHULBUS_ASSERT(av_get_bytes_per_sample(codec_context->sample_fmt) == sizeof(float));
-        std::size_t const idx_base = audio_data.getNumberOfSamples();
-        audio_data.resize(audio_data.getNumberOfSamples() + frame->nb_samples);
-        for (int sample_idx = 0; sample_idx < frame->nb_samples; ++sample_idx) {
+        break;
+    case AV_SAMPLE_FMT_FLTP:
+        for (std::size_t i = 0; i < dst.size(); ++i) {
+            std::size_t const sample_idx = offset + i;
             float f1, f2;
-            std::memcpy(&f1, frame->extended_data[0] + sizeof(float) * sample_idx, sizeof(float));
+            std::memcpy(&f1, frame.extended_data[0] + sizeof(float) * sample_idx, sizeof(float));
             f1 = std::clamp(f1, -1.f, 1.f);
-            audio_data[idx_base + sample_idx].left =  static_cast<int16_t>(f1 * 32767.f);
-            std::memcpy(&f2, frame->extended_data[1] + sizeof(float) * sample_idx, sizeof(float));
+            dst[i].left = static_cast<int16_t>(f1 * 32767.f);
+            std::memcpy(&f2, frame.extended_data[1] + sizeof(float) * sample_idx, sizeof(float));
             f2 = std::clamp(f2, -1.f, 1.f);
-            audio_data[idx_base + sample_idx].right = static_cast<int16_t>(f2 * 32767.f);
+            dst[i].right = static_cast<int16_t>(f2 * 32767.f);
         }
-    }
-    return audio_data;
-}
-
-media_minion::Result<GhulbusAudio::DataVariant> decode_packet(AVFormatContext* format_context, AVPacket* packet,
-                                                              AVCodecContext* codec_context, AVFrame* frame)
-{
-    auto const packet_guard =
-        Ghulbus::finally([packet]() mutable { if (packet) { av_packet_unref(packet); } }); // capture by-value here! packet will
-                                                                                           // get overwritten by decode below
-    int res = avcodec_send_packet(codec_context, packet);
-    if (res != 0) {
-        GHULBUS_LOG(Error, "Codec send packet error: " << res);
-        return make_error_code(media_minion::errc::decode_error);
-    }
-
-    switch (codec_context->sample_fmt)
-    {
-    case AV_SAMPLE_FMT_S16P: MM_OUTCOME_PROPAGATE(decode_frame_s16p(codec_context, frame));
-    case AV_SAMPLE_FMT_S32:  MM_OUTCOME_PROPAGATE(decode_frame_s32(codec_context, frame));
-    case AV_SAMPLE_FMT_FLTP: MM_OUTCOME_PROPAGATE(decode_frame_flp(codec_context, frame));
+        break;
     default:
-        GHULBUS_LOG(Error, "Unrecognized sample format " << av_get_sample_fmt_name(codec_context->sample_fmt));
-        return make_error_code(media_minion::errc::decode_error);
+        GHULBUS_UNREACHABLE_MESSAGE("Unsupported sample format.");
     }
 }
 }
@@ -296,71 +146,149 @@ namespace media_minion::player {
 struct FfmpegStream::Pimpl {
     std::unique_ptr<AVFormatContext, void(*)(AVFormatContext*)> m_formatContextStorage;
     AVFormatContext* m_formatContext;
+    std::filesystem::path m_filepath;
     std::string m_filename;
-    std::ifstream m_fin;
-    StreamIOContext m_avIoContext;
+    FfmpegStreamOptions m_options;
+    std::unique_ptr<MediaIOContext> m_avIoContext;
     int m_avStreamIndex;
     std::unique_ptr<AVCodecContext, void(*)(AVCodecContext*)> m_avCodecContext;
     Ghulbus::AnyFinalizer m_guardCodecContextClose;
     std::unique_ptr<AVFrame, void(*)(AVFrame*)> m_avFrame;
     AVPacket m_avPacket;
-
-    Pimpl();
+    bool m_endOfStream;
+    std::optional<std::int64_t> m_positionFrames;       ///< index of the next decoded sample frame, if known
+    std::int64_t m_seekTargetFrames;                    ///< decoded frames before this index get discarded
+    std::optional<std::int64_t> m_endFrames;            ///< decoded frames from this index on are padding
+    bool m_isOpen;
+    std::optional<SeekTable> m_seekTable;
+    bool m_seekTableComplete;
+    bool m_recordSeekTable;
+    bool m_isRemote;
+    std::string m_cacheKey;                             ///< file signature key; empty if nothing gets cached
+    std::size_t m_frameOffset;                          ///< frames of m_avFrame before this were handed out
+    std::size_t m_frameEnd;                             ///< frames of m_avFrame from this on get discarded
+    std::chrono::microseconds m_packetDecodeTime;       ///< spent in the decoder on the current packet so far
+    bool m_packetSent;                                  ///< the decoder has not handed out all of a packet yet
+
+    Pimpl(std::filesystem::path const& filepath, FfmpegStreamOptions const& options);
 
     std::optional<int> findAudioStream();
-    std::unordered_map<std::string, std::string> getTrackInfo();
-    std::optional<GhulbusAudio::DataVariant> pull();
+    TrackInfo getTrackInfo() const;
+    std::size_t read(std::span<PlaybackSample> frames);
+    bool seek(std::chrono::microseconds position);
+    std::optional<std::chrono::microseconds> getDuration() const;
+private:
+    AVStream* getAudioStream() const;
+    std::int64_t getStartTimestamp() const;
+    std::int64_t timestampToFrames(std::int64_t ts) const;
+    std::filesystem::path getCachePath(char const* directory, char const* extension) const;
+    bool applyProbeInfo(ProbeInfo const& probe_info);
+    void storeProbeInfo(std::filesystem::path const& probe_info_path) const;
+    bool needsSeekTable() const;
+    std::filesystem::path getSeekTablePath() const;
+    void initializeSeekTable();
+    void onAudioPacket();
+    void onEndOfStream();
+    std::optional<std::int64_t> getExactLengthFrames() const;
+    bool receiveFrame();
+    bool sendNextPacket();
+    bool trimFrame();
 };
 
-FfmpegStream::Pimpl::Pimpl()
+FfmpegStream::Pimpl::Pimpl(std::filesystem::path const& filepath, FfmpegStreamOptions const& options)
     :m_formatContextStorage(avformat_alloc_context(), &avformat_free_context),
      m_formatContext(m_formatContextStorage.get()),
-     m_filename("D:/Media/Warpaint/The Fool (2010)/Warpaint - 01 Set Your Arms Down.mp3"),
-     m_fin(m_filename, std::ios_base::binary),
-     m_avIoContext(m_fin, 8192), m_avStreamIndex(0),
+     m_filepath(filepath),
+     m_filename(filepath.string()),
+     m_options(options),
+     m_avIoContext(openMediaIOContext(filepath, options.io_mode)), m_avStreamIndex(0),
      m_avCodecContext(nullptr, [](AVCodecContext* ctx) { avcodec_free_context(&ctx); }),
-     m_avFrame(av_frame_alloc(), [](AVFrame* f) { av_frame_free(&f); })
+     m_avFrame(av_frame_alloc(), [](AVFrame* f) { av_frame_free(&f); }),
+     m_endOfStream(true), m_seekTargetFrames(0), m_isOpen(false), m_seekTableComplete(false),
+     m_recordSeekTable(false), m_isRemote(parseHttpLocation(filepath.generic_string()).has_value()),
+     m_frameOffset(0), m_frameEnd(0), m_packetDecodeTime(0), m_packetSent(false)
 {
-    m_formatContext->pb = m_avIoContext.getContext();
+    av_init_packet(&m_avPacket);
+    m_avPacket.data = nullptr;
+    m_avPacket.size = 0;
+
+    // without custom io, ffmpeg will try to open the file by itself
+    if (m_avIoContext) { m_formatContext->pb = m_avIoContext->getContext(); }
 
     if (avformat_open_input(&m_formatContext, m_filename.c_str(), nullptr, nullptr) != 0) {
         GHULBUS_LOG(Error, "Error opening file '" << m_filename << "'.");
+        // avformat_open_input frees the context on failure
+        m_formatContextStorage.release();
+        m_formatContextStorage.reset(avformat_alloc_context());
+        m_formatContext = m_formatContextStorage.get();
+        return;
+    }
+
+    if (!m_options.cache_directory.empty() && !m_isRemote) {
+        if (auto const signature = getFileSignature(m_filepath); signature) { m_cacheKey = signature->toKey(); }
     }
 
-    if (avformat_find_stream_info(m_formatContext, nullptr) < 0) {
+    // probing reads ahead and decodes until all streams are understood; for a file that was probed before,
+    // the cached results get us to the first packet without any of that
+    std::optional<ProbeInfo> probe_info;
+    auto const probe_info_path = getCachePath("probe", ".mmpi");
+    if (!probe_info_path.empty()) {
+        probe_info = loadProbeInfo(probe_info_path);
+        if (probe_info && !applyProbeInfo(*probe_info)) {
+            GHULBUS_LOG(Warning, "Discarding stale probe info for '" << m_filename << "'.");
+            probe_info.reset();
+        }
+    }
+    if (!probe_info && (avformat_find_stream_info(m_formatContext, nullptr) < 0)) {
         GHULBUS_LOG(Error, "Error reading stream info.");
     }
 
-    auto const opt_stream_index = findAudioStream();
+    auto const opt_stream_index = probe_info ? std::optional<int>(probe_info->stream_index) : findAudioStream();
     if (!opt_stream_index) {
         GHULBUS_LOG(Error, "No audio stream found.");
+        return;
     }
     m_avStreamIndex = *opt_stream_index;
     AVStream* avstream = m_formatContext->streams[m_avStreamIndex];
+    if (m_options.decoder.discard_other_streams) {
+        for (unsigned int i = 0; i < m_formatContext->nb_streams; ++i) {
+            if (static_cast<int>(i) != m_avStreamIndex) { m_formatContext->streams[i]->discard = AVDISCARD_ALL; }
+        }
+    }
 
-    auto const length = std::chrono::seconds((avstream->duration / avstream->time_base.den) *
-                                             avstream->time_base.num);
     auto codec = avcodec_find_decoder(avstream->codecpar->codec_id);
     if (codec == 0) {
         GHULBUS_LOG(Error, "Invalid codec.");
+        return;
     }
 
     m_avCodecContext.reset(avcodec_alloc_context3(codec));
+    avcodec_parameters_to_context(m_avCodecContext.get(), avstream->codecpar);
+    m_avCodecContext->thread_count = static_cast<int>(m_options.decoder.thread_count);
+    switch (m_options.decoder.threading) {
+    case DecoderThreading::Frame:         m_avCodecContext->thread_type = FF_THREAD_FRAME; break;
+    case DecoderThreading::Slice:         m_avCodecContext->thread_type = FF_THREAD_SLICE; break;
+    case DecoderThreading::FrameAndSlice: m_avCodecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE; break;
+    }
     auto res = avcodec_open2(m_avCodecContext.get(), codec, nullptr);
     if (res != 0) {
         GHULBUS_LOG(Error, "Error opening codec: " << translateErrorCode(res));
+        return;
     }
     m_guardCodecContextClose = Ghulbus::finally([this]() { avcodec_close(m_avCodecContext.get()); });
-
-    av_init_packet(&m_avPacket);
-    m_avPacket.data = nullptr;
-    m_avPacket.size = 0;
-    while (av_read_frame(m_formatContext, &m_avPacket) == 0) {
-        if (m_avPacket.stream_index == m_avStreamIndex) {
-            break;
-        }
+    if (!isSupportedSampleFormat(m_avCodecContext->sample_fmt)) {
+        GHULBUS_LOG(Error, "Unrecognized sample format " << av_get_sample_fmt_name(m_avCodecContext->sample_fmt));
+        return;
     }
-    
+    if (!probe_info && !probe_info_path.empty()) { storeProbeInfo(probe_info_path); }
+
+    // encoder delay is cut by the decoder through the skip samples side data of the first packets;
+    // the padding at the end is only known implicitly through the exact length of the stream
+    m_endFrames = getExactLengthFrames();
+    m_endOfStream = false;
+    m_isOpen = true;
+
+    initializeSeekTable();
 }
 
 std::optional<int> FfmpegStream::Pimpl::findAudioStream()
@@ -378,20 +306,390 @@ std::optional<int> FfmpegStream::Pimpl::findAudioStream()
     return ret;
 }
 
-std::unordered_map<std::string, std::string> FfmpegStream::Pimpl::getTrackInfo()
+TrackInfo FfmpegStream::Pimpl::getTrackInfo() const
 {
-    std::unordered_map<std::string, std::string> ret;
-    AVDictionaryEntry* t = NULL;
-    while ((t = av_dict_get(m_formatContext->metadata, "", t, AV_DICT_IGNORE_SUFFIX)) != 0) {
-        ret.emplace(std::make_pair(t->key, t->value));
+    TrackInfo ret;
+    if (!m_isOpen) { return ret; }
+    ret.codec = avcodec_get_name(m_avCodecContext->codec_id);
+    ret.sampling_frequency = static_cast<std::uint32_t>(m_avCodecContext->sample_rate);
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(59, 24, 100)
+    ret.channels = static_cast<std::uint32_t>(m_avCodecContext->ch_layout.nb_channels);
+#else
+    ret.channels = static_cast<std::uint32_t>(m_avCodecContext->channels);
+#endif
+    if (m_endFrames) { ret.frames = static_cast<std::uint64_t>(*m_endFrames); }
+    ret.duration = getDuration();
+    // containers like ogg keep their tags with the stream instead of the file
+    for (AVDictionary const* metadata : { m_formatContext->metadata, getAudioStream()->metadata }) {
+        AVDictionaryEntry const* t = nullptr;
+        while ((t = av_dict_get(metadata, "", t, AV_DICT_IGNORE_SUFFIX)) != nullptr) {
+            std::string key = t->key;
+            std::transform(key.begin(), key.end(), key.begin(),
+                           [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+            ret.tags.try_emplace(std::move(key), t->value);
+        }
     }
     return ret;
 }
 
-std::optional<GhulbusAudio::DataVariant> FfmpegStream::Pimpl::pull()
+std::size_t FfmpegStream::Pimpl::read(std::span<PlaybackSample> frames)
 {
-    auto const data = decode_packet(m_formatContext, &m_avPacket, m_avCodecContext.get(), m_avFrame.get());
-    return data.has_value() ? std::make_optional(std::move(data).assume_value()) : std::nullopt;
+    std::size_t written = 0;
+    while (written < frames.size()) {
+        if (m_frameOffset == m_frameEnd) {
+            if (!receiveFrame()) { break; }
+            continue;
+        }
+        std::size_t const n = std::min(frames.size() - written, m_frameEnd - m_frameOffset);
+        convertFrames(*m_avFrame, m_avCodecContext->sample_fmt, m_frameOffset, frames.subspan(written, n));
+        m_frameOffset += n;
+        written += n;
+    }
+    return written;
+}
+
+bool FfmpegStream::Pimpl::receiveFrame()
+{
+    for (;;) {
+        Stopwatch decode_time;
+        int const res = avcodec_receive_frame(m_avCodecContext.get(), m_avFrame.get());
+        m_packetDecodeTime += decode_time.elapsed();
+        if (res == 0) {
+            if (trimFrame()) { return true; }
+            continue;
+        }
+        if (m_packetSent) {
+            // everything that was sent to the decoder came out; that is the time it took to decode the packet
+            if (m_options.telemetry) { m_options.telemetry->recordDecode(m_packetDecodeTime); }
+            m_packetDecodeTime = std::chrono::microseconds(0);
+            m_packetSent = false;
+        }
+        if (res == AVERROR_EOF) { return false; }
+        if (res != AVERROR(EAGAIN)) {
+            GHULBUS_LOG(Error, "Codec receive frame error: " << res);
+            m_endOfStream = true;
+            return false;
+        }
+        // a flushed decoder reports AVERROR_EOF once it is empty; only a failed flush ends up here
+        if (m_endOfStream || !sendNextPacket()) { return false; }
+    }
+}
+
+bool FfmpegStream::Pimpl::sendNextPacket()
+{
+    for (;;) {
+        Stopwatch read_time;
+        int const res = av_read_frame(m_formatContext, &m_avPacket);
+        if (m_options.telemetry) {
+            std::size_t const bytes_read = (res < 0) ? 0 : static_cast<std::size_t>(m_avPacket.size);
+            m_options.telemetry->recordRead(read_time.elapsed(), bytes_read, m_isRemote);
+        }
+        if (res < 0) {
+            if (res == AVERROR_EOF) {
+                onEndOfStream();
+            } else {
+                GHULBUS_LOG(Error, "Error reading from '" << m_filename << "': " << translateErrorCode(res));
+            }
+            m_endOfStream = true;
+        } else if (m_avPacket.stream_index != m_avStreamIndex) {
+            av_packet_unref(&m_avPacket);
+            continue;
+        } else {
+            onAudioPacket();
+        }
+
+        // a nullptr packet flushes the remaining frames out of the decoder
+        Stopwatch decode_time;
+        int const send_res = avcodec_send_packet(m_avCodecContext.get(), m_endOfStream ? nullptr : &m_avPacket);
+        m_packetDecodeTime += decode_time.elapsed();
+        if (!m_endOfStream) { av_packet_unref(&m_avPacket); }
+        if (send_res != 0) {
+            GHULBUS_LOG(Error, "Codec send packet error: " << send_res);
+            m_endOfStream = true;
+            return false;
+        }
+        m_packetSent = true;
+        return true;
+    }
+}
+
+bool FfmpegStream::Pimpl::seek(std::chrono::microseconds position)
+{
+    if (!m_isOpen) { return false; }
+    AVStream* avstream = getAudioStream();
+    std::int64_t const start_ts = getStartTimestamp();
+    std::int64_t const target_ts = start_ts + av_rescale_q(position.count(), AVRational{ 1, 1'000'000 },
+                                                           avstream->time_base);
+    // a seek interrupts the linear read; the table would have holes
+    m_recordSeekTable = false;
+
+    std::optional<SeekTable::Entry> table_entry;
+    if (m_seekTable && m_seekTableComplete) {
+        // land a bit in front of the target, so that decoders with a bit reservoir (mp3) can prime themselves
+        std::int64_t const preroll = av_rescale_q(100'000, AVRational{ 1, 1'000'000 }, avstream->time_base);
+        table_entry = m_seekTable->findEntry(target_ts - preroll);
+    }
+
+    int res;
+    if (table_entry) {
+        res = av_seek_frame(m_formatContext, m_avStreamIndex, table_entry->byte_offset, AVSEEK_FLAG_BYTE);
+        m_positionFrames = timestampToFrames(table_entry->timestamp);
+    } else {
+        res = av_seek_frame(m_formatContext, m_avStreamIndex, target_ts, AVSEEK_FLAG_BACKWARD);
+        // the timestamp of the next packet tells us where we actually ended up
+        m_positionFrames.reset();
+    }
+    if (res < 0) {
+        GHULBUS_LOG(Error, "Error seeking in '" << m_filename << "': " << translateErrorCode(res));
+        return false;
+    }
+
+    avcodec_flush_buffers(m_avCodecContext.get());
+    m_frameOffset = 0;
+    m_frameEnd = 0;
+    m_packetDecodeTime = std::chrono::microseconds(0);
+    m_packetSent = false;
+    m_endOfStream = false;
+    m_seekTargetFrames = timestampToFrames(target_ts);
+    return true;
+}
+
+std::optional<std::chrono::microseconds> FfmpegStream::Pimpl::getDuration() const
+{
+    if (!m_isOpen) { return std::nullopt; }
+    AVStream const* avstream = getAudioStream();
+    if (avstream->duration != AV_NOPTS_VALUE) {
+        return std::chrono::microseconds(av_rescale_q(avstream->duration, avstream->time_base,
+                                                      AVRational{ 1, 1'000'000 }));
+    } else if (m_formatContext->duration != AV_NOPTS_VALUE) {
+        return std::chrono::microseconds(av_rescale(m_formatContext->duration, 1'000'000, AV_TIME_BASE));
+    }
+    return std::nullopt;
+}
+
+AVStream* FfmpegStream::Pimpl::getAudioStream() const
+{
+    return m_formatContext->streams[m_avStreamIndex];
+}
+
+std::int64_t FfmpegStream::Pimpl::getStartTimestamp() const
+{
+    AVStream const* avstream = getAudioStream();
+    return (avstream->start_time != AV_NOPTS_VALUE) ? avstream->start_time : 0;
+}
+
+std::int64_t FfmpegStream::Pimpl::timestampToFrames(std::int64_t ts) const
+{
+    GHULBUS_PRECONDITION(m_avCodecContext->sample_rate > 0);
+    return av_rescale_q(ts - getStartTimestamp(), getAudioStream()->time_base,
+                        AVRational{ 1, m_avCodecContext->sample_rate });
+}
+
+bool FfmpegStream::Pimpl::needsSeekTable() const
+{
+    // formats whose native seeking has to guess from the average bitrate
+    std::string_view const format_name = m_formatContext->iformat->name;
+    if (format_name == "aac") { return true; }
+    if (format_name == "mp3") {
+        // no Xing/VBRI header; for VBR files this means no TOC either
+        return m_formatContext->duration_estimation_method == AVFMT_DURATION_FROM_BITRATE;
+    }
+    return false;
+}
+
+std::filesystem::path FfmpegStream::Pimpl::getCachePath(char const* directory, char const* extension) const
+{
+    if (m_cacheKey.empty()) { return {}; }
+    return m_options.cache_directory / directory / (m_cacheKey + extension);
+}
+
+bool FfmpegStream::Pimpl::applyProbeInfo(ProbeInfo const& probe_info)
+{
+    // the cache key already ties the info to this version of the file; this guards against changes in the demuxer
+    if ((probe_info.library_version != LIBAVFORMAT_VERSION_INT) ||
+        (probe_info.stream_count != m_formatContext->nb_streams) || (probe_info.stream_index < 0) ||
+        (static_cast<unsigned int>(probe_info.stream_index) >= m_formatContext->nb_streams))
+    {
+        return false;
+    }
+    AVStream* avstream = m_formatContext->streams[probe_info.stream_index];
+    AVCodecParameters* codecpar = avstream->codecpar;
+    if ((codecpar->codec_type != AVMEDIA_TYPE_AUDIO) ||
+        (codecpar->codec_id != static_cast<AVCodecID>(probe_info.codec_id)) ||
+        (avstream->time_base.num != probe_info.time_base_num) || (avstream->time_base.den != probe_info.time_base_den))
+    {
+        return false;
+    }
+
+    if (!probe_info.extradata.empty()) {
+        auto extradata = static_cast<std::uint8_t*>(av_mallocz(probe_info.extradata.size() +
+                                                               AV_INPUT_BUFFER_PADDING_SIZE));
+        if (!extradata) { return false; }
+        std::memcpy(extradata, probe_info.extradata.data(), probe_info.extradata.size());
+        av_freep(&codecpar->extradata);
+        codecpar->extradata = extradata;
+        codecpar->extradata_size = static_cast<int>(probe_info.extradata.size());
+    }
+    codecpar->format = probe_info.sample_format;
+    codecpar->sample_rate = probe_info.sampling_frequency;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(59, 24, 100)
+    av_channel_layout_uninit(&codecpar->ch_layout);
+    if (probe_info.channel_mask != 0) {
+        av_channel_layout_from_mask(&codecpar->ch_layout, probe_info.channel_mask);
+    } else {
+        codecpar->ch_layout.order = AV_CHANNEL_ORDER_UNSPEC;
+        codecpar->ch_layout.nb_channels = probe_info.channels;
+    }
+#else
+    codecpar->channels = probe_info.channels;
+    codecpar->channel_layout = probe_info.channel_mask;
+#endif
+    codecpar->bit_rate = probe_info.bit_rate;
+    codecpar->frame_size = probe_info.frame_size;
+    codecpar->block_align = probe_info.block_align;
+    codecpar->bits_per_coded_sample = probe_info.bits_per_coded_sample;
+    codecpar->bits_per_raw_sample = probe_info.bits_per_raw_sample;
+    codecpar->initial_padding = probe_info.initial_padding;
+    codecpar->trailing_padding = probe_info.trailing_padding;
+    avstream->start_time = probe_info.start_time;
+    avstream->duration = probe_info.duration;
+    m_formatContext->duration = probe_info.container_duration;
+    m_formatContext->duration_estimation_method =
+        static_cast<AVDurationEstimationMethod>(probe_info.duration_estimation_method);
+    return true;
+}
+
+void FfmpegStream::Pimpl::storeProbeInfo(std::filesystem::path const& probe_info_path) const
+{
+    AVStream const* avstream = getAudioStream();
+    AVCodecParameters const* codecpar = avstream->codecpar;
+    ProbeInfo probe_info;
+    probe_info.library_version = LIBAVFORMAT_VERSION_INT;
+    probe_info.stream_count = m_formatContext->nb_streams;
+    probe_info.stream_index = m_avStreamIndex;
+    probe_info.codec_id = codecpar->codec_id;
+    probe_info.sample_format = codecpar->format;
+    probe_info.sampling_frequency = codecpar->sample_rate;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(59, 24, 100)
+    probe_info.channels = codecpar->ch_layout.nb_channels;
+    probe_info.channel_mask = (codecpar->ch_layout.order == AV_CHANNEL_ORDER_NATIVE) ? codecpar->ch_layout.u.mask : 0;
+#else
+    probe_info.channels = codecpar->channels;
+    probe_info.channel_mask = codecpar->channel_layout;
+#endif
+    probe_info.bit_rate = codecpar->bit_rate;
+    probe_info.frame_size = codecpar->frame_size;
+    probe_info.block_align = codecpar->block_align;
+    probe_info.bits_per_coded_sample = codecpar->bits_per_coded_sample;
+    probe_info.bits_per_raw_sample = codecpar->bits_per_raw_sample;
+    probe_info.initial_padding = codecpar->initial_padding;
+    probe_info.trailing_padding = codecpar->trailing_padding;
+    probe_info.time_base_num = avstream->time_base.num;
+    probe_info.time_base_den = avstream->time_base.den;
+    probe_info.start_time = avstream->start_time;
+    probe_info.duration = avstream->duration;
+    probe_info.container_duration = m_formatContext->duration;
+    probe_info.duration_estimation_method = m_formatContext->duration_estimation_method;
+    if ((codecpar->extradata != nullptr) && (codecpar->extradata_size > 0)) {
+        probe_info.extradata.assign(codecpar->extradata, codecpar->extradata + codecpar->extradata_size);
+    }
+    if (saveProbeInfo(probe_info, probe_info_path)) {
+        GHULBUS_LOG(Trace, "Stored probe info for '" << m_filename << "'.");
+    }
+}
+
+std::filesystem::path FfmpegStream::Pimpl::getSeekTablePath() const
+{
+    return getCachePath("seek_tables", ".mmst");
+}
+
+void FfmpegStream::Pimpl::initializeSeekTable()
+{
+    if (!needsSeekTable()) { return; }
+    AVStream const* avstream = getAudioStream();
+    auto const seek_table_path = getSeekTablePath();
+    if (!seek_table_path.empty()) {
+        m_seekTable = SeekTable::load(seek_table_path);
+        if (m_seekTable && ((m_seekTable->getTimeBaseNum() != avstream->time_base.num) ||
+                            (m_seekTable->getTimeBaseDen() != avstream->time_base.den)))
+        {
+            GHULBUS_LOG(Warning, "Discarding stale seek table for '" << m_filename << "'.");
+            m_seekTable.reset();
+        }
+    }
+    if (m_seekTable) {
+        GHULBUS_LOG(Trace, "Using cached seek table with " << m_seekTable->size() << " entries for '" <<
+                           m_filename << "'.");
+        m_seekTableComplete = true;
+    } else {
+        // no usable index; build one while the stream gets read from start to end
+        m_seekTable.emplace(avstream->time_base.num, avstream->time_base.den);
+        m_recordSeekTable = true;
+    }
+}
+
+void FfmpegStream::Pimpl::onAudioPacket()
+{
+    std::int64_t const ts = (m_avPacket.pts != AV_NOPTS_VALUE) ? m_avPacket.pts : m_avPacket.dts;
+    if (ts == AV_NOPTS_VALUE) { return; }
+    if (!m_positionFrames) {
+        m_positionFrames = timestampToFrames(ts);
+    }
+    if (m_recordSeekTable) {
+        m_seekTable->addPacket(ts, m_avPacket.pos);
+    }
+}
+
+void FfmpegStream::Pimpl::onEndOfStream()
+{
+    if (!m_recordSeekTable) { return; }
+    m_recordSeekTable = false;
+    m_seekTableComplete = true;
+    auto const seek_table_path = getSeekTablePath();
+    if (!seek_table_path.empty() && m_seekTable->save(seek_table_path)) {
+        GHULBUS_LOG(Trace, "Stored seek table with " << m_seekTable->size() << " entries for '" <<
+                           m_filename << "'.");
+    }
+}
+
+std::optional<std::int64_t> FfmpegStream::Pimpl::getExactLengthFrames() const
+{
+    // durations guessed from the bitrate or from the last timestamp are not sample accurate
+    AVStream const* avstream = getAudioStream();
+    if ((m_formatContext->duration_estimation_method != AVFMT_DURATION_FROM_STREAM) ||
+        (avstream->duration == AV_NOPTS_VALUE) || (avstream->duration <= 0))
+    {
+        return std::nullopt;
+    }
+    return av_rescale_q(avstream->duration, avstream->time_base, AVRational{ 1, m_avCodecContext->sample_rate });
+}
+
+bool FfmpegStream::Pimpl::trimFrame()
+{
+    std::size_t const n_frames = static_cast<std::size_t>(std::max(m_avFrame->nb_samples, 0));
+    m_frameOffset = 0;
+    m_frameEnd = n_frames;
+    if (n_frames == 0) { return false; }
+    if (!m_positionFrames) { return true; }
+
+    std::int64_t const position = *m_positionFrames;
+    std::int64_t const end_position = position + static_cast<std::int64_t>(n_frames);
+    *m_positionFrames = end_position;
+    if (m_endFrames && (end_position > *m_endFrames)) {
+        if (position >= *m_endFrames) {
+            m_frameEnd = 0;
+            return false;
+        }
+        m_frameEnd -= static_cast<std::size_t>(end_position - *m_endFrames);
+    }
+    if (position >= m_seekTargetFrames) { return true; }
+    std::int64_t const to_drop = m_seekTargetFrames - position;
+    if (to_drop >= static_cast<std::int64_t>(m_frameEnd)) {
+        m_frameEnd = 0;
+        return false;
+    }
+    m_frameOffset = static_cast<std::size_t>(to_drop);
+    return true;
 }
 
 void FfmpegStream::initializeFfmpeg()
@@ -399,8 +697,13 @@ void FfmpegStream::initializeFfmpeg()
     av_log_set_callback(ffmpegLogHandler);
 }
 
-FfmpegStream::FfmpegStream()
-    :m_pimpl(std::make_unique<Pimpl>())
+FfmpegStream::FfmpegStream(std::filesystem::path const& filepath)
+    :FfmpegStream(filepath, FfmpegStreamOptions{})
+{
+}
+
+FfmpegStream::FfmpegStream(std::filesystem::path const& filepath, FfmpegStreamOptions const& options)
+    :m_pimpl(std::make_unique<Pimpl>(filepath, options))
 {
 }
 
@@ -408,9 +711,52 @@ FfmpegStream::~FfmpegStream()
 {
 }
 
-std::optional<GhulbusAudio::DataVariant> FfmpegStream::pull()
+bool FfmpegStream::hasAudioFileExtension(std::filesystem::path const& filepath)
+{
+    static std::unordered_set<std::string> const extensions = {
+        ".aac", ".aif", ".aiff", ".ape", ".flac", ".m4a", ".mka", ".mp2", ".mp3", ".mpc", ".oga", ".ogg", ".opus",
+        ".wav", ".wma", ".wv",
+    };
+    std::string ext = filepath.extension().string();
+    std::transform(begin(ext), end(ext), begin(ext), [](char c) { return static_cast<char>(std::tolower(c)); });
+    return extensions.count(ext) > 0;
+}
+
+bool FfmpegStream::isOpen() const
+{
+    return m_pimpl->m_isOpen;
+}
+
+std::uint32_t FfmpegStream::getSamplingFrequency() const
+{
+    if (!m_pimpl->m_isOpen) { return 0; }
+    return static_cast<std::uint32_t>(m_pimpl->m_avCodecContext->sample_rate);
+}
+
+std::size_t FfmpegStream::read(std::span<PlaybackSample> frames)
+{
+    return m_pimpl->read(frames);
+}
+
+bool FfmpegStream::seek(std::chrono::microseconds position)
+{
+    return m_pimpl->seek(position);
+}
+
+std::optional<std::chrono::microseconds> FfmpegStream::getDuration() const
+{
+    return m_pimpl->getDuration();
+}
+
+TrackInfo FfmpegStream::getTrackInfo() const
+{
+    return m_pimpl->getTrackInfo();
+}
+
+std::string FfmpegStream::getCodecName() const
 {
-    return m_pimpl->pull();
+    if (!m_pimpl->m_isOpen) { return std::string{}; }
+    return avcodec_get_name(m_pimpl->m_avCodecContext->codec_id);
 }
 
 }
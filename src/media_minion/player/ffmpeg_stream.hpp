@@ -1,24 +1,75 @@
 #ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_FFMPEG_STREAM_HPP_
 #define MEDIA_MINION_INCLUDE_GUARD_PLAYER_FFMPEG_STREAM_HPP_
 
+#include <media_minion/player/decoder_options.hpp>
+#include <media_minion/player/media_io_context.hpp>
+#include <media_minion/player/media_source.hpp>
+#include <media_minion/player/track_info.hpp>
+
 #include <gbAudio/Data.hpp>
 
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
 #include <memory>
 #include <optional>
+#include <string>
 
 namespace media_minion::player {
 
-class FfmpegStream {
+class Telemetry;
+
+struct FfmpegStreamOptions {
+    IOMode io_mode = IOMode::MemoryMapped;
+    /** Directory for persisted per-file data (probe results, seek tables). Empty to disable persisting.
+     */
+    std::filesystem::path cache_directory;
+    /** Receives read and decode timings; optional.
+     */
+    Telemetry* telemetry = nullptr;
+    DecoderOptions decoder;
+};
+
+class FfmpegStream : public PlaybackSource {
 private:
     struct Pimpl;
     std::unique_ptr<Pimpl> m_pimpl;
 public:
     static void initializeFfmpeg();
 
-    FfmpegStream();
-    ~FfmpegStream();
+    /** Cheap check for library scans, so that cover art and playlists do not have to be opened.
+     */
+    static bool hasAudioFileExtension(std::filesystem::path const& filepath);
+
+    explicit FfmpegStream(std::filesystem::path const& filepath);
+    FfmpegStream(std::filesystem::path const& filepath, FfmpegStreamOptions const& options);
+    ~FfmpegStream() override;
+
+    /** False if the file could not be opened or contains no decodable audio; read() then returns nothing.
+     */
+    bool isOpen() const;
+
+    std::uint32_t getSamplingFrequency() const override;
+
+    /** Decodes packets as needed and converts the decoded frames straight into frames.
+     */
+    std::size_t read(std::span<PlaybackSample> frames) override;
+
+    /** Repositions the stream so that the next read() starts with the sample at position.
+     * Positions past the end of the stream leave the stream at its end.
+     * @return true if successful; on failure the stream position is unspecified.
+     */
+    bool seek(std::chrono::microseconds position) override;
+
+    std::optional<std::chrono::microseconds> getDuration() const override;
+
+    /** Short name of the audio codec, like "mp3" or "flac"; empty if the stream is not open.
+     */
+    std::string getCodecName() const;
 
-    std::optional<GhulbusAudio::DataVariant> pull();
+    /** Format, length and tags as found by libavformat; readTrackInfo() gets the same from most files cheaper.
+     */
+    TrackInfo getTrackInfo() const;
 };
 
 }
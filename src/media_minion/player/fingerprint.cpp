@@ -0,0 +1,416 @@
+#include <media_minion/player/fingerprint.hpp>
+
+#include <media_minion/common/binary_io.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numbers>
+#include <type_traits>
+#include <variant>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   define MEDIA_MINION_FINGERPRINT_USE_SSE2
+#   include <emmintrin.h>
+#endif
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::array<char, 4> g_fingerprintMagic = { 'M', 'M', 'F', 'P' };
+constexpr std::uint32_t g_fingerprintVersion = 1;
+
+constexpr std::size_t g_chromaBins = 12;
+constexpr double g_minChromaFrequency = 28.0;
+constexpr double g_maxChromaFrequency = 3520.0;
+constexpr double g_lowpassCutoffFrequency = 4800.0;
+constexpr int g_lowpassHalfLength = 16;
+constexpr int g_smoothingRadius = 2;
+constexpr int g_minOverlap = 40;                ///< about 5 seconds
+constexpr std::size_t g_readFrames = 16384;
+
+using Chroma = std::array<float, g_chromaBins>;
+
+/** Radix-2 complex FFT on split real and imaginary arrays.
+ * With split arrays, four butterflies of the same stage map directly onto one SSE register.
+ */
+class Fft {
+private:
+    std::size_t m_size;
+    std::vector<std::uint32_t> m_bitReversed;
+    std::vector<float> m_twiddleRe;     ///< twiddles for a stage of half size h start at index h - 1
+    std::vector<float> m_twiddleIm;
+public:
+    explicit Fft(std::size_t size)
+        :m_size(size), m_bitReversed(size), m_twiddleRe(size - 1), m_twiddleIm(size - 1)
+    {
+        int const bits = std::countr_zero(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            std::uint32_t r = 0;
+            for (int b = 0; b < bits; ++b) { r |= ((i >> b) & 1u) << (bits - 1 - b); }
+            m_bitReversed[i] = r;
+        }
+        for (std::size_t half = 1; half < size; half *= 2) {
+            for (std::size_t j = 0; j < half; ++j) {
+                double const phi = -std::numbers::pi * static_cast<double>(j) / static_cast<double>(half);
+                m_twiddleRe[half - 1 + j] = static_cast<float>(std::cos(phi));
+                m_twiddleIm[half - 1 + j] = static_cast<float>(std::sin(phi));
+            }
+        }
+    }
+
+    void transform(std::vector<float>& re, std::vector<float>& im) const
+    {
+        for (std::size_t i = 0; i < m_size; ++i) {
+            std::size_t const r = m_bitReversed[i];
+            if (i < r) {
+                std::swap(re[i], re[r]);
+                std::swap(im[i], im[r]);
+            }
+        }
+        for (std::size_t half = 1; half < m_size; half *= 2) {
+            float const* wr = m_twiddleRe.data() + half - 1;
+            float const* wi = m_twiddleIm.data() + half - 1;
+            for (std::size_t block = 0; block < m_size; block += 2 * half) {
+                float* are = re.data() + block;
+                float* aim = im.data() + block;
+                float* bre = are + half;
+                float* bim = aim + half;
+                std::size_t j = 0;
+#ifdef MEDIA_MINION_FINGERPRINT_USE_SSE2
+                for (; j + 4 <= half; j += 4) {
+                    __m128 const vwr = _mm_loadu_ps(wr + j);
+                    __m128 const vwi = _mm_loadu_ps(wi + j);
+                    __m128 const vbre = _mm_loadu_ps(bre + j);
+                    __m128 const vbim = _mm_loadu_ps(bim + j);
+                    __m128 const tre = _mm_sub_ps(_mm_mul_ps(vbre, vwr), _mm_mul_ps(vbim, vwi));
+                    __m128 const tim = _mm_add_ps(_mm_mul_ps(vbre, vwi), _mm_mul_ps(vbim, vwr));
+                    __m128 const vare = _mm_loadu_ps(are + j);
+                    __m128 const vaim = _mm_loadu_ps(aim + j);
+                    _mm_storeu_ps(bre + j, _mm_sub_ps(vare, tre));
+                    _mm_storeu_ps(bim + j, _mm_sub_ps(vaim, tim));
+                    _mm_storeu_ps(are + j, _mm_add_ps(vare, tre));
+                    _mm_storeu_ps(aim + j, _mm_add_ps(vaim, tim));
+                }
+#endif
+                for (; j < half; ++j) {
+                    float const tre = bre[j] * wr[j] - bim[j] * wi[j];
+                    float const tim = bre[j] * wi[j] + bim[j] * wr[j];
+                    bre[j] = are[j] - tre;
+                    bim[j] = aim[j] - tim;
+                    are[j] += tre;
+                    aim[j] += tim;
+                }
+            }
+        }
+    }
+};
+}
+
+struct FingerprintCalculator::Pimpl {
+    std::uint32_t m_inputFrequency;
+    double m_resampleStep;
+    double m_resamplePosition;              ///< in samples of m_input
+    std::vector<float> m_lowpass;
+    std::vector<float> m_input;             ///< downmixed, at the input sampling frequency
+    std::vector<float> m_resampled;         ///< samples not yet covered by a complete frame
+    std::uint64_t m_resampledTotal;
+    bool m_isDone;
+
+    Fft m_fft;
+    std::vector<float> m_window;
+    std::vector<int> m_chromaIndex;         ///< per fft bin; -1 for bins outside of the chroma range
+    std::vector<float> m_frameRe;
+    std::vector<float> m_frameIm;
+    std::vector<Chroma> m_chroma;
+
+    Pimpl();
+
+    template<typename SampleType>
+    bool process(std::span<SampleType const> frames, std::uint32_t sampling_frequency);
+    void setInputFrequency(std::uint32_t sampling_frequency);
+    void resample();
+    void processFrame();
+    Fingerprint finish();
+};
+
+FingerprintCalculator::Pimpl::Pimpl()
+    :m_inputFrequency(0), m_resampleStep(1.0), m_resamplePosition(g_lowpassHalfLength), m_resampledTotal(0),
+     m_isDone(false), m_fft(Fingerprint::frame_size), m_window(Fingerprint::frame_size),
+     m_chromaIndex(Fingerprint::frame_size / 2 + 1, -1), m_frameRe(Fingerprint::frame_size),
+     m_frameIm(Fingerprint::frame_size)
+{
+    for (std::size_t i = 0; i < Fingerprint::frame_size; ++i) {
+        m_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * static_cast<double>(i) /
+                                                              static_cast<double>(Fingerprint::frame_size - 1)));
+    }
+    for (std::size_t k = 1; k < m_chromaIndex.size(); ++k) {
+        double const frequency = static_cast<double>(k * Fingerprint::sampling_frequency) /
+                                 static_cast<double>(Fingerprint::frame_size);
+        if ((frequency < g_minChromaFrequency) || (frequency > g_maxChromaFrequency)) { continue; }
+        long const midi_note = std::lround(12.0 * std::log2(frequency / 440.0) + 69.0);
+        m_chromaIndex[k] = static_cast<int>(midi_note % static_cast<long>(g_chromaBins));
+    }
+}
+
+void FingerprintCalculator::Pimpl::setInputFrequency(std::uint32_t sampling_frequency)
+{
+    m_inputFrequency = sampling_frequency;
+    m_resampleStep = static_cast<double>(sampling_frequency) / static_cast<double>(Fingerprint::sampling_frequency);
+    // windowed sinc; the cutoff sits below the output nyquist frequency to keep aliasing out of the chroma range
+    double const cutoff = std::min(g_lowpassCutoffFrequency / static_cast<double>(sampling_frequency), 0.45);
+    m_lowpass.resize(2 * g_lowpassHalfLength + 1);
+    double sum = 0.0;
+    for (int n = -g_lowpassHalfLength; n <= g_lowpassHalfLength; ++n) {
+        double const x = 2.0 * cutoff * n;
+        double const sinc = (n == 0) ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+        double const w = 0.42 + 0.5 * std::cos(std::numbers::pi * n / g_lowpassHalfLength) +
+                         0.08 * std::cos(2.0 * std::numbers::pi * n / g_lowpassHalfLength);
+        double const h = 2.0 * cutoff * sinc * w;
+        m_lowpass[n + g_lowpassHalfLength] = static_cast<float>(h);
+        sum += h;
+    }
+    for (auto& h : m_lowpass) { h = static_cast<float>(h / sum); }
+    m_input.assign(g_lowpassHalfLength, 0.0f);
+}
+
+template<typename SampleType>
+bool FingerprintCalculator::Pimpl::process(std::span<SampleType const> frames, std::uint32_t sampling_frequency)
+{
+    if (m_isDone) { return false; }
+    if (frames.empty()) { return true; }
+    if (m_inputFrequency == 0) { setInputFrequency(sampling_frequency); }
+    using Traits = SampleTraits<SampleType>;
+    auto const* const values = reinterpret_cast<typename Traits::ValueType const*>(frames.data());
+    std::size_t const offset = m_input.size();
+    m_input.resize(offset + frames.size());
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        int sum = 0;
+        for (std::size_t c = 0; c < Traits::channels; ++c) { sum += values[i * Traits::channels + c]; }
+        if constexpr (std::is_same_v<typename Traits::ValueType, std::uint8_t>) {
+            m_input[offset + i] = static_cast<float>(sum - 128 * static_cast<int>(Traits::channels)) /
+                                  (128.0f * Traits::channels);
+        } else {
+            m_input[offset + i] = static_cast<float>(sum) / (32768.0f * Traits::channels);
+        }
+    }
+    resample();
+    while (!m_isDone && (m_resampled.size() >= Fingerprint::frame_size)) {
+        processFrame();
+        m_resampled.erase(m_resampled.begin(), m_resampled.begin() + Fingerprint::frame_step);
+    }
+    return !m_isDone;
+}
+
+void FingerprintCalculator::Pimpl::resample()
+{
+    // filter at the input rate and interpolate linearly between the two filtered samples around each output
+    auto const filteredAt = [this](std::size_t i) {
+        float acc = 0.0f;
+        float const* x = m_input.data() + i - g_lowpassHalfLength;
+        for (std::size_t k = 0; k < m_lowpass.size(); ++k) { acc += m_lowpass[k] * x[k]; }
+        return acc;
+    };
+    while (m_resamplePosition + 1.0 + g_lowpassHalfLength < static_cast<double>(m_input.size())) {
+        std::size_t const i = static_cast<std::size_t>(m_resamplePosition);
+        float const frac = static_cast<float>(m_resamplePosition - static_cast<double>(i));
+        float const y0 = filteredAt(i);
+        float const y1 = (frac > 0.0f) ? filteredAt(i + 1) : y0;
+        m_resampled.push_back(y0 + frac * (y1 - y0));
+        m_resamplePosition += m_resampleStep;
+    }
+    std::size_t const consumed =
+        std::min(static_cast<std::size_t>(m_resamplePosition), m_input.size()) - g_lowpassHalfLength;
+    m_input.erase(m_input.begin(), m_input.begin() + consumed);
+    m_resamplePosition -= static_cast<double>(consumed);
+}
+
+void FingerprintCalculator::Pimpl::processFrame()
+{
+    for (std::size_t i = 0; i < Fingerprint::frame_size; ++i) {
+        m_frameRe[i] = m_resampled[i] * m_window[i];
+        m_frameIm[i] = 0.0f;
+    }
+    m_fft.transform(m_frameRe, m_frameIm);
+
+    Chroma chroma{};
+    for (std::size_t k = 0; k < m_chromaIndex.size(); ++k) {
+        if (m_chromaIndex[k] < 0) { continue; }
+        chroma[m_chromaIndex[k]] += m_frameRe[k] * m_frameRe[k] + m_frameIm[k] * m_frameIm[k];
+    }
+    float norm = 0.0f;
+    for (float c : chroma) { norm += c * c; }
+    norm = std::sqrt(norm);
+    // silence gets an all-zero vector instead of amplified noise
+    for (float& c : chroma) { c = (norm > 1e-6f) ? (c / norm) : 0.0f; }
+    m_chroma.push_back(chroma);
+
+    m_resampledTotal += Fingerprint::frame_step;
+    std::uint64_t const max_samples =
+        static_cast<std::uint64_t>(Fingerprint::max_duration.count()) * Fingerprint::sampling_frequency;
+    if (m_resampledTotal >= max_samples) { m_isDone = true; }
+}
+
+Fingerprint FingerprintCalculator::Pimpl::finish()
+{
+    Fingerprint ret;
+    ret.duration = std::chrono::milliseconds(
+        static_cast<std::int64_t>((m_resampledTotal + m_resampled.size()) * 1000 / Fingerprint::sampling_frequency));
+    int const n_frames = static_cast<int>(m_chroma.size());
+    std::vector<Chroma> smoothed(m_chroma.size());
+    for (int t = 0; t < n_frames; ++t) {
+        int const first = std::max(t - g_smoothingRadius, 0);
+        int const last = std::min(t + g_smoothingRadius, n_frames - 1);
+        Chroma& s = smoothed[t];
+        s.fill(0.0f);
+        for (int u = first; u <= last; ++u) {
+            for (std::size_t b = 0; b < g_chromaBins; ++b) { s[b] += m_chroma[u][b]; }
+        }
+        for (float& c : s) { c /= static_cast<float>(last - first + 1); }
+    }
+
+    constexpr int time_distance = 2;
+    for (int t = time_distance; t < n_frames; ++t) {
+        Chroma const& s = smoothed[t];
+        Chroma const& p = smoothed[t - time_distance];
+        std::uint32_t hash = 0;
+        for (std::size_t b = 0; b < g_chromaBins; ++b) {
+            // neighbouring semitones and fifths
+            if (s[b] > s[(b + 1) % g_chromaBins]) { hash |= 1u << b; }
+            if (s[b] > s[(b + 7) % g_chromaBins]) { hash |= 1u << (12 + b); }
+        }
+        for (std::size_t b = 0; b < 8; ++b) {
+            if ((s[b] - p[b]) > (s[b + 4] - p[b + 4])) { hash |= 1u << (24 + b); }
+        }
+        ret.hashes.push_back(hash);
+    }
+    return ret;
+}
+
+FingerprintCalculator::FingerprintCalculator()
+    :m_pimpl(std::make_unique<Pimpl>())
+{
+}
+
+FingerprintCalculator::~FingerprintCalculator()
+{
+}
+
+bool FingerprintCalculator::process(GhulbusAudio::DataVariant const& data)
+{
+    return std::visit([this](auto const& d) {
+            using SampleType = std::decay_t<decltype(d[0])>;
+            std::size_t const n_frames = d.getNumberOfSamples();
+            if (n_frames == 0) { return m_pimpl->process(std::span<SampleType const>(), 0); }
+            return m_pimpl->process(std::span<SampleType const>(&d[0], n_frames), d.getSamplingFrequency());
+        }, data);
+}
+
+bool FingerprintCalculator::process(std::span<PlaybackSample const> frames, std::uint32_t sampling_frequency)
+{
+    return m_pimpl->process(frames, sampling_frequency);
+}
+
+Fingerprint FingerprintCalculator::finish()
+{
+    return m_pimpl->finish();
+}
+
+std::optional<Fingerprint> computeFingerprint(std::filesystem::path const& track, FfmpegStreamOptions const& options,
+                                              std::atomic<bool> const* cancel)
+{
+    FfmpegStream stream(track, options);
+    if (!stream.isOpen()) { return std::nullopt; }
+    FingerprintCalculator calculator;
+    std::vector<PlaybackSample> buffer(g_readFrames);
+    while (std::size_t const n_frames = stream.read(buffer)) {
+        if (cancel && *cancel) { return std::nullopt; }
+        if (!calculator.process(std::span<PlaybackSample const>(buffer.data(), n_frames),
+                                stream.getSamplingFrequency()))
+        {
+            break;
+        }
+    }
+    Fingerprint ret = calculator.finish();
+    if (ret.hashes.size() < static_cast<std::size_t>(g_minOverlap)) { return std::nullopt; }
+    if (auto const duration = stream.getDuration(); duration) {
+        ret.duration = std::chrono::duration_cast<std::chrono::milliseconds>(*duration);
+    }
+    return ret;
+}
+
+std::optional<FingerprintMatch> compareFingerprints(Fingerprint const& lhs, Fingerprint const& rhs,
+                                                    int offset, int max_offset_deviation)
+{
+    std::optional<FingerprintMatch> ret;
+    int const lhs_size = static_cast<int>(lhs.hashes.size());
+    int const rhs_size = static_cast<int>(rhs.hashes.size());
+    for (int o = offset - max_offset_deviation; o <= offset + max_offset_deviation; ++o) {
+        // lhs[i] is compared against rhs[i + o]
+        int const first = std::max(0, -o);
+        int const last = std::min(lhs_size, rhs_size - o);
+        if (last - first < g_minOverlap) { continue; }
+        std::uint64_t bit_errors = 0;
+        for (int i = first; i < last; ++i) {
+            bit_errors += std::popcount(lhs.hashes[i] ^ rhs.hashes[i + o]);
+        }
+        double const similarity = 1.0 - static_cast<double>(bit_errors) / (32.0 * (last - first));
+        if (!ret || (similarity > ret->similarity)) { ret = FingerprintMatch{ similarity, o }; }
+    }
+    return ret;
+}
+
+std::vector<unsigned char> serializeFingerprint(Fingerprint const& fingerprint)
+{
+    std::vector<unsigned char> ret;
+    ret.reserve(20 + 4 * fingerprint.hashes.size());
+    ret.insert(end(ret), begin(g_fingerprintMagic), end(g_fingerprintMagic));
+    writeLE(ret, g_fingerprintVersion, 4);
+    writeLE(ret, static_cast<std::uint64_t>(fingerprint.duration.count()), 8);
+    writeLE(ret, fingerprint.hashes.size(), 4);
+    for (auto const h : fingerprint.hashes) { writeLE(ret, h, 4); }
+    return ret;
+}
+
+std::optional<Fingerprint> deserializeFingerprint(unsigned char const* data, std::size_t size)
+{
+    unsigned char const* it = data;
+    unsigned char const* const end = data + size;
+    if ((size < g_fingerprintMagic.size()) ||
+        (std::memcmp(data, g_fingerprintMagic.data(), g_fingerprintMagic.size()) != 0))
+    {
+        return std::nullopt;
+    }
+    it += g_fingerprintMagic.size();
+    auto const version = readLE(it, end, 4);
+    if (!version || (*version != g_fingerprintVersion)) { return std::nullopt; }
+    auto const duration = readLE(it, end, 8);
+    auto const n_hashes = readLE(it, end, 4);
+    if (!duration || !n_hashes || (*n_hashes * 4 != static_cast<std::uint64_t>(end - it))) { return std::nullopt; }
+    Fingerprint ret;
+    ret.duration = std::chrono::milliseconds(static_cast<std::int64_t>(*duration));
+    ret.hashes.reserve(static_cast<std::size_t>(*n_hashes));
+    for (std::uint64_t i = 0; i < *n_hashes; ++i) {
+        ret.hashes.push_back(static_cast<std::uint32_t>(*readLE(it, end, 4)));
+    }
+    return ret;
+}
+
+bool saveFingerprint(Fingerprint const& fingerprint, std::filesystem::path const& filepath)
+{
+    std::vector<unsigned char> const buffer = serializeFingerprint(fingerprint);
+    return writeFileAtomically(filepath, buffer.data(), buffer.size());
+}
+
+std::optional<Fingerprint> loadFingerprint(std::filesystem::path const& filepath)
+{
+    std::ifstream fin(filepath, std::ios_base::binary);
+    if (!fin) { return std::nullopt; }
+    std::vector<unsigned char> buffer((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    return deserializeFingerprint(buffer.data(), buffer.size());
+}
+
+}
@@ -0,0 +1,84 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_FINGERPRINT_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_FINGERPRINT_HPP_
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/media_source.hpp>
+
+#include <gbAudio/Data.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace media_minion::player {
+
+/** Acoustic fingerprint of the beginning of a track.
+ * The audio is downmixed and resampled to sampling_frequency, split into overlapping frames and reduced to
+ * a 12 bin chroma vector per frame. Each hash encodes the relations between neighbouring chroma bins in one
+ * frame and their change over time, which survives lossy encoding, different masterings of the same rip,
+ * and small changes in volume.
+ */
+struct Fingerprint {
+    static constexpr std::uint32_t sampling_frequency = 11025;
+    static constexpr std::size_t frame_size = 4096;
+    static constexpr std::size_t frame_step = 1365;                 ///< about 8 hashes per second
+    static constexpr std::chrono::seconds max_duration{ 120 };
+    /** The bits of a hash that only depend on a single frame. They change least between different encodings.
+     */
+    static constexpr std::uint32_t frame_bits_mask = 0x00ffffff;
+
+    std::chrono::milliseconds duration;     ///< of the whole track, if known; otherwise of the analysed audio
+    std::vector<std::uint32_t> hashes;
+};
+
+class FingerprintCalculator {
+private:
+    struct Pimpl;
+    std::unique_ptr<Pimpl> m_pimpl;
+public:
+    FingerprintCalculator();
+    ~FingerprintCalculator();
+
+    FingerprintCalculator(FingerprintCalculator const&) = delete;
+    FingerprintCalculator& operator=(FingerprintCalculator const&) = delete;
+
+    /** @return false once Fingerprint::max_duration of audio has been processed; further data is ignored.
+     */
+    bool process(GhulbusAudio::DataVariant const& data);
+    bool process(std::span<PlaybackSample const> frames, std::uint32_t sampling_frequency);
+    Fingerprint finish();
+};
+
+/** Decodes the beginning of the track and computes its fingerprint.
+ * @param[in] cancel Optional; computation is aborted once it becomes true.
+ */
+std::optional<Fingerprint> computeFingerprint(std::filesystem::path const& track, FfmpegStreamOptions const& options,
+                                              std::atomic<bool> const* cancel = nullptr);
+
+struct FingerprintMatch {
+    double similarity;      ///< fraction of equal hash bits; unrelated audio scores around 0.5
+    int offset;             ///< hashes of rhs are shifted by this many positions against lhs
+};
+
+/** Compares two fingerprints at all alignments within offset +/- max_offset_deviation.
+ * @return std::nullopt if the fingerprints do not overlap sufficiently at any of those alignments.
+ */
+std::optional<FingerprintMatch> compareFingerprints(Fingerprint const& lhs, Fingerprint const& rhs,
+                                                    int offset, int max_offset_deviation);
+
+/** Binary sidecar format; all values are little endian:
+ *   "MMFP", u32 version, u64 duration in milliseconds, u32 number of hashes, u32 hashes.
+ */
+std::vector<unsigned char> serializeFingerprint(Fingerprint const& fingerprint);
+std::optional<Fingerprint> deserializeFingerprint(unsigned char const* data, std::size_t size);
+
+bool saveFingerprint(Fingerprint const& fingerprint, std::filesystem::path const& filepath);
+std::optional<Fingerprint> loadFingerprint(std::filesystem::path const& filepath);
+
+}
+#endif
@@ -0,0 +1,102 @@
+#include <media_minion/player/gain_stage.hpp>
+
+#include <media_minion/player/sample_traits.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   define MEDIA_MINION_GAIN_STAGE_USE_SSE2
+#   include <emmintrin.h>
+#endif
+
+namespace media_minion::player {
+
+namespace {
+void applyGain16(std::int16_t* samples, std::size_t count, float gain)
+{
+    std::size_t i = 0;
+#ifdef MEDIA_MINION_GAIN_STAGE_USE_SSE2
+    __m128 const g = _mm_set1_ps(gain);
+    for (; i + 8 <= count; i += 8) {
+        __m128i const s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(samples + i));
+        // sign extend to 32 bit by unpacking into the upper half and shifting back down
+        __m128i const lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i const hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        __m128i const scaled_lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(lo), g));
+        __m128i const scaled_hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(hi), g));
+        // packs saturates, which is our limiter
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + i), _mm_packs_epi32(scaled_lo, scaled_hi));
+    }
+#endif
+    for (; i < count; ++i) {
+        long const scaled = std::lround(static_cast<float>(samples[i]) * gain);
+        samples[i] = static_cast<std::int16_t>(std::clamp<long>(scaled, -32768, 32767));
+    }
+}
+
+void applyGain8(std::uint8_t* samples, std::size_t count, float gain)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        long const scaled = std::lround((static_cast<float>(samples[i]) - 128.f) * gain);
+        samples[i] = static_cast<std::uint8_t>(std::clamp<long>(scaled, -128, 127) + 128);
+    }
+}
+}
+
+void mixWithGainRamps(std::int16_t const* a, float const* gain_a, std::int16_t const* b, float const* gain_b,
+                      std::int16_t* out, std::size_t n_frames)
+{
+    std::size_t i = 0;
+#ifdef MEDIA_MINION_GAIN_STAGE_USE_SSE2
+    // 4 stereo frames per iteration; each gain applies to both channels of its frame
+    for (; i + 4 <= n_frames; i += 4) {
+        __m128i const sa = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + 2 * i));
+        __m128i const sb = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + 2 * i));
+        __m128 const ga = _mm_loadu_ps(gain_a + i);
+        __m128 const gb = _mm_loadu_ps(gain_b + i);
+        __m128 const fa_lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(sa, sa), 16));
+        __m128 const fa_hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(sa, sa), 16));
+        __m128 const fb_lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(sb, sb), 16));
+        __m128 const fb_hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(sb, sb), 16));
+        __m128 const mix_lo = _mm_add_ps(_mm_mul_ps(fa_lo, _mm_unpacklo_ps(ga, ga)),
+                                         _mm_mul_ps(fb_lo, _mm_unpacklo_ps(gb, gb)));
+        __m128 const mix_hi = _mm_add_ps(_mm_mul_ps(fa_hi, _mm_unpackhi_ps(ga, ga)),
+                                         _mm_mul_ps(fb_hi, _mm_unpackhi_ps(gb, gb)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(mix_lo), _mm_cvtps_epi32(mix_hi)));
+    }
+#endif
+    for (; i < n_frames; ++i) {
+        for (std::size_t c = 0; c < 2; ++c) {
+            float const mixed = static_cast<float>(a[2 * i + c]) * gain_a[i] +
+                                static_cast<float>(b[2 * i + c]) * gain_b[i];
+            out[2 * i + c] = static_cast<std::int16_t>(std::clamp<long>(std::lround(mixed), -32768, 32767));
+        }
+    }
+}
+
+template<typename SampleType>
+void applyGain(std::span<SampleType> frames, float gain)
+{
+    if ((gain == 1.f) || frames.empty()) { return; }
+    using Traits = SampleTraits<SampleType>;
+    static_assert(sizeof(SampleType) == sizeof(typename Traits::ValueType) * Traits::channels);
+    auto* const values = reinterpret_cast<typename Traits::ValueType*>(frames.data());
+    std::size_t const count = frames.size() * Traits::channels;
+    if constexpr (std::is_same_v<typename Traits::ValueType, std::int16_t>) {
+        applyGain16(values, count, gain);
+    } else {
+        applyGain8(values, count, gain);
+    }
+}
+
+template void applyGain(std::span<GhulbusAudio::SampleMono8Bit>, float);
+template void applyGain(std::span<GhulbusAudio::SampleStereo8Bit>, float);
+template void applyGain(std::span<GhulbusAudio::SampleMono16Bit>, float);
+template void applyGain(std::span<GhulbusAudio::SampleStereo16Bit>, float);
+
+}
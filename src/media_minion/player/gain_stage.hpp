@@ -0,0 +1,25 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_GAIN_STAGE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_GAIN_STAGE_HPP_
+
+#include <gbAudio/Data.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace media_minion::player {
+
+/** Scales all samples by gain, limiting the result to full scale.
+ * 16 bit data is processed with SSE2 where available. Instantiated for all gbAudio sample types.
+ */
+template<typename SampleType>
+void applyGain(std::span<SampleType> frames, float gain);
+
+/** Mixes two interleaved stereo streams, each scaled by its own per-frame gain, into out.
+ * out may alias neither input.
+ */
+void mixWithGainRamps(std::int16_t const* a, float const* gain_a, std::int16_t const* b, float const* gain_b,
+                      std::int16_t* out, std::size_t n_frames);
+
+}
+#endif
@@ -0,0 +1,351 @@
+#include <media_minion/player/http_range_io_context.hpp>
+
+#include <gbBase/Assert.hpp>
+#include <gbBase/Log.hpp>
+
+#include <boost/asio/connect.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/parser.hpp>
+#include <boost/beast/http/read.hpp>
+#include <boost/beast/http/string_body.hpp>
+#include <boost/beast/http/vector_body.hpp>
+#include <boost/beast/http/write.hpp>
+#include <boost/beast/version.hpp>
+
+extern "C" {
+#   include <libavformat/avio.h>
+#   include <libavutil/error.h>
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::size_t g_ioBufferSize = 32 * 1024;
+constexpr std::int64_t g_blockSize = 128 * 1024;
+constexpr std::size_t g_maxCachedBlocks = 64;
+constexpr std::int64_t g_minReadAheadBlocks = 1;
+constexpr std::int64_t g_maxReadAheadBlocks = 16;
+constexpr std::chrono::seconds g_connectTimeout(5);
+constexpr std::chrono::seconds g_requestTimeout(10);
+
+std::optional<std::int64_t> parseNumber(std::string_view str)
+{
+    std::int64_t ret;
+    auto const [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), ret);
+    if ((ec != std::errc{}) || (ptr != str.data() + str.size()) || str.empty()) { return std::nullopt; }
+    return ret;
+}
+
+struct ContentRange {
+    std::int64_t first;
+    std::int64_t total;
+};
+
+/** Parses a Content-Range header of the form 'bytes first-last/total'.
+ */
+std::optional<ContentRange> parseContentRange(std::string_view str)
+{
+    constexpr std::string_view prefix = "bytes ";
+    if (str.substr(0, prefix.size()) != prefix) { return std::nullopt; }
+    str.remove_prefix(prefix.size());
+    auto const dash = str.find('-');
+    auto const slash = str.find('/');
+    if ((dash == std::string_view::npos) || (slash == std::string_view::npos) || (slash < dash)) {
+        return std::nullopt;
+    }
+    auto const first = parseNumber(str.substr(0, dash));
+    auto const total = parseNumber(str.substr(slash + 1));
+    if (!first || !total) { return std::nullopt; }
+    return ContentRange{ *first, *total };
+}
+
+bool isUnreserved(char c)
+{
+    return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) ||
+           (c == '-') || (c == '.') || (c == '_') || (c == '~');
+}
+}
+
+std::optional<HttpLocation> parseHttpLocation(std::string_view url)
+{
+    constexpr std::string_view scheme = "http://";
+    if (url.substr(0, scheme.size()) != scheme) { return std::nullopt; }
+    url.remove_prefix(scheme.size());
+    auto const target_start = url.find('/');
+    if ((target_start == std::string_view::npos) || (target_start == 0)) { return std::nullopt; }
+    std::string_view const authority = url.substr(0, target_start);
+    HttpLocation ret;
+    ret.target = std::string(url.substr(target_start));
+    if (auto const colon = authority.rfind(':'); colon != std::string_view::npos) {
+        ret.host = std::string(authority.substr(0, colon));
+        ret.port = std::string(authority.substr(colon + 1));
+        if (!parseNumber(ret.port)) { return std::nullopt; }
+    } else {
+        ret.host = std::string(authority);
+        ret.port = "80";
+    }
+    return ret;
+}
+
+std::string makeServerMediaUrl(std::string_view host, std::uint16_t port, std::string_view library_path)
+{
+    std::string ret = "http://" + std::string(host) + ":" + std::to_string(port) + "/media/";
+    for (char c : library_path) {
+        if (isUnreserved(c) || (c == '/')) {
+            ret.push_back(c);
+        } else if (c == '\\') {
+            ret.push_back('/');
+        } else {
+            char hex[4];
+            std::snprintf(hex, sizeof(hex), "%%%02X", static_cast<unsigned char>(c));
+            ret.append(hex);
+        }
+    }
+    return ret;
+}
+
+HttpRangeIOContext::HttpRangeIOContext(HttpLocation location)
+    :MediaIOContext(g_ioBufferSize), m_location(std::move(location)), m_stream(m_ioContext), m_connected(false),
+     m_fileSize(-1), m_position(0), m_useCounter(0), m_nextSequentialBlock(0),
+     m_readAheadBlocks(g_minReadAheadBlocks), m_stats{}
+{
+}
+
+HttpRangeIOContext::~HttpRangeIOContext()
+{
+    boost::system::error_code ec;
+    m_stream.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+    m_stream.close();
+    GHULBUS_LOG(Info, "Http range io: " << m_stats.requests << " requests, " << m_stats.bytes_fetched <<
+                       " bytes fetched in " << m_stats.total_request_time.count() << "us, " << m_stats.cache_hits <<
+                       " cache hits, " << m_stats.cache_misses << " misses, " << m_stats.reconnects <<
+                       " reconnects.");
+}
+
+HttpRangeIOContext::Statistics HttpRangeIOContext::getStatistics() const
+{
+    return m_stats;
+}
+
+int HttpRangeIOContext::readPacket(std::uint8_t* buf, int buf_size)
+{
+    if ((m_fileSize >= 0) && (m_position >= m_fileSize)) { return AVERROR_EOF; }
+    std::int64_t const block_index = m_position / g_blockSize;
+    CachedBlock const* block = lookupBlock(block_index);
+    if (block) {
+        ++m_stats.cache_hits;
+    } else {
+        ++m_stats.cache_misses;
+        if (block_index == m_nextSequentialBlock) {
+            m_readAheadBlocks = std::min(m_readAheadBlocks * 2, g_maxReadAheadBlocks);
+        } else {
+            m_readAheadBlocks = g_minReadAheadBlocks;
+        }
+        if (!fetchBlocks(block_index, m_readAheadBlocks)) { return AVERROR(EIO); }
+        block = lookupBlock(block_index);
+        if (!block) {
+            // only possible if the first request revealed that we are past the end of the file
+            return AVERROR_EOF;
+        }
+    }
+    std::int64_t const block_offset = m_position - (block_index * g_blockSize);
+    std::int64_t const n = std::min<std::int64_t>(buf_size,
+                                                  static_cast<std::int64_t>(block->data.size()) - block_offset);
+    if (n <= 0) { return AVERROR_EOF; }
+    std::memcpy(buf, block->data.data() + block_offset, static_cast<std::size_t>(n));
+    m_position += n;
+    return static_cast<int>(n);
+}
+
+std::int64_t HttpRangeIOContext::seek(std::int64_t offset, int whence)
+{
+    if (whence == AVSEEK_SIZE) {
+        if (m_fileSize < 0) {
+            // the size is only reported along with data; fetch the first block which is needed anyway
+            if (!fetchBlocks(0, 1)) { return -1; }
+        }
+        return m_fileSize;
+    }
+    std::int64_t new_position;
+    if (whence == SEEK_SET) {
+        new_position = offset;
+    } else if (whence == SEEK_CUR) {
+        new_position = m_position + offset;
+    } else if (whence == SEEK_END) {
+        if ((m_fileSize < 0) && !fetchBlocks(0, 1)) { return -1; }
+        new_position = m_fileSize + offset;
+    } else {
+        return -1;
+    }
+    if (new_position < 0) { return -1; }
+    m_position = new_position;
+    return m_position;
+}
+
+bool HttpRangeIOContext::connect()
+{
+    boost::system::error_code ec;
+    m_stream.close();
+    m_buffer.consume(m_buffer.size());
+    boost::asio::ip::tcp::resolver resolver(m_ioContext);
+    auto const endpoints = resolver.resolve(m_location.host, m_location.port, ec);
+    if (ec) {
+        GHULBUS_LOG(Error, "Unable to resolve " << m_location.host << ": " << ec.message());
+        return false;
+    }
+    m_stream.expires_after(g_connectTimeout);
+    m_stream.async_connect(endpoints, [&ec](boost::system::error_code const& e, auto const&) { ec = e; });
+    runPendingOperation();
+    if (ec) {
+        GHULBUS_LOG(Error, "Unable to connect to " << m_location.host << ":" << m_location.port << ": " <<
+                           ec.message());
+        return false;
+    }
+    m_stream.socket().set_option(boost::asio::ip::tcp::no_delay(true), ec);
+    m_connected = true;
+    return true;
+}
+
+bool HttpRangeIOContext::fetchBlocks(std::int64_t first_block, std::int64_t block_count)
+{
+    GHULBUS_PRECONDITION(block_count > 0);
+    // do not fetch blocks twice; the run ends at the first block that is already cached
+    std::int64_t n = 1;
+    while ((n < block_count) && (m_cache.find(first_block + n) == m_cache.end())) { ++n; }
+    std::int64_t const first_byte = first_block * g_blockSize;
+    std::int64_t last_byte = (first_block + n) * g_blockSize - 1;
+    if (m_fileSize >= 0) {
+        if (first_byte >= m_fileSize) { return true; }
+        last_byte = std::min(last_byte, m_fileSize - 1);
+    }
+
+    auto const t0 = std::chrono::steady_clock::now();
+    RequestResult result = RequestResult::ConnectionError;
+    for (int attempt = 0; (attempt < 2) && (result == RequestResult::ConnectionError); ++attempt) {
+        if (!m_connected || (attempt > 0)) {
+            // the server closes idle keep-alive connections; a broken connection gets one retry
+            if (attempt > 0) { ++m_stats.reconnects; }
+            if (!connect()) { break; }
+        }
+        result = requestRange(first_byte, last_byte);
+        if (result == RequestResult::ConnectionError) { m_connected = false; }
+    }
+    m_stats.total_request_time +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0);
+    m_nextSequentialBlock = first_block + n;
+    return result == RequestResult::Success;
+}
+
+HttpRangeIOContext::RequestResult HttpRangeIOContext::requestRange(std::int64_t first_byte, std::int64_t last_byte)
+{
+    namespace http = boost::beast::http;
+    http::request<http::string_body> request{ http::verb::get, m_location.target, 11 };
+    request.set(http::field::host, m_location.host);
+    request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    request.set(http::field::range, "bytes=" + std::to_string(first_byte) + "-" + std::to_string(last_byte));
+    request.keep_alive(true);
+
+    boost::system::error_code ec;
+    m_stream.expires_after(g_requestTimeout);
+    http::async_write(m_stream, request, [&ec](boost::system::error_code const& e, std::size_t) { ec = e; });
+    runPendingOperation();
+    if (ec) {
+        GHULBUS_LOG(Debug, "Error writing range request: " << ec.message());
+        return RequestResult::ConnectionError;
+    }
+    http::response_parser<http::vector_body<unsigned char>> parser;
+    // a server that ignores the range sends the whole file
+    parser.body_limit(std::numeric_limits<std::uint64_t>::max());
+    m_stream.expires_after(g_requestTimeout);
+    http::async_read(m_stream, m_buffer, parser, [&ec](boost::system::error_code const& e, std::size_t) { ec = e; });
+    runPendingOperation();
+    if (ec) {
+        GHULBUS_LOG(Debug, "Error reading range response: " << ec.message());
+        return RequestResult::ConnectionError;
+    }
+    auto& response = parser.get();
+    ++m_stats.requests;
+    m_stats.bytes_fetched += response.body().size();
+    if (!response.keep_alive()) { m_connected = false; }
+
+    std::int64_t data_offset = 0;
+    // blocks of the body that are worth caching; all of them unless the server ignored the range
+    std::int64_t first_stored_block = 0;
+    std::int64_t end_stored_block = std::numeric_limits<std::int64_t>::max();
+    if (response.result() == http::status::partial_content) {
+        auto const content_range = response[http::field::content_range];
+        auto const range = parseContentRange(std::string_view(content_range.data(), content_range.size()));
+        if (!range || ((range->first % g_blockSize) != 0)) {
+            GHULBUS_LOG(Error, "Invalid Content-Range in response for " << m_location.target << ".");
+            return RequestResult::Failed;
+        }
+        data_offset = range->first;
+        m_fileSize = range->total;
+    } else if (response.result() == http::status::ok) {
+        m_fileSize = static_cast<std::int64_t>(response.body().size());
+        // caching the whole file would evict the very blocks that were requested
+        first_stored_block = std::max<std::int64_t>(first_byte / g_blockSize - 1, 0);
+        end_stored_block = std::max(last_byte / g_blockSize + 1, first_byte / g_blockSize + g_maxReadAheadBlocks);
+    } else if (response.result() == http::status::range_not_satisfiable) {
+        auto const content_range = response[http::field::content_range];
+        std::string_view const str(content_range.data(), content_range.size());
+        if (auto const slash = str.find('/'); slash != std::string_view::npos) {
+            if (auto const total = parseNumber(str.substr(slash + 1)); total) { m_fileSize = *total; }
+        }
+        return (m_fileSize >= 0) ? RequestResult::Success : RequestResult::Failed;
+    } else {
+        GHULBUS_LOG(Error, "Server responded to range request for " << m_location.target << " with " <<
+                           response.result_int() << ".");
+        return RequestResult::Failed;
+    }
+
+    auto const& body = response.body();
+    for (std::size_t offset = 0; offset < body.size(); offset += g_blockSize) {
+        std::size_t const n = std::min<std::size_t>(g_blockSize, body.size() - offset);
+        std::int64_t const block_start = data_offset + static_cast<std::int64_t>(offset);
+        if (block_start / g_blockSize < first_stored_block) { continue; }
+        if (block_start / g_blockSize >= end_stored_block) { break; }
+        bool const is_last_block = (block_start + static_cast<std::int64_t>(n) >= m_fileSize);
+        if ((n < static_cast<std::size_t>(g_blockSize)) && !is_last_block) {
+            // partial block in the middle of the file; not worth caching
+            break;
+        }
+        storeBlock(block_start / g_blockSize,
+                   std::vector<unsigned char>(body.begin() + offset, body.begin() + offset + n));
+    }
+    return RequestResult::Success;
+}
+
+void HttpRangeIOContext::runPendingOperation()
+{
+    // the deadline of the stream only applies to asynchronous operations
+    m_ioContext.restart();
+    m_ioContext.run();
+}
+
+HttpRangeIOContext::CachedBlock const* HttpRangeIOContext::lookupBlock(std::int64_t block_index)
+{
+    auto it = m_cache.find(block_index);
+    if (it == m_cache.end()) { return nullptr; }
+    it->second.last_use = ++m_useCounter;
+    return &it->second;
+}
+
+void HttpRangeIOContext::storeBlock(std::int64_t block_index, std::vector<unsigned char> data)
+{
+    if ((m_cache.size() >= g_maxCachedBlocks) && (m_cache.find(block_index) == m_cache.end())) {
+        auto const it_lru = std::min_element(m_cache.begin(), m_cache.end(),
+            [](auto const& lhs, auto const& rhs) { return lhs.second.last_use < rhs.second.last_use; });
+        m_cache.erase(it_lru);
+    }
+    m_cache[block_index] = CachedBlock{ std::move(data), ++m_useCounter };
+}
+
+}
@@ -0,0 +1,95 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_HTTP_RANGE_IO_CONTEXT_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_HTTP_RANGE_IO_CONTEXT_HPP_
+
+#include <media_minion/player/media_io_context.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace media_minion::player {
+
+struct HttpLocation {
+    std::string host;
+    std::string port;
+    std::string target;
+};
+
+/** Splits an url of the form http://host[:port]/target.
+ */
+std::optional<HttpLocation> parseHttpLocation(std::string_view url);
+
+/** Url under which the server hosts the file at library_path, relative to its media root.
+ */
+std::string makeServerMediaUrl(std::string_view host, std::uint16_t port, std::string_view library_path);
+
+/** Reads a file from the media server via HTTP range requests.
+ * Data is fetched in fixed size blocks that are kept in a small LRU cache, so that the probing done
+ * by ffmpeg when opening a file (header, then tags at the end, then header again) does not cause
+ * repeated round trips. Sequential reads fetch increasingly larger runs of blocks with a single request.
+ * The connection is kept alive between requests and re-established once if the server dropped it.
+ * All network operations have a deadline, so a stalled server cannot block the decoder for good.
+ */
+class HttpRangeIOContext : public MediaIOContext {
+public:
+    struct Statistics {
+        std::uint64_t requests;
+        std::uint64_t bytes_fetched;
+        std::uint64_t cache_hits;
+        std::uint64_t cache_misses;
+        std::uint64_t reconnects;
+        std::chrono::microseconds total_request_time;
+    };
+private:
+    enum class RequestResult {
+        Success,
+        ConnectionError,        ///< worth retrying on a fresh connection
+        Failed,
+    };
+
+    struct CachedBlock {
+        std::vector<unsigned char> data;
+        std::uint64_t last_use;
+    };
+
+    HttpLocation m_location;
+    boost::asio::io_context m_ioContext;
+    boost::beast::tcp_stream m_stream;
+    boost::beast::flat_buffer m_buffer;
+    bool m_connected;
+
+    std::int64_t m_fileSize;                    ///< -1 until the first response told us
+    std::int64_t m_position;
+    std::unordered_map<std::int64_t, CachedBlock> m_cache;
+    std::uint64_t m_useCounter;
+    std::int64_t m_nextSequentialBlock;         ///< block following the last fetched run
+    std::int64_t m_readAheadBlocks;
+    Statistics m_stats;
+public:
+    explicit HttpRangeIOContext(HttpLocation location);
+    ~HttpRangeIOContext() override;
+
+    Statistics getStatistics() const;
+protected:
+    int readPacket(std::uint8_t* buf, int buf_size) override;
+    std::int64_t seek(std::int64_t offset, int whence) override;
+private:
+    bool connect();
+    bool fetchBlocks(std::int64_t first_block, std::int64_t block_count);
+    RequestResult requestRange(std::int64_t first_byte, std::int64_t last_byte);
+    void runPendingOperation();
+    CachedBlock const* lookupBlock(std::int64_t block_index);
+    void storeBlock(std::int64_t block_index, std::vector<unsigned char> data);
+};
+
+}
+#endif
@@ -0,0 +1,186 @@
+#include <media_minion/player/loudness_analyzer.hpp>
+
+#include <gbBase/Assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace media_minion::player {
+
+namespace {
+constexpr double g_pi = 3.14159265358979323846;
+constexpr double g_absoluteGate = -70.0;
+constexpr double g_relativeGate = -10.0;
+
+double energyToLoudness(double energy)
+{
+    return -0.691 + 10.0 * std::log10(energy);
+}
+
+double loudnessToEnergy(double loudness)
+{
+    return std::pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+void extractFrame(PlaybackSample const& s, float* out)
+{
+    out[0] = static_cast<float>(s.left) / 32768.f;
+    out[1] = static_cast<float>(s.right) / 32768.f;
+}
+}
+
+LoudnessAnalyzer::LoudnessAnalyzer()
+    :m_samplingFrequency(0), m_channels(0), m_stage1{}, m_stage2{}, m_channelState{}, m_oversamplingFilter{},
+     m_subBlockFrames(0), m_subBlockPosition(0), m_subBlockEnergy(0.0), m_truePeak(0.0)
+{
+    // windowed sinc interpolator with its cutoff at the original nyquist frequency
+    std::size_t const n_taps = m_oversamplingFilter.size();
+    double const center = static_cast<double>(n_taps - 1) / 2.0;
+    double sum = 0.0;
+    for (std::size_t i = 0; i < n_taps; ++i) {
+        double const x = (static_cast<double>(i) - center) / static_cast<double>(oversampling_factor);
+        double const sinc = (x == 0.0) ? 1.0 : std::sin(g_pi * x) / (g_pi * x);
+        double const window = 0.42 - 0.5 * std::cos(2.0 * g_pi * i / (n_taps - 1)) +
+                              0.08 * std::cos(4.0 * g_pi * i / (n_taps - 1));
+        m_oversamplingFilter[i] = static_cast<float>(sinc * window);
+        sum += sinc * window;
+    }
+    for (auto& h : m_oversamplingFilter) {
+        h = static_cast<float>(h * oversampling_factor / sum);
+    }
+}
+
+void LoudnessAnalyzer::configure(std::uint32_t sampling_frequency, std::size_t channels)
+{
+    GHULBUS_PRECONDITION((sampling_frequency > 0) && (channels > 0) && (channels <= m_channelState.size()));
+    m_samplingFrequency = sampling_frequency;
+    m_channels = channels;
+    double const fs = static_cast<double>(sampling_frequency);
+
+    // K-weighting; coefficients from BS.1770 re-derived for arbitrary sampling frequencies
+    {
+        // high shelf modelling the acoustic effect of the head
+        double const f0 = 1681.974450955533;
+        double const G = 3.999843853973347;
+        double const Q = 0.7071752369554196;
+        double const K = std::tan(g_pi * f0 / fs);
+        double const Vh = std::pow(10.0, G / 20.0);
+        double const Vb = std::pow(Vh, 0.4996667741545416);
+        double const a0 = 1.0 + K / Q + K * K;
+        m_stage1.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        m_stage1.b1 = 2.0 * (K * K - Vh) / a0;
+        m_stage1.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        m_stage1.a1 = 2.0 * (K * K - 1.0) / a0;
+        m_stage1.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+    {
+        // RLB high pass
+        double const f0 = 38.13547087602444;
+        double const Q = 0.5003270373238773;
+        double const K = std::tan(g_pi * f0 / fs);
+        double const a0 = 1.0 + K / Q + K * K;
+        m_stage2.b0 = 1.0;
+        m_stage2.b1 = -2.0;
+        m_stage2.b2 = 1.0;
+        m_stage2.a1 = 2.0 * (K * K - 1.0) / a0;
+        m_stage2.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+    m_channelState = {};
+    m_subBlockFrames = std::max<std::size_t>(sampling_frequency / 10, 1);
+    m_subBlockPosition = 0;
+    m_subBlockEnergy = 0.0;
+}
+
+void LoudnessAnalyzer::process(std::span<PlaybackSample const> frames, std::uint32_t sampling_frequency)
+{
+    if ((sampling_frequency != m_samplingFrequency) || (m_channels != 2)) { configure(sampling_frequency, 2); }
+    float frame[2];
+    for (auto const& f : frames) {
+        extractFrame(f, frame);
+        processFrame(frame);
+    }
+}
+
+void LoudnessAnalyzer::processFrame(float const* samples)
+{
+    for (std::size_t c = 0; c < m_channels; ++c) {
+        ChannelState& state = m_channelState[c];
+        // transposed direct form II
+        double const x = samples[c];
+        double const y1 = m_stage1.b0 * x + state.z1[0];
+        state.z1[0] = m_stage1.b1 * x - m_stage1.a1 * y1 + state.z1[1];
+        state.z1[1] = m_stage1.b2 * x - m_stage1.a2 * y1;
+        double const y2 = m_stage2.b0 * y1 + state.z2[0];
+        state.z2[0] = m_stage2.b1 * y1 - m_stage2.a1 * y2 + state.z2[1];
+        state.z2[1] = m_stage2.b2 * y1 - m_stage2.a2 * y2;
+        // all channels of mono and stereo material have a weight of 1
+        m_subBlockEnergy += y2 * y2;
+
+        m_truePeak = std::max(m_truePeak, static_cast<double>(oversampledPeak(state, samples[c])));
+    }
+    if (++m_subBlockPosition == m_subBlockFrames) {
+        m_subBlocks.push_back(m_subBlockEnergy / static_cast<double>(m_subBlockFrames));
+        m_subBlockPosition = 0;
+        m_subBlockEnergy = 0.0;
+    }
+}
+
+float LoudnessAnalyzer::oversampledPeak(ChannelState& state, float sample) const
+{
+    state.history[state.history_index] = sample;
+    float peak = std::abs(sample);
+    for (std::size_t phase = 0; phase < oversampling_factor; ++phase) {
+        float acc = 0.f;
+        std::size_t idx = state.history_index;
+        for (std::size_t k = 0; k < taps_per_phase; ++k) {
+            acc += m_oversamplingFilter[phase + k * oversampling_factor] * state.history[idx];
+            idx = (idx == 0) ? (taps_per_phase - 1) : (idx - 1);
+        }
+        peak = std::max(peak, std::abs(acc));
+    }
+    state.history_index = (state.history_index + 1) % taps_per_phase;
+    return peak;
+}
+
+std::optional<LoudnessInfo> LoudnessAnalyzer::getResult() const
+{
+    // gating blocks of 400ms with 75% overlap, made up of four consecutive sub-blocks
+    if (m_subBlocks.size() < 4) { return std::nullopt; }
+    std::vector<double> blocks;
+    blocks.reserve(m_subBlocks.size() - 3);
+    for (std::size_t i = 0; i + 3 < m_subBlocks.size(); ++i) {
+        double const energy = (m_subBlocks[i] + m_subBlocks[i + 1] + m_subBlocks[i + 2] + m_subBlocks[i + 3]) / 4.0;
+        if (energyToLoudness(energy) > g_absoluteGate) { blocks.push_back(energy); }
+    }
+    if (blocks.empty()) { return std::nullopt; }
+
+    double const relative_threshold = loudnessToEnergy(
+        energyToLoudness(std::accumulate(blocks.begin(), blocks.end(), 0.0) / blocks.size()) + g_relativeGate);
+    double sum = 0.0;
+    std::uint64_t count = 0;
+    for (double const energy : blocks) {
+        if (energy > relative_threshold) {
+            sum += energy;
+            ++count;
+        }
+    }
+    if (count == 0) { return std::nullopt; }
+    return LoudnessInfo{ energyToLoudness(sum / static_cast<double>(count)), m_truePeak, count };
+}
+
+std::optional<LoudnessInfo> combineLoudness(std::vector<LoudnessInfo> const& tracks)
+{
+    double energy_sum = 0.0;
+    std::uint64_t block_count = 0;
+    double peak = 0.0;
+    for (auto const& t : tracks) {
+        energy_sum += loudnessToEnergy(t.integrated_loudness) * static_cast<double>(t.gated_blocks);
+        block_count += t.gated_blocks;
+        peak = std::max(peak, t.true_peak);
+    }
+    if (block_count == 0) { return std::nullopt; }
+    return LoudnessInfo{ energyToLoudness(energy_sum / static_cast<double>(block_count)), peak, block_count };
+}
+
+}
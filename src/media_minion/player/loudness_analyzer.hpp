@@ -0,0 +1,72 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_LOUDNESS_ANALYZER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_LOUDNESS_ANALYZER_HPP_
+
+#include <media_minion/player/media_source.hpp>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace media_minion::player {
+
+struct LoudnessInfo {
+    double integrated_loudness;     ///< in LUFS
+    double true_peak;               ///< linear, relative to full scale
+    std::uint64_t gated_blocks;     ///< number of 400ms blocks that passed both gates
+};
+
+/** Measures integrated loudness and true peak of a stream of audio data as per EBU R128 / ITU-R BS.1770.
+ * Audio is fed in arbitrarily sized pieces; the analyzer adapts to the format of the first piece and
+ * restarts its filters if the sampling frequency or the channel count changes midstream.
+ * The true peak is estimated from a 4x oversampled signal.
+ */
+class LoudnessAnalyzer {
+private:
+    static constexpr std::size_t oversampling_factor = 4;
+    static constexpr std::size_t taps_per_phase = 12;
+
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+    struct ChannelState {
+        double z1[2];               ///< filter state of the two K-weighting stages
+        double z2[2];
+        std::array<float, taps_per_phase> history;
+        std::size_t history_index;
+    };
+
+    std::uint32_t m_samplingFrequency;
+    std::size_t m_channels;
+    Biquad m_stage1;
+    Biquad m_stage2;
+    std::array<ChannelState, 2> m_channelState;
+    std::array<float, oversampling_factor * taps_per_phase> m_oversamplingFilter;
+    std::size_t m_subBlockFrames;
+    std::size_t m_subBlockPosition;
+    double m_subBlockEnergy;
+    std::vector<double> m_subBlocks;            ///< mean square of each 100ms sub-block
+    double m_truePeak;
+public:
+    LoudnessAnalyzer();
+
+    void process(std::span<PlaybackSample const> frames, std::uint32_t sampling_frequency);
+
+    /** @return std::nullopt if less than one 400ms block passed the gates (silence or a very short stream).
+     */
+    std::optional<LoudnessInfo> getResult() const;
+private:
+    void configure(std::uint32_t sampling_frequency, std::size_t channels);
+    void processFrame(float const* samples);
+    float oversampledPeak(ChannelState& state, float sample) const;
+};
+
+/** Loudness of a set of tracks played back to back, from their individual results.
+ * The energies of the gated blocks get averaged, which matches an analysis of the concatenated
+ * tracks except for blocks close to the relative gate.
+ */
+std::optional<LoudnessInfo> combineLoudness(std::vector<LoudnessInfo> const& tracks);
+
+}
+#endif
@@ -0,0 +1,102 @@
+#include <media_minion/player/loudness_scanner.hpp>
+
+#include <media_minion/player/track_metadata_cache.hpp>
+
+#include <media_minion/common/file_signature.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <chrono>
+#include <vector>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::size_t g_readFrames = 16384;
+}
+
+LoudnessScanner::LoudnessScanner(TrackMetadataCache& cache, FfmpegStreamOptions const& stream_options)
+    :m_cache(&cache), m_streamOptions(stream_options), m_shutdownRequested(false)
+{
+    m_worker = std::thread([this]() { workerThread(); });
+}
+
+LoudnessScanner::~LoudnessScanner()
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_shutdownRequested = true;
+    }
+    m_cvWorker.notify_all();
+    m_worker.join();
+    m_cache->save();
+}
+
+void LoudnessScanner::scan(std::filesystem::path track)
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_pending.emplace_back(std::move(track));
+    }
+    m_cvWorker.notify_all();
+}
+
+void LoudnessScanner::workerThread()
+{
+    std::unique_lock lk(m_mtx);
+    for (;;) {
+        m_cvWorker.wait(lk, [this]() { return m_shutdownRequested || !m_pending.empty(); });
+        if (m_shutdownRequested) { return; }
+        std::filesystem::path const track = std::move(m_pending.front());
+        m_pending.pop_front();
+        bool const is_last_pending = m_pending.empty();
+        lk.unlock();
+
+        processTrack(track);
+        // tracks queued in the meantime save the cache once they are done
+        if (is_last_pending) { m_cache->save(); }
+
+        lk.lock();
+    }
+}
+
+void LoudnessScanner::processTrack(std::filesystem::path const& track)
+{
+    // remote tracks have no local signature; their analysis happens on the machine hosting the library
+    auto const signature = getFileSignature(track);
+    if (!signature) { return; }
+    if (m_cache->lookup(*signature)) { return; }
+
+    auto const t0 = std::chrono::steady_clock::now();
+    auto const loudness = analyzeTrack(track);
+    if (!loudness) { return; }
+    auto const t1 = std::chrono::steady_clock::now();
+    GHULBUS_LOG(Info, "Analysed " << track << ": " << loudness->integrated_loudness << " LUFS, true peak " <<
+                      loudness->true_peak << " (" <<
+                      std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << "ms).");
+
+    TrackMetadataCache::Entry entry;
+    entry.path = signature->path;
+    entry.album = getAlbumKey(track);
+    entry.loudness = *loudness;
+    m_cache->store(*signature, std::move(entry));
+}
+
+std::optional<LoudnessInfo> LoudnessScanner::analyzeTrack(std::filesystem::path const& track)
+{
+    FfmpegStream stream(track, m_streamOptions);
+    if (!stream.isOpen()) { return std::nullopt; }
+    LoudnessAnalyzer analyzer;
+    std::vector<PlaybackSample> buffer(g_readFrames);
+    while (std::size_t const n_frames = stream.read(buffer)) {
+        if (m_shutdownRequested) { return std::nullopt; }
+        analyzer.process(std::span<PlaybackSample const>(buffer.data(), n_frames), stream.getSamplingFrequency());
+    }
+    auto ret = analyzer.getResult();
+    if (!ret) {
+        GHULBUS_LOG(Warning, "Unable to determine loudness of " << track << ".");
+    }
+    return ret;
+}
+
+}
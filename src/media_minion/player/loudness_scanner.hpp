@@ -0,0 +1,49 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_LOUDNESS_SCANNER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_LOUDNESS_SCANNER_HPP_
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/loudness_analyzer.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace media_minion::player {
+
+class TrackMetadataCache;
+
+/** Analyses the loudness of tracks on a background thread and stores the results in the metadata cache.
+ * Tracks that already have an up-to-date cache entry are skipped, so scanning the same library
+ * repeatedly only costs the time to check the file signatures.
+ */
+class LoudnessScanner {
+private:
+    TrackMetadataCache* m_cache;
+    FfmpegStreamOptions m_streamOptions;
+
+    std::mutex m_mtx;
+    std::condition_variable m_cvWorker;
+    std::deque<std::filesystem::path> m_pending;
+    std::atomic<bool> m_shutdownRequested;
+
+    std::thread m_worker;
+public:
+    LoudnessScanner(TrackMetadataCache& cache, FfmpegStreamOptions const& stream_options);
+    ~LoudnessScanner();
+
+    LoudnessScanner(LoudnessScanner const&) = delete;
+    LoudnessScanner& operator=(LoudnessScanner const&) = delete;
+
+    void scan(std::filesystem::path track);
+private:
+    void workerThread();
+    void processTrack(std::filesystem::path const& track);
+    std::optional<LoudnessInfo> analyzeTrack(std::filesystem::path const& track);
+};
+
+}
+#endif
@@ -0,0 +1,73 @@
+#include <media_minion/player/mapped_file_io_context.hpp>
+
+#include <gbBase/Assert.hpp>
+
+extern "C" {
+#   include <libavformat/avio.h>
+#   include <libavutil/error.h>
+}
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace media_minion::player {
+
+namespace {
+// the mapping makes the reads themselves cheap; a larger buffer still saves on callbacks from avio
+constexpr std::size_t g_ioBufferSize = 32 * 1024;
+constexpr std::uint64_t g_readAheadWindow = 1024 * 1024;
+}
+
+MappedFileIOContext::MappedFileIOContext(MappedFile&& file)
+    :MediaIOContext(g_ioBufferSize), m_file(std::move(file)), m_position(0), m_adviseHorizon(0)
+{
+    m_file.adviseSequential();
+    adviseReadAhead();
+}
+
+int MappedFileIOContext::readPacket(std::uint8_t* buf, int buf_size)
+{
+    if (m_position >= m_file.size()) { return AVERROR_EOF; }
+    std::uint64_t const n = std::min(static_cast<std::uint64_t>(buf_size), m_file.size() - m_position);
+    std::memcpy(buf, m_file.data() + m_position, static_cast<std::size_t>(n));
+    m_position += n;
+    adviseReadAhead();
+    return static_cast<int>(n);
+}
+
+std::int64_t MappedFileIOContext::seek(std::int64_t offset, int whence)
+{
+    std::int64_t const file_size = static_cast<std::int64_t>(m_file.size());
+    std::int64_t new_position;
+    switch (whence)
+    {
+    case SEEK_SET: new_position = offset; break;
+    case SEEK_CUR: new_position = static_cast<std::int64_t>(m_position) + offset; break;
+    case SEEK_END: new_position = file_size + offset; break;
+    case AVSEEK_SIZE: return file_size;
+    default:
+        GHULBUS_UNREACHABLE_MESSAGE("Invalid whence token in seek.");
+    }
+    if (new_position < 0) { return -1; }
+
+    std::uint64_t const old_position = m_position;
+    m_position = static_cast<std::uint64_t>(new_position);
+    if ((m_position < old_position) || (m_position > m_adviseHorizon)) {
+        // jumped out of the range that is being read ahead; restart read-ahead from the new position
+        m_adviseHorizon = m_position;
+        adviseReadAhead();
+    }
+    return new_position;
+}
+
+void MappedFileIOContext::adviseReadAhead()
+{
+    // keep at least half a window of hinted data in front of the read position
+    if (m_position + g_readAheadWindow / 2 < m_adviseHorizon) { return; }
+    std::uint64_t const start = std::max(m_position, m_adviseHorizon);
+    m_file.adviseWillNeed(start, g_readAheadWindow);
+    m_adviseHorizon = start + g_readAheadWindow;
+}
+
+}
@@ -0,0 +1,28 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_MAPPED_FILE_IO_CONTEXT_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_MAPPED_FILE_IO_CONTEXT_HPP_
+
+#include <media_minion/player/media_io_context.hpp>
+
+#include <media_minion/common/mapped_file.hpp>
+
+namespace media_minion::player {
+
+/** Serves ffmpeg reads by copying directly out of a memory mapping of the file.
+ * Reads and seeks do not involve any system calls, except for occasional read-ahead hints to the OS.
+ */
+class MappedFileIOContext : public MediaIOContext {
+private:
+    MappedFile m_file;
+    std::uint64_t m_position;
+    std::uint64_t m_adviseHorizon;      ///< end of the range for which we already sent a read-ahead hint
+public:
+    explicit MappedFileIOContext(MappedFile&& file);
+protected:
+    int readPacket(std::uint8_t* buf, int buf_size) override;
+    std::int64_t seek(std::int64_t offset, int whence) override;
+private:
+    void adviseReadAhead();
+};
+
+}
+#endif
@@ -0,0 +1,118 @@
+#include <media_minion/player/mapped_wav_file.hpp>
+
+#include <media_minion/player/riff_chunk_reader.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::uint16_t g_formatPcm = 0x0001;
+constexpr std::uint16_t g_formatFloat = 0x0003;
+
+std::optional<WavSampleFormat> getSampleFormat(std::uint16_t format_tag, std::uint16_t bits_per_sample)
+{
+    if (format_tag == g_formatPcm) {
+        switch (bits_per_sample) {
+        case 8:  return WavSampleFormat::UnsignedInt8;
+        case 16: return WavSampleFormat::SignedInt16;
+        case 24: return WavSampleFormat::SignedInt24;
+        case 32: return WavSampleFormat::SignedInt32;
+        default: return std::nullopt;
+        }
+    } else if ((format_tag == g_formatFloat) && (bits_per_sample == 32)) {
+        return WavSampleFormat::Float32;
+    }
+    return std::nullopt;
+}
+}
+
+MappedWavFile::MappedWavFile(MappedFile&& mapping, WavFormat const& format, std::uint64_t data_offset,
+                             std::uint64_t frames)
+    :m_mapping(std::move(mapping)), m_format(format), m_dataOffset(data_offset), m_frames(frames)
+{
+}
+
+std::optional<MappedWavFile> MappedWavFile::open(std::filesystem::path const& filepath)
+{
+    auto mapping = MappedFile::open(filepath);
+    if (!mapping) { return std::nullopt; }
+    std::uint64_t const size = mapping->size();
+    auto const bytesAt = [&mapping, size](std::uint64_t offset, std::uint64_t n) {
+        if (offset >= size) { return std::span<unsigned char const>(); }
+        return std::span<unsigned char const>(mapping->data() + offset,
+                                              static_cast<std::size_t>(std::min(n, size - offset)));
+    };
+    auto reader = RiffChunkReader::open(bytesAt(0, 12), size);
+    if (!reader) {
+        GHULBUS_LOG(Error, filepath << " is not a wav file.");
+        return std::nullopt;
+    }
+
+    std::optional<WavFormat> format;
+    std::optional<RiffChunk> data_chunk;
+    for (;;) {
+        auto const chunk = reader->next(bytesAt(reader->getNextOffset(), 8));
+        if (!chunk) { break; }
+        if (chunk->is("data")) {
+            data_chunk = chunk;
+            break;
+        }
+        auto const body = bytesAt(chunk->body_offset, chunk->size);
+        if (body.size() < chunk->size) { break; }
+        if (chunk->is("ds64")) {
+            if (!reader->readDs64(body)) { break; }
+        } else if (chunk->is("fmt ")) {
+            auto const fmt = parseWavFmtChunk(body);
+            if (!fmt) {
+                GHULBUS_LOG(Error, "Unsupported fmt chunk in " << filepath << ".");
+                return std::nullopt;
+            }
+            auto const sample_format = getSampleFormat(fmt->format_tag, fmt->bits_per_sample);
+            if (!sample_format || (fmt->channels == 0) || (fmt->sampling_frequency == 0) ||
+                (fmt->block_align != fmt->channels * (fmt->bits_per_sample / 8)))
+            {
+                GHULBUS_LOG(Error, "Unsupported sample format " << fmt->format_tag << " with " <<
+                                   fmt->bits_per_sample << " bits in " << filepath << ".");
+                return std::nullopt;
+            }
+            format = WavFormat{ *sample_format, fmt->channels, fmt->sampling_frequency, fmt->block_align };
+        }
+    }
+    if (!format || !data_chunk) {
+        GHULBUS_LOG(Error, "Missing " << (format ? "data" : "fmt") << " chunk in " << filepath << ".");
+        return std::nullopt;
+    }
+    mapping->adviseSequential();
+    return MappedWavFile(std::move(*mapping), *format, data_chunk->body_offset,
+                         data_chunk->size / format->block_align);
+}
+
+WavFormat const& MappedWavFile::getFormat() const
+{
+    return m_format;
+}
+
+std::uint64_t MappedWavFile::getNumberOfFrames() const
+{
+    return m_frames;
+}
+
+std::span<unsigned char const> MappedWavFile::getFrames(std::uint64_t first_frame, std::uint64_t n_frames) const
+{
+    if (first_frame >= m_frames) { return {}; }
+    n_frames = std::min(n_frames, m_frames - first_frame);
+    return std::span<unsigned char const>(m_mapping.data() + m_dataOffset + first_frame * m_format.block_align,
+                                          static_cast<std::size_t>(n_frames * m_format.block_align));
+}
+
+void MappedWavFile::prefetch(std::uint64_t first_frame, std::uint64_t n_frames)
+{
+    if (first_frame >= m_frames) { return; }
+    n_frames = std::min(n_frames, m_frames - first_frame);
+    m_mapping.adviseWillNeed(m_dataOffset + first_frame * m_format.block_align, n_frames * m_format.block_align);
+}
+
+}
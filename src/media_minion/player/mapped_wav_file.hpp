@@ -0,0 +1,58 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_MAPPED_WAV_FILE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_MAPPED_WAV_FILE_HPP_
+
+#include <media_minion/common/mapped_file.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace media_minion::player {
+
+enum class WavSampleFormat {
+    UnsignedInt8,
+    SignedInt16,
+    SignedInt24,
+    SignedInt32,
+    Float32,
+};
+
+struct WavFormat {
+    WavSampleFormat sample_format;
+    std::uint16_t channels;
+    std::uint32_t sampling_frequency;
+    std::uint16_t block_align;          ///< bytes per frame
+};
+
+/** A RIFF WAVE file mapped into memory, including RF64 files beyond 4 GB and WAVE_FORMAT_EXTENSIBLE headers.
+ * The chunk structure is validated once on open; afterwards audio data is handed out as views into
+ * the mapping without copying.
+ */
+class MappedWavFile {
+private:
+    MappedFile m_mapping;
+    WavFormat m_format;
+    std::uint64_t m_dataOffset;
+    std::uint64_t m_frames;
+public:
+    static std::optional<MappedWavFile> open(std::filesystem::path const& filepath);
+
+    WavFormat const& getFormat() const;
+    std::uint64_t getNumberOfFrames() const;
+
+    /** Raw interleaved sample data for up to n_frames frames starting at first_frame.
+     * The view is shorter if the range extends past the end of the data and stays valid as long as the file.
+     */
+    std::span<unsigned char const> getFrames(std::uint64_t first_frame, std::uint64_t n_frames) const;
+
+    /** Hint that the given frames will be read soon, e.g. after a seek.
+     */
+    void prefetch(std::uint64_t first_frame, std::uint64_t n_frames);
+private:
+    MappedWavFile(MappedFile&& mapping, WavFormat const& format, std::uint64_t data_offset, std::uint64_t frames);
+};
+
+}
+#endif
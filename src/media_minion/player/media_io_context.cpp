@@ -0,0 +1,74 @@
+#include <media_minion/player/media_io_context.hpp>
+
+#include <media_minion/player/http_range_io_context.hpp>
+#include <media_minion/player/mapped_file_io_context.hpp>
+#include <media_minion/player/read_ahead_io_context.hpp>
+#include <media_minion/player/stream_io_context.hpp>
+
+#include <gbBase/Log.hpp>
+
+extern "C" {
+#   include <libavformat/avio.h>
+#   include <libavutil/mem.h>
+}
+
+#include <fstream>
+
+namespace media_minion::player {
+
+MediaIOContext::MediaIOContext(std::size_t buffer_size)
+    :m_ioContextStorage(avio_alloc_context(static_cast<unsigned char*>(av_malloc(buffer_size)),
+                                           static_cast<int>(buffer_size), 0, this,
+                                           MediaIOContext::static_io_read_packet, nullptr,
+                                           MediaIOContext::static_io_seek),
+                        [](AVIOContext* ctx) { av_free(ctx->buffer); av_free(ctx); })
+{
+}
+
+MediaIOContext::~MediaIOContext()
+{
+}
+
+AVIOContext* MediaIOContext::getContext() const
+{
+    return m_ioContextStorage.get();
+}
+
+int MediaIOContext::static_io_read_packet(void* opaque, std::uint8_t* buf, int buf_size)
+{
+    if (buf_size == 0) { return 0; }
+    auto* self = static_cast<MediaIOContext*>(opaque);
+    return self->readPacket(buf, buf_size);
+}
+
+std::int64_t MediaIOContext::static_io_seek(void* opaque, std::int64_t offset, int whence)
+{
+    auto* self = static_cast<MediaIOContext*>(opaque);
+    return self->seek(offset, whence & ~AVSEEK_FORCE);
+}
+
+std::unique_ptr<MediaIOContext> openMediaIOContext(std::filesystem::path const& filepath, IOMode mode)
+{
+    if (auto opt_location = parseHttpLocation(filepath.generic_string()); opt_location) {
+        return std::make_unique<HttpRangeIOContext>(std::move(*opt_location));
+    }
+    if (mode == IOMode::ReadAhead) {
+        auto ret = std::make_unique<ReadAheadIOContext>(filepath);
+        if (!ret->isOpen()) { return nullptr; }
+        return ret;
+    } else if (mode == IOMode::MemoryMapped) {
+        auto opt_file = MappedFile::open(filepath);
+        if (opt_file) {
+            return std::make_unique<MappedFileIOContext>(std::move(*opt_file));
+        }
+        GHULBUS_LOG(Warning, "Unable to map " << filepath << "; falling back to stream io.");
+    }
+    auto fin = std::make_unique<std::ifstream>(filepath, std::ios_base::binary);
+    if (!*fin) {
+        GHULBUS_LOG(Error, "Unable to open " << filepath << ".");
+        return nullptr;
+    }
+    return std::make_unique<StreamIOContext>(std::move(fin), 8192);
+}
+
+}
@@ -0,0 +1,54 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_MEDIA_IO_CONTEXT_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_MEDIA_IO_CONTEXT_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+struct AVIOContext;
+
+namespace media_minion::player {
+
+enum class IOMode {
+    Stream,             ///< read through a std::istream; works for anything, including non-seekable sources
+    MemoryMapped,       ///< serve reads straight from a mapping of the file
+    ReadAhead,          ///< prefetch on a background thread; for slow or network storage
+};
+
+/** Base class for custom ffmpeg I/O.
+ * Owns the AVIOContext and forwards its callbacks to the virtual read and seek functions.
+ */
+class MediaIOContext {
+private:
+    std::unique_ptr<AVIOContext, void(*)(AVIOContext*)> m_ioContextStorage;
+public:
+    explicit MediaIOContext(std::size_t buffer_size);
+    virtual ~MediaIOContext();
+
+    MediaIOContext(MediaIOContext const&) = delete;
+    MediaIOContext& operator=(MediaIOContext const&) = delete;
+
+    AVIOContext* getContext() const;
+protected:
+    /** Fill buf with up to buf_size bytes.
+     * @return Number of bytes read, AVERROR_EOF at the end of the stream or a negative value on error.
+     */
+    virtual int readPacket(std::uint8_t* buf, int buf_size) = 0;
+    /** Seek as with fseek; whence may also be AVSEEK_SIZE.
+     * @return The new position, the stream size for AVSEEK_SIZE or a negative value on error.
+     */
+    virtual std::int64_t seek(std::int64_t offset, int whence) = 0;
+private:
+    static int static_io_read_packet(void* opaque, std::uint8_t* buf, int buf_size);
+    static std::int64_t static_io_seek(void* opaque, std::int64_t offset, int whence);
+};
+
+/** Opens a file for reading through ffmpeg.
+ * Locations of the form http://host:port/... are streamed from the server, regardless of mode.
+ * If a local file cannot be mapped, falls back to IOMode::Stream.
+ * @return nullptr if the file could not be opened at all.
+ */
+std::unique_ptr<MediaIOContext> openMediaIOContext(std::filesystem::path const& filepath, IOMode mode);
+
+}
+#endif
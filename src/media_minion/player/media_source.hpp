@@ -0,0 +1,82 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_MEDIA_SOURCE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_MEDIA_SOURCE_HPP_
+
+#include <media_minion/player/sample_traits.hpp>
+
+#include <gbAudio/Data.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace media_minion::player {
+
+/** A source of audio that writes frames of one sample type into buffers provided by the caller.
+ * The sample type is fixed at compile time; sources convert from whatever their input is while writing,
+ * so consumers neither dispatch on the format of every buffer nor allocate one per read.
+ */
+template<typename SampleType>
+class MediaSource {
+public:
+    using Sample = SampleType;
+
+    virtual ~MediaSource() = default;
+
+    /** 0 if the source is not open.
+     */
+    virtual std::uint32_t getSamplingFrequency() const = 0;
+
+    /** Fills frames from the current position.
+     * @return Number of frames written; less than frames.size() only at the end of the stream.
+     */
+    virtual std::size_t read(std::span<SampleType> frames) = 0;
+
+    /** Positions past the end of the stream leave the stream at its end.
+     */
+    virtual bool seek(std::chrono::microseconds position) = 0;
+
+    virtual std::optional<std::chrono::microseconds> getDuration() const = 0;
+};
+
+/** Sample type of the playback pipeline, from the sources through the crossfader to the sink.
+ */
+using PlaybackSample = GhulbusAudio::SampleStereo16Bit;
+using PlaybackSource = MediaSource<PlaybackSample>;
+
+/** Result of reading from a source that is made up of several tracks, whose sampling frequency may differ.
+ * Such sources end a read early where the sampling frequency changes, so that all frames of a read share it.
+ */
+struct PcmRead {
+    std::size_t frames;                     ///< 0 at the end of the stream
+    std::uint32_t sampling_frequency;
+};
+
+/** Number of sample frames that make up the given duration at the given sampling frequency.
+ */
+inline std::size_t framesForDuration(std::uint32_t sampling_frequency, std::chrono::milliseconds duration)
+{
+    // multiply before dividing; 44.1 and 22.05 kHz are not divisible by 1000
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(sampling_frequency) * duration.count()) / 1000);
+}
+
+/** Index of the sample frame at the given position, rounded to the nearest; negative positions give frame 0.
+ * Rounds both ways like positionForFrames(), so that converting back and forth does not drift.
+ */
+inline std::uint64_t framesForPosition(std::uint32_t sampling_frequency, std::chrono::microseconds position)
+{
+    auto const us = static_cast<std::uint64_t>((position.count() > 0) ? position.count() : 0);
+    return (us * sampling_frequency + 500'000) / 1'000'000;
+}
+
+/** Position of the sample frame with the given index, rounded to the nearest microsecond.
+ */
+inline std::chrono::microseconds positionForFrames(std::uint32_t sampling_frequency, std::uint64_t frames)
+{
+    return std::chrono::microseconds(
+        static_cast<std::int64_t>((frames * 1'000'000 + sampling_frequency / 2) / sampling_frequency));
+}
+
+}
+#endif
@@ -0,0 +1,138 @@
+#include <media_minion/player/null_audio_sink.hpp>
+
+#include <gbBase/Assert.hpp>
+
+#include <variant>
+
+namespace media_minion::player {
+
+namespace {
+std::chrono::nanoseconds getPlaybackDuration(GhulbusAudio::DataVariant const& data)
+{
+    return std::visit([](auto const& d) {
+            return std::chrono::nanoseconds(static_cast<std::int64_t>(
+                static_cast<std::uint64_t>(d.getNumberOfSamples()) * 1'000'000'000 / d.getSamplingFrequency()));
+        }, data);
+}
+}
+
+NullAudioSink::NullAudioSink(std::size_t capacity, ConsumptionRate rate)
+    :m_capacity(capacity), m_rate(rate), m_playing(false)
+{
+    GHULBUS_PRECONDITION(capacity > 0);
+}
+
+std::size_t NullAudioSink::getCapacity() const
+{
+    return m_capacity;
+}
+
+bool NullAudioSink::isRealTime() const
+{
+    return m_rate == ConsumptionRate::RealTime;
+}
+
+void NullAudioSink::enqueue(GhulbusAudio::DataVariant const& data)
+{
+    GHULBUS_PRECONDITION(m_queue.size() < m_capacity);
+    // a device that ran out of data starts again right away once something arrives
+    if (m_queue.empty() && m_playing) { m_frontStart = std::chrono::steady_clock::now(); }
+    m_queue.push_back(data);
+}
+
+void NullAudioSink::play()
+{
+    if (m_playing) { return; }
+    auto const now = std::chrono::steady_clock::now();
+    if (m_pausedAt) {
+        m_frontStart += now - *m_pausedAt;
+        m_pausedAt.reset();
+    } else {
+        m_frontStart = now;
+    }
+    m_playing = true;
+    m_playingSince = now;
+}
+
+void NullAudioSink::pause()
+{
+    if (!m_playing) { return; }
+    auto const now = std::chrono::steady_clock::now();
+    leavePlayingState(now);
+    m_pausedAt = now;
+}
+
+void NullAudioSink::stop()
+{
+    if (m_playing) { leavePlayingState(std::chrono::steady_clock::now()); }
+    m_pausedAt.reset();
+}
+
+void NullAudioSink::clear()
+{
+    stop();
+    m_queue.clear();
+}
+
+void NullAudioSink::pump()
+{
+    if (!m_playing || m_queue.empty()) { return; }
+    auto const now = std::chrono::steady_clock::now();
+    std::size_t n_finished = 0;
+    if (m_rate == ConsumptionRate::Unlimited) {
+        n_finished = m_queue.size();
+    } else {
+        for (auto const& chunk : m_queue) {
+            auto const chunk_end = m_frontStart + getPlaybackDuration(chunk);
+            if (chunk_end > now) { break; }
+            m_frontStart = chunk_end;
+            ++n_finished;
+        }
+    }
+    bool const drained = (n_finished == m_queue.size());
+
+    for (std::size_t i = 0; i < n_finished; ++i) {
+        GhulbusAudio::DataVariant data = std::move(m_queue.front());
+        m_queue.pop_front();
+        consume(data);
+        ++m_statistics.chunks;
+        m_statistics.frames += std::visit([](auto const& d) { return d.getNumberOfSamples(); }, data);
+        m_statistics.audio_duration += std::chrono::duration_cast<std::chrono::microseconds>(getPlaybackDuration(data));
+        if (auto const* next = onBufferFinished ? onBufferFinished() : nullptr; next) {
+            // copying into the retired chunk reuses its storage
+            data = *next;
+            m_queue.push_back(std::move(data));
+        }
+    }
+
+    if (drained && !m_queue.empty() && (m_rate == ConsumptionRate::RealTime)) {
+        // everything finished before this pump; the device was silent until the refills arrived just now
+        auto const gap = std::chrono::duration_cast<std::chrono::microseconds>(now - m_frontStart);
+        ++m_statistics.gaps;
+        m_statistics.gap_duration += gap;
+        if (gap > m_statistics.max_gap) { m_statistics.max_gap = gap; }
+        m_frontStart = now;
+    }
+}
+
+NullAudioSinkStatistics NullAudioSink::getStatistics() const
+{
+    NullAudioSinkStatistics ret = m_statistics;
+    if (m_playing) {
+        ret.wall_time += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_playingSince);
+    }
+    return ret;
+}
+
+void NullAudioSink::consume(GhulbusAudio::DataVariant const&)
+{
+}
+
+void NullAudioSink::leavePlayingState(std::chrono::steady_clock::time_point now)
+{
+    m_statistics.wall_time += std::chrono::duration_cast<std::chrono::microseconds>(now - m_playingSince);
+    m_playing = false;
+}
+
+}
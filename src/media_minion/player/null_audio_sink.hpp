@@ -0,0 +1,66 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_NULL_AUDIO_SINK_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_NULL_AUDIO_SINK_HPP_
+
+#include <media_minion/player/audio_sink.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+namespace media_minion::player {
+
+enum class ConsumptionRate {
+    RealTime,               ///< chunks finish after their playback duration, like on a sound card
+    Unlimited,              ///< every pump() finishes all queued chunks
+};
+
+struct NullAudioSinkStatistics {
+    std::uint64_t chunks = 0;
+    std::uint64_t frames = 0;
+    std::chrono::microseconds audio_duration{ 0 };  ///< playback duration of everything consumed
+    std::chrono::microseconds wall_time{ 0 };       ///< time spent in the playing state
+    std::uint64_t gaps = 0;                         ///< times the queue ran dry while more audio was coming
+    std::chrono::microseconds gap_duration{ 0 };    ///< total silence caused by gaps
+    std::chrono::microseconds max_gap{ 0 };
+};
+
+/** Discards the audio instead of playing it; for running the playback pipeline on machines without sound hardware.
+ * In real-time mode it models a sound card: chunks are consumed at the sampling rate and a pump() that comes too
+ * late to keep the queue filled causes an audible gap.
+ */
+class NullAudioSink : public AudioSink {
+private:
+    std::size_t m_capacity;
+    ConsumptionRate m_rate;
+    std::deque<GhulbusAudio::DataVariant> m_queue;
+    bool m_playing;
+    std::chrono::steady_clock::time_point m_frontStart;         ///< when the first queued chunk started playing
+    std::optional<std::chrono::steady_clock::time_point> m_pausedAt;
+    std::chrono::steady_clock::time_point m_playingSince;
+    NullAudioSinkStatistics m_statistics;
+public:
+    NullAudioSink(std::size_t capacity, ConsumptionRate rate);
+
+    std::size_t getCapacity() const override;
+    bool isRealTime() const override;
+
+    void enqueue(GhulbusAudio::DataVariant const& data) override;
+
+    void play() override;
+    void pause() override;
+    void stop() override;
+    void clear() override;
+    void pump() override;
+
+    NullAudioSinkStatistics getStatistics() const;
+protected:
+    /** Invoked for every chunk that finished playing.
+     */
+    virtual void consume(GhulbusAudio::DataVariant const& data);
+private:
+    void leavePlayingState(std::chrono::steady_clock::time_point now);
+};
+
+}
+#endif
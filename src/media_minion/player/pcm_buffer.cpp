@@ -0,0 +1,80 @@
+#include <media_minion/player/pcm_buffer.hpp>
+
+#include <gbBase/Assert.hpp>
+
+#include <algorithm>
+
+namespace media_minion::player {
+
+PcmBuffer::PcmBuffer()
+    :m_begin(0), m_end(0)
+{
+}
+
+std::size_t PcmBuffer::size() const
+{
+    return m_end - m_begin;
+}
+
+bool PcmBuffer::empty() const
+{
+    return m_end == m_begin;
+}
+
+std::span<PlaybackSample> PcmBuffer::frames()
+{
+    return std::span<PlaybackSample>(m_storage.data() + m_begin, size());
+}
+
+std::span<PlaybackSample const> PcmBuffer::frames() const
+{
+    return std::span<PlaybackSample const>(m_storage.data() + m_begin, size());
+}
+
+std::span<PlaybackSample> PcmBuffer::prepare(std::size_t n_frames)
+{
+    if (m_storage.size() - m_end < n_frames) {
+        if (m_begin > 0) {
+            // reclaim the space of the frames that were consumed already
+            std::copy(m_storage.begin() + m_begin, m_storage.begin() + m_end, m_storage.begin());
+            m_end -= m_begin;
+            m_begin = 0;
+        }
+        if (m_storage.size() - m_end < n_frames) { m_storage.resize(m_end + n_frames); }
+    }
+    return std::span<PlaybackSample>(m_storage.data() + m_end, n_frames);
+}
+
+void PcmBuffer::commit(std::size_t n_frames)
+{
+    GHULBUS_PRECONDITION(n_frames <= m_storage.size() - m_end);
+    m_end += n_frames;
+}
+
+void PcmBuffer::append(std::span<PlaybackSample const> frames)
+{
+    auto const target = prepare(frames.size());
+    std::copy(frames.begin(), frames.end(), target.begin());
+    commit(frames.size());
+}
+
+void PcmBuffer::consume(std::size_t n_frames)
+{
+    GHULBUS_PRECONDITION(n_frames <= size());
+    m_begin += n_frames;
+    if (m_begin == m_end) { clear(); }
+}
+
+void PcmBuffer::truncate(std::size_t n_frames)
+{
+    GHULBUS_PRECONDITION(n_frames <= size());
+    m_end = m_begin + n_frames;
+}
+
+void PcmBuffer::clear()
+{
+    m_begin = 0;
+    m_end = 0;
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_PCM_BUFFER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_PCM_BUFFER_HPP_
+
+#include <media_minion/player/media_source.hpp>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace media_minion::player {
+
+/** Sample frames of the playback pipeline in first-in, first-out order, kept in one contiguous piece of memory.
+ * Taking frames from the front only frees up space that later appends reuse, so a buffer that is filled and
+ * drained at a steady rate stops allocating once it has reached its working size.
+ */
+class PcmBuffer {
+private:
+    std::vector<PlaybackSample> m_storage;
+    std::size_t m_begin;
+    std::size_t m_end;
+public:
+    PcmBuffer();
+
+    std::size_t size() const;
+    bool empty() const;
+
+    std::span<PlaybackSample> frames();
+    std::span<PlaybackSample const> frames() const;
+
+    /** Space for n_frames frames at the back, for the caller to write to and then add with commit().
+     * Invalidates all spans previously obtained from the buffer.
+     */
+    std::span<PlaybackSample> prepare(std::size_t n_frames);
+    /** Adds the first n_frames frames of the space returned by the preceding prepare().
+     */
+    void commit(std::size_t n_frames);
+    void append(std::span<PlaybackSample const> frames);
+
+    /** Removes n_frames frames from the front.
+     */
+    void consume(std::size_t n_frames);
+    /** Keeps only the first n_frames frames.
+     */
+    void truncate(std::size_t n_frames);
+    void clear();
+};
+
+}
+#endif
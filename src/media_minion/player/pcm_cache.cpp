@@ -0,0 +1,233 @@
+#include <media_minion/player/pcm_cache.hpp>
+
+#include <gbBase/Assert.hpp>
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::size_t g_groupSize = 64;
+// bookkeeping overhead per cached block, so that tiny blocks are not free
+constexpr std::size_t g_entryOverhead = 128;
+
+std::string makeIndexKey(std::string const& track_key, std::uint64_t block_index)
+{
+    return track_key + '#' + std::to_string(block_index);
+}
+
+std::uint32_t zigzagEncode(std::int32_t v)
+{
+    return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+}
+
+std::int32_t zigzagDecode(std::uint32_t v)
+{
+    return static_cast<std::int32_t>(v >> 1) ^ -static_cast<std::int32_t>(v & 1);
+}
+
+std::int32_t getChannel(GhulbusAudio::SampleStereo16Bit const& s, std::size_t channel)
+{
+    return (channel == 0) ? s.left : s.right;
+}
+
+std::int32_t predict(std::int32_t const* history, std::size_t i)
+{
+    // fixed second order predictor: continue the slope of the previous two samples
+    if (i == 0) { return 0; }
+    if (i == 1) { return history[0]; }
+    return 2 * history[1] - history[0];
+}
+
+class BitWriter {
+private:
+    std::vector<std::uint8_t>* m_out;
+    std::uint64_t m_acc;
+    unsigned m_bits;
+public:
+    explicit BitWriter(std::vector<std::uint8_t>& out) :m_out(&out), m_acc(0), m_bits(0) {}
+    void write(std::uint32_t value, unsigned n_bits) {
+        m_acc |= static_cast<std::uint64_t>(value) << m_bits;
+        m_bits += n_bits;
+        while (m_bits >= 8) {
+            m_out->push_back(static_cast<std::uint8_t>(m_acc));
+            m_acc >>= 8;
+            m_bits -= 8;
+        }
+    }
+    void flush() {
+        if (m_bits > 0) { m_out->push_back(static_cast<std::uint8_t>(m_acc)); }
+        m_acc = 0;
+        m_bits = 0;
+    }
+};
+
+class BitReader {
+private:
+    std::uint8_t const* m_it;
+    std::uint8_t const* m_end;
+    std::uint64_t m_acc;
+    unsigned m_bits;
+public:
+    BitReader(std::uint8_t const* data, std::size_t size) :m_it(data), m_end(data + size), m_acc(0), m_bits(0) {}
+    std::uint32_t read(unsigned n_bits) {
+        while (m_bits < n_bits) {
+            std::uint64_t const byte = (m_it != m_end) ? *m_it++ : 0;
+            m_acc |= byte << m_bits;
+            m_bits += 8;
+        }
+        std::uint32_t const ret = static_cast<std::uint32_t>(m_acc & ((std::uint64_t(1) << n_bits) - 1));
+        m_acc >>= n_bits;
+        m_bits -= n_bits;
+        return ret;
+    }
+};
+
+std::vector<std::uint8_t> compressBlock(GhulbusAudio::DataStereo16Bit const& data)
+{
+    std::vector<std::uint8_t> ret;
+    std::size_t const n_frames = data.getNumberOfSamples();
+    ret.reserve(n_frames * 2);
+    BitWriter writer(ret);
+    std::uint32_t residuals[g_groupSize];
+    for (std::size_t channel = 0; channel < 2; ++channel) {
+        std::int32_t history[2] = { 0, 0 };
+        for (std::size_t group_start = 0; group_start < n_frames; group_start += g_groupSize) {
+            std::size_t const group_size = std::min(g_groupSize, n_frames - group_start);
+            std::uint32_t max_residual = 0;
+            for (std::size_t i = 0; i < group_size; ++i) {
+                std::size_t const idx = group_start + i;
+                std::int32_t const sample = getChannel(data[idx], channel);
+                residuals[i] = zigzagEncode(sample - predict(history, idx));
+                max_residual = std::max(max_residual, residuals[i]);
+                history[0] = history[1];
+                history[1] = sample;
+            }
+            unsigned width = 0;
+            while ((width < 32) && ((max_residual >> width) != 0)) { ++width; }
+            writer.write(width, 5);
+            for (std::size_t i = 0; i < group_size; ++i) { writer.write(residuals[i], width); }
+        }
+    }
+    writer.flush();
+    return ret;
+}
+
+void decompressBlock(std::vector<std::uint8_t> const& payload, GhulbusAudio::DataStereo16Bit& data)
+{
+    std::size_t const n_frames = data.getNumberOfSamples();
+    BitReader reader(payload.data(), payload.size());
+    for (std::size_t channel = 0; channel < 2; ++channel) {
+        std::int32_t history[2] = { 0, 0 };
+        for (std::size_t group_start = 0; group_start < n_frames; group_start += g_groupSize) {
+            std::size_t const group_size = std::min(g_groupSize, n_frames - group_start);
+            unsigned const width = reader.read(5);
+            for (std::size_t i = 0; i < group_size; ++i) {
+                std::size_t const idx = group_start + i;
+                std::int32_t const sample = predict(history, idx) + zigzagDecode((width > 0) ? reader.read(width) : 0);
+                auto const s16 = static_cast<std::int16_t>(sample);
+                if (channel == 0) { data[idx].left = s16; } else { data[idx].right = s16; }
+                history[0] = history[1];
+                history[1] = sample;
+            }
+        }
+    }
+}
+}
+
+PcmCache::PcmCache(std::size_t budget_bytes, bool compress)
+    :m_budget(budget_bytes), m_compress(compress), m_stats{}
+{
+}
+
+void PcmCache::insert(std::string const& track_key, std::uint64_t block_index,
+                      GhulbusAudio::DataStereo16Bit const& data, bool is_last)
+{
+    GHULBUS_PRECONDITION(is_last || (data.getNumberOfSamples() == block_frames));
+    std::size_t const n_frames = data.getNumberOfSamples();
+    std::size_t const raw_size = n_frames * sizeof(GhulbusAudio::SampleStereo16Bit);
+    if (raw_size + g_entryOverhead > m_budget) { return; }
+
+    Entry entry;
+    entry.track_key = track_key;
+    entry.block_index = block_index;
+    entry.sampling_frequency = data.getSamplingFrequency();
+    entry.n_frames = static_cast<std::uint32_t>(n_frames);
+    entry.is_last = is_last;
+    entry.is_compressed = false;
+    if (m_compress && (n_frames > 0)) {
+        entry.payload = compressBlock(data);
+        entry.is_compressed = (entry.payload.size() < raw_size);
+    }
+    if (!entry.is_compressed) {
+        // noise-like material does not compress; keep it as is to save the decoding time
+        entry.payload.resize(raw_size);
+        if (n_frames > 0) { std::memcpy(entry.payload.data(), &data[0], raw_size); }
+    }
+    entry.payload.shrink_to_fit();
+
+    std::lock_guard lk(m_mtx);
+    std::string const index_key = makeIndexKey(track_key, block_index);
+    if (auto it = m_index.find(index_key); it != m_index.end()) {
+        m_stats.bytes_used -= it->second->payload.size() + g_entryOverhead;
+        m_stats.bytes_uncompressed -= it->second->n_frames * sizeof(GhulbusAudio::SampleStereo16Bit);
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+    m_stats.bytes_used += entry.payload.size() + g_entryOverhead;
+    m_stats.bytes_uncompressed += raw_size;
+    ++m_stats.insertions;
+    m_lru.push_front(std::move(entry));
+    m_index.emplace(index_key, m_lru.begin());
+
+    while (m_stats.bytes_used > m_budget) {
+        Entry const& victim = m_lru.back();
+        m_stats.bytes_used -= victim.payload.size() + g_entryOverhead;
+        m_stats.bytes_uncompressed -= victim.n_frames * sizeof(GhulbusAudio::SampleStereo16Bit);
+        m_index.erase(makeIndexKey(victim.track_key, victim.block_index));
+        m_lru.pop_back();
+        ++m_stats.evictions;
+    }
+}
+
+std::optional<PcmCache::Block> PcmCache::lookup(std::string const& track_key, std::uint64_t block_index)
+{
+    std::unique_lock lk(m_mtx);
+    auto const it = m_index.find(makeIndexKey(track_key, block_index));
+    if (it == m_index.end()) {
+        ++m_stats.misses;
+        return std::nullopt;
+    }
+    ++m_stats.hits;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    Entry const& entry = *it->second;
+
+    Block ret{ GhulbusAudio::DataStereo16Bit{ entry.sampling_frequency }, entry.is_last };
+    ret.data.resize(entry.n_frames);
+    if (entry.n_frames == 0) { return ret; }
+    if (entry.is_compressed) {
+        // decompress outside of the lock; the payload copy is cheaper than blocking other threads
+        std::vector<std::uint8_t> const payload = entry.payload;
+        lk.unlock();
+        decompressBlock(payload, ret.data);
+    } else {
+        std::memcpy(&ret.data[0], entry.payload.data(), entry.payload.size());
+    }
+    return ret;
+}
+
+bool PcmCache::contains(std::string const& track_key, std::uint64_t block_index) const
+{
+    std::lock_guard lk(m_mtx);
+    return m_index.find(makeIndexKey(track_key, block_index)) != m_index.end();
+}
+
+PcmCache::Statistics PcmCache::getStatistics() const
+{
+    std::lock_guard lk(m_mtx);
+    return m_stats;
+}
+
+}
@@ -0,0 +1,75 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_PCM_CACHE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_PCM_CACHE_HPP_
+
+#include <gbAudio/Data.hpp>
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace media_minion::player {
+
+/** Keeps decoded audio in memory, so that replaying a part of a track needs neither disk nor codec.
+ * Tracks are split into blocks of block_frames sample frames; a block is identified by the track key and
+ * its index. When the memory budget is exceeded, the least recently used blocks get evicted.
+ * Blocks can optionally be stored compressed with a fast lossless codec (second order prediction and
+ * bit packing of the residuals), which roughly halves the footprint for typical material.
+ * Access is thread-safe.
+ */
+class PcmCache {
+public:
+    static constexpr std::size_t block_frames = 32768;
+
+    struct Block {
+        GhulbusAudio::DataStereo16Bit data;
+        bool is_last;               ///< the track ends with this block
+    };
+
+    struct Statistics {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t insertions;
+        std::uint64_t evictions;
+        std::size_t bytes_used;
+        std::size_t bytes_uncompressed;     ///< size the cached blocks would occupy without compression
+    };
+private:
+    struct Entry {
+        std::string track_key;
+        std::uint64_t block_index;
+        std::uint32_t sampling_frequency;
+        std::uint32_t n_frames;
+        bool is_last;
+        bool is_compressed;
+        std::vector<std::uint8_t> payload;
+    };
+    using LruList = std::list<Entry>;
+
+    std::size_t m_budget;
+    bool m_compress;
+    mutable std::mutex m_mtx;
+    LruList m_lru;                          ///< most recently used first
+    std::unordered_map<std::string, LruList::iterator> m_index;
+    Statistics m_stats;
+public:
+    PcmCache(std::size_t budget_bytes, bool compress);
+
+    PcmCache(PcmCache const&) = delete;
+    PcmCache& operator=(PcmCache const&) = delete;
+
+    /** @pre data holds block_frames frames, unless is_last is set.
+     */
+    void insert(std::string const& track_key, std::uint64_t block_index, GhulbusAudio::DataStereo16Bit const& data,
+                bool is_last);
+    std::optional<Block> lookup(std::string const& track_key, std::uint64_t block_index);
+    bool contains(std::string const& track_key, std::uint64_t block_index) const;
+
+    Statistics getStatistics() const;
+};
+
+}
+#endif
@@ -0,0 +1,121 @@
+#include <media_minion/player/pcm_fanout.hpp>
+
+#include <media_minion/player/gain_stage.hpp>
+
+#include <gbBase/Assert.hpp>
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+
+namespace media_minion::player {
+
+PcmFanout::PcmFanout(std::chrono::milliseconds max_backlog)
+    :m_backlogStart(0), m_maxBacklog(max_backlog)
+{
+    GHULBUS_PRECONDITION(max_backlog.count() > 0);
+}
+
+std::size_t PcmFanout::addOutput(OutputSettings const& settings)
+{
+    m_outputs.push_back(Output{ settings, m_backlogStart + m_backlog.size(), true, 0 });
+    return m_outputs.size() - 1;
+}
+
+std::size_t PcmFanout::getNumberOfOutputs() const
+{
+    return m_outputs.size();
+}
+
+PcmRead PcmFanout::read(std::size_t output, std::span<PlaybackSample> frames)
+{
+    GHULBUS_PRECONDITION(output < m_outputs.size());
+    Output& out = m_outputs[output];
+    if (out.position == m_backlogStart + m_backlog.size()) {
+        if (!source) { return PcmRead{ 0, 0 }; }
+        if ((m_outputs.size() == 1) && m_backlog.empty() && !out.delayPending && (out.delayFrames == 0)) {
+            // nothing to share; frames pass through without being copied
+            PcmRead const ret = source(frames);
+            m_backlogStart += ret.frames;
+            out.position = m_backlogStart;
+            applyGain(frames.first(ret.frames), out.settings.gain);
+            return ret;
+        }
+        if (!fillBacklog(frames.size())) { return PcmRead{ 0, 0 }; }
+    }
+
+    auto const it_frequency = std::prev(std::upper_bound(begin(m_frequencies), end(m_frequencies),
+                                                         std::make_pair(out.position, ~std::uint32_t(0))));
+    std::uint32_t const sampling_frequency = it_frequency->second;
+    if (out.delayPending) {
+        out.delayPending = false;
+        out.delayFrames = framesForDuration(sampling_frequency, out.settings.delay);
+    }
+    if (out.delayFrames > 0) {
+        std::size_t const n_silence = std::min(out.delayFrames, frames.size());
+        std::fill_n(frames.begin(), n_silence, PlaybackSample{});
+        out.delayFrames -= n_silence;
+        return PcmRead{ n_silence, sampling_frequency };
+    }
+
+    // frames of a single read share their sampling frequency
+    std::uint64_t const part_end = (std::next(it_frequency) != end(m_frequencies)) ?
+                                   std::next(it_frequency)->first : (m_backlogStart + m_backlog.size());
+    std::size_t const n_frames = static_cast<std::size_t>(std::min<std::uint64_t>(frames.size(),
+                                                                                  part_end - out.position));
+    auto const src = m_backlog.frames().subspan(static_cast<std::size_t>(out.position - m_backlogStart), n_frames);
+    std::copy(src.begin(), src.end(), frames.begin());
+    out.position += n_frames;
+    trimBacklog();
+    applyGain(frames.first(n_frames), out.settings.gain);
+    return PcmRead{ n_frames, sampling_frequency };
+}
+
+void PcmFanout::reset()
+{
+    m_backlog.clear();
+    m_backlogStart = 0;
+    m_frequencies.clear();
+    for (auto& o : m_outputs) {
+        o.position = 0;
+        o.delayPending = true;
+        o.delayFrames = 0;
+    }
+}
+
+bool PcmFanout::fillBacklog(std::size_t n_frames)
+{
+    std::uint64_t const backlog_end = m_backlogStart + m_backlog.size();
+    PcmRead const data = source(m_backlog.prepare(n_frames));
+    if (data.frames == 0) { return false; }
+    m_backlog.commit(data.frames);
+    if (m_frequencies.empty() || (m_frequencies.back().second != data.sampling_frequency)) {
+        m_frequencies.emplace_back(backlog_end, data.sampling_frequency);
+    }
+    std::size_t const max_frames = framesForDuration(data.sampling_frequency, m_maxBacklog);
+    if (m_backlog.size() > max_frames) {
+        GHULBUS_LOG(Warning, "Output fell too far behind; skipping ahead.");
+        std::uint64_t const new_start = m_backlogStart + (m_backlog.size() - max_frames);
+        for (auto& o : m_outputs) { o.position = std::max(o.position, new_start); }
+        trimBacklog();
+    }
+    return true;
+}
+
+void PcmFanout::trimBacklog()
+{
+    auto const it_slowest = std::min_element(begin(m_outputs), end(m_outputs),
+                                             [](Output const& lhs, Output const& rhs) {
+                                                 return lhs.position < rhs.position;
+                                             });
+    std::size_t const n_done = static_cast<std::size_t>(std::min<std::uint64_t>(
+        it_slowest->position - std::min(it_slowest->position, m_backlogStart), m_backlog.size()));
+    m_backlog.consume(n_done);
+    m_backlogStart += n_done;
+    // keep the part that the front of the backlog belongs to
+    while ((m_frequencies.size() > 1) && (m_frequencies[1].first <= m_backlogStart)) {
+        m_frequencies.erase(m_frequencies.begin());
+    }
+    if (m_backlog.empty()) { m_frequencies.clear(); }
+}
+
+}
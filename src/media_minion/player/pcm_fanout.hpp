@@ -0,0 +1,68 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_PCM_FANOUT_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_PCM_FANOUT_HPP_
+
+#include <media_minion/player/media_source.hpp>
+#include <media_minion/player/pcm_buffer.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace media_minion::player {
+
+/** Distributes the audio of a single source to several outputs, so that it only needs to be decoded once.
+ * Frames are held back until every output read them. Each output applies its own gain and can start later
+ * than the others by a fixed delay, which compensates for output paths of different latency.
+ * An output that falls more than max_backlog behind the fastest one skips ahead.
+ * A single output without delay reads straight from the source.
+ */
+class PcmFanout {
+public:
+    using DataSource = std::function<PcmRead(std::span<PlaybackSample>)>;
+    struct OutputSettings {
+        float gain = 1.f;
+        std::chrono::milliseconds delay = std::chrono::milliseconds(0);
+    };
+private:
+    struct Output {
+        OutputSettings settings;
+        std::uint64_t position;             ///< frame that the next read of the output starts with
+        bool delayPending;                  ///< the silence for the delay still needs to be determined
+        std::size_t delayFrames;            ///< silence that remains to be played before position
+    };
+    PcmBuffer m_backlog;
+    std::uint64_t m_backlogStart;           ///< position of the front of m_backlog
+    /** First frame and sampling frequency of each part of m_backlog, in order.
+     */
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> m_frequencies;
+    std::vector<Output> m_outputs;
+    std::chrono::milliseconds m_maxBacklog;
+public:
+    explicit PcmFanout(std::chrono::milliseconds max_backlog);
+
+    /** @return Index of the new output for use with read().
+     */
+    std::size_t addOutput(OutputSettings const& settings);
+    std::size_t getNumberOfOutputs() const;
+
+    /** Fills frames with the next audio for the given output. Only the fastest output reads from the source.
+     * @return Number of frames written, which may be less than frames.size(); 0 at the end of the source.
+     */
+    PcmRead read(std::size_t output, std::span<PlaybackSample> frames);
+
+    /** Drops everything that is held back; outputs start over with their delay.
+     */
+    void reset();
+
+    DataSource source;
+private:
+    bool fillBacklog(std::size_t n_frames);
+    void trimBacklog();
+};
+
+}
+#endif
@@ -0,0 +1,79 @@
+#include <media_minion/player/playback_sync.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <variant>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::chrono::seconds g_baselineDuration(3);
+// weight of a new measurement; averages over a few dozen pumps
+constexpr double g_filterWeight = 0.05;
+}
+
+PlaybackSync::PlaybackSync(std::chrono::microseconds start_time, std::chrono::microseconds start_lateness)
+    :m_startTime(start_time), m_startLateness(start_lateness), m_baselineSum(0.0), m_baselineCount(0),
+     m_filtered(0.0)
+{
+}
+
+std::optional<std::chrono::microseconds> PlaybackSync::update(std::chrono::microseconds server_time,
+                                                              std::chrono::microseconds played)
+{
+    auto const elapsed = server_time - m_startTime;
+    double const raw = static_cast<double>((elapsed - played).count());
+    if (!m_baseline) {
+        if (elapsed < g_baselineDuration) {
+            m_baselineSum += raw;
+            ++m_baselineCount;
+            return std::nullopt;
+        }
+        m_baseline = ((m_baselineCount > 0) ? (m_baselineSum / static_cast<double>(m_baselineCount)) : raw) -
+                     static_cast<double>(m_startLateness.count());
+        m_filtered = *m_baseline;
+    }
+    m_filtered += g_filterWeight * (raw - m_filtered);
+    return std::chrono::microseconds(static_cast<std::int64_t>(m_filtered - *m_baseline));
+}
+
+void adjustFrameCount(GhulbusAudio::DataVariant& data, std::int64_t n)
+{
+    if (n == 0) { return; }
+    std::visit([n](auto& d) {
+            std::size_t const size = d.getNumberOfSamples();
+            std::size_t const count = std::min<std::size_t>(static_cast<std::size_t>(std::abs(n)), size);
+            if (count == 0) { return; }
+            // frames k * step for k in [1, count]; chunks too short to spread the adjustment take it at the end
+            std::size_t const step = size / (count + 1);
+            std::size_t const spread = (step > 0) ? count : 0;
+            if (n > 0) {
+                // compacting front to back never overwrites a frame that is still to be read
+                std::size_t out = 0;
+                std::size_t dropped = 0;
+                for (std::size_t i = 0; i < size; ++i) {
+                    if ((dropped < spread) && (i == (dropped + 1) * step)) {
+                        ++dropped;
+                        continue;
+                    }
+                    d[out++] = d[i];
+                }
+                d.resize(out - (count - spread));
+            } else {
+                // expanding back to front never overwrites a frame that is still to be read
+                d.resize(size + count);
+                std::size_t out = size + count;
+                for (std::size_t k = spread; k < count; ++k) { d[--out] = d[size - 1]; }
+                std::size_t repeats = spread;
+                for (std::size_t i = size; i-- > 0;) {
+                    d[--out] = d[i];
+                    if ((repeats > 0) && (i == repeats * step)) {
+                        d[--out] = d[i];
+                        --repeats;
+                    }
+                }
+            }
+        }, data);
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_PLAYBACK_SYNC_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_PLAYBACK_SYNC_HPP_
+
+#include <gbAudio/Data.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace media_minion::player {
+
+/** Follows how far an output that was started at a given time on the server clock deviates from it.
+ * Outputs only report progress per finished buffer, so a single measurement is off by up to a buffer and a
+ * pump interval. Measurements are smoothed and taken relative to their average over the first seconds after
+ * the start, which also cancels the constant latency of the device. How late the output was started is known
+ * and kept out of the baseline, so that it gets corrected like any other deviation.
+ */
+class PlaybackSync {
+private:
+    std::chrono::microseconds m_startTime;
+    std::chrono::microseconds m_startLateness;
+    double m_baselineSum;
+    std::size_t m_baselineCount;
+    std::optional<double> m_baseline;
+    double m_filtered;
+public:
+    /** @param[in] start_time Time on the server clock that the output was meant to start at.
+     * @param[in] start_lateness How much later than that the output was actually started.
+     */
+    PlaybackSync(std::chrono::microseconds start_time, std::chrono::microseconds start_lateness);
+
+    /** @param[in] server_time Current time on the server clock.
+     * @param[in] played Content played since the start.
+     * @return Deviation of the output; positive if it is behind the server clock.
+     *         std::nullopt while the baseline is still being established.
+     */
+    std::optional<std::chrono::microseconds> update(std::chrono::microseconds server_time,
+                                                    std::chrono::microseconds played);
+};
+
+/** Drops (n > 0) or repeats (n < 0) |n| single frames at evenly spaced positions of data.
+ * Spread out over a chunk, this is inaudible for the few frames per second needed to follow a clock.
+ * Works in place; data only reallocates if repeating frames exceeds its capacity.
+ */
+void adjustFrameCount(GhulbusAudio::DataVariant& data, std::int64_t n);
+
+}
+#endif
@@ -22,6 +22,12 @@ int main(int argc, char* argv[])
         return 1;
     }
     media_minion::player::Configuration const& config = *opt_config;
+    if (config.zones.size() > 1) {
+        // gbAudio only opens the default device; several zones would all end up playing on it
+        GHULBUS_LOG(Critical, "Only a single zone can be played on the audio device; " << config.zones.size() <<
+                              " zones are configured.");
+        return 1;
+    }
 
     QApplication the_app(argc, argv);
 
@@ -0,0 +1,436 @@
+#include <media_minion/player/player_engine.hpp>
+
+#include <media_minion/player/audio_sink.hpp>
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/replay_gain.hpp>
+
+#include <gbBase/Assert.hpp>
+#include <gbBase/Log.hpp>
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace media_minion::player {
+
+namespace {
+// time from receiving a remote command until it is audible that we aim for on a LAN
+constexpr std::chrono::milliseconds g_commandLatencyBudget(50);
+constexpr std::chrono::seconds g_telemetryInterval(10);
+// far more than the controls can issue between two pumps
+constexpr std::size_t g_commandBusCapacity = 64;
+// decoded audio kept for zones that lag behind because of their delay
+constexpr std::chrono::seconds g_maxFanoutBacklog(25);
+// deviations from the server clock below this are inaudible between rooms
+constexpr std::chrono::milliseconds g_syncTolerance(2);
+// leaves the smoothed deviation time to settle on the result of the previous correction
+constexpr std::chrono::seconds g_syncCorrectionInterval(5);
+
+bool isAnyRealTime(std::vector<std::unique_ptr<AudioSink>> const& sinks)
+{
+    return std::any_of(begin(sinks), end(sinks), [](auto const& s) { return s->isRealTime(); });
+}
+}
+
+PlayerEngine::PlayerEngine(Configuration const& config, std::vector<std::unique_ptr<AudioSink>> sinks,
+                           std::shared_ptr<TrackMetadataCache> metadata_cache)
+    :m_config(config), m_io_ctx(1), m_audioTimer(m_io_ctx), m_telemetryTimer(m_io_ctx), m_startTimer(m_io_ctx),
+     m_pumpInterval(isAnyRealTime(sinks) ? config.latency_profile.pump_interval : std::chrono::milliseconds(0)),
+     m_fanout(g_maxFanoutBacklog), m_finishedOutputs(0), m_wavStream("nearer.wav"),
+     m_metadataCache(metadata_cache ? std::move(metadata_cache) :
+                     std::make_shared<TrackMetadataCache>(config.cache_directory / "track_metadata.json")),
+     m_loudnessScanner(*m_metadataCache,
+                       FfmpegStreamOptions{ IOMode::ReadAhead, config.cache_directory, nullptr, config.decoder }),
+     m_pcmCache((config.pcm_cache.budget_bytes > 0) ?
+                std::make_unique<PcmCache>(config.pcm_cache.budget_bytes, config.pcm_cache.compress) : nullptr),
+     m_trackQueue(FfmpegStreamOptions{ config.io_mode, config.cache_directory, &m_telemetry, config.decoder },
+                  config.crossfade, m_pcmCache.get(), config.pcm_cache.prefetch_duration,
+                  config.threads.decoder),
+     m_useWavStream(config.playlist.empty()), m_playbackState(PlaybackState::Stopped),
+     m_outputFlushed(true), m_memoryLocked(false),
+     m_serverConnection(config.server_host.empty() ? nullptr :
+                        std::make_unique<ServerConnection>(config.server_host, config.server_port)),
+     m_commandBus(g_commandBusCapacity), m_drainScheduled(false), m_nextTicket(1), m_shutdownRequested(false)
+{
+    if (m_config.replaygain_mode != ReplayGainMode::Off) {
+        m_trackQueue.onGainRequest = [this](std::filesystem::path const& track) {
+            return lookupReplayGain(*m_metadataCache, track, m_config.replaygain_mode, m_config.replaygain_preamp_db);
+        };
+        // analysed once per file; later runs find everything in the cache
+        for (auto const& location : m_config.playlist) {
+            m_loudnessScanner.scan(location);
+        }
+    }
+    for (auto const& location : m_config.playlist) {
+        m_trackQueue.enqueue(location);
+    }
+    GHULBUS_PRECONDITION(sinks.size() == m_config.zones.size());
+    m_fanout.source = [this](std::span<PlaybackSample> frames) { return readAudio(frames); };
+    for (std::size_t i = 0; i < sinks.size(); ++i) {
+        ZoneSettings const& zone = m_config.zones[i];
+        std::size_t const fanout_output = m_fanout.addOutput(PcmFanout::OutputSettings{
+            static_cast<float>(std::pow(10.0, zone.volume_db / 20.0)), zone.delay });
+        auto& output = m_outputs.emplace_back(std::make_unique<AudioPlayer>(std::move(sinks[i]),
+                                                                            config.latency_profile, &m_telemetry));
+        output->onDataRequest = [this, fanout_output](std::span<PlaybackSample> frames) {
+            return m_fanout.read(fanout_output, frames);
+        };
+        output->onPlaybackFinished = [this]() {
+            // zones with a delay finish later than the others
+            if ((++m_finishedOutputs == m_outputs.size()) && onPlaybackFinished) { onPlaybackFinished(); }
+        };
+    }
+    m_trackQueue.onTrackChanged = [this](std::filesystem::path const&) { reportState(); };
+
+    if (m_serverConnection) {
+        m_serverConnection->onThreadStarted = [this]() {
+            m_telemetry.recordThreadTuning("network", tuneCurrentThread("network", m_config.threads.network));
+        };
+        m_serverConnection->onConnected = [this]() {
+            m_serverConnection->send(serializeHello(m_config.player_name));
+            boost::asio::post(m_io_ctx, [this]() { reportState(); });
+        };
+        m_serverConnection->onMessage = [this](std::string msg) {
+            auto const received = std::chrono::steady_clock::now();
+            auto command = parsePlayerCommand(msg);
+            if (!command) { return; }
+            command->received = received;
+            if (!pushCommand(std::move(*command), CommandOrigin::Remote)) {
+                GHULBUS_LOG(Warning, "Command bus is full; dropping remote command.");
+            }
+        };
+    }
+}
+
+PlayerEngine::~PlayerEngine()
+{
+    if (m_thread.joinable()) { m_thread.join(); }
+}
+
+void PlayerEngine::run()
+{
+    GHULBUS_PRECONDITION(!m_thread.joinable());
+    m_thread = std::thread([this]() { do_run(); });
+    if (m_serverConnection) { m_serverConnection->start(); }
+}
+
+void PlayerEngine::requestShutdown()
+{
+    if (m_serverConnection) { m_serverConnection->requestShutdown(); }
+    // the output belongs to the playback thread, which stops it and the io_context on its next pump
+    m_shutdownRequested = true;
+    if (!m_thread.joinable()) { m_io_ctx.stop(); }
+}
+
+std::optional<std::uint64_t> PlayerEngine::submitCommand(PlayerCommand command)
+{
+    command.received = std::chrono::steady_clock::now();
+    return pushCommand(std::move(command), CommandOrigin::Local);
+}
+
+TelemetryReport PlayerEngine::takeTelemetryReport()
+{
+    TelemetryReport ret = m_telemetry.takeReport();
+    ret.network_rtt = getRoundTripTime();
+    return ret;
+}
+
+void PlayerEngine::do_run()
+{
+    m_telemetry.recordThreadTuning("audio", tuneCurrentThread("audio", m_config.threads.audio));
+    scheduleTimer();
+    scheduleTelemetryReport();
+
+    m_io_ctx.post([this]() {
+            playOutputs();
+            m_playbackState = PlaybackState::Playing;
+            m_outputFlushed = false;
+            reportState();
+        });
+
+    m_io_ctx.run();
+}
+
+void PlayerEngine::scheduleTimer()
+{
+    m_audioTimer.expires_from_now(m_pumpInterval);
+    m_audioTimer.async_wait([this](boost::system::error_code const& ec) {
+            if (ec) { return; }
+            if (m_shutdownRequested) {
+                for (auto& output : m_outputs) { output->stop(); }
+                m_io_ctx.stop();
+                return;
+            }
+            auto const lateness = std::chrono::steady_clock::now() - m_audioTimer.expiry();
+            Stopwatch pump_time;
+            processCommands();
+            for (auto& output : m_outputs) { output->pump(); }
+            updatePlaybackSync();
+            if (m_config.threads.lock_memory && !m_memoryLocked && (m_playbackState == PlaybackState::Playing)) {
+                // only memory mapped at this point gets locked; by now the threads and playback buffers exist
+                m_telemetry.recordMemoryLock(lockProcessMemory());
+                m_memoryLocked = true;
+            }
+            m_telemetry.recordPump(std::chrono::duration_cast<std::chrono::microseconds>(lateness),
+                                   pump_time.elapsed());
+            scheduleTimer();
+        });
+}
+
+void PlayerEngine::scheduleTelemetryReport()
+{
+    m_telemetryTimer.expires_from_now(g_telemetryInterval);
+    m_telemetryTimer.async_wait([this](boost::system::error_code const& ec) {
+            if (ec) { return; }
+            TelemetryReport const report = takeTelemetryReport();
+            if (report.underruns > 0) {
+                GHULBUS_LOG(Warning, report.underruns << " underruns in the last " << report.interval.count() <<
+                                     "ms; longest disk read " << report.disk_read.max.count() <<
+                                     "us, network read " << report.network_read.max.count() << "us, decode " <<
+                                     report.decode.max.count() << "us, refill " << report.refill.max.count() <<
+                                     "us, pump delay " << report.pump_lateness.max.count() << "us.");
+            }
+            sendToServer(serializeTelemetryReport(report));
+            if (onTelemetryReport) { onTelemetryReport(report); }
+            scheduleTelemetryReport();
+        });
+}
+
+PcmRead PlayerEngine::readAudio(std::span<PlaybackSample> frames)
+{
+    if (m_useWavStream) { return PcmRead{ m_wavStream.read(frames), m_wavStream.getSamplingFrequency() }; }
+    PcmRead const ret = m_trackQueue.read(frames);
+    if ((ret.frames == 0) && (m_playbackState == PlaybackState::Playing)) {
+        m_playbackState = PlaybackState::Stopped;
+        reportState();
+    }
+    return ret;
+}
+
+std::optional<std::uint64_t> PlayerEngine::pushCommand(PlayerCommand command, CommandOrigin origin)
+{
+    std::uint64_t const ticket = m_nextTicket.fetch_add(1, std::memory_order_relaxed);
+    if (!m_commandBus.push(EngineCommand{ std::move(command), origin, ticket })) { return std::nullopt; }
+    // don't leave the command waiting for the next pump; that alone may take up most of the latency budget.
+    // posting locks and allocates, so only the first command of a burst does it.
+    // the fences pair with processCommands(): either the drain sees the command or this sees the cleared flag
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!m_drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+        boost::asio::post(m_io_ctx, [this]() { processCommands(); });
+    }
+    return ticket;
+}
+
+void PlayerEngine::processCommands()
+{
+    // cleared before draining, so a command pushed during the drain posts another one
+    m_drainScheduled.store(false, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (auto engine_command = m_commandBus.pop()) {
+        executeCommand(*engine_command);
+    }
+}
+
+void PlayerEngine::executeCommand(EngineCommand const& engine_command)
+{
+    PlayerCommand const& command = engine_command.command;
+    bool const is_remote = (engine_command.origin == CommandOrigin::Remote);
+    GHULBUS_LOG(Trace, "Executing " << (is_remote ? "remote" : "local") << " command '" <<
+                       toString(command.type) << "'.");
+    if (command.start_at) {
+        if (m_serverConnection && m_serverConnection->getClock().isSynchronized()) {
+            m_pendingStart = command.start_at;
+        } else {
+            GHULBUS_LOG(Warning, "Clock is not synchronized with the server yet; starting immediately.");
+        }
+    }
+    // most commands act on the outputs directly or flush them; the others only change what gets decoded next
+    bool waits_for_output = false;
+    switch (command.type) {
+    case PlayerCommandType::Play:
+        // a synchronized start needs empty outputs, at the price of the few buffers queued before the pause
+        if ((m_playbackState == PlaybackState::Paused) && !m_outputFlushed && !m_pendingStart) {
+            for (auto& output : m_outputs) { output->resume(); }
+        } else if (m_playbackState != PlaybackState::Playing) {
+            clearOutputs();
+            playOutputs();
+        }
+        m_playbackState = PlaybackState::Playing;
+        m_outputFlushed = false;
+        break;
+    case PlayerCommandType::Pause:
+        if (m_playbackState == PlaybackState::Playing) {
+            for (auto& output : m_outputs) { output->pause(); }
+            m_playbackState = PlaybackState::Paused;
+            m_playbackSyncs.clear();
+            // outputs that are still waiting for their start time have nothing to resume
+            if (m_startTimer.cancel() > 0) { m_outputFlushed = true; }
+        }
+        break;
+    case PlayerCommandType::Stop:
+        clearOutputs();
+        m_trackQueue.restartCurrentTrack();
+        m_playbackState = PlaybackState::Stopped;
+        m_outputFlushed = true;
+        break;
+    case PlayerCommandType::Seek:
+        m_trackQueue.seekCurrentTrack(command.position);
+        restartOutput();
+        break;
+    case PlayerCommandType::Next:
+        m_trackQueue.skipCurrentTrack();
+        restartOutput();
+        break;
+    case PlayerCommandType::Restart:
+        m_trackQueue.restartCurrentTrack();
+        restartOutput();
+        break;
+    case PlayerCommandType::Enqueue:
+        if (m_config.replaygain_mode != ReplayGainMode::Off) { m_loudnessScanner.scan(command.location); }
+        m_trackQueue.enqueue(command.location);
+        if (m_useWavStream) {
+            // the test tone makes way for real content
+            m_useWavStream = false;
+            restartOutput();
+        }
+        break;
+    case PlayerCommandType::Clear:
+        clearOutputs();
+        m_trackQueue.clear();
+        m_playbackState = PlaybackState::Stopped;
+        m_outputFlushed = true;
+        break;
+    case PlayerCommandType::Repeat:
+        // takes effect at the end of the track; nothing queued for the devices is affected
+        m_trackQueue.setRepeatCurrent(command.repeat);
+        waits_for_output = true;
+        break;
+    case PlayerCommandType::Loop:
+        if (command.loop) {
+            m_trackQueue.setLoop(std::pair<std::chrono::microseconds, std::chrono::microseconds>(*command.loop));
+            // the jump to the start of the loop has to be audible immediately, like a seek
+            restartOutput();
+        } else {
+            m_trackQueue.setLoop(std::nullopt);
+            waits_for_output = true;
+        }
+        break;
+    }
+    m_pendingStart.reset();
+
+    // such an effect only becomes audible once the devices have played what is queued ahead of it
+    auto const queued_output = waits_for_output ? getQueuedOutput() : std::chrono::microseconds(0);
+    CommandLatency const latency{
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - command.received) +
+            queued_output,
+        queued_output, getRoundTripTime() };
+    auto const estimated_latency = latency.processing + (latency.network_rtt ? (*latency.network_rtt / 2) :
+                                                                               std::chrono::microseconds(0));
+    if (estimated_latency > g_commandLatencyBudget) {
+        GHULBUS_LOG(Warning, (is_remote ? "Remote" : "Local") << " command '" << toString(command.type) <<
+                             "' took " << estimated_latency.count() << "us to take effect.");
+    }
+    if (is_remote) { sendToServer(serializeCommandAck(command, latency)); }
+    reportState();
+    if (onCommandCompleted) {
+        onCommandCompleted(CommandCompletion{ engine_command.ticket, command.type, engine_command.origin,
+                                              m_playbackState });
+    }
+}
+
+void PlayerEngine::playOutputs()
+{
+    m_finishedOutputs = 0;
+    if (m_pendingStart) {
+        auto const server_start = *m_pendingStart;
+        auto const start_time = m_serverConnection->getClock().toLocalTime(server_start);
+        if (start_time && (*start_time > std::chrono::steady_clock::now())) {
+            // decoding ahead of time keeps the start from being delayed by the first reads
+            for (auto& output : m_outputs) { output->preload(); }
+            m_startTimer.expires_at(*start_time);
+            m_startTimer.async_wait([this, server_start](boost::system::error_code const& ec) {
+                    if (ec) { return; }
+                    startOutputs(server_start);
+                });
+            return;
+        }
+        GHULBUS_LOG(Warning, "Start time of a synchronized command has already passed; starting immediately.");
+    }
+    for (auto& output : m_outputs) { output->play(); }
+}
+
+void PlayerEngine::startOutputs(std::chrono::microseconds server_start)
+{
+    auto const lateness = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - m_startTimer.expiry());
+    for (auto& output : m_outputs) { output->play(); }
+    m_playbackSyncs.assign(m_outputs.size(), PlaybackSync(server_start, lateness));
+    m_lastSyncCorrection = std::chrono::steady_clock::now();
+}
+
+void PlayerEngine::clearOutputs()
+{
+    m_startTimer.cancel();
+    m_playbackSyncs.clear();
+    for (auto& output : m_outputs) { output->clear(); }
+    m_fanout.reset();
+}
+
+void PlayerEngine::updatePlaybackSync()
+{
+    if (m_playbackSyncs.empty()) { return; }
+    auto const now = std::chrono::steady_clock::now();
+    auto const server_time = m_serverConnection->getClock().toServerTime(now);
+    if (!server_time) { return; }
+    bool const may_correct = (now - m_lastSyncCorrection >= g_syncCorrectionInterval);
+    bool corrected = false;
+    for (std::size_t i = 0; i < m_outputs.size(); ++i) {
+        auto const deviation = m_playbackSyncs[i].update(*server_time, m_outputs[i]->getPlayedDuration());
+        if (!deviation || !may_correct || m_outputs[i]->isCorrecting()) { continue; }
+        if (std::chrono::abs(*deviation) > g_syncTolerance) {
+            GHULBUS_LOG(Trace, "Output " << i << " is off the server clock by " << deviation->count() << "us.");
+            m_outputs[i]->correctPosition(*deviation);
+            corrected = true;
+        }
+    }
+    if (corrected) { m_lastSyncCorrection = now; }
+}
+
+void PlayerEngine::restartOutput()
+{
+    // drop everything that is queued up for the devices, so the change is audible immediately
+    clearOutputs();
+    m_outputFlushed = (m_playbackState != PlaybackState::Playing);
+    if (!m_outputFlushed) { playOutputs(); }
+}
+
+void PlayerEngine::reportState()
+{
+    if (!m_serverConnection) { return; }
+    PlayerState const state{ m_playbackState,
+                             m_useWavStream ? std::nullopt : m_trackQueue.getCurrentTrack(),
+                             m_trackQueue.getNumberOfQueuedTracks() };
+    m_serverConnection->send(serializePlayerState(state));
+}
+
+void PlayerEngine::sendToServer(std::string msg)
+{
+    if (m_serverConnection) { m_serverConnection->send(std::move(msg)); }
+}
+
+std::optional<std::chrono::microseconds> PlayerEngine::getRoundTripTime() const
+{
+    if (!m_serverConnection) { return std::nullopt; }
+    return m_serverConnection->getRoundTripTime();
+}
+
+std::chrono::microseconds PlayerEngine::getQueuedOutput() const
+{
+    // the zone with the most audio queued is the last one to play the effect
+    std::chrono::microseconds ret(0);
+    for (auto const& output : m_outputs) { ret = std::max(ret, output->getQueuedDuration()); }
+    return ret;
+}
+
+}
@@ -0,0 +1,133 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_PLAYER_ENGINE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_PLAYER_ENGINE_HPP_
+
+#include <media_minion/player/audio_player.hpp>
+#include <media_minion/player/command_bus.hpp>
+#include <media_minion/player/configuration.hpp>
+#include <media_minion/player/control_protocol.hpp>
+#include <media_minion/player/loudness_scanner.hpp>
+#include <media_minion/player/pcm_cache.hpp>
+#include <media_minion/player/pcm_fanout.hpp>
+#include <media_minion/player/playback_sync.hpp>
+#include <media_minion/player/server_connection.hpp>
+#include <media_minion/player/telemetry.hpp>
+#include <media_minion/player/track_metadata_cache.hpp>
+#include <media_minion/player/track_queue.hpp>
+#include <media_minion/player/wav_stream.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace media_minion::player {
+
+/** The complete playback pipeline: decoding, the track queue, the outputs and the remote control.
+ * There is one output per zone of the configuration. They all play the same stream, which is decoded once.
+ * All playback state is owned by a single thread that is started by run().
+ * Other threads only talk to it through the command bus, which the playback thread drains as soon as a command
+ * arrives and again on every pump.
+ * Remote commands may carry a start time on the server clock, at which all players of the server start together;
+ * from then on, the outputs follow the server clock.
+ */
+class PlayerEngine {
+private:
+    Configuration m_config;
+
+    boost::asio::io_context m_io_ctx;
+    boost::asio::steady_timer m_audioTimer;
+    boost::asio::steady_timer m_telemetryTimer;
+    boost::asio::steady_timer m_startTimer;
+    std::chrono::milliseconds m_pumpInterval;
+
+    Telemetry m_telemetry;
+    PcmFanout m_fanout;
+    std::vector<std::unique_ptr<AudioPlayer>> m_outputs;    ///< one per zone, fed from m_fanout
+    std::size_t m_finishedOutputs;
+    WavStream m_wavStream;
+    std::shared_ptr<TrackMetadataCache> m_metadataCache;
+    LoudnessScanner m_loudnessScanner;
+    std::unique_ptr<PcmCache> m_pcmCache;
+    TrackQueue m_trackQueue;
+    bool m_useWavStream;
+    PlaybackState m_playbackState;          ///< only touched from the io_context thread
+    bool m_outputFlushed;                   ///< nothing queued for the device; resuming needs a fresh play()
+    bool m_memoryLocked;                    ///< locked after the first pump, once the playback buffers exist
+    std::optional<std::chrono::microseconds> m_pendingStart;    ///< server time for the next playOutputs()
+    std::vector<PlaybackSync> m_playbackSyncs;      ///< one per output while following the server clock
+    std::chrono::steady_clock::time_point m_lastSyncCorrection;
+
+    std::unique_ptr<ServerConnection> m_serverConnection;  ///< null if no server is configured
+
+    CommandBus m_commandBus;
+    std::atomic<bool> m_drainScheduled;         ///< a processCommands() is posted and did not start draining yet
+    std::atomic<std::uint64_t> m_nextTicket;
+    std::atomic<bool> m_shutdownRequested;
+
+    std::thread m_thread;
+public:
+    /** @param[in] sinks Receive the audio output, one for each of the zones in config.
+     *                   If none of them is real-time, they are pumped continuously instead of on the pump interval.
+     * @param[in] metadata_cache Optional; allows engines of the same process to share their analysis results.
+     */
+    PlayerEngine(Configuration const& config, std::vector<std::unique_ptr<AudioSink>> sinks,
+                 std::shared_ptr<TrackMetadataCache> metadata_cache = nullptr);
+    ~PlayerEngine();
+
+    PlayerEngine(PlayerEngine const&) = delete;
+    PlayerEngine& operator=(PlayerEngine const&) = delete;
+
+    void run();
+    /** Thread-safe; playback stops on the next pump of the playback thread.
+     */
+    void requestShutdown();
+
+    /** Queues a command for the playback thread and wakes it up. Thread-safe and never blocks.
+     * @return Ticket of the command for matching it with its onCommandCompleted notification;
+     *         std::nullopt if the command bus is full.
+     */
+    std::optional<std::uint64_t> submitCommand(PlayerCommand command);
+
+    /** Returns everything recorded since the previous report. Thread-safe.
+     */
+    TelemetryReport takeTelemetryReport();
+
+    /** Invoked from the playback thread once everything in the queue has been played by all outputs.
+     */
+    std::function<void()> onPlaybackFinished;
+    /** Invoked from the playback thread for each of the periodic telemetry reports.
+     */
+    std::function<void(TelemetryReport const&)> onTelemetryReport;
+    /** Invoked from the playback thread once a command took effect, for local and remote commands alike.
+     */
+    std::function<void(CommandCompletion const&)> onCommandCompleted;
+private:
+    void do_run();
+    void scheduleTimer();
+    void scheduleTelemetryReport();
+    PcmRead readAudio(std::span<PlaybackSample> frames);
+    std::optional<std::uint64_t> pushCommand(PlayerCommand command, CommandOrigin origin);
+    void processCommands();
+    void executeCommand(EngineCommand const& engine_command);
+    void playOutputs();
+    void startOutputs(std::chrono::microseconds server_start);
+    void clearOutputs();
+    void updatePlaybackSync();
+    void restartOutput();
+    void reportState();
+    void sendToServer(std::string msg);
+    std::optional<std::chrono::microseconds> getRoundTripTime() const;
+    std::chrono::microseconds getQueuedOutput() const;
+};
+
+}
+#endif
@@ -0,0 +1,187 @@
+#include <media_minion/player/configuration.hpp>
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/null_audio_sink.hpp>
+#include <media_minion/player/player_engine.hpp>
+#include <media_minion/player/telemetry.hpp>
+#include <media_minion/player/wav_file_audio_sink.hpp>
+
+#include <media_minion/common/logging.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** Runs the playback pipeline without audio hardware.
+ * Plays the tracks given on the command line (or the playlist from the config) into a null sink or a wav file
+ * for each zone of the first stream and prints the timing of the pipeline. With a limit on underruns, the exit
+ * code tells whether the limit was kept, so that playback performance can be regression-tested on build machines.
+ */
+
+namespace {
+struct Options {
+    std::filesystem::path config_file = "player_config.json";
+    std::optional<std::filesystem::path> wav_output;
+    media_minion::player::ConsumptionRate rate = media_minion::player::ConsumptionRate::RealTime;
+    bool connect = false;
+    std::optional<std::uint64_t> max_underruns;
+    std::vector<std::filesystem::path> tracks;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: mm_player_headless [options] [track...]\n"
+                 "  --config <file>        player configuration (default: player_config.json)\n"
+                 "  --wav <file>           write the output to a wav file instead of discarding it;\n"
+                 "                         additional zones get a numbered file each\n"
+                 "  --unlimited            consume audio as fast as it is decoded instead of in real time\n"
+                 "  --connect              connect to the server from the configuration\n"
+                 "  --max-underruns <n>    fail if more than n underruns occur\n"
+                 "Without tracks, the playlist from the configuration is played.\n";
+}
+
+std::optional<Options> parseOptions(int argc, char* argv[])
+{
+    Options ret;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view const arg = argv[i];
+        bool const has_value = (i + 1 < argc);
+        if ((arg == "--config") && has_value) {
+            ret.config_file = argv[++i];
+        } else if ((arg == "--wav") && has_value) {
+            ret.wav_output = argv[++i];
+        } else if (arg == "--unlimited") {
+            ret.rate = media_minion::player::ConsumptionRate::Unlimited;
+        } else if (arg == "--connect") {
+            ret.connect = true;
+        } else if ((arg == "--max-underruns") && has_value) {
+            std::string_view const value = argv[++i];
+            std::uint64_t n;
+            auto const [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), n);
+            if ((ec != std::errc{}) || (ptr != value.data() + value.size())) { return std::nullopt; }
+            ret.max_underruns = n;
+        } else if (arg.substr(0, 2) == "--") {
+            return std::nullopt;
+        } else {
+            ret.tracks.emplace_back(std::u8string(arg.begin(), arg.end()));
+        }
+    }
+    return ret;
+}
+
+std::filesystem::path getZoneOutputPath(std::filesystem::path const& wav_output, std::size_t zone_index)
+{
+    if (zone_index == 0) { return wav_output; }
+    std::filesystem::path ret = wav_output;
+    ret.replace_filename(wav_output.stem().string() + "_" + std::to_string(zone_index + 1) +
+                         wav_output.extension().string());
+    return ret;
+}
+
+void printTiming(char const* name, media_minion::player::TimingStatistics const& t)
+{
+    std::cout << "  " << name << ": " << t.count << " x avg " << t.average().count() << "us, max " <<
+                 t.max.count() << "us\n";
+}
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace media_minion::player;
+    auto const guard_logging = media_minion::init_logging("mm_player_headless.log");
+
+    auto const opt_options = parseOptions(argc, argv);
+    if (!opt_options) {
+        printUsage();
+        return 1;
+    }
+    Options const& options = *opt_options;
+
+    auto opt_config = parsePlayerConfig(options.config_file);
+    if (!opt_config) {
+        GHULBUS_LOG(Critical, "Invalid config file.");
+        return 1;
+    }
+    Configuration& config = *opt_config;
+    if (!options.tracks.empty()) { config.playlist = options.tracks; }
+    if (config.playlist.empty()) {
+        GHULBUS_LOG(Critical, "Nothing to play.");
+        return 1;
+    }
+    if (!options.connect) { config.server_host.clear(); }
+    config = splitStreams(config).front();
+
+    FfmpegStream::initializeFfmpeg();
+
+    NullAudioSinkStatistics sink_statistics;
+    TelemetryReport telemetry;
+    {
+        std::vector<std::unique_ptr<AudioSink>> sinks;
+        NullAudioSink const* first_sink = nullptr;
+        for (std::size_t i = 0; i < config.zones.size(); ++i) {
+            std::unique_ptr<NullAudioSink> sink = options.wav_output ?
+                std::make_unique<WavFileAudioSink>(getZoneOutputPath(*options.wav_output, i),
+                                                   config.latency_profile.buffer_count, options.rate) :
+                std::make_unique<NullAudioSink>(config.latency_profile.buffer_count, options.rate);
+            if (!first_sink) { first_sink = sink.get(); }
+            sinks.push_back(std::move(sink));
+        }
+        NullAudioSink const& sink_ref = *first_sink;
+        PlayerEngine engine(config, std::move(sinks));
+
+        std::promise<void> finished;
+        bool is_finished = false;
+        engine.onTelemetryReport = [&telemetry, &is_finished](TelemetryReport const& report) {
+            if (!is_finished) { mergeReports(telemetry, report); }
+        };
+        engine.onPlaybackFinished = [&]() {
+            if (is_finished) { return; }
+            is_finished = true;
+            sink_statistics = sink_ref.getStatistics();
+            mergeReports(telemetry, engine.takeTelemetryReport());
+            finished.set_value();
+        };
+
+        engine.run();
+        finished.get_future().wait();
+        engine.requestShutdown();
+    }
+
+    auto const audio_ms = sink_statistics.audio_duration.count() / 1000;
+    auto const wall_ms = sink_statistics.wall_time.count() / 1000;
+    std::cout << "Played " << audio_ms << "ms of audio in " << wall_ms << "ms";
+    if (wall_ms > 0) { std::cout << " (" << static_cast<double>(audio_ms) / static_cast<double>(wall_ms) << "x)"; }
+    std::cout << ".\n";
+    std::cout << "Output latency: " << config.latency_profile.buffer_count << " x " <<
+                 config.latency_profile.buffer_duration.count() << "ms buffers, pumped every " <<
+                 config.latency_profile.pump_interval.count() << "ms.\n";
+    std::cout << "Underruns: " << telemetry.underruns << ", " << sink_statistics.gap_duration.count() / 1000 <<
+                 "ms of silence in total, longest gap " << sink_statistics.max_gap.count() / 1000 << "ms.\n";
+    if (telemetry.queue_depth_samples > 0) {
+        std::cout << "Queue depth: min " << telemetry.queue_depth_min << ", avg " <<
+                     static_cast<double>(telemetry.queue_depth_sum) / static_cast<double>(telemetry.queue_depth_samples) <<
+                     " of " << telemetry.queue_capacity << ".\n";
+    }
+    std::cout << "Timings:\n";
+    printTiming("refill", telemetry.refill);
+    printTiming("disk read", telemetry.disk_read);
+    printTiming("network read", telemetry.network_read);
+    printTiming("decode", telemetry.decode);
+    printTiming("pump lateness", telemetry.pump_lateness);
+    printTiming("pump duration", telemetry.pump_duration);
+    std::cout << std::flush;
+
+    if (options.max_underruns && (telemetry.underruns > *options.max_underruns)) {
+        GHULBUS_LOG(Error, "Too many underruns: " << telemetry.underruns << ".");
+        return 2;
+    }
+    return 0;
+}
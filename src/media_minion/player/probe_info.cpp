@@ -0,0 +1,116 @@
+#include <media_minion/player/probe_info.hpp>
+
+#include <media_minion/common/binary_io.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::array<char, 4> g_probeInfoMagic = { 'M', 'M', 'P', 'I' };
+constexpr std::uint32_t g_probeInfoVersion = 1;
+/// Extradata is a codec header of at most a few kilobytes; anything bigger is a corrupt file.
+constexpr std::uint64_t g_maxExtradataSize = 1 << 20;
+
+template<typename T>
+bool readField(unsigned char const*& it, unsigned char const* end, T& field)
+{
+    auto const v = readLE(it, end, sizeof(T));
+    if (!v) { return false; }
+    field = static_cast<T>(*v);
+    return true;
+}
+}
+
+std::vector<unsigned char> serializeProbeInfo(ProbeInfo const& probe_info)
+{
+    std::vector<unsigned char> ret;
+    ret.reserve(128 + probe_info.extradata.size());
+    ret.insert(end(ret), begin(g_probeInfoMagic), end(g_probeInfoMagic));
+    writeLE(ret, g_probeInfoVersion, 4);
+    auto const write = [&ret](auto v) { writeLE(ret, static_cast<std::uint64_t>(v), sizeof(v)); };
+    write(probe_info.library_version);
+    write(probe_info.stream_count);
+    write(probe_info.stream_index);
+    write(probe_info.codec_id);
+    write(probe_info.sample_format);
+    write(probe_info.sampling_frequency);
+    write(probe_info.channels);
+    write(probe_info.channel_mask);
+    write(probe_info.bit_rate);
+    write(probe_info.frame_size);
+    write(probe_info.block_align);
+    write(probe_info.bits_per_coded_sample);
+    write(probe_info.bits_per_raw_sample);
+    write(probe_info.initial_padding);
+    write(probe_info.trailing_padding);
+    write(probe_info.time_base_num);
+    write(probe_info.time_base_den);
+    write(probe_info.start_time);
+    write(probe_info.duration);
+    write(probe_info.container_duration);
+    write(probe_info.duration_estimation_method);
+    writeLE(ret, probe_info.extradata.size(), 4);
+    ret.insert(end(ret), begin(probe_info.extradata), end(probe_info.extradata));
+    return ret;
+}
+
+std::optional<ProbeInfo> deserializeProbeInfo(unsigned char const* data, std::size_t size)
+{
+    unsigned char const* it = data;
+    unsigned char const* const end = data + size;
+    if ((size < g_probeInfoMagic.size()) ||
+        (std::memcmp(data, g_probeInfoMagic.data(), g_probeInfoMagic.size()) != 0))
+    {
+        return std::nullopt;
+    }
+    it += g_probeInfoMagic.size();
+    auto const version = readLE(it, end, 4);
+    if (!version || (*version != g_probeInfoVersion)) { return std::nullopt; }
+
+    ProbeInfo ret;
+    bool const fields_ok = readField(it, end, ret.library_version) && readField(it, end, ret.stream_count) &&
+        readField(it, end, ret.stream_index) && readField(it, end, ret.codec_id) &&
+        readField(it, end, ret.sample_format) && readField(it, end, ret.sampling_frequency) &&
+        readField(it, end, ret.channels) && readField(it, end, ret.channel_mask) &&
+        readField(it, end, ret.bit_rate) && readField(it, end, ret.frame_size) &&
+        readField(it, end, ret.block_align) && readField(it, end, ret.bits_per_coded_sample) &&
+        readField(it, end, ret.bits_per_raw_sample) && readField(it, end, ret.initial_padding) &&
+        readField(it, end, ret.trailing_padding) && readField(it, end, ret.time_base_num) &&
+        readField(it, end, ret.time_base_den) && readField(it, end, ret.start_time) &&
+        readField(it, end, ret.duration) && readField(it, end, ret.container_duration) &&
+        readField(it, end, ret.duration_estimation_method);
+    if (!fields_ok) { return std::nullopt; }
+    auto const extradata_size = readLE(it, end, 4);
+    if (!extradata_size || (*extradata_size > g_maxExtradataSize) ||
+        (*extradata_size != static_cast<std::uint64_t>(end - it)))
+    {
+        return std::nullopt;
+    }
+    ret.extradata.assign(it, end);
+    return ret;
+}
+
+bool saveProbeInfo(ProbeInfo const& probe_info, std::filesystem::path const& filepath)
+{
+    std::vector<unsigned char> const buffer = serializeProbeInfo(probe_info);
+    // several streams may open the same file at once
+    return writeFileAtomically(filepath, buffer.data(), buffer.size());
+}
+
+std::optional<ProbeInfo> loadProbeInfo(std::filesystem::path const& filepath)
+{
+    std::ifstream fin(filepath, std::ios_base::binary);
+    if (!fin) { return std::nullopt; }
+    std::vector<unsigned char> buffer((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    auto ret = deserializeProbeInfo(buffer.data(), buffer.size());
+    if (!ret) { GHULBUS_LOG(Warning, "Invalid probe info file " << filepath); }
+    return ret;
+}
+
+}
@@ -0,0 +1,53 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_PROBE_INFO_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_PROBE_INFO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace media_minion::player {
+
+/** What avformat_find_stream_info found out about the audio stream of a file.
+ * Probing can read and decode megabytes for some containers. With the results at hand, later opens of the same
+ * file configure the decoder directly and start reading packets right after the container header.
+ * Values are stored as plain integers, so that this header does not depend on the ffmpeg headers.
+ */
+struct ProbeInfo {
+    std::uint32_t library_version;          ///< LIBAVFORMAT_VERSION_INT of the library that did the probing
+    std::uint32_t stream_count;
+    std::int32_t stream_index;
+    std::int32_t codec_id;
+    std::int32_t sample_format;
+    std::int32_t sampling_frequency;
+    std::int32_t channels;
+    std::uint64_t channel_mask;             ///< 0 for layouts that are not described by a mask
+    std::int64_t bit_rate;
+    std::int32_t frame_size;
+    std::int32_t block_align;
+    std::int32_t bits_per_coded_sample;
+    std::int32_t bits_per_raw_sample;
+    std::int32_t initial_padding;           ///< encoder delay in frames
+    std::int32_t trailing_padding;
+    std::int32_t time_base_num;
+    std::int32_t time_base_den;
+    std::int64_t start_time;                ///< in units of the stream's time base
+    std::int64_t duration;                  ///< in units of the stream's time base
+    std::int64_t container_duration;        ///< in AV_TIME_BASE units
+    std::int32_t duration_estimation_method;
+    std::vector<unsigned char> extradata;
+};
+
+/** Binary sidecar format; all values are little endian:
+ *   "MMPI", u32 version, then the fields of ProbeInfo in declaration order with their natural width,
+ *   u32 extradata size, extradata.
+ */
+std::vector<unsigned char> serializeProbeInfo(ProbeInfo const& probe_info);
+std::optional<ProbeInfo> deserializeProbeInfo(unsigned char const* data, std::size_t size);
+
+bool saveProbeInfo(ProbeInfo const& probe_info, std::filesystem::path const& filepath);
+std::optional<ProbeInfo> loadProbeInfo(std::filesystem::path const& filepath);
+
+}
+#endif
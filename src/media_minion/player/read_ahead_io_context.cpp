@@ -0,0 +1,237 @@
+#include <media_minion/player/read_ahead_io_context.hpp>
+
+#include <gbBase/Assert.hpp>
+#include <gbBase/Log.hpp>
+
+extern "C" {
+#   include <libavformat/avio.h>
+#   include <libavutil/error.h>
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::size_t g_ioBufferSize = 32 * 1024;
+constexpr std::int64_t g_blockSize = 256 * 1024;
+constexpr std::size_t g_minWindow = 2 * g_blockSize;
+constexpr std::size_t g_maxWindow = 32 * 1024 * 1024;
+constexpr std::int64_t g_maxBackendRead = 4 * g_blockSize;
+
+std::int64_t alignDown(std::int64_t offset)
+{
+    return offset - (offset % g_blockSize);
+}
+}
+
+ReadAheadIOContext::ReadAheadIOContext(std::filesystem::path const& filepath)
+    :MediaIOContext(g_ioBufferSize), m_fileSize(-1), m_openFailed(false), m_position(0), m_prefetchPosition(0), m_generation(0),
+     m_window(g_minWindow), m_sequentialBytes(0), m_backendError(false), m_shutdownRequested(false), m_stats{}
+{
+    // we do our own buffering in large chunks; avoid a second copy through the filebuf
+    m_fin.rdbuf()->pubsetbuf(nullptr, 0);
+    m_fin.open(filepath, std::ios_base::binary);
+    if (!m_fin) {
+        GHULBUS_LOG(Error, "Unable to open " << filepath << ".");
+        m_openFailed = true;
+        m_backendError = true;
+    } else {
+        m_fin.seekg(0, std::ios_base::end);
+        m_fileSize = m_fin.tellg();
+        m_fin.seekg(0, std::ios_base::beg);
+    }
+    m_stats.read_ahead_window = m_window;
+    m_worker = std::thread([this]() { workerThread(); });
+}
+
+ReadAheadIOContext::~ReadAheadIOContext()
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_shutdownRequested = true;
+    }
+    m_cvWorker.notify_all();
+    m_worker.join();
+
+    GHULBUS_LOG(Info, "Read-ahead io: " << m_stats.hits << " hits, " << m_stats.misses << " misses, " <<
+                       m_stats.total_stall_time.count() << "us total stall (max " <<
+                       m_stats.max_stall_time.count() << "us), " << m_stats.backend_reads << " backend reads, " <<
+                       m_stats.cancelled_prefetches << " cancelled.");
+}
+
+bool ReadAheadIOContext::isOpen() const
+{
+    return !m_openFailed;
+}
+
+ReadAheadIOContext::Statistics ReadAheadIOContext::getStatistics()
+{
+    std::lock_guard lk(m_mtx);
+    return m_stats;
+}
+
+int ReadAheadIOContext::readPacket(std::uint8_t* buf, int buf_size)
+{
+    std::unique_lock lk(m_mtx);
+    bool stalled = false;
+    std::chrono::steady_clock::time_point stall_start;
+    for (;;) {
+        if (Block const* block = findBlock(m_position); block) {
+            std::int64_t const block_offset = m_position - block->offset;
+            std::int64_t const n = std::min<std::int64_t>(buf_size,
+                                                          static_cast<std::int64_t>(block->data.size()) - block_offset);
+            std::memcpy(buf, block->data.data() + block_offset, static_cast<std::size_t>(n));
+            m_position += n;
+            m_stats.bytes_read += n;
+            if (stalled) {
+                auto const stall_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - stall_start);
+                ++m_stats.misses;
+                m_stats.total_stall_time += stall_time;
+                m_stats.max_stall_time = std::max(m_stats.max_stall_time, stall_time);
+            } else {
+                ++m_stats.hits;
+            }
+
+            // sequential access: widen the window once a full window has been consumed
+            m_sequentialBytes += n;
+            if ((m_sequentialBytes >= static_cast<std::int64_t>(m_window)) && (m_window < g_maxWindow)) {
+                m_window = std::min(m_window * 2, g_maxWindow);
+                m_stats.read_ahead_window = m_window;
+                m_sequentialBytes = 0;
+            }
+            dropConsumedBlocks();
+            lk.unlock();
+            m_cvWorker.notify_one();
+            return static_cast<int>(n);
+        }
+
+        if ((m_fileSize >= 0) && (m_position >= m_fileSize)) { return AVERROR_EOF; }
+        if (m_backendError) { return AVERROR(EIO); }
+
+        if (!stalled) {
+            stalled = true;
+            stall_start = std::chrono::steady_clock::now();
+            m_cvWorker.notify_one();
+        }
+        m_cvReader.wait(lk);
+    }
+}
+
+std::int64_t ReadAheadIOContext::seek(std::int64_t offset, int whence)
+{
+    std::unique_lock lk(m_mtx);
+    std::int64_t new_position;
+    switch (whence)
+    {
+    case SEEK_SET: new_position = offset; break;
+    case SEEK_CUR: new_position = m_position + offset; break;
+    case SEEK_END:
+        if (m_fileSize < 0) { return -1; }
+        new_position = m_fileSize + offset;
+        break;
+    case AVSEEK_SIZE: return m_fileSize;
+    default:
+        GHULBUS_UNREACHABLE_MESSAGE("Invalid whence token in seek.");
+    }
+    if (new_position < 0) { return -1; }
+
+    bool const is_buffered = (findBlock(new_position) != nullptr) ||
+                             ((new_position >= m_position) && (new_position <= m_prefetchPosition));
+    if (!is_buffered) {
+        resetWindow(new_position);
+        lk.unlock();
+        m_cvWorker.notify_one();
+        return new_position;
+    }
+    m_position = new_position;
+    return new_position;
+}
+
+void ReadAheadIOContext::workerThread()
+{
+    std::unique_lock lk(m_mtx);
+    std::vector<unsigned char> read_buffer;
+    for (;;) {
+        m_cvWorker.wait(lk, [this]() {
+                if (m_shutdownRequested) { return true; }
+                if (m_backendError) { return false; }
+                return (m_prefetchPosition < m_fileSize) &&
+                       (m_prefetchPosition < m_position + static_cast<std::int64_t>(m_window));
+            });
+        if (m_shutdownRequested) { return; }
+
+        std::uint64_t const generation = m_generation;
+        std::int64_t const read_offset = m_prefetchPosition;
+        // read in larger chunks when the window is large; always end on a block boundary
+        std::int64_t const read_size = std::min(
+            std::clamp<std::int64_t>(alignDown(static_cast<std::int64_t>(m_window) / 4), g_blockSize, g_maxBackendRead),
+            m_fileSize - read_offset);
+        GHULBUS_ASSERT(read_size > 0);
+
+        lk.unlock();
+        read_buffer.resize(static_cast<std::size_t>(read_size));
+        m_fin.clear();
+        m_fin.seekg(read_offset, std::ios_base::beg);
+        m_fin.read(reinterpret_cast<char*>(read_buffer.data()), read_size);
+        std::int64_t const bytes_read = m_fin.gcount();
+        lk.lock();
+
+        ++m_stats.backend_reads;
+        m_stats.backend_bytes_read += bytes_read;
+        if (generation != m_generation) {
+            // a seek happened while we were reading; nobody needs this data anymore
+            ++m_stats.cancelled_prefetches;
+            continue;
+        }
+        if (bytes_read <= 0) {
+            GHULBUS_LOG(Error, "Read-ahead io: read from backing file failed at offset " << read_offset << ".");
+            m_backendError = true;
+            m_cvReader.notify_all();
+            continue;
+        }
+        read_buffer.resize(static_cast<std::size_t>(bytes_read));
+        m_blocks.push_back(Block{ read_offset, read_buffer });
+        m_prefetchPosition = read_offset + bytes_read;
+        m_cvReader.notify_all();
+    }
+}
+
+ReadAheadIOContext::Block const* ReadAheadIOContext::findBlock(std::int64_t offset) const
+{
+    for (auto const& b : m_blocks) {
+        if ((offset >= b.offset) && (offset < b.offset + static_cast<std::int64_t>(b.data.size()))) {
+            return &b;
+        }
+    }
+    return nullptr;
+}
+
+void ReadAheadIOContext::dropConsumedBlocks()
+{
+    // keep one consumed block around; demuxers like to seek back a little while probing
+    while ((m_blocks.size() > 1) &&
+           (m_blocks[1].offset + static_cast<std::int64_t>(m_blocks[1].data.size()) <= m_position))
+    {
+        m_blocks.pop_front();
+    }
+}
+
+void ReadAheadIOContext::resetWindow(std::int64_t new_position)
+{
+    m_blocks.clear();
+    ++m_generation;
+    m_position = new_position;
+    m_prefetchPosition = alignDown(new_position);
+    m_window = g_minWindow;
+    m_stats.read_ahead_window = m_window;
+    m_sequentialBytes = 0;
+    // a failed read may succeed at a different position; a file that could not be opened never will
+    m_backendError = m_openFailed;
+}
+
+}
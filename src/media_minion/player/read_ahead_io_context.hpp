@@ -0,0 +1,79 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_READ_AHEAD_IO_CONTEXT_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_READ_AHEAD_IO_CONTEXT_HPP_
+
+#include <media_minion/player/media_io_context.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace media_minion::player {
+
+/** Prefetches file data on a background thread, so that slow storage does not block the decoder.
+ * Reads from the backing file are done in large chunks aligned to the block size. The amount of data
+ * read ahead starts out small and grows while the file is being read sequentially; a seek outside
+ * of the prefetched range drops all buffered data, shrinks the window again and abandons the prefetch
+ * that was in flight.
+ */
+class ReadAheadIOContext : public MediaIOContext {
+public:
+    struct Statistics {
+        std::uint64_t hits;                     ///< reads that were served from prefetched data
+        std::uint64_t misses;                   ///< reads that had to wait for the backing file
+        std::uint64_t bytes_read;               ///< bytes handed out to ffmpeg
+        std::uint64_t backend_reads;            ///< reads from the backing file
+        std::uint64_t backend_bytes_read;
+        std::uint64_t cancelled_prefetches;     ///< backend reads whose data got discarded due to a seek
+        std::chrono::microseconds total_stall_time;
+        std::chrono::microseconds max_stall_time;
+        std::size_t read_ahead_window;          ///< current size of the read-ahead window in bytes
+    };
+private:
+    struct Block {
+        std::int64_t offset;
+        std::vector<unsigned char> data;
+    };
+
+    std::ifstream m_fin;
+    std::int64_t m_fileSize;
+    bool m_openFailed;                          ///< unlike read errors, this is not cleared by a seek
+
+    std::mutex m_mtx;
+    std::condition_variable m_cvWorker;
+    std::condition_variable m_cvReader;
+    std::deque<Block> m_blocks;                 ///< contiguous range of prefetched data, ordered by offset
+    std::int64_t m_position;
+    std::int64_t m_prefetchPosition;            ///< next offset the worker will read from
+    std::uint64_t m_generation;                 ///< incremented by seeks that invalidate the prefetched data
+    std::size_t m_window;
+    std::int64_t m_sequentialBytes;             ///< bytes consumed since the last window adjustment
+    bool m_backendError;
+    bool m_shutdownRequested;
+    Statistics m_stats;
+
+    std::thread m_worker;
+public:
+    explicit ReadAheadIOContext(std::filesystem::path const& filepath);
+    ~ReadAheadIOContext() override;
+
+    bool isOpen() const;
+
+    Statistics getStatistics();
+protected:
+    int readPacket(std::uint8_t* buf, int buf_size) override;
+    std::int64_t seek(std::int64_t offset, int whence) override;
+private:
+    void workerThread();
+    Block const* findBlock(std::int64_t offset) const;
+    void dropConsumedBlocks();
+    void resetWindow(std::int64_t new_position);
+};
+
+}
+#endif
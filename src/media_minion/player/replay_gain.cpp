@@ -0,0 +1,45 @@
+#include <media_minion/player/replay_gain.hpp>
+
+#include <media_minion/player/track_metadata_cache.hpp>
+
+#include <media_minion/common/file_signature.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+namespace media_minion::player {
+
+float computeReplayGain(LoudnessInfo const& loudness, double preamp_db)
+{
+    double const gain_db = replaygain_reference_loudness - loudness.integrated_loudness + preamp_db;
+    double gain = std::pow(10.0, gain_db / 20.0);
+    if (loudness.true_peak > 0.0) {
+        gain = std::min(gain, 1.0 / loudness.true_peak);
+    }
+    return static_cast<float>(gain);
+}
+
+float lookupReplayGain(TrackMetadataCache const& cache, std::filesystem::path const& track, ReplayGainMode mode,
+                       double preamp_db)
+{
+    if (mode == ReplayGainMode::Off) { return 1.f; }
+    auto const signature = getFileSignature(track);
+    if (!signature) { return 1.f; }
+    auto const entry = cache.lookup(*signature);
+    if (!entry) { return 1.f; }
+    if (mode == ReplayGainMode::Album) {
+        auto const album = cache.getAlbum(entry->album);
+        std::vector<LoudnessInfo> album_loudness;
+        album_loudness.reserve(album.size());
+        std::transform(album.begin(), album.end(), std::back_inserter(album_loudness),
+                       [](TrackMetadataCache::Entry const& e) { return e.loudness; });
+        if (auto const combined = combineLoudness(album_loudness); combined) {
+            return computeReplayGain(*combined, preamp_db);
+        }
+    }
+    return computeReplayGain(entry->loudness, preamp_db);
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_REPLAY_GAIN_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_REPLAY_GAIN_HPP_
+
+#include <media_minion/player/loudness_analyzer.hpp>
+
+#include <filesystem>
+
+namespace media_minion::player {
+
+class TrackMetadataCache;
+
+enum class ReplayGainMode {
+    Off,
+    Track,      ///< every track is normalized to the reference loudness on its own
+    Album,      ///< tracks of an album keep their relative loudness
+};
+
+/** Loudness that tracks are normalized to, as in ReplayGain 2.0.
+ */
+constexpr double replaygain_reference_loudness = -18.0;
+
+/** Linear gain that brings audio of the given loudness to the reference level.
+ * The gain is reduced if necessary to keep the true peak from exceeding full scale.
+ */
+float computeReplayGain(LoudnessInfo const& loudness, double preamp_db);
+
+/** Gain for a track according to mode, from the results stored in cache.
+ * Tracks that were not analysed yet are played without any gain.
+ */
+float lookupReplayGain(TrackMetadataCache const& cache, std::filesystem::path const& track, ReplayGainMode mode,
+                       double preamp_db);
+
+}
+#endif
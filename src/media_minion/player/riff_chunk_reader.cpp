@@ -0,0 +1,86 @@
+#include <media_minion/player/riff_chunk_reader.hpp>
+
+#include <media_minion/common/binary_io.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::uint16_t g_formatExtensible = 0xfffe;
+/// Trailing 14 bytes of the KSDATAFORMAT_SUBTYPE guids; the first two bytes hold the plain format tag.
+constexpr std::array<unsigned char, 14> g_subformatGuidTail = {
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71
+};
+constexpr std::uint32_t g_rf64SizePlaceholder = 0xffffffff;
+}
+
+bool RiffChunk::is(std::string_view chunk_id) const
+{
+    return (chunk_id.size() == 4) && (std::memcmp(id, chunk_id.data(), 4) == 0);
+}
+
+RiffChunkReader::RiffChunkReader(std::uint64_t file_size, bool is_rf64)
+    :m_fileSize(file_size), m_isRf64(is_rf64), m_nextOffset(12)
+{
+}
+
+std::optional<RiffChunkReader> RiffChunkReader::open(std::span<unsigned char const> header, std::uint64_t file_size)
+{
+    if ((file_size < 12) || !(hasId(header, 0, "RIFF") || hasId(header, 0, "RF64")) || !hasId(header, 8, "WAVE")) {
+        return std::nullopt;
+    }
+    return RiffChunkReader(file_size, hasId(header, 0, "RF64"));
+}
+
+std::uint64_t RiffChunkReader::getNextOffset() const
+{
+    return m_nextOffset;
+}
+
+std::optional<RiffChunk> RiffChunkReader::next(std::span<unsigned char const> chunk_header)
+{
+    if ((m_nextOffset + 8 > m_fileSize) || (chunk_header.size() < 8)) { return std::nullopt; }
+    RiffChunk ret;
+    std::memcpy(ret.id, chunk_header.data(), 4);
+    ret.body_offset = m_nextOffset + 8;
+    ret.size = readLE(chunk_header.data() + 4, 4);
+    std::uint64_t const available = m_fileSize - ret.body_offset;
+    if (ret.is("data")) {
+        if (m_isRf64 && (ret.size == g_rf64SizePlaceholder) && m_rf64DataSize) { ret.size = *m_rf64DataSize; }
+        if ((ret.size == 0) || (ret.size > available)) { ret.size = available; }
+    }
+    // chunks are padded to even sizes
+    m_nextOffset = ret.body_offset + ret.size + (ret.size & 1);
+    return ret;
+}
+
+bool RiffChunkReader::readDs64(std::span<unsigned char const> body)
+{
+    if (body.size() < 24) { return false; }
+    m_rf64DataSize = readLE(body.data() + 8, 8);
+    return true;
+}
+
+std::optional<WavFmtChunk> parseWavFmtChunk(std::span<unsigned char const> body)
+{
+    if (body.size() < 16) { return std::nullopt; }
+    WavFmtChunk ret{ static_cast<std::uint16_t>(readLE(body.data(), 2)),
+                     static_cast<std::uint16_t>(readLE(body.data() + 2, 2)),
+                     static_cast<std::uint32_t>(readLE(body.data() + 4, 4)),
+                     static_cast<std::uint16_t>(readLE(body.data() + 12, 2)),
+                     static_cast<std::uint16_t>(readLE(body.data() + 14, 2)) };
+    if (ret.format_tag == g_formatExtensible) {
+        if ((body.size() < 40) || !std::equal(g_subformatGuidTail.begin(), g_subformatGuidTail.end(),
+                                              body.data() + 26))
+        {
+            return std::nullopt;
+        }
+        ret.format_tag = static_cast<std::uint16_t>(readLE(body.data() + 24, 2));
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,69 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_RIFF_CHUNK_READER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_RIFF_CHUNK_READER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace media_minion::player {
+
+struct RiffChunk {
+    char id[4];
+    std::uint64_t body_offset;
+    std::uint64_t size;                 ///< size of the body, without the padding byte
+
+    bool is(std::string_view chunk_id) const;
+};
+
+/** Walks the chunks of a RIFF WAVE file, including RF64 files beyond 4 GB.
+ * The reader only interprets the bytes it is handed, so that it works on mapped memory as well as on small
+ * reads from a file: read 8 bytes at getNextOffset() and pass them to next().
+ */
+class RiffChunkReader {
+private:
+    std::uint64_t m_fileSize;
+    bool m_isRf64;
+    std::optional<std::uint64_t> m_rf64DataSize;
+    std::uint64_t m_nextOffset;
+public:
+    /** @param[in] header The first 12 bytes of the file.
+     * @return std::nullopt if the file is not a RIFF or RF64 WAVE file.
+     */
+    static std::optional<RiffChunkReader> open(std::span<unsigned char const> header, std::uint64_t file_size);
+
+    std::uint64_t getNextOffset() const;
+
+    /** @param[in] chunk_header The 8 bytes at getNextOffset().
+     * @return std::nullopt once the end of the file is reached.
+     *         The size of the data chunk is taken from the ds64 chunk for RF64 files and is clamped to the
+     *         end of the file, since writers that were interrupted or stream their output leave it too big
+     *         or at zero.
+     */
+    std::optional<RiffChunk> next(std::span<unsigned char const> chunk_header);
+
+    /** Takes note of the 64 bit sizes of an RF64 file; to be called with the body of the ds64 chunk.
+     * @return false if the chunk is too short.
+     */
+    bool readDs64(std::span<unsigned char const> body);
+private:
+    RiffChunkReader(std::uint64_t file_size, bool is_rf64);
+};
+
+/** Contents of the fmt chunk, with WAVE_FORMAT_EXTENSIBLE resolved to the plain format tag.
+ */
+struct WavFmtChunk {
+    std::uint16_t format_tag;
+    std::uint16_t channels;
+    std::uint32_t sampling_frequency;
+    std::uint16_t block_align;
+    std::uint16_t bits_per_sample;
+};
+
+/** @return std::nullopt if body is too short or has an extensible subformat other than the plain format tags.
+ */
+std::optional<WavFmtChunk> parseWavFmtChunk(std::span<unsigned char const> body);
+
+}
+#endif
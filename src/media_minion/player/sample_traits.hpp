@@ -0,0 +1,47 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_SAMPLE_TRAITS_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_SAMPLE_TRAITS_HPP_
+
+#include <gbAudio/Data.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace media_minion::player {
+
+/** Compile-time description of the gbAudio sample frame types.
+ * Frames are tightly packed arrays of channels values of ValueType; 8 bit values are unsigned with an
+ * offset of 128, 16 bit values are signed.
+ */
+template<typename SampleType>
+struct SampleTraits;
+
+template<>
+struct SampleTraits<GhulbusAudio::SampleMono8Bit> {
+    using DataType = GhulbusAudio::DataMono8Bit;
+    using ValueType = std::uint8_t;
+    static constexpr std::size_t channels = 1;
+};
+
+template<>
+struct SampleTraits<GhulbusAudio::SampleStereo8Bit> {
+    using DataType = GhulbusAudio::DataStereo8Bit;
+    using ValueType = std::uint8_t;
+    static constexpr std::size_t channels = 2;
+};
+
+template<>
+struct SampleTraits<GhulbusAudio::SampleMono16Bit> {
+    using DataType = GhulbusAudio::DataMono16Bit;
+    using ValueType = std::int16_t;
+    static constexpr std::size_t channels = 1;
+};
+
+template<>
+struct SampleTraits<GhulbusAudio::SampleStereo16Bit> {
+    using DataType = GhulbusAudio::DataStereo16Bit;
+    using ValueType = std::int16_t;
+    static constexpr std::size_t channels = 2;
+};
+
+}
+#endif
@@ -0,0 +1,164 @@
+#include <media_minion/player/seek_table.hpp>
+
+#include <gbBase/Assert.hpp>
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::array<char, 4> g_seekTableMagic = { 'M', 'M', 'S', 'T' };
+constexpr std::uint32_t g_seekTableVersion = 1;
+
+void writeVarint(std::vector<unsigned char>& out, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<unsigned char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+std::optional<std::uint64_t> readVarint(unsigned char const*& it, unsigned char const* end)
+{
+    std::uint64_t ret = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (it == end) { return std::nullopt; }
+        unsigned char const c = *it++;
+        ret |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) { return ret; }
+    }
+    return std::nullopt;
+}
+
+std::uint64_t zigzagEncode(std::int64_t v)
+{
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+std::int64_t zigzagDecode(std::uint64_t v)
+{
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+}
+
+SeekTable::SeekTable(std::int32_t time_base_num, std::int32_t time_base_den)
+    :m_timeBaseNum(time_base_num), m_timeBaseDen(time_base_den)
+{
+    GHULBUS_PRECONDITION((time_base_num > 0) && (time_base_den > 0));
+    // one entry per second of audio
+    m_granularity = std::max<std::int64_t>(time_base_den / time_base_num, 1);
+}
+
+void SeekTable::addPacket(std::int64_t timestamp, std::int64_t byte_offset)
+{
+    if (byte_offset < 0) { return; }
+    if (!m_entries.empty()) {
+        Entry const& last = m_entries.back();
+        if ((timestamp < last.timestamp + m_granularity) || (byte_offset <= last.byte_offset)) { return; }
+    }
+    m_entries.push_back(Entry{ timestamp, byte_offset });
+}
+
+std::optional<SeekTable::Entry> SeekTable::findEntry(std::int64_t timestamp) const
+{
+    auto const it = std::upper_bound(begin(m_entries), end(m_entries), timestamp,
+                                     [](std::int64_t t, Entry const& e) { return t < e.timestamp; });
+    if (it == begin(m_entries)) { return std::nullopt; }
+    return *std::prev(it);
+}
+
+bool SeekTable::empty() const
+{
+    return m_entries.empty();
+}
+
+std::size_t SeekTable::size() const
+{
+    return m_entries.size();
+}
+
+std::int32_t SeekTable::getTimeBaseNum() const
+{
+    return m_timeBaseNum;
+}
+
+std::int32_t SeekTable::getTimeBaseDen() const
+{
+    return m_timeBaseDen;
+}
+
+bool SeekTable::save(std::filesystem::path const& filepath) const
+{
+    std::vector<unsigned char> buffer;
+    buffer.insert(end(buffer), begin(g_seekTableMagic), end(g_seekTableMagic));
+    writeVarint(buffer, g_seekTableVersion);
+    writeVarint(buffer, static_cast<std::uint64_t>(m_timeBaseNum));
+    writeVarint(buffer, static_cast<std::uint64_t>(m_timeBaseDen));
+    writeVarint(buffer, m_entries.size());
+    Entry previous{ 0, 0 };
+    for (auto const& e : m_entries) {
+        writeVarint(buffer, zigzagEncode(e.timestamp - previous.timestamp));
+        writeVarint(buffer, zigzagEncode(e.byte_offset - previous.byte_offset));
+        previous = e;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(filepath.parent_path(), ec);
+    std::ofstream fout(filepath, std::ios_base::binary);
+    fout.write(reinterpret_cast<char const*>(buffer.data()), buffer.size());
+    if (!fout) {
+        GHULBUS_LOG(Warning, "Unable to write seek table " << filepath);
+        return false;
+    }
+    return true;
+}
+
+std::optional<SeekTable> SeekTable::load(std::filesystem::path const& filepath)
+{
+    std::ifstream fin(filepath, std::ios_base::binary);
+    if (!fin) { return std::nullopt; }
+    std::vector<unsigned char> const buffer((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    if ((buffer.size() < g_seekTableMagic.size()) ||
+        (std::memcmp(buffer.data(), g_seekTableMagic.data(), g_seekTableMagic.size()) != 0))
+    {
+        GHULBUS_LOG(Warning, "Invalid seek table file " << filepath);
+        return std::nullopt;
+    }
+    unsigned char const* it = buffer.data() + g_seekTableMagic.size();
+    unsigned char const* const it_end = buffer.data() + buffer.size();
+    auto const version = readVarint(it, it_end);
+    auto const tb_num = readVarint(it, it_end);
+    auto const tb_den = readVarint(it, it_end);
+    auto const count = readVarint(it, it_end);
+    if (!version || (*version != g_seekTableVersion) || !tb_num || !tb_den || !count ||
+        (*tb_num == 0) || (*tb_den == 0) || (*tb_num > INT32_MAX) || (*tb_den > INT32_MAX) ||
+        (*count > buffer.size()))
+    {
+        GHULBUS_LOG(Warning, "Invalid seek table file " << filepath);
+        return std::nullopt;
+    }
+
+    SeekTable ret(static_cast<std::int32_t>(*tb_num), static_cast<std::int32_t>(*tb_den));
+    ret.m_entries.reserve(*count);
+    Entry previous{ 0, 0 };
+    for (std::uint64_t i = 0; i < *count; ++i) {
+        auto const d_ts = readVarint(it, it_end);
+        auto const d_offset = readVarint(it, it_end);
+        if (!d_ts || !d_offset) {
+            GHULBUS_LOG(Warning, "Truncated seek table file " << filepath);
+            return std::nullopt;
+        }
+        previous.timestamp += zigzagDecode(*d_ts);
+        previous.byte_offset += zigzagDecode(*d_offset);
+        ret.m_entries.push_back(previous);
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_SEEK_TABLE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_SEEK_TABLE_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace media_minion::player {
+
+/** Maps stream timestamps to byte offsets of packets in the container.
+ * For formats without a usable index (VBR MP3 without TOC, raw AAC), the demuxer can only seek by guessing
+ * from the average bitrate and then has to read forward. A seek table that was recorded during one full linear
+ * read allows jumping straight to the packet in front of the seek target with a single byte seek.
+ * Entries are kept at least one granularity apart, so a two hour track needs only a few kilobytes on disk.
+ */
+class SeekTable {
+public:
+    struct Entry {
+        std::int64_t timestamp;             ///< in units of the stream's time base
+        std::int64_t byte_offset;
+    };
+private:
+    std::int32_t m_timeBaseNum;
+    std::int32_t m_timeBaseDen;
+    std::int64_t m_granularity;
+    std::vector<Entry> m_entries;
+public:
+    SeekTable(std::int32_t time_base_num, std::int32_t time_base_den);
+
+    /** Records the start of a packet.
+     * Packets must be added in stream order. Packets that are closer than the table's granularity to the
+     * previous entry are skipped.
+     */
+    void addPacket(std::int64_t timestamp, std::int64_t byte_offset);
+
+    /** Retrieves the last entry with a timestamp not greater than timestamp.
+     */
+    std::optional<Entry> findEntry(std::int64_t timestamp) const;
+
+    bool empty() const;
+    std::size_t size() const;
+    std::int32_t getTimeBaseNum() const;
+    std::int32_t getTimeBaseDen() const;
+
+    bool save(std::filesystem::path const& filepath) const;
+    static std::optional<SeekTable> load(std::filesystem::path const& filepath);
+};
+
+}
+#endif
@@ -0,0 +1,250 @@
+#include <media_minion/player/server_connection.hpp>
+
+#include <media_minion/player/control_protocol.hpp>
+
+#include <media_minion/common/coroutine_support/awaitables.hpp>
+
+#include <boost/asio/post.hpp>
+#include <boost/beast/core/buffers_to_string.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+
+template<typename... Args>
+struct std::experimental::coroutine_traits<media_minion::player::ConnectionToken, Args...> {
+    using promise_type = media_minion::player::ConnectionPromise;
+};
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::chrono::milliseconds g_minReconnectDelay(500);
+constexpr std::chrono::milliseconds g_maxReconnectDelay(30000);
+constexpr std::chrono::seconds g_pingInterval(2);
+constexpr std::size_t g_initialTimeRequests = 8;
+constexpr std::chrono::milliseconds g_initialTimeRequestInterval(250);
+}
+
+ConnectionToken ConnectionPromise::get_return_object() {
+    return ConnectionToken{ std::experimental::coroutine_handle<ConnectionPromise>::from_promise(*this) };
+}
+
+std::experimental::suspend_never ConnectionPromise::initial_suspend() {
+    return {};
+}
+
+std::experimental::suspend_always ConnectionPromise::final_suspend() {
+    return {};
+}
+
+void ConnectionPromise::return_void()
+{
+}
+
+void ConnectionPromise::unhandled_exception()
+{
+    std::terminate();
+}
+
+ConnectionToken::ConnectionToken(std::experimental::coroutine_handle<ConnectionPromise> h)
+    :m_coroutine(h)
+{}
+
+ConnectionToken::~ConnectionToken()
+{
+    m_coroutine.destroy();
+}
+
+void ConnectionToken::run()
+{
+    m_coroutine.promise().io_ctx->run();
+}
+
+ServerConnection::Session::Session(boost::asio::io_context& io_ctx)
+    :websocket(boost::asio::ip::tcp::socket(io_ctx))
+{
+}
+
+ServerConnection::ServerConnection(std::string_view host, std::uint16_t port)
+    :m_io_ctx(1), m_host(host), m_service(std::to_string(port)), m_resolver(m_io_ctx),
+     m_reconnectTimer(m_io_ctx), m_pingTimer(m_io_ctx), m_clockTimer(m_io_ctx), m_sessionGeneration(0),
+     m_shutdownRequested(false), m_roundTripTime(-1)
+{
+}
+
+ServerConnection::~ServerConnection()
+{
+    if (m_thread.joinable()) {
+        requestShutdown();
+        m_thread.join();
+    }
+}
+
+void ServerConnection::start()
+{
+    m_thread = std::thread([this]() {
+            if (onThreadStarted) { onThreadStarted(); }
+            auto token = run();
+            token.run();
+        });
+}
+
+void ServerConnection::requestShutdown()
+{
+    boost::asio::post(m_io_ctx, [this]() {
+            if (m_shutdownRequested) { return; }
+            m_shutdownRequested = true;
+            m_resolver.cancel();
+            m_reconnectTimer.cancel();
+            m_pingTimer.cancel();
+            if (!m_session) { return; }
+            if (m_session->websocket.is_open()) {
+                // the session has to outlive the closing handshake, even though the read loop ends before it
+                m_session->websocket.async_close(boost::beast::websocket::close_code::normal,
+                                                 [session = m_session](boost::system::error_code const&) {});
+            } else {
+                // still connecting
+                boost::system::error_code ec;
+                m_session->websocket.next_layer().close(ec);
+            }
+        });
+}
+
+void ServerConnection::send(std::string msg)
+{
+    boost::asio::post(m_io_ctx, [this, msg = std::move(msg)]() mutable { enqueueMessage(std::move(msg)); });
+}
+
+std::optional<std::chrono::microseconds> ServerConnection::getRoundTripTime() const
+{
+    std::int64_t const rtt = m_roundTripTime.load();
+    if (rtt < 0) { return std::nullopt; }
+    return std::chrono::microseconds(rtt);
+}
+
+ClockSync const& ServerConnection::getClock() const
+{
+    return m_clock;
+}
+
+ConnectionToken ServerConnection::run()
+{
+    using namespace media_minion::coroutine;
+    co_await IoContextProvider<ConnectionPromise>{ m_io_ctx };
+
+    std::chrono::milliseconds reconnect_delay = g_minReconnectDelay;
+    while (!m_shutdownRequested) {
+        m_session = std::make_shared<Session>(m_io_ctx);
+        ++m_sessionGeneration;
+
+        auto resolved = co_await AsyncResolve(m_resolver, m_host, m_service);
+        boost::system::error_code ec = resolved.error;
+        if (!ec) {
+            ec = (co_await AsyncConnect(m_session->websocket.next_layer(), resolved.value)).error;
+        }
+        if (!ec) {
+            m_session->websocket.next_layer().set_option(boost::asio::ip::tcp::no_delay(true), ec);
+        }
+        if (!ec) {
+            ec = (co_await AsyncHandshake(m_session->websocket, m_host, "/")).error;
+        }
+        if (!ec) {
+            GHULBUS_LOG(Info, "Connected to server " << m_host << ":" << m_service << ".");
+            reconnect_delay = g_minReconnectDelay;
+            m_session->websocket.text(true);
+            m_session->websocket.control_callback(
+                [this](boost::beast::websocket::frame_type kind, boost::beast::string_view) { onControlFrame(kind); });
+            schedulePing();
+            // the server may have been restarted, which resets its clock
+            m_clock.reset();
+            scheduleTimeRequest();
+            if (onConnected) { onConnected(); }
+
+            for (;;) {
+                auto [ec_read, bytes_read] = co_await AsyncRead(m_session->websocket, m_session->buffer);
+                if (ec_read) {
+                    ec = ec_read;
+                    break;
+                }
+                auto const received = std::chrono::steady_clock::now();
+                std::string msg = boost::beast::buffers_to_string(m_session->buffer.data());
+                m_session->buffer.consume(bytes_read);
+                if (msg.find("\"time_response\"") != std::string::npos) {
+                    if (auto const response = parseTimeResponse(msg); response) {
+                        m_clock.addSample(ClockSync::fromMicroseconds(response->t0), response->t1, response->t2,
+                                          received);
+                        continue;
+                    }
+                }
+                if (onMessage) { onMessage(std::move(msg)); }
+            }
+        }
+
+        m_pingTimer.cancel();
+        m_clockTimer.cancel();
+        m_session.reset();
+        m_roundTripTime = -1;
+        if (m_shutdownRequested) { break; }
+        GHULBUS_LOG(Trace, "No connection to server: " << ec.message() << "; retrying in " <<
+                           reconnect_delay.count() << "ms.");
+        m_reconnectTimer.expires_after(reconnect_delay);
+        co_await AsyncWait(m_reconnectTimer);
+        reconnect_delay = std::min(reconnect_delay * 2, g_maxReconnectDelay);
+    }
+    GHULBUS_LOG(Trace, "Server connection shut down.");
+}
+
+void ServerConnection::enqueueMessage(std::string msg)
+{
+    if (!m_session || !m_session->websocket.is_open()) { return; }
+    m_session->writeQueue.emplace_back(std::move(msg));
+    if (m_session->writeQueue.size() == 1) { doWrite(); }
+}
+
+void ServerConnection::doWrite()
+{
+    m_session->websocket.async_write(boost::asio::buffer(m_session->writeQueue.front()),
+        [this, generation = m_sessionGeneration](boost::system::error_code const& ec, std::size_t) {
+            // errors surface in the read loop as well, which takes care of reconnecting
+            if (ec || (generation != m_sessionGeneration) || !m_session) { return; }
+            m_session->writeQueue.pop_front();
+            if (!m_session->writeQueue.empty()) { doWrite(); }
+        });
+}
+
+void ServerConnection::schedulePing()
+{
+    m_pingTimer.expires_after(g_pingInterval);
+    m_pingTimer.async_wait([this, generation = m_sessionGeneration](boost::system::error_code const& ec) {
+            if (ec || (generation != m_sessionGeneration) || !m_session) { return; }
+            if (!m_session->pingSent) {
+                m_session->pingSent = std::chrono::steady_clock::now();
+                m_session->websocket.async_ping({}, [](boost::system::error_code const&) {});
+            }
+            schedulePing();
+        });
+}
+
+void ServerConnection::scheduleTimeRequest()
+{
+    std::chrono::milliseconds const interval = (m_session->timeRequestsSent < g_initialTimeRequests) ?
+        g_initialTimeRequestInterval : std::chrono::milliseconds(g_pingInterval);
+    m_clockTimer.expires_after(interval);
+    m_clockTimer.async_wait([this, generation = m_sessionGeneration](boost::system::error_code const& ec) {
+            if (ec || (generation != m_sessionGeneration) || !m_session) { return; }
+            ++m_session->timeRequestsSent;
+            enqueueMessage(serializeTimeRequest(ClockSync::toMicroseconds(std::chrono::steady_clock::now())));
+            scheduleTimeRequest();
+        });
+}
+
+void ServerConnection::onControlFrame(boost::beast::websocket::frame_type kind)
+{
+    if ((kind != boost::beast::websocket::frame_type::pong) || !m_session->pingSent) { return; }
+    auto const rtt = std::chrono::steady_clock::now() - *m_session->pingSent;
+    m_session->pingSent.reset();
+    m_roundTripTime = std::chrono::duration_cast<std::chrono::microseconds>(rtt).count();
+}
+
+}
@@ -0,0 +1,120 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_SERVER_CONNECTION_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_SERVER_CONNECTION_HPP_
+
+#include <media_minion/player/clock_sync.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/websocket/stream.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <experimental/coroutine>
+
+namespace media_minion::player {
+
+struct ConnectionToken;
+
+struct ConnectionPromise {
+    boost::asio::io_context* io_ctx;
+    ConnectionToken get_return_object();
+    std::experimental::suspend_never initial_suspend();
+    std::experimental::suspend_always final_suspend();
+    void return_void();
+    void unhandled_exception();
+};
+
+struct ConnectionToken {
+private:
+    std::experimental::coroutine_handle<ConnectionPromise> m_coroutine;
+public:
+    ConnectionToken(std::experimental::coroutine_handle<ConnectionPromise> h);
+    ~ConnectionToken();
+    void run();
+};
+
+/** Persistent websocket connection from the player to mm_server.
+ * Runs on its own thread, so that network traffic never competes with the audio pump. Lost connections
+ * are reestablished with an increasing delay. The round trip time to the server is measured continuously
+ * with websocket pings, the offset to the server clock with time requests; a burst of them right after
+ * connecting gets the clock synchronized quickly.
+ * Nagle's algorithm is disabled on the socket; control messages are tiny and must not be held back.
+ */
+class ServerConnection {
+private:
+    struct Session {
+        boost::beast::websocket::stream<boost::asio::ip::tcp::socket> websocket;
+        boost::beast::flat_buffer buffer;
+        std::deque<std::string> writeQueue;
+        std::optional<std::chrono::steady_clock::time_point> pingSent;
+        std::size_t timeRequestsSent = 0;
+
+        explicit Session(boost::asio::io_context& io_ctx);
+    };
+
+    boost::asio::io_context m_io_ctx;
+    std::string m_host;
+    std::string m_service;
+    boost::asio::ip::tcp::resolver m_resolver;
+    boost::asio::steady_timer m_reconnectTimer;
+    boost::asio::steady_timer m_pingTimer;
+    boost::asio::steady_timer m_clockTimer;
+    std::shared_ptr<Session> m_session;
+    std::uint64_t m_sessionGeneration;         ///< invalidates handlers of previous sessions
+    bool m_shutdownRequested;
+    std::atomic<std::int64_t> m_roundTripTime;  ///< in microseconds; negative while unknown
+    ClockSync m_clock;
+    std::thread m_thread;
+public:
+    ServerConnection(std::string_view host, std::uint16_t port);
+    ~ServerConnection();
+
+    ServerConnection(ServerConnection const&) = delete;
+    ServerConnection& operator=(ServerConnection const&) = delete;
+
+    void start();
+    void requestShutdown();
+
+    /** Sends a text message to the server. Thread-safe.
+     * Messages sent while there is no connection are dropped.
+     */
+    void send(std::string msg);
+
+    std::optional<std::chrono::microseconds> getRoundTripTime() const;
+    /** Thread-safe.
+     */
+    ClockSync const& getClock() const;
+
+    /** Invoked from the connection thread once it starts, before connecting for the first time.
+     */
+    std::function<void()> onThreadStarted;
+    /** Invoked from the connection thread each time a connection has been established.
+     * Messages sent from within the callback are the first ones the server receives.
+     */
+    std::function<void()> onConnected;
+    /** Invoked from the connection thread for each received message, except for time responses.
+     */
+    std::function<void(std::string)> onMessage;
+private:
+    ConnectionToken run();
+    void enqueueMessage(std::string msg);
+    void doWrite();
+    void schedulePing();
+    void scheduleTimeRequest();
+    void onControlFrame(boost::beast::websocket::frame_type kind);
+};
+
+}
+#endif
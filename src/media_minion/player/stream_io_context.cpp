@@ -0,0 +1,75 @@
+#include <media_minion/player/stream_io_context.hpp>
+
+#include <gbBase/Assert.hpp>
+
+extern "C" {
+#   include <libavformat/avio.h>
+#   include <libavutil/error.h>
+}
+
+namespace media_minion::player {
+
+StreamIOContext::StreamIOContext(std::istream& stream, std::size_t buffer_size)
+    :MediaIOContext(buffer_size), m_fin(stream)
+{
+}
+
+StreamIOContext::StreamIOContext(std::unique_ptr<std::istream> stream, std::size_t buffer_size)
+    :MediaIOContext(buffer_size), m_ownedStream(std::move(stream)), m_fin(*m_ownedStream)
+{
+}
+
+int StreamIOContext::readPacket(std::uint8_t* buf, int buf_size)
+{
+    m_fin.read(reinterpret_cast<char*>(buf), buf_size);
+    if (m_fin.fail() && !m_fin.eof()) {
+        return -1;
+    }
+    int const ret = static_cast<int>(m_fin.gcount());
+    return (ret == 0) ? AVERROR_EOF : ret;
+}
+
+std::int64_t StreamIOContext::seek(std::int64_t offset, int whence)
+{
+    // a previous read might have hit eof; that must not prevent seeking back
+    m_fin.clear();
+    std::int64_t ret;
+    switch (whence)
+    {
+    case SEEK_SET:
+        m_fin.seekg(offset, std::ios_base::beg);
+        ret = m_fin.tellg();
+        break;
+    case SEEK_CUR:
+        m_fin.seekg(offset, std::ios_base::cur);
+        ret = m_fin.tellg();
+        break;
+    case SEEK_END:
+        m_fin.seekg(offset, std::ios_base::end);
+        ret = m_fin.tellg();
+        break;
+    case AVSEEK_SIZE:
+        ret = determineStreamSize();
+        break;
+    default:
+        GHULBUS_UNREACHABLE_MESSAGE("Invalid whence token in seek.");
+    }
+    if (m_fin.fail()) { return -1; }
+    return ret;
+}
+
+std::int64_t StreamIOContext::determineStreamSize()
+{
+    // ffmpeg queries the size a lot; the file does not change underneath us, so only ask the stream once
+    if (!m_streamSize) {
+        auto const pos = m_fin.tellg();
+        m_fin.seekg(0, std::ios_base::end);
+        auto const pos_end = m_fin.tellg();
+        m_fin.seekg(pos);
+        if (m_fin.fail() || (pos_end < 0)) { return -1; }
+        m_streamSize = static_cast<std::int64_t>(pos_end);
+    }
+    return *m_streamSize;
+}
+
+}
@@ -0,0 +1,28 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_STREAM_IO_CONTEXT_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_STREAM_IO_CONTEXT_HPP_
+
+#include <media_minion/player/media_io_context.hpp>
+
+#include <istream>
+#include <memory>
+#include <optional>
+
+namespace media_minion::player {
+
+class StreamIOContext : public MediaIOContext {
+private:
+    std::unique_ptr<std::istream> m_ownedStream;
+    std::istream& m_fin;
+    std::optional<std::int64_t> m_streamSize;
+public:
+    StreamIOContext(std::istream& stream, std::size_t buffer_size);
+    StreamIOContext(std::unique_ptr<std::istream> stream, std::size_t buffer_size);
+protected:
+    int readPacket(std::uint8_t* buf, int buf_size) override;
+    std::int64_t seek(std::int64_t offset, int whence) override;
+private:
+    std::int64_t determineStreamSize();
+};
+
+}
+#endif
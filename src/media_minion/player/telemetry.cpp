@@ -0,0 +1,123 @@
+#include <media_minion/player/telemetry.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace media_minion::player {
+
+void TimingStatistics::add(std::chrono::microseconds t)
+{
+    ++count;
+    total += t;
+    max = std::max(max, t);
+}
+
+void TimingStatistics::merge(TimingStatistics const& rhs)
+{
+    count += rhs.count;
+    total += rhs.total;
+    max = std::max(max, rhs.max);
+}
+
+std::chrono::microseconds TimingStatistics::average() const
+{
+    return (count == 0) ? std::chrono::microseconds(0) : (total / static_cast<std::int64_t>(count));
+}
+
+void mergeReports(TelemetryReport& report, TelemetryReport const& subsequent)
+{
+    report.interval += subsequent.interval;
+    if (subsequent.queue_depth_samples > 0) {
+        report.queue_capacity = subsequent.queue_capacity;
+        report.queue_depth_min = (report.queue_depth_samples > 0) ?
+            std::min(report.queue_depth_min, subsequent.queue_depth_min) : subsequent.queue_depth_min;
+        report.queue_depth_sum += subsequent.queue_depth_sum;
+        report.queue_depth_samples += subsequent.queue_depth_samples;
+    }
+    report.underruns += subsequent.underruns;
+    report.refill.merge(subsequent.refill);
+    report.packets += subsequent.packets;
+    report.bytes_read += subsequent.bytes_read;
+    report.disk_read.merge(subsequent.disk_read);
+    report.network_read.merge(subsequent.network_read);
+    report.decode.merge(subsequent.decode);
+    report.pump_lateness.merge(subsequent.pump_lateness);
+    report.pump_duration.merge(subsequent.pump_duration);
+    if (subsequent.network_rtt) { report.network_rtt = subsequent.network_rtt; }
+    if (!subsequent.thread_tuning.empty()) { report.thread_tuning = subsequent.thread_tuning; }
+    if (subsequent.memory_lock != TuningOutcome::NotRequested) { report.memory_lock = subsequent.memory_lock; }
+}
+
+Telemetry::Telemetry()
+    :m_intervalStart(std::chrono::steady_clock::now()), m_memoryLock(TuningOutcome::NotRequested)
+{
+}
+
+void Telemetry::recordQueueDepth(std::size_t depth, std::size_t capacity)
+{
+    std::lock_guard lk(m_mtx);
+    m_current.queue_capacity = capacity;
+    m_current.queue_depth_min = std::min(m_current.queue_depth_min, depth);
+    m_current.queue_depth_sum += depth;
+    ++m_current.queue_depth_samples;
+}
+
+void Telemetry::recordUnderrun()
+{
+    std::lock_guard lk(m_mtx);
+    ++m_current.underruns;
+}
+
+void Telemetry::recordRefill(std::chrono::microseconds t)
+{
+    std::lock_guard lk(m_mtx);
+    m_current.refill.add(t);
+}
+
+void Telemetry::recordRead(std::chrono::microseconds t, std::size_t bytes, bool is_remote)
+{
+    std::lock_guard lk(m_mtx);
+    ++m_current.packets;
+    m_current.bytes_read += bytes;
+    (is_remote ? m_current.network_read : m_current.disk_read).add(t);
+}
+
+void Telemetry::recordDecode(std::chrono::microseconds t)
+{
+    std::lock_guard lk(m_mtx);
+    m_current.decode.add(t);
+}
+
+void Telemetry::recordPump(std::chrono::microseconds lateness, std::chrono::microseconds duration)
+{
+    std::lock_guard lk(m_mtx);
+    m_current.pump_lateness.add(lateness);
+    m_current.pump_duration.add(duration);
+}
+
+void Telemetry::recordThreadTuning(std::string_view thread_name, ThreadTuningResult const& result)
+{
+    std::lock_guard lk(m_mtx);
+    m_threadTuning[std::string(thread_name)] = result;
+}
+
+void Telemetry::recordMemoryLock(TuningOutcome outcome)
+{
+    std::lock_guard lk(m_mtx);
+    m_memoryLock = outcome;
+}
+
+TelemetryReport Telemetry::takeReport()
+{
+    auto const now = std::chrono::steady_clock::now();
+    std::lock_guard lk(m_mtx);
+    TelemetryReport ret = std::exchange(m_current, TelemetryReport{});
+    ret.interval = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_intervalStart);
+    if (ret.queue_depth_samples == 0) { ret.queue_depth_min = 0; }
+    ret.thread_tuning = m_threadTuning;
+    ret.memory_lock = m_memoryLock;
+    m_intervalStart = now;
+    return ret;
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_TELEMETRY_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_TELEMETRY_HPP_
+
+#include <media_minion/common/thread_tuning.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace media_minion::player {
+
+struct TimingStatistics {
+    std::uint64_t count = 0;
+    std::chrono::microseconds total{ 0 };
+    std::chrono::microseconds max{ 0 };
+
+    void add(std::chrono::microseconds t);
+    void merge(TimingStatistics const& rhs);
+    std::chrono::microseconds average() const;
+};
+
+/** Player health over one reporting interval.
+ * Read times are kept apart by where the data comes from, so that a stutter can be attributed to the disk,
+ * the network or the cpu (decode time).
+ */
+struct TelemetryReport {
+    std::chrono::milliseconds interval{ 0 };
+
+    // output queue, sampled on every pump
+    std::size_t queue_capacity = 0;
+    std::size_t queue_depth_min = std::numeric_limits<std::size_t>::max();
+    std::uint64_t queue_depth_sum = 0;
+    std::uint64_t queue_depth_samples = 0;
+    std::uint64_t underruns = 0;
+    TimingStatistics refill;                ///< producing one chunk for the device
+
+    // decoding
+    std::uint64_t packets = 0;
+    std::uint64_t bytes_read = 0;
+    TimingStatistics disk_read;             ///< demuxing local files, including the io
+    TimingStatistics network_read;          ///< demuxing files streamed from the server, including the io
+    TimingStatistics decode;
+
+    // pump loop
+    TimingStatistics pump_lateness;         ///< how much later than scheduled the pump ran
+    TimingStatistics pump_duration;
+
+    std::optional<std::chrono::microseconds> network_rtt;
+
+    // which of the configured scheduling settings took effect; the same in every report
+    std::map<std::string, ThreadTuningResult> thread_tuning;
+    TuningOutcome memory_lock = TuningOutcome::NotRequested;
+};
+
+/** Adds a subsequent report to report, so that it covers both intervals.
+ */
+void mergeReports(TelemetryReport& report, TelemetryReport const& subsequent);
+
+/** Collects timing and counter data from the playback pipeline. Thread-safe.
+ */
+class Telemetry {
+private:
+    mutable std::mutex m_mtx;
+    TelemetryReport m_current;
+    std::chrono::steady_clock::time_point m_intervalStart;
+    std::map<std::string, ThreadTuningResult> m_threadTuning;
+    TuningOutcome m_memoryLock;
+public:
+    Telemetry();
+
+    Telemetry(Telemetry const&) = delete;
+    Telemetry& operator=(Telemetry const&) = delete;
+
+    void recordQueueDepth(std::size_t depth, std::size_t capacity);
+    void recordUnderrun();
+    void recordRefill(std::chrono::microseconds t);
+    void recordRead(std::chrono::microseconds t, std::size_t bytes, bool is_remote);
+    void recordDecode(std::chrono::microseconds t);
+    void recordPump(std::chrono::microseconds lateness, std::chrono::microseconds duration);
+    void recordThreadTuning(std::string_view thread_name, ThreadTuningResult const& result);
+    void recordMemoryLock(TuningOutcome outcome);
+
+    /** Returns everything recorded since the last call and starts a new interval.
+     */
+    TelemetryReport takeReport();
+};
+
+/** Measures the time since construction.
+ */
+class Stopwatch {
+private:
+    std::chrono::steady_clock::time_point m_start;
+public:
+    Stopwatch()
+        :m_start(std::chrono::steady_clock::now())
+    {}
+
+    std::chrono::microseconds elapsed() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+    }
+};
+
+}
+#endif
@@ -0,0 +1,601 @@
+#include <media_minion/player/track_info.hpp>
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/riff_chunk_reader.hpp>
+
+#include <media_minion/common/binary_io.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::size_t g_mpegSyncSearchSize = 64 * 1024;
+constexpr std::size_t g_oggTailSize = 64 * 1024;
+/// Tags beyond this size are cover art or similar binary data that indexing has no use for.
+constexpr std::size_t g_maxTagSize = 64 * 1024;
+/// Upper bound for the Ogg header packets, which may include embedded cover art.
+constexpr std::size_t g_maxOggHeaderSize = 1024 * 1024;
+constexpr std::uint32_t g_opusSamplingFrequency = 48000;
+
+/** Reads small pieces of a file at arbitrary offsets.
+ */
+class HeaderReader {
+private:
+    std::ifstream m_file;
+    std::uint64_t m_size;
+public:
+    explicit HeaderReader(std::filesystem::path const& filepath)
+        :m_file(filepath, std::ios_base::binary), m_size(0)
+    {
+        std::error_code ec;
+        m_size = std::filesystem::file_size(filepath, ec);
+        if (ec) { m_file.close(); }
+    }
+
+    bool isOpen() const
+    {
+        return m_file.is_open();
+    }
+
+    std::uint64_t size() const
+    {
+        return m_size;
+    }
+
+    /** Up to n bytes starting at offset; fewer at the end of the file.
+     */
+    std::vector<unsigned char> read(std::uint64_t offset, std::size_t n)
+    {
+        if (offset >= m_size) { return {}; }
+        n = static_cast<std::size_t>(std::min<std::uint64_t>(n, m_size - offset));
+        std::vector<unsigned char> ret(n);
+        m_file.clear();
+        m_file.seekg(static_cast<std::streamoff>(offset));
+        m_file.read(reinterpret_cast<char*>(ret.data()), static_cast<std::streamsize>(n));
+        ret.resize(static_cast<std::size_t>(std::max<std::streamsize>(m_file.gcount(), 0)));
+        return ret;
+    }
+};
+
+std::uint32_t readSyncsafe(unsigned char const* p)
+{
+    return (static_cast<std::uint32_t>(p[0] & 0x7f) << 21) | (static_cast<std::uint32_t>(p[1] & 0x7f) << 14) |
+           (static_cast<std::uint32_t>(p[2] & 0x7f) << 7) | static_cast<std::uint32_t>(p[3] & 0x7f);
+}
+
+std::string toLower(std::string_view str)
+{
+    std::string ret(str);
+    std::transform(ret.begin(), ret.end(), ret.begin(),
+                   [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    return ret;
+}
+
+void appendUtf8(std::string& out, char32_t c)
+{
+    if (c < 0x80) {
+        out.push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+        out.push_back(static_cast<char>(0xc0 | (c >> 6)));
+        out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    } else if (c < 0x10000) {
+        out.push_back(static_cast<char>(0xe0 | (c >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    } else {
+        out.push_back(static_cast<char>(0xf0 | (c >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (c & 0x3f)));
+    }
+}
+
+std::chrono::microseconds framesToDuration(std::uint64_t frames, std::uint32_t sampling_frequency)
+{
+    return std::chrono::microseconds(static_cast<std::int64_t>(
+        (static_cast<double>(frames) * 1'000'000.0) / static_cast<double>(sampling_frequency)));
+}
+
+void setFrames(TrackInfo& info, std::uint64_t frames)
+{
+    info.frames = frames;
+    info.duration = framesToDuration(frames, info.sampling_frequency);
+}
+
+void addTag(TrackInfo& info, std::string key, std::string value)
+{
+    while (!value.empty() && (value.back() == '\0')) { value.pop_back(); }
+    if (value.empty()) { return; }
+    info.tags.try_emplace(std::move(key), std::move(value));
+}
+
+// ID3v2 ---------------------------------------------------------------------------------------------------------
+
+std::optional<std::string> getId3TagKey(std::string_view frame_id)
+{
+    if (frame_id == "TIT2") { return "title"; }
+    if (frame_id == "TPE1") { return "artist"; }
+    if (frame_id == "TALB") { return "album"; }
+    if (frame_id == "TPE2") { return "album_artist"; }
+    if ((frame_id == "TDRC") || (frame_id == "TYER")) { return "date"; }
+    if (frame_id == "TRCK") { return "track"; }
+    if (frame_id == "TPOS") { return "disc"; }
+    if (frame_id == "TCON") { return "genre"; }
+    return std::nullopt;
+}
+
+/** Decodes the first string of an ID3v2 text frame to UTF-8.
+ */
+std::string decodeId3Text(unsigned char const* data, std::size_t size)
+{
+    std::string ret;
+    if (size == 0) { return ret; }
+    unsigned char const encoding = data[0];
+    ++data;
+    --size;
+    if ((encoding == 1) || (encoding == 2)) {
+        bool big_endian = (encoding == 2);
+        std::size_t i = 0;
+        if ((encoding == 1) && (size >= 2)) {
+            big_endian = (data[0] == 0xfe) && (data[1] == 0xff);
+            i = 2;
+        }
+        auto const unit = [&](std::size_t at) {
+            return static_cast<char32_t>(big_endian ? ((data[at] << 8) | data[at + 1]) :
+                                                      ((data[at + 1] << 8) | data[at]));
+        };
+        for (; i + 1 < size; i += 2) {
+            char32_t c = unit(i);
+            if (c == 0) { break; }
+            if ((c >= 0xd800) && (c < 0xdc00) && (i + 3 < size)) {
+                char32_t const low = unit(i + 2);
+                if ((low >= 0xdc00) && (low < 0xe000)) {
+                    c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+                    i += 2;
+                }
+            }
+            appendUtf8(ret, c);
+        }
+    } else {
+        for (std::size_t i = 0; (i < size) && (data[i] != 0); ++i) {
+            if (encoding == 3) {
+                ret.push_back(static_cast<char>(data[i]));
+            } else {
+                appendUtf8(ret, data[i]);
+            }
+        }
+    }
+    return ret;
+}
+
+/** Reads the text frames of an ID3v2 tag at the start of the file.
+ * @return Size of the tag in bytes; 0 if there is none.
+ */
+std::uint64_t readId3v2(HeaderReader& reader, TrackInfo& info)
+{
+    auto const header = reader.read(0, 10);
+    if (!hasId(header, 0, "ID3") || (header.size() < 10)) { return 0; }
+    std::uint8_t const version = header[3];
+    std::uint8_t const flags = header[5];
+    std::uint64_t const tag_size = 10 + readSyncsafe(header.data() + 6) + (((flags & 0x10) != 0) ? 10 : 0);
+    // tags with tag-wide unsynchronisation or the three letter frames of ID3v2.2 are rare enough to go unread
+    if ((version < 3) || (version > 4) || ((flags & 0x80) != 0)) { return tag_size; }
+
+    std::uint64_t offset = 10;
+    std::uint64_t const frames_end = 10 + readSyncsafe(header.data() + 6);
+    if ((flags & 0x40) != 0) {
+        auto const extended_header = reader.read(offset, 4);
+        if (extended_header.size() < 4) { return tag_size; }
+        offset += (version == 4) ? readSyncsafe(extended_header.data()) : (4 + readBE(extended_header.data(), 4));
+    }
+    while (offset + 10 <= frames_end) {
+        auto const frame_header = reader.read(offset, 10);
+        if ((frame_header.size() < 10) || (frame_header[0] == 0)) { break; }
+        std::string_view const frame_id(reinterpret_cast<char const*>(frame_header.data()), 4);
+        std::uint64_t const frame_size = (version == 4) ? readSyncsafe(frame_header.data() + 4) :
+                                                          readBE(frame_header.data() + 4, 4);
+        std::uint16_t const frame_flags = static_cast<std::uint16_t>(readBE(frame_header.data() + 8, 2));
+        // compressed, encrypted or unsynchronised frames
+        bool const is_plain = (version == 4) ? ((frame_flags & 0x000f) == 0) : ((frame_flags & 0x00c0) == 0);
+        auto const key = getId3TagKey(frame_id);
+        if (key && is_plain && (frame_size <= g_maxTagSize)) {
+            auto const body = reader.read(offset + 10, static_cast<std::size_t>(frame_size));
+            addTag(info, *key, decodeId3Text(body.data(), body.size()));
+        }
+        offset += 10 + frame_size;
+    }
+    return tag_size;
+}
+
+// Vorbis comments, shared by FLAC, Opus and Vorbis ------------------------------------------------------------
+
+void parseVorbisComments(unsigned char const* data, std::size_t size, TrackInfo& info)
+{
+    unsigned char const* it = data;
+    unsigned char const* const end = data + size;
+    auto const readLength = [&]() -> std::optional<std::size_t> {
+        auto const length = readLE(it, end, 4);
+        if (!length || (*length > static_cast<std::uint64_t>(end - it))) { return std::nullopt; }
+        return static_cast<std::size_t>(*length);
+    };
+    auto const vendor_length = readLength();
+    if (!vendor_length) { return; }
+    it += *vendor_length;
+    auto const count = readLength();
+    if (!count) { return; }
+    for (std::size_t i = 0; i < *count; ++i) {
+        auto const length = readLength();
+        if (!length) { return; }
+        std::string_view const comment(reinterpret_cast<char const*>(it), *length);
+        it += *length;
+        auto const separator = comment.find('=');
+        if ((separator == std::string_view::npos) || (comment.size() - separator > g_maxTagSize)) { continue; }
+        std::string key = toLower(comment.substr(0, separator));
+        if (key == "albumartist") {
+            key = "album_artist";
+        } else if (key == "tracknumber") {
+            key = "track";
+        } else if (key == "discnumber") {
+            key = "disc";
+        } else if (key == "metadata_block_picture") {
+            continue;
+        }
+        addTag(info, std::move(key), std::string(comment.substr(separator + 1)));
+    }
+}
+
+// FLAC ----------------------------------------------------------------------------------------------------------
+
+std::optional<TrackInfo> readFlac(HeaderReader& reader, std::uint64_t offset, TrackInfo info)
+{
+    info.codec = "flac";
+    offset += 4;
+    bool has_stream_info = false;
+    for (bool is_last = false; !is_last;) {
+        auto const block_header = reader.read(offset, 4);
+        if (block_header.size() < 4) { break; }
+        is_last = (block_header[0] & 0x80) != 0;
+        std::uint8_t const block_type = block_header[0] & 0x7f;
+        std::uint64_t const block_size = readBE(block_header.data() + 1, 3);
+        if ((block_type == 0) && (block_size >= 34)) {
+            auto const stream_info = reader.read(offset + 4, 34);
+            if (stream_info.size() < 34) { return std::nullopt; }
+            std::uint64_t const bits = readBE(stream_info.data() + 10, 8);
+            info.sampling_frequency = static_cast<std::uint32_t>(bits >> 44);
+            info.channels = static_cast<std::uint32_t>((bits >> 41) & 0x7) + 1;
+            if (info.sampling_frequency == 0) { return std::nullopt; }
+            // 0 total samples means unknown
+            if (std::uint64_t const total_samples = bits & 0xfffffffffull; total_samples > 0) {
+                setFrames(info, total_samples);
+            }
+            has_stream_info = true;
+        } else if ((block_type == 4) && (block_size <= g_maxOggHeaderSize)) {
+            auto const comments = reader.read(offset + 4, static_cast<std::size_t>(block_size));
+            parseVorbisComments(comments.data(), comments.size(), info);
+        }
+        offset += 4 + block_size;
+    }
+    if (!has_stream_info) { return std::nullopt; }
+    return info;
+}
+
+// MPEG audio ----------------------------------------------------------------------------------------------------
+
+struct MpegFrameHeader {
+    int version;                    ///< 1 for MPEG-1, 2 for MPEG-2, 25 for MPEG-2.5
+    int layer;
+    std::uint32_t bitrate;          ///< in bits per second
+    std::uint32_t sampling_frequency;
+    std::uint32_t channels;
+    std::uint32_t frame_size;       ///< in bytes
+    std::uint32_t samples_per_frame;
+};
+
+std::optional<MpegFrameHeader> parseMpegFrameHeader(unsigned char const* p)
+{
+    static constexpr std::array<std::array<std::uint16_t, 15>, 5> bitrates = {{
+        { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },   // MPEG-1 layer 1
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },      // MPEG-1 layer 2
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },       // MPEG-1 layer 3
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },      // MPEG-2 layer 1
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },           // MPEG-2 layers 2 and 3
+    }};
+    static constexpr std::array<std::uint32_t, 3> sampling_frequencies = { 44100, 48000, 32000 };
+    if ((p[0] != 0xff) || ((p[1] & 0xe0) != 0xe0)) { return std::nullopt; }
+    int const version_bits = (p[1] >> 3) & 0x3;
+    int const layer_bits = (p[1] >> 1) & 0x3;
+    int const bitrate_index = p[2] >> 4;
+    int const frequency_index = (p[2] >> 2) & 0x3;
+    if ((version_bits == 1) || (layer_bits == 0) || (bitrate_index == 0) || (bitrate_index == 15) ||
+        (frequency_index == 3))
+    {
+        return std::nullopt;
+    }
+    MpegFrameHeader ret;
+    ret.version = (version_bits == 3) ? 1 : ((version_bits == 2) ? 2 : 25);
+    ret.layer = 4 - layer_bits;
+    std::size_t const table = (ret.version == 1) ? static_cast<std::size_t>(ret.layer - 1) :
+                                                   ((ret.layer == 1) ? 3 : 4);
+    ret.bitrate = bitrates[table][bitrate_index] * 1000u;
+    ret.sampling_frequency = sampling_frequencies[frequency_index] /
+                             ((ret.version == 1) ? 1 : ((ret.version == 2) ? 2 : 4));
+    ret.channels = ((p[3] >> 6) == 3) ? 1 : 2;
+    std::uint32_t const padding = (p[2] >> 1) & 0x1;
+    if (ret.layer == 1) {
+        ret.samples_per_frame = 384;
+        ret.frame_size = (12 * ret.bitrate / ret.sampling_frequency + padding) * 4;
+    } else {
+        ret.samples_per_frame = ((ret.layer == 3) && (ret.version != 1)) ? 576 : 1152;
+        ret.frame_size = (ret.samples_per_frame / 8) * ret.bitrate / ret.sampling_frequency + padding;
+    }
+    return ret;
+}
+
+std::optional<TrackInfo> readMpegAudio(HeaderReader& reader, std::uint64_t offset, TrackInfo info)
+{
+    auto const data = reader.read(offset, g_mpegSyncSearchSize);
+    // a sync pattern counts only if the next frame header follows right where the first frame ends
+    std::size_t frame_offset = 0;
+    std::optional<MpegFrameHeader> header;
+    for (; frame_offset + 4 <= data.size(); ++frame_offset) {
+        header = parseMpegFrameHeader(data.data() + frame_offset);
+        if (!header) { continue; }
+        std::size_t const next = frame_offset + header->frame_size;
+        if ((next + 4 <= data.size()) && parseMpegFrameHeader(data.data() + next)) { break; }
+        header.reset();
+    }
+    if (!header) { return std::nullopt; }
+    info.codec = (header->layer == 3) ? "mp3" : ((header->layer == 2) ? "mp2" : "mp1");
+    info.sampling_frequency = header->sampling_frequency;
+    info.channels = header->channels;
+
+    std::size_t const side_info_size = (header->version == 1) ? ((header->channels == 1) ? 17 : 32) :
+                                                                ((header->channels == 1) ? 9 : 17);
+    std::size_t const xing_offset = frame_offset + 4 + side_info_size;
+    std::size_t const vbri_offset = frame_offset + 4 + 32;
+    if (hasId(data, xing_offset, "Xing") || hasId(data, xing_offset, "Info")) {
+        std::size_t it = xing_offset + 4;
+        if (it + 4 > data.size()) { return std::nullopt; }
+        std::uint32_t const flags = static_cast<std::uint32_t>(readBE(data.data() + it, 4));
+        it += 4;
+        std::optional<std::uint64_t> frames;
+        if ((flags & 0x1) && (it + 4 <= data.size())) { frames = readBE(data.data() + it, 4); }
+        it += ((flags & 0x1) ? 4 : 0) + ((flags & 0x2) ? 4 : 0) + ((flags & 0x4) ? 100 : 0) + ((flags & 0x8) ? 4 : 0);
+        // the LAME extension tells how much of the first and last frame is encoder delay and padding
+        std::uint64_t delay_and_padding = 0;
+        if ((hasId(data, it, "LAME") || hasId(data, it, "Lavf") || hasId(data, it, "Lavc")) &&
+            (it + 24 <= data.size()))
+        {
+            std::uint32_t const v = static_cast<std::uint32_t>(readBE(data.data() + it + 21, 3));
+            delay_and_padding = (v >> 12) + (v & 0xfff);
+        }
+        if (frames) {
+            std::uint64_t const total = *frames * header->samples_per_frame;
+            setFrames(info, (total > delay_and_padding) ? (total - delay_and_padding) : 0);
+        }
+    } else if (hasId(data, vbri_offset, "VBRI") && (vbri_offset + 18 <= data.size())) {
+        std::uint64_t const frames = readBE(data.data() + vbri_offset + 14, 4);
+        info.duration = framesToDuration(frames * header->samples_per_frame, info.sampling_frequency);
+    }
+    if (!info.duration) {
+        // constant bitrate; the same estimate that ffmpeg makes
+        std::uint64_t audio_size = reader.size() - (offset + frame_offset);
+        if (auto const id3v1 = reader.read(reader.size() - std::min<std::uint64_t>(reader.size(), 128), 3);
+            hasId(id3v1, 0, "TAG") && (audio_size >= 128))
+        {
+            audio_size -= 128;
+        }
+        info.duration = std::chrono::microseconds(static_cast<std::int64_t>(
+            (static_cast<double>(audio_size) * 8.0 * 1'000'000.0) / static_cast<double>(header->bitrate)));
+    }
+    return info;
+}
+
+// WAV -----------------------------------------------------------------------------------------------------------
+
+std::optional<std::string> getPcmCodecName(std::uint16_t format_tag, std::uint16_t bits_per_sample)
+{
+    if (format_tag == 0x0001) {
+        switch (bits_per_sample) {
+        case 8:  return "pcm_u8";
+        case 16: return "pcm_s16le";
+        case 24: return "pcm_s24le";
+        case 32: return "pcm_s32le";
+        default: return std::nullopt;
+        }
+    } else if (format_tag == 0x0003) {
+        if (bits_per_sample == 32) { return "pcm_f32le"; }
+        if (bits_per_sample == 64) { return "pcm_f64le"; }
+    }
+    return std::nullopt;
+}
+
+void parseRiffInfo(std::vector<unsigned char> const& list, TrackInfo& info)
+{
+    static constexpr std::array<std::pair<std::string_view, std::string_view>, 7> keys = {{
+        { "INAM", "title" }, { "IART", "artist" }, { "IPRD", "album" }, { "ICRD", "date" },
+        { "IPRT", "track" }, { "ITRK", "track" }, { "IGNR", "genre" },
+    }};
+    if (!hasId(list, 0, "INFO")) { return; }
+    std::size_t offset = 4;
+    while (offset + 8 <= list.size()) {
+        std::size_t const size = static_cast<std::size_t>(readLE(list.data() + offset + 4, 4));
+        if (size > list.size() - offset - 8) { return; }
+        for (auto const& [id, key] : keys) {
+            if (hasId(list, offset, id)) {
+                addTag(info, std::string(key),
+                       std::string(reinterpret_cast<char const*>(list.data() + offset + 8), size));
+            }
+        }
+        offset += 8 + size + (size & 1);
+    }
+}
+
+std::optional<TrackInfo> readWav(HeaderReader& reader, TrackInfo info)
+{
+    auto riff = RiffChunkReader::open(reader.read(0, 12), reader.size());
+    if (!riff) { return std::nullopt; }
+    std::uint16_t block_align = 0;
+    std::optional<std::uint64_t> data_size;
+    // tags may follow the audio data, so the walk continues past the data chunk
+    for (int chunk_count = 0; chunk_count < 64; ++chunk_count) {
+        auto const chunk = riff->next(reader.read(riff->getNextOffset(), 8));
+        if (!chunk) { break; }
+        if (chunk->is("ds64")) {
+            if (!riff->readDs64(reader.read(chunk->body_offset, 24))) { return std::nullopt; }
+        } else if (chunk->is("fmt ")) {
+            auto const fmt = parseWavFmtChunk(reader.read(chunk->body_offset,
+                static_cast<std::size_t>(std::min<std::uint64_t>(chunk->size, 40))));
+            if (!fmt) { return std::nullopt; }
+            auto const codec = getPcmCodecName(fmt->format_tag, fmt->bits_per_sample);
+            if (!codec) { return std::nullopt; }
+            info.codec = *codec;
+            info.channels = fmt->channels;
+            info.sampling_frequency = fmt->sampling_frequency;
+            block_align = fmt->block_align;
+            if ((info.channels == 0) || (info.sampling_frequency == 0) || (block_align == 0)) { return std::nullopt; }
+        } else if (chunk->is("data")) {
+            data_size = chunk->size;
+        } else if (chunk->is("LIST") && (chunk->size <= g_maxTagSize)) {
+            parseRiffInfo(reader.read(chunk->body_offset, static_cast<std::size_t>(chunk->size)), info);
+        }
+    }
+    if ((block_align == 0) || !data_size) { return std::nullopt; }
+    setFrames(info, *data_size / block_align);
+    return info;
+}
+
+// Ogg -----------------------------------------------------------------------------------------------------------
+
+/** Reassembles the first packets of the first logical stream in an Ogg file.
+ */
+std::vector<std::vector<unsigned char>> readOggHeaderPackets(HeaderReader& reader, std::size_t n_packets,
+                                                             std::uint32_t& serial)
+{
+    std::vector<std::vector<unsigned char>> ret;
+    std::vector<unsigned char> packet;
+    std::uint64_t offset = 0;
+    std::size_t total_size = 0;
+    bool first_page = true;
+    while ((ret.size() < n_packets) && (total_size <= g_maxOggHeaderSize)) {
+        auto const page_header = reader.read(offset, 27);
+        if (!hasId(page_header, 0, "OggS") || (page_header.size() < 27)) { break; }
+        std::uint32_t const page_serial = static_cast<std::uint32_t>(readLE(page_header.data() + 14, 4));
+        std::size_t const n_segments = page_header[26];
+        auto const lacing = reader.read(offset + 27, n_segments);
+        if (lacing.size() < n_segments) { break; }
+        std::size_t body_size = 0;
+        for (auto const l : lacing) { body_size += l; }
+        std::uint64_t const body_offset = offset + 27 + n_segments;
+        offset = body_offset + body_size;
+        if (first_page) {
+            serial = page_serial;
+            first_page = false;
+        } else if (page_serial != serial) {
+            continue;
+        }
+        auto const body = reader.read(body_offset, body_size);
+        if (body.size() < body_size) { break; }
+        total_size += body_size;
+        std::size_t segment_offset = 0;
+        for (auto const l : lacing) {
+            packet.insert(packet.end(), body.begin() + segment_offset, body.begin() + segment_offset + l);
+            segment_offset += l;
+            if (l < 255) {
+                ret.push_back(std::move(packet));
+                packet.clear();
+                if (ret.size() == n_packets) { break; }
+            }
+        }
+    }
+    return ret;
+}
+
+/** Granule position of the last page of the given stream, which is its length in samples.
+ */
+std::optional<std::uint64_t> readOggLastGranule(HeaderReader& reader, std::uint32_t serial)
+{
+    std::uint64_t const tail_offset = reader.size() - std::min<std::uint64_t>(reader.size(), g_oggTailSize);
+    auto const tail = reader.read(tail_offset, g_oggTailSize);
+    for (std::size_t i = tail.size(); i-- > 0;) {
+        if ((i + 27 > tail.size()) || !hasId(tail, i, "OggS") || (tail[i + 4] != 0)) { continue; }
+        std::uint64_t const granule = readLE(tail.data() + i + 6, 8);
+        if ((readLE(tail.data() + i + 14, 4) == serial) && (granule != ~std::uint64_t{ 0 })) { return granule; }
+    }
+    return std::nullopt;
+}
+
+std::optional<TrackInfo> readOgg(HeaderReader& reader, TrackInfo info)
+{
+    std::uint32_t serial = 0;
+    auto const packets = readOggHeaderPackets(reader, 2, serial);
+    if (packets.empty()) { return std::nullopt; }
+    auto const& identification = packets[0];
+    std::uint64_t pre_skip = 0;
+    if (hasId(identification, 0, "OpusHead") && (identification.size() >= 19)) {
+        info.codec = "opus";
+        info.channels = identification[9];
+        pre_skip = readLE(identification.data() + 10, 2);
+        // opus always decodes at 48 kHz, regardless of the input rate stated in the header
+        info.sampling_frequency = g_opusSamplingFrequency;
+        if ((packets.size() > 1) && hasId(packets[1], 0, "OpusTags")) {
+            parseVorbisComments(packets[1].data() + 8, packets[1].size() - 8, info);
+        }
+    } else if (hasId(identification, 0, "\x01vorbis") && (identification.size() >= 30)) {
+        info.codec = "vorbis";
+        info.channels = identification[11];
+        info.sampling_frequency = static_cast<std::uint32_t>(readLE(identification.data() + 12, 4));
+        if ((packets.size() > 1) && hasId(packets[1], 0, "\x03vorbis")) {
+            parseVorbisComments(packets[1].data() + 7, packets[1].size() - 7, info);
+        }
+    } else {
+        return std::nullopt;
+    }
+    if ((info.channels == 0) || (info.sampling_frequency == 0)) { return std::nullopt; }
+    if (auto const granule = readOggLastGranule(reader, serial); granule && (*granule >= pre_skip)) {
+        setFrames(info, *granule - pre_skip);
+    }
+    return info;
+}
+}
+
+std::optional<TrackInfo> readNativeTrackInfo(std::filesystem::path const& filepath)
+{
+    HeaderReader reader(filepath);
+    if (!reader.isOpen()) { return std::nullopt; }
+    TrackInfo info;
+    // ID3v2 tags show up in front of FLAC streams as well
+    std::uint64_t const offset = readId3v2(reader, info);
+    auto const magic = reader.read(offset, 12);
+    if (hasId(magic, 0, "fLaC")) {
+        return readFlac(reader, offset, std::move(info));
+    } else if ((offset == 0) && (hasId(magic, 0, "RIFF") || hasId(magic, 0, "RF64")) && hasId(magic, 8, "WAVE")) {
+        return readWav(reader, std::move(info));
+    } else if ((offset == 0) && hasId(magic, 0, "OggS")) {
+        return readOgg(reader, std::move(info));
+    }
+    std::string const extension = toLower(filepath.extension().string());
+    if ((offset > 0) || (extension == ".mp3") || (extension == ".mp2")) {
+        return readMpegAudio(reader, offset, std::move(info));
+    }
+    return std::nullopt;
+}
+
+std::optional<TrackInfo> readTrackInfo(std::filesystem::path const& filepath, FfmpegStreamOptions const& options)
+{
+    if (auto ret = readNativeTrackInfo(filepath); ret) { return ret; }
+    GHULBUS_LOG(Trace, "No native header parser for " << filepath << "; probing with ffmpeg.");
+    FfmpegStream stream(filepath, options);
+    if (!stream.isOpen()) { return std::nullopt; }
+    return stream.getTrackInfo();
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_TRACK_INFO_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_TRACK_INFO_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace media_minion::player {
+
+struct FfmpegStreamOptions;
+
+/** Format, length and tags of a track, as needed for indexing a library.
+ * Tag keys are lower case and use the generic names of libavformat ("title", "artist", "album", "album_artist",
+ * "date", "track", "disc", "genre"), so native parsers and ffmpeg produce interchangeable results.
+ */
+struct TrackInfo {
+    std::string codec;                                  ///< ffmpeg's short codec name, like "mp3" or "flac"
+    std::uint32_t sampling_frequency = 0;
+    std::uint32_t channels = 0;
+    std::optional<std::uint64_t> frames;                ///< sample accurate length, if the headers state one
+    std::optional<std::chrono::microseconds> duration;
+    std::map<std::string, std::string> tags;
+};
+
+/** Reads the track info of FLAC, MP3, WAV, Ogg Opus and Ogg Vorbis files straight from their headers.
+ * This takes a handful of small reads instead of a full libavformat probe.
+ * @return std::nullopt if the file is not in one of these formats or its headers are not understood.
+ */
+std::optional<TrackInfo> readNativeTrackInfo(std::filesystem::path const& filepath);
+
+/** Uses the native parsers where possible and falls back to opening the file with ffmpeg.
+ */
+std::optional<TrackInfo> readTrackInfo(std::filesystem::path const& filepath, FfmpegStreamOptions const& options);
+
+}
+#endif
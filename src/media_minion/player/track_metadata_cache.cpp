@@ -0,0 +1,146 @@
+#include <media_minion/player/track_metadata_cache.hpp>
+
+#include <media_minion/common/binary_io.hpp>
+
+#include <rapidjson/rapidjson.h>
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 5054)
+#endif
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <gbBase/Log.hpp>
+
+#include <fstream>
+#include <iterator>
+
+namespace media_minion::player {
+
+namespace {
+constexpr int g_cacheVersion = 1;
+
+std::string toUtf8String(std::filesystem::path const& p)
+{
+    std::u8string const str = p.generic_u8string();
+    return std::string(str.begin(), str.end());
+}
+}
+
+TrackMetadataCache::TrackMetadataCache(std::filesystem::path filepath)
+    :m_filepath(std::move(filepath)), m_isDirty(false)
+{
+    std::ifstream fin(m_filepath, std::ios_base::binary);
+    if (!fin) { return; }
+    std::string const contents{ std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>() };
+
+    rapidjson::Document doc;
+    doc.Parse(contents.c_str());
+    if (doc.HasParseError() || !doc.IsObject()) {
+        GHULBUS_LOG(Warning, "Ignoring corrupted track metadata cache " << m_filepath);
+        return;
+    }
+    if (!doc.HasMember("version") || !doc["version"].IsInt() || (doc["version"].GetInt() != g_cacheVersion) ||
+        !doc.HasMember("tracks") || !doc["tracks"].IsObject())
+    {
+        GHULBUS_LOG(Warning, "Ignoring track metadata cache " << m_filepath << " of unsupported version.");
+        return;
+    }
+    for (auto const& t : doc["tracks"].GetObject()) {
+        auto const& v = t.value;
+        if (!v.IsObject() || !v.HasMember("path") || !v["path"].IsString() ||
+            !v.HasMember("album") || !v["album"].IsString() ||
+            !v.HasMember("integrated_loudness") || !v["integrated_loudness"].IsNumber() ||
+            !v.HasMember("true_peak") || !v["true_peak"].IsNumber() ||
+            !v.HasMember("gated_blocks") || !v["gated_blocks"].IsUint64())
+        {
+            GHULBUS_LOG(Warning, "Skipping invalid entry " << t.name.GetString() << " in track metadata cache.");
+            continue;
+        }
+        Entry entry;
+        entry.path = v["path"].GetString();
+        entry.album = v["album"].GetString();
+        entry.loudness.integrated_loudness = v["integrated_loudness"].GetDouble();
+        entry.loudness.true_peak = v["true_peak"].GetDouble();
+        entry.loudness.gated_blocks = v["gated_blocks"].GetUint64();
+        m_entries.emplace(t.name.GetString(), std::move(entry));
+    }
+    GHULBUS_LOG(Trace, "Loaded " << m_entries.size() << " entries from track metadata cache.");
+}
+
+std::optional<TrackMetadataCache::Entry> TrackMetadataCache::lookup(FileSignature const& signature) const
+{
+    std::lock_guard lk(m_mtx);
+    auto const it = m_entries.find(signature.toKey());
+    if (it == m_entries.end()) { return std::nullopt; }
+    return it->second;
+}
+
+void TrackMetadataCache::store(FileSignature const& signature, Entry entry)
+{
+    std::lock_guard lk(m_mtx);
+    m_entries[signature.toKey()] = std::move(entry);
+    m_isDirty = true;
+}
+
+std::vector<TrackMetadataCache::Entry> TrackMetadataCache::getAlbum(std::string const& album) const
+{
+    std::lock_guard lk(m_mtx);
+    std::vector<Entry> ret;
+    for (auto const& [key, entry] : m_entries) {
+        if (entry.album == album) { ret.push_back(entry); }
+    }
+    return ret;
+}
+
+bool TrackMetadataCache::save()
+{
+    rapidjson::StringBuffer buffer;
+    {
+        std::lock_guard lk(m_mtx);
+        if (!m_isDirty) { return true; }
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        writer.StartObject();
+        writer.Key("version");
+        writer.Int(g_cacheVersion);
+        writer.Key("tracks");
+        writer.StartObject();
+        for (auto const& [key, entry] : m_entries) {
+            writer.Key(key.c_str());
+            writer.StartObject();
+            writer.Key("path");
+            writer.String(entry.path.c_str());
+            writer.Key("album");
+            writer.String(entry.album.c_str());
+            writer.Key("integrated_loudness");
+            writer.Double(entry.loudness.integrated_loudness);
+            writer.Key("true_peak");
+            writer.Double(entry.loudness.true_peak);
+            writer.Key("gated_blocks");
+            writer.Uint64(entry.loudness.gated_blocks);
+            writer.EndObject();
+        }
+        writer.EndObject();
+        writer.EndObject();
+        m_isDirty = false;
+    }
+
+    // a crash while saving must not lose the whole cache
+    if (!writeFileAtomically(m_filepath, buffer.GetString(), buffer.GetSize())) {
+        std::lock_guard lk(m_mtx);
+        m_isDirty = true;
+        return false;
+    }
+    return true;
+}
+
+std::string getAlbumKey(std::filesystem::path const& track_path)
+{
+    return toUtf8String(track_path.parent_path());
+}
+
+}
@@ -0,0 +1,53 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_TRACK_METADATA_CACHE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_TRACK_METADATA_CACHE_HPP_
+
+#include <media_minion/player/loudness_analyzer.hpp>
+
+#include <media_minion/common/file_signature.hpp>
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace media_minion::player {
+
+/** Results of analysing a track, persisted as json so that tracks only need to be analysed once.
+ * Entries are keyed by the signature of the file and become stale when the file changes.
+ * Access is thread-safe.
+ */
+class TrackMetadataCache {
+public:
+    struct Entry {
+        std::string path;
+        std::string album;          ///< tracks with equal album keys are normalized together in album mode
+        LoudnessInfo loudness;
+    };
+private:
+    std::filesystem::path m_filepath;
+    mutable std::mutex m_mtx;
+    std::unordered_map<std::string, Entry> m_entries;
+    bool m_isDirty;
+public:
+    /** Loads the cache from filepath, if it exists.
+     */
+    explicit TrackMetadataCache(std::filesystem::path filepath);
+
+    std::optional<Entry> lookup(FileSignature const& signature) const;
+    void store(FileSignature const& signature, Entry entry);
+
+    std::vector<Entry> getAlbum(std::string const& album) const;
+
+    /** Writes the cache back to disk if it changed since it was loaded or last saved.
+     */
+    bool save();
+};
+
+/** Tracks are grouped into albums by the directory they reside in.
+ */
+std::string getAlbumKey(std::filesystem::path const& track_path);
+
+}
+#endif
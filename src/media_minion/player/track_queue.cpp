@@ -0,0 +1,389 @@
+#include <media_minion/player/track_queue.hpp>
+
+#include <media_minion/player/gain_stage.hpp>
+#include <media_minion/player/pcm_cache.hpp>
+#include <media_minion/player/telemetry.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace media_minion::player {
+
+namespace {
+// silence at the end of a track that gets skipped over before the overlap starts
+constexpr std::chrono::milliseconds g_maxTrailingSilence(2000);
+// silence at the start of a track that gets skipped over; longer intros are kept
+constexpr std::chrono::milliseconds g_maxLeadingSilence(5000);
+constexpr std::chrono::milliseconds g_minPredecodeDuration(500);
+constexpr std::size_t g_maxPrefetchTracks = 3;
+// frames decoded from a track at a time
+constexpr std::size_t g_decodeFrames = 4096;
+}
+
+bool TrackQueue::Track::readStream(bool repeat)
+{
+    if (stream_ended) { return false; }
+    bool restarted = false;
+    for (;;) {
+        std::uint64_t const position = source->getPositionFrames();
+        std::size_t n_wanted = g_decodeFrames;
+        if (loop) {
+            n_wanted = (position >= loop->second) ? 0 :
+                       static_cast<std::size_t>(std::min<std::uint64_t>(n_wanted, loop->second - position));
+        }
+        auto const frames = buffered.prepare(n_wanted);
+        std::size_t const n_frames = (n_wanted > 0) ? source->read(frames) : 0;
+        if (n_frames == 0) {
+            // an unplayable section must not turn this into an endless loop
+            if ((loop || repeat) && !restarted && restartAt(loop ? loop->first : 0)) {
+                restarted = true;
+                continue;
+            }
+            stream_ended = true;
+            return false;
+        }
+        applyGain(frames.first(n_frames), gain);
+        buffered.commit(n_frames);
+        if (loop && (position + n_frames == loop->second)) { restartAt(loop->first); }
+        return true;
+    }
+}
+
+bool TrackQueue::Track::restartAt(std::uint64_t frame)
+{
+    if (!source->seekToFrame(frame)) { return false; }
+    stream_ended = false;
+    transition_checked = false;
+    return true;
+}
+
+std::uint32_t TrackQueue::Track::getSamplingFrequency() const
+{
+    return source->getSamplingFrequency().value_or(0);
+}
+
+TrackQueue::TrackQueue(FfmpegStreamOptions const& stream_options, CrossfadeSettings const& crossfade,
+                       PcmCache* pcm_cache, std::chrono::seconds prefetch_duration,
+                       ThreadTuning const& worker_tuning)
+    :m_streamOptions(stream_options), m_crossfade(crossfade),
+     m_lookaheadDuration((crossfade.duration.count() > 0) ?
+                         (crossfade.duration + (crossfade.silence_aware ? g_maxTrailingSilence :
+                                                                         std::chrono::milliseconds(0))) :
+                         std::chrono::milliseconds(0)),
+     m_predecodeDuration(m_lookaheadDuration + g_minPredecodeDuration),
+     m_pcmCache(pcm_cache), m_prefetchDuration(prefetch_duration), m_workerTuning(worker_tuning),
+     m_repeatCurrent(false),
+     m_preparing(false), m_generation(0), m_shutdownRequested(false)
+{
+    m_worker = std::thread([this]() { workerThread(); });
+}
+
+TrackQueue::~TrackQueue()
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_shutdownRequested = true;
+    }
+    m_cvWorker.notify_all();
+    m_cvPrepared.notify_all();
+    m_worker.join();
+}
+
+void TrackQueue::enqueue(std::filesystem::path location)
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_pending.emplace_back(std::move(location));
+    }
+    m_cvWorker.notify_all();
+}
+
+void TrackQueue::clear()
+{
+    std::lock_guard lk(m_mtx);
+    m_pending.clear();
+    m_prepared.reset();
+    ++m_generation;
+    m_prefetched.clear();
+    m_current.reset();
+    m_upcoming.reset();
+}
+
+PcmRead TrackQueue::read(std::span<PlaybackSample> frames)
+{
+    PcmRead ret{ 0, 0 };
+    while (ret.frames < frames.size()) {
+        if (!m_current) {
+            auto next = takePreparedTrack();
+            if (!next) { break; }
+            startTrack(std::move(next));
+        }
+        Track& track = *m_current;
+
+        // hold back the end of the track, so that it is available for crossfading once the stream ends
+        std::size_t const n_wanted = frames.size() - ret.frames;
+        while (track.buffered.size() <
+               n_wanted + framesForDuration(track.getSamplingFrequency(), m_lookaheadDuration))
+        {
+            if (!track.readStream(m_repeatCurrent)) { break; }
+        }
+
+        if (track.stream_ended && !track.transition_checked && !m_repeatCurrent &&
+            (m_crossfade.duration.count() > 0))
+        {
+            track.transition_checked = true;
+            if (auto next = takePreparedTrack(); next) {
+                if (!crossfadeInto(track, *next)) {
+                    // formats do not match up; play what is left and switch gapless
+                    m_upcoming = std::move(next);
+                } else {
+                    GHULBUS_LOG(Trace, "Crossfading from " << track.location << " to " << next->location);
+                    startTrack(std::move(next));
+                    continue;
+                }
+            }
+        }
+
+        if (!track.buffered.empty()) {
+            std::uint32_t const sampling_frequency = track.getSamplingFrequency();
+            // the caller gets the frames of the new track with its next read
+            if ((ret.frames > 0) && (sampling_frequency != ret.sampling_frequency)) { break; }
+            ret.sampling_frequency = sampling_frequency;
+            std::size_t const n_frames = std::min(n_wanted, track.buffered.size());
+            std::copy_n(track.buffered.frames().begin(), n_frames, frames.begin() + ret.frames);
+            track.buffered.consume(n_frames);
+            ret.frames += n_frames;
+            continue;
+        }
+        if (m_repeatCurrent && track.restartAt(0)) {
+            // repeat was switched on after the end of the track had already been decoded
+            continue;
+        }
+        GHULBUS_LOG(Trace, "Finished playing " << track.location);
+        m_current.reset();
+    }
+    return ret;
+}
+
+void TrackQueue::restartCurrentTrack()
+{
+    if (!m_current) { return; }
+    m_current->buffered.clear();
+    m_current->loop.reset();
+    if (!m_current->restartAt(0)) {
+        GHULBUS_LOG(Warning, "Unable to restart " << m_current->location);
+    }
+}
+
+void TrackQueue::seekCurrentTrack(std::chrono::microseconds position)
+{
+    if (!m_current) { return; }
+    Track& track = *m_current;
+    track.buffered.clear();
+    track.loop.reset();
+    bool success = false;
+    if (auto const sampling_frequency = track.source->getSamplingFrequency(); sampling_frequency) {
+        success = track.restartAt(framesForPosition(*sampling_frequency, position));
+    } else if (track.source->seek(position)) {
+        track.stream_ended = false;
+        track.transition_checked = false;
+        success = true;
+    }
+    if (!success) {
+        GHULBUS_LOG(Warning, "Unable to seek in " << track.location);
+    }
+}
+
+void TrackQueue::skipCurrentTrack()
+{
+    if (!m_current) { return; }
+    GHULBUS_LOG(Trace, "Skipping " << m_current->location);
+    m_current.reset();
+}
+
+std::optional<std::filesystem::path> TrackQueue::getCurrentTrack() const
+{
+    if (!m_current) { return std::nullopt; }
+    return m_current->location;
+}
+
+std::size_t TrackQueue::getNumberOfQueuedTracks()
+{
+    std::lock_guard lk(m_mtx);
+    return m_pending.size() + (m_prepared ? 1 : 0) + (m_preparing ? 1 : 0) + (m_upcoming ? 1 : 0);
+}
+
+void TrackQueue::setRepeatCurrent(bool repeat)
+{
+    m_repeatCurrent = repeat;
+}
+
+void TrackQueue::setLoop(std::optional<std::pair<std::chrono::microseconds, std::chrono::microseconds>> const& loop)
+{
+    if (!m_current) { return; }
+    Track& track = *m_current;
+    if (!loop) {
+        track.loop.reset();
+        return;
+    }
+    auto const sampling_frequency = track.source->getSamplingFrequency();
+    if (!sampling_frequency) { return; }
+    std::uint64_t const begin = framesForPosition(*sampling_frequency, loop->first);
+    std::uint64_t const end = framesForPosition(*sampling_frequency, loop->second);
+    if (begin >= end) {
+        GHULBUS_LOG(Warning, "Ignoring empty loop.");
+        return;
+    }
+    track.loop.emplace(begin, end);
+    track.buffered.clear();
+    track.restartAt(begin);
+}
+
+std::unique_ptr<TrackQueue::Track> TrackQueue::takePreparedTrack()
+{
+    if (m_upcoming) { return std::move(m_upcoming); }
+    std::unique_lock lk(m_mtx);
+    m_cvPrepared.wait(lk, [this]() {
+            return m_prepared || (!m_preparing && m_pending.empty()) || m_shutdownRequested;
+        });
+    return std::move(m_prepared);
+}
+
+void TrackQueue::startTrack(std::unique_ptr<Track> track)
+{
+    m_current = std::move(track);
+    // the slot is free again; start preparing the track after this one
+    m_cvWorker.notify_all();
+    GHULBUS_LOG(Info, "Now playing " << m_current->location);
+    if (onTrackChanged) { onTrackChanged(m_current->location); }
+}
+
+bool TrackQueue::crossfadeInto(Track& outgoing, Track& incoming)
+{
+    if (outgoing.buffered.empty()) { return false; }
+    std::uint32_t const sampling_frequency = outgoing.getSamplingFrequency();
+    std::size_t const fade_frames = framesForDuration(sampling_frequency, m_crossfade.duration);
+    std::size_t const max_silence = framesForDuration(sampling_frequency, g_maxLeadingSilence);
+
+    // normally all of this is already there from the predecoding
+    std::size_t leading_silence = 0;
+    std::size_t target_frames = fade_frames;
+    for (;;) {
+        while ((incoming.buffered.size() < target_frames) && incoming.readStream(false)) {}
+        if (incoming.buffered.empty() || (incoming.getSamplingFrequency() != sampling_frequency)) { return false; }
+        leading_silence = m_crossfade.silence_aware ?
+                          countLeadingSilence(incoming.buffered.frames(), m_crossfade.silence_threshold_db) : 0;
+        bool const enough_data = (incoming.buffered.size() >= leading_silence + fade_frames);
+        if (incoming.stream_ended || (leading_silence >= max_silence) || enough_data) { break; }
+        target_frames = leading_silence + fade_frames;
+    }
+
+    CrossfadeSettings settings = m_crossfade;
+    if (leading_silence >= max_silence) {
+        // a long silent intro is deliberate and part of the track
+        settings.silence_aware = false;
+    }
+    PcmBuffer mixed;
+    crossfade(outgoing.buffered.frames(), incoming.buffered.frames(), sampling_frequency, settings, mixed);
+    outgoing.buffered.clear();
+    incoming.buffered = std::move(mixed);
+    return true;
+}
+
+void TrackQueue::workerThread()
+{
+    ThreadTuningResult const tuning = tuneCurrentThread("decoder", m_workerTuning);
+    if (m_streamOptions.telemetry) { m_streamOptions.telemetry->recordThreadTuning("decoder", tuning); }
+    std::unique_lock lk(m_mtx);
+    for (;;) {
+        m_cvWorker.wait(lk, [this]() {
+                return m_shutdownRequested || (!m_prepared && !m_pending.empty()) || getPrefetchCandidate();
+            });
+        if (m_shutdownRequested) { return; }
+
+        std::uint64_t const generation = m_generation;
+        if (m_prepared || m_pending.empty()) {
+            // nothing to prepare right now; use the time to fill the cache
+            std::filesystem::path const location = *getPrefetchCandidate();
+            m_prefetched.insert(location.generic_string());
+            lk.unlock();
+            prefetchTrack(location, generation);
+            lk.lock();
+            continue;
+        }
+
+        std::filesystem::path const location = std::move(m_pending.front());
+        m_pending.pop_front();
+        m_prefetched.erase(location.generic_string());
+        m_preparing = true;
+        lk.unlock();
+
+        auto track = prepareTrack(location);
+
+        lk.lock();
+        m_preparing = false;
+        if (generation == m_generation) {
+            m_prepared = std::move(track);
+        }
+        m_cvPrepared.notify_all();
+    }
+}
+
+std::unique_ptr<TrackQueue::Track> TrackQueue::prepareTrack(std::filesystem::path const& location)
+{
+    auto ret = std::make_unique<Track>();
+    ret->location = location;
+    ret->source = std::make_unique<CachedPcmSource>(m_pcmCache, location, m_streamOptions);
+    ret->stream_ended = false;
+    ret->transition_checked = false;
+    if (!ret->source->isPlayable()) {
+        GHULBUS_LOG(Warning, "Skipping unplayable track " << location);
+        return nullptr;
+    }
+    ret->gain = onGainRequest ? onGainRequest(location) : 1.f;
+
+    // decode the start of the track, so that the handover does not have to wait for the decoder
+    while (ret->readStream(false)) {
+        if (ret->buffered.size() >= framesForDuration(ret->getSamplingFrequency(), m_predecodeDuration)) { break; }
+    }
+    // if the start came from the cache, open the file here rather than on the playback thread
+    ret->source->prepareDecoder();
+    return ret;
+}
+
+std::optional<std::filesystem::path> TrackQueue::getPrefetchCandidate() const
+{
+    if (!m_pcmCache || (m_prefetchDuration.count() <= 0)) { return std::nullopt; }
+    std::size_t const n_candidates = std::min(m_pending.size(), g_maxPrefetchTracks);
+    for (std::size_t i = 0; i < n_candidates; ++i) {
+        if (!m_prefetched.contains(m_pending[i].generic_string())) { return m_pending[i]; }
+    }
+    return std::nullopt;
+}
+
+bool TrackQueue::isPrefetchInterrupted(std::uint64_t generation)
+{
+    std::lock_guard lk(m_mtx);
+    return m_shutdownRequested || (generation != m_generation) || (!m_prepared && !m_pending.empty());
+}
+
+void TrackQueue::prefetchTrack(std::filesystem::path const& location, std::uint64_t generation)
+{
+    CachedPcmSource source(m_pcmCache, location, m_streamOptions);
+    std::vector<PlaybackSample> frames(g_decodeFrames);
+    std::uint64_t target_frames = 0;
+    while (!isPrefetchInterrupted(generation)) {
+        if (source.read(frames) < frames.size()) { break; }
+        if (target_frames == 0) {
+            target_frames = static_cast<std::uint64_t>(*source.getSamplingFrequency()) * m_prefetchDuration.count();
+        }
+        if (source.getPositionFrames() >= target_frames) {
+            GHULBUS_LOG(Trace, "Prefetched " << location);
+            break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,166 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_TRACK_QUEUE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_TRACK_QUEUE_HPP_
+
+#include <media_minion/player/cached_pcm_source.hpp>
+#include <media_minion/player/crossfader.hpp>
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/media_source.hpp>
+#include <media_minion/player/pcm_buffer.hpp>
+
+#include <media_minion/common/thread_tuning.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+namespace media_minion::player {
+
+class PcmCache;
+
+/** A queue of tracks that plays as one continuous stream of audio data.
+ * While a track is playing, the next one is opened, probed and decoded up to a small prefix on a
+ * background thread. When the current track runs out, read() continues with the prepared track within
+ * the same call, so the output queue never sees the end of a track and there is no gap between them.
+ *
+ * With crossfading enabled, the current track is decoded ahead by the crossfade duration, so that its
+ * end is known before it has to be played. The prefix decoded in the background is extended accordingly,
+ * so that in the steady state each read() only decodes as much as it hands out.
+ *
+ * With a PcmCache, all decoded audio passes through the cache before gain is applied, so restarting a track,
+ * repeating it or looping a section of it is served from memory. While idle, the background thread
+ * additionally fills the cache with the start of the next few queued tracks.
+ */
+class TrackQueue {
+private:
+    struct Track {
+        std::filesystem::path location;
+        std::unique_ptr<CachedPcmSource> source;
+        PcmBuffer buffered;                 ///< decoded, not yet played frames with gain applied
+        bool stream_ended;
+        bool transition_checked;
+        float gain;
+        std::optional<std::pair<std::uint64_t, std::uint64_t>> loop;    ///< [begin, end) in sample frames
+
+        /** Decodes the next block of frames into buffered.
+         */
+        bool readStream(bool repeat);
+        bool restartAt(std::uint64_t frame);
+        /** 0 until the first frames were read.
+         */
+        std::uint32_t getSamplingFrequency() const;
+    };
+
+    FfmpegStreamOptions m_streamOptions;
+    CrossfadeSettings m_crossfade;
+    std::chrono::milliseconds m_lookaheadDuration;
+    std::chrono::milliseconds m_predecodeDuration;
+    PcmCache* m_pcmCache;
+    std::chrono::seconds m_prefetchDuration;
+    ThreadTuning m_workerTuning;
+    bool m_repeatCurrent;
+
+    std::mutex m_mtx;
+    std::condition_variable m_cvWorker;
+    std::condition_variable m_cvPrepared;
+    std::deque<std::filesystem::path> m_pending;
+    std::unique_ptr<Track> m_prepared;
+    bool m_preparing;
+    std::uint64_t m_generation;                 ///< incremented by clear() to discard an in-flight preparation
+    std::unordered_set<std::string> m_prefetched;
+    bool m_shutdownRequested;
+
+    std::unique_ptr<Track> m_current;           ///< only touched by the thread calling read()
+    std::unique_ptr<Track> m_upcoming;          ///< taken from m_prepared, but not started yet; read() thread only
+
+    std::thread m_worker;
+public:
+    /** @param[in] pcm_cache Optional cache for decoded audio; must outlive the queue.
+     * @param[in] prefetch_duration Amount of audio of each upcoming track that is decoded into pcm_cache ahead of time.
+     * @param[in] worker_tuning Applied to the background thread; the outcome is recorded to the telemetry of
+     *                          stream_options.
+     */
+    explicit TrackQueue(FfmpegStreamOptions const& stream_options,
+                        CrossfadeSettings const& crossfade = CrossfadeSettings{},
+                        PcmCache* pcm_cache = nullptr,
+                        std::chrono::seconds prefetch_duration = std::chrono::seconds(0),
+                        ThreadTuning const& worker_tuning = ThreadTuning{});
+    ~TrackQueue();
+
+    TrackQueue(TrackQueue const&) = delete;
+    TrackQueue& operator=(TrackQueue const&) = delete;
+
+    void enqueue(std::filesystem::path location);
+
+    /** Removes all tracks, including the one currently playing.
+     * Must be called from the thread that calls read().
+     */
+    void clear();
+
+    /** Fills frames from the current track; continues seamlessly with the next track when the current one ends.
+     * Only blocks if the next track is not prepared yet by the time it is needed.
+     * @return Number of frames written, which is less than frames.size() if the next track has a different
+     *         sampling frequency; 0 once all tracks have been played.
+     */
+    PcmRead read(std::span<PlaybackSample> frames);
+
+    /** Continues playback from the start of the current track.
+     * The following functions must be called from the thread that calls read().
+     */
+    void restartCurrentTrack();
+
+    /** Continues playback of the current track at position; removes any loop.
+     */
+    void seekCurrentTrack(std::chrono::microseconds position);
+
+    /** Moves on to the next track without crossfading.
+     */
+    void skipCurrentTrack();
+
+    std::optional<std::filesystem::path> getCurrentTrack() const;
+
+    /** Number of tracks that will be played after the current one.
+     */
+    std::size_t getNumberOfQueuedTracks();
+
+    /** While set, the current track starts over instead of moving on to the next track.
+     * Must be called from the thread calling read(), like setLoop().
+     */
+    void setRepeatCurrent(bool repeat);
+
+    /** Repeats the section [begin, end) of the current track until the loop is removed or the track changes.
+     * Playback jumps to begin immediately. Passing std::nullopt removes the loop; the track then plays on
+     * from wherever the loop currently is.
+     */
+    void setLoop(std::optional<std::pair<std::chrono::microseconds, std::chrono::microseconds>> const& loop);
+
+    /** Invoked from the thread calling read() when playback moves on to a new track.
+     */
+    std::function<void(std::filesystem::path const&)> onTrackChanged;
+    /** Invoked from the background thread while preparing a track; the returned gain is applied to all its data.
+     */
+    std::function<float(std::filesystem::path const&)> onGainRequest;
+private:
+    void workerThread();
+    std::unique_ptr<Track> prepareTrack(std::filesystem::path const& location);
+    std::optional<std::filesystem::path> getPrefetchCandidate() const;
+    bool isPrefetchInterrupted(std::uint64_t generation);
+    void prefetchTrack(std::filesystem::path const& location, std::uint64_t generation);
+    std::unique_ptr<Track> takePreparedTrack();
+    void startTrack(std::unique_ptr<Track> track);
+    bool crossfadeInto(Track& outgoing, Track& incoming);
+};
+
+}
+#endif
@@ -2,114 +2,86 @@
 
 #include <media_minion/player/ui/tray_icon.hpp>
 
-#include <media_minion/player/audio_player.hpp>
+#include <media_minion/player/device_audio_sink.hpp>
 #include <media_minion/player/ffmpeg_stream.hpp>
-#include <media_minion/player/wav_stream.hpp>
+#include <media_minion/player/player_engine.hpp>
 
 #include <gbAudio/Audio.hpp>
 
 #include <gbBase/Assert.hpp>
-
-#include <boost/asio/io_context.hpp>
-#include <boost/asio/steady_timer.hpp>
+#include <gbBase/Log.hpp>
 
 #include <QCoreApplication>
 
-#include <chrono>
-#include <thread>
+#include <memory>
+#include <vector>
 
 namespace media_minion::player::ui {
 
 struct PlayerApplication::Pimpl {
-    Configuration m_config;
-
-    boost::asio::io_context m_io_ctx;
-    boost::asio::steady_timer m_audioTimer;
-
-    AudioPlayer m_audio;
-    WavStream m_wavStream;
-    FfmpegStream m_ffmpegStream;
-
-    std::thread m_thread;
+    std::unique_ptr<PlayerEngine> m_engine;
 
     TrayIcon m_trayIcon;
 
     Pimpl(Configuration const& config);
-    ~Pimpl();
-
-    void run();
-    void requestShutdown();
-
-    void do_run();
-private:
-    void scheduleTimer();
 };
 
 PlayerApplication::Pimpl::Pimpl(Configuration const& config)
-    :m_config(config), m_io_ctx(1), m_audioTimer(m_io_ctx)
-{
-    m_audio.onDataRequest = [this]() { return m_wavStream.pull(); };
-}
-
-PlayerApplication::Pimpl::~Pimpl()
 {
-    m_thread.join();
+    // there is only the default device to play on, see main()
+    GHULBUS_PRECONDITION(config.zones.size() == 1);
+    std::vector<std::unique_ptr<AudioSink>> sinks;
+    sinks.push_back(std::make_unique<DeviceAudioSink>(config.latency_profile.buffer_count));
+    m_engine = std::make_unique<PlayerEngine>(config, std::move(sinks));
 }
 
-void PlayerApplication::Pimpl::run()
-{
-    GHULBUS_PRECONDITION(!m_thread.joinable());
-    m_thread = std::thread([this]() { do_run(); });
-}
-
-void PlayerApplication::Pimpl::requestShutdown()
-{
-    m_audio.stop();
-    m_io_ctx.stop();
-}
-
-void PlayerApplication::Pimpl::do_run()
-{
-    scheduleTimer();
-
-    m_io_ctx.post([this]() { m_audio.play(); });
-
-    m_io_ctx.run();
-}
-
-void PlayerApplication::Pimpl::scheduleTimer()
-{
-    m_audioTimer.expires_from_now(std::chrono::milliseconds(100));
-    m_audioTimer.async_wait([this](boost::system::error_code const& ec) {
-            if (ec) { return; }
-            m_audio.pump();
-            scheduleTimer();
-        });
-}
-
-
 PlayerApplication::PlayerApplication(Configuration const& config)
     :m_pimpl(std::make_unique<Pimpl>(config))
 {
     GhulbusAudio::initializeAudio();
     FfmpegStream::initializeFfmpeg();
     connect(&m_pimpl->m_trayIcon, &TrayIcon::requestShutdown, this, &PlayerApplication::requestShutdown);
+    connect(&m_pimpl->m_trayIcon, &TrayIcon::requestPlay, this,
+            [this]() { submitCommand(PlayerCommandType::Play); });
+    connect(&m_pimpl->m_trayIcon, &TrayIcon::requestPause, this,
+            [this]() { submitCommand(PlayerCommandType::Pause); });
+    connect(&m_pimpl->m_trayIcon, &TrayIcon::requestNext, this,
+            [this]() { submitCommand(PlayerCommandType::Next); });
+    connect(this, &PlayerApplication::commandCompleted, &m_pimpl->m_trayIcon,
+            [tray_icon = &m_pimpl->m_trayIcon](quint64, bool is_playing) {
+                tray_icon->onPlaybackStateChanged(is_playing);
+            }, Qt::QueuedConnection);
+    m_pimpl->m_engine->onCommandCompleted = [this](CommandCompletion const& completion) {
+        emit commandCompleted(completion.ticket, completion.state == PlaybackState::Playing);
+    };
 }
 
 PlayerApplication::~PlayerApplication()
 {
+    // the playback thread still uses the device until it is joined
+    m_pimpl->m_engine->requestShutdown();
+    m_pimpl->m_engine.reset();
     GhulbusAudio::shutdownAudio();
 }
 
 void PlayerApplication::run()
 {
-    m_pimpl->run();
+    m_pimpl->m_engine->run();
 }
 
 void PlayerApplication::requestShutdown()
 {
-    m_pimpl->requestShutdown();
+    m_pimpl->m_engine->requestShutdown();
     QCoreApplication::quit();
 }
 
+void PlayerApplication::submitCommand(PlayerCommandType type)
+{
+    PlayerCommand command{};
+    command.type = type;
+    if (!m_pimpl->m_engine->submitCommand(command)) {
+        GHULBUS_LOG(Warning, "Command bus is full; dropping command '" << toString(type) << "'.");
+    }
+}
+
 }
@@ -2,6 +2,7 @@
 #define MEDIA_MINION_INCLUDE_GUARD_PLAYER_UI_PLAYER_APPLICATION_HPP_
 
 #include <media_minion/player/configuration.hpp>
+#include <media_minion/player/control_protocol.hpp>
 
 #include <QObject>
 
@@ -21,6 +22,11 @@ public:
 
     void run();
     void requestShutdown();
+    void submitCommand(PlayerCommandType type);
+signals:
+    /** Emitted from the playback thread; connections to objects of the ui thread are queued.
+     */
+    void commandCompleted(quint64 ticket, bool is_playing);
 };
 
 }
@@ -3,8 +3,13 @@
 namespace media_minion::player::ui {
 
 TrayIcon::TrayIcon()
-    :QSystemTrayIcon()
+    :QSystemTrayIcon(), m_playPauseAction(nullptr), m_isPlaying(true)
 {
+    m_playPauseAction = m_contextMenu.addAction("&Pause");
+    connect(m_playPauseAction, &QAction::triggered, this, &TrayIcon::onPlayPauseTriggered);
+    QAction* next_action = m_contextMenu.addAction("&Next");
+    connect(next_action, &QAction::triggered, this, &TrayIcon::requestNext);
+    m_contextMenu.addSeparator();
     QAction* quit_action = m_contextMenu.addAction("&Quit");
     connect(quit_action, &QAction::triggered, this, &TrayIcon::onQuitRequested);
     this->setContextMenu(&m_contextMenu);
@@ -20,4 +25,19 @@ void TrayIcon::onQuitRequested()
     emit requestShutdown();
 }
 
+void TrayIcon::onPlayPauseTriggered()
+{
+    if (m_isPlaying) {
+        emit requestPause();
+    } else {
+        emit requestPlay();
+    }
+}
+
+void TrayIcon::onPlaybackStateChanged(bool is_playing)
+{
+    m_isPlaying = is_playing;
+    m_playPauseAction->setText(is_playing ? "&Pause" : "&Play");
+}
+
 }
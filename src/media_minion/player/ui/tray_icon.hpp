@@ -11,6 +11,7 @@
 #pragma warning(pop)
 #endif
 
+class QAction;
 class QMenu;
 
 namespace media_minion::player::ui {
@@ -20,12 +21,21 @@ class TrayIcon : public QSystemTrayIcon
     Q_OBJECT
 private:
     QMenu m_contextMenu;
+    QAction* m_playPauseAction;
+    bool m_isPlaying;
 public:
     TrayIcon();
 public slots:
     void onQuitRequested();
+    void onPlayPauseTriggered();
+    /** Keeps the play/pause entry in line with the playback state, including changes from remote controls.
+     */
+    void onPlaybackStateChanged(bool is_playing);
 signals:
     void requestShutdown();
+    void requestPlay();
+    void requestPause();
+    void requestNext();
 };
 
 }
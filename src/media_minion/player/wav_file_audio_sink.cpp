@@ -0,0 +1,102 @@
+#include <media_minion/player/wav_file_audio_sink.hpp>
+
+#include <media_minion/common/binary_io.hpp>
+
+#include <gbBase/Assert.hpp>
+#include <gbBase/Log.hpp>
+
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::size_t g_wavHeaderSize = 44;
+
+template<typename SampleType>
+constexpr std::uint16_t numberOfChannels()
+{
+    return (std::is_same_v<SampleType, GhulbusAudio::SampleStereo16Bit> ||
+            std::is_same_v<SampleType, GhulbusAudio::SampleStereo8Bit>) ? 2 : 1;
+}
+}
+
+WavFileAudioSink::WavFileAudioSink(std::filesystem::path filepath, std::size_t capacity, ConsumptionRate rate)
+    :NullAudioSink(capacity, rate), m_filepath(std::move(filepath)), m_fout(m_filepath, std::ios_base::binary),
+     m_samplingFrequency(0), m_channels(0), m_bitsPerSample(0), m_dataSize(0), m_formatMismatch(false)
+{
+    if (!m_fout) {
+        GHULBUS_LOG(Error, "Unable to open " << m_filepath << " for writing.");
+    }
+}
+
+WavFileAudioSink::~WavFileAudioSink()
+{
+    if (!m_fout || !m_formatIndex) { return; }
+    // the sizes in the header were unknown when it was first written
+    m_fout.seekp(0);
+    writeHeader();
+}
+
+void WavFileAudioSink::consume(GhulbusAudio::DataVariant const& data)
+{
+    if (!m_fout) { return; }
+    std::uint32_t const sampling_frequency =
+        std::visit([](auto const& d) { return d.getSamplingFrequency(); }, data);
+    if (!m_formatIndex) {
+        m_formatIndex = data.index();
+        m_samplingFrequency = sampling_frequency;
+        std::visit([this](auto const& d) {
+                using SampleType = std::decay_t<decltype(d[0])>;
+                m_channels = numberOfChannels<SampleType>();
+                m_bitsPerSample = static_cast<std::uint16_t>(8 * sizeof(SampleType) / m_channels);
+            }, data);
+        writeHeader();
+    }
+    if ((data.index() != *m_formatIndex) || (sampling_frequency != m_samplingFrequency)) {
+        if (!m_formatMismatch) {
+            GHULBUS_LOG(Warning, "Output format changed; only the audio in the initial format is written to " <<
+                                 m_filepath << ".");
+            m_formatMismatch = true;
+        }
+        return;
+    }
+    std::visit([this](auto const& d) {
+            using SampleType = std::decay_t<decltype(d[0])>;
+            std::size_t const n_bytes = d.getNumberOfSamples() * sizeof(SampleType);
+            if ((n_bytes == 0) || (m_dataSize + n_bytes > std::numeric_limits<std::uint32_t>::max() - g_wavHeaderSize)) {
+                return;
+            }
+            // sample structs are tightly packed little endian pcm, which is what wav expects
+            m_fout.write(reinterpret_cast<char const*>(&d[0]), n_bytes);
+            m_dataSize += n_bytes;
+        }, data);
+}
+
+void WavFileAudioSink::writeHeader()
+{
+    std::uint32_t const block_align = m_channels * m_bitsPerSample / 8;
+    std::uint32_t const data_size = static_cast<std::uint32_t>(m_dataSize);
+    std::vector<unsigned char> header;
+    header.reserve(g_wavHeaderSize);
+    auto const writeId = [&header](std::string_view id) { header.insert(header.end(), id.begin(), id.end()); };
+    writeId("RIFF");
+    writeLE(header, static_cast<std::uint32_t>(g_wavHeaderSize - 8) + data_size, 4);
+    writeId("WAVEfmt ");
+    writeLE(header, 16, 4);
+    writeLE(header, 1, 2);                          // integer pcm
+    writeLE(header, m_channels, 2);
+    writeLE(header, m_samplingFrequency, 4);
+    writeLE(header, m_samplingFrequency * block_align, 4);
+    writeLE(header, block_align, 2);
+    writeLE(header, m_bitsPerSample, 2);
+    writeId("data");
+    writeLE(header, data_size, 4);
+    GHULBUS_ASSERT(header.size() == g_wavHeaderSize);
+    m_fout.write(reinterpret_cast<char const*>(header.data()), static_cast<std::streamsize>(header.size()));
+}
+
+}
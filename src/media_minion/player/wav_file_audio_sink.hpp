@@ -0,0 +1,36 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_WAV_FILE_AUDIO_SINK_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_WAV_FILE_AUDIO_SINK_HPP_
+
+#include <media_minion/player/null_audio_sink.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+
+namespace media_minion::player {
+
+/** Writes everything that is played to a wav file, so that the output of the pipeline can be inspected.
+ * The format of the file is that of the first chunk; chunks in a different format are dropped.
+ */
+class WavFileAudioSink : public NullAudioSink {
+private:
+    std::filesystem::path m_filepath;
+    std::ofstream m_fout;
+    std::optional<std::size_t> m_formatIndex;
+    std::uint32_t m_samplingFrequency;
+    std::uint16_t m_channels;
+    std::uint16_t m_bitsPerSample;
+    std::uint64_t m_dataSize;
+    bool m_formatMismatch;
+public:
+    WavFileAudioSink(std::filesystem::path filepath, std::size_t capacity, ConsumptionRate rate);
+    ~WavFileAudioSink() override;
+protected:
+    void consume(GhulbusAudio::DataVariant const& data) override;
+private:
+    void writeHeader();
+};
+
+}
+#endif
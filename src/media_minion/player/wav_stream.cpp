@@ -1,26 +1,97 @@
 #include <media_minion/player/wav_stream.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 namespace media_minion::player {
 
-WavStream::WavStream()
-    :m_fin("nearer.wav", std::ios_base::binary), m_loader()
+namespace {
+template<WavSampleFormat Format>
+std::int16_t toInt16(unsigned char const* sample)
 {
-    m_loader.openWav(m_fin);
+    if constexpr (Format == WavSampleFormat::UnsignedInt8) {
+        return static_cast<std::int16_t>((static_cast<int>(sample[0]) - 128) * 256);
+    } else if constexpr (Format == WavSampleFormat::SignedInt16) {
+        return static_cast<std::int16_t>(sample[0] | (sample[1] << 8));
+    } else if constexpr (Format == WavSampleFormat::SignedInt24) {
+        return static_cast<std::int16_t>(sample[1] | (sample[2] << 8));
+    } else if constexpr (Format == WavSampleFormat::SignedInt32) {
+        return static_cast<std::int16_t>(sample[2] | (sample[3] << 8));
+    } else {
+        static_assert(Format == WavSampleFormat::Float32);
+        float f;
+        std::memcpy(&f, sample, sizeof(f));
+        return static_cast<std::int16_t>(std::clamp(f * 32768.f, -32768.f, 32767.f));
+    }
 }
 
-std::optional<GhulbusAudio::DataVariant> WavStream::pull()
+/** The first two channels make up the stereo image; mono is duplicated to both sides.
+ */
+template<WavSampleFormat Format>
+void convertFrames(std::span<unsigned char const> src, WavFormat const& format, std::span<PlaybackSample> dst)
 {
-    std::size_t const time_ms = 100;
-    std::size_t const sample_size = GhulbusAudio::formatSampleSize(m_loader.getFormat());
-    std::size_t const buffer_size = m_loader.getSamplingFrequency() / 1000 * time_ms * sample_size;
-    if (buffer_size > m_loader.getDataSize() - m_loader.getCurrentReadPosition()) {
-        if (m_loader.getDataSize() != m_loader.getCurrentReadPosition()) {
-            return m_loader.readAll();
-        } else {
-            return std::nullopt;
-        }
+    std::size_t const right_offset = (format.channels > 1) ? (format.block_align / format.channels) : 0;
+    for (std::size_t i = 0; i < dst.size(); ++i) {
+        unsigned char const* const frame = src.data() + i * format.block_align;
+        dst[i].left = toInt16<Format>(frame);
+        dst[i].right = toInt16<Format>(frame + right_offset);
     }
-    return m_loader.readChunk(buffer_size);
+}
+}
+
+WavStream::WavStream(std::filesystem::path const& filepath)
+    :m_file(MappedWavFile::open(filepath)), m_position(0)
+{
+}
+
+bool WavStream::isOpen() const
+{
+    return m_file.has_value();
+}
+
+std::uint32_t WavStream::getSamplingFrequency() const
+{
+    return m_file ? m_file->getFormat().sampling_frequency : 0;
+}
+
+std::size_t WavStream::read(std::span<PlaybackSample> frames)
+{
+    if (!m_file) { return 0; }
+    WavFormat const& format = m_file->getFormat();
+    auto const src = m_file->getFrames(m_position, frames.size());
+    std::size_t const n_frames = src.size() / format.block_align;
+    m_position += n_frames;
+    auto const dst = frames.first(n_frames);
+    if ((format.sample_format == WavSampleFormat::SignedInt16) && (format.channels == 2)) {
+        // same layout as the playback pipeline on the little endian machines we run on
+        std::memcpy(dst.data(), src.data(), src.size());
+        return n_frames;
+    }
+    switch (format.sample_format) {
+    case WavSampleFormat::UnsignedInt8: convertFrames<WavSampleFormat::UnsignedInt8>(src, format, dst); break;
+    case WavSampleFormat::SignedInt16:  convertFrames<WavSampleFormat::SignedInt16>(src, format, dst); break;
+    case WavSampleFormat::SignedInt24:  convertFrames<WavSampleFormat::SignedInt24>(src, format, dst); break;
+    case WavSampleFormat::SignedInt32:  convertFrames<WavSampleFormat::SignedInt32>(src, format, dst); break;
+    case WavSampleFormat::Float32:      convertFrames<WavSampleFormat::Float32>(src, format, dst); break;
+    }
+    return n_frames;
+}
+
+bool WavStream::seek(std::chrono::microseconds position)
+{
+    if (!m_file) { return false; }
+    std::uint64_t const frame = static_cast<std::uint64_t>(std::max<std::int64_t>(position.count(), 0)) *
+                                m_file->getFormat().sampling_frequency / 1'000'000;
+    m_position = std::min(frame, m_file->getNumberOfFrames());
+    m_file->prefetch(m_position, static_cast<std::uint64_t>(m_file->getFormat().sampling_frequency));
+    return true;
+}
+
+std::optional<std::chrono::microseconds> WavStream::getDuration() const
+{
+    if (!m_file) { return std::nullopt; }
+    return std::chrono::microseconds(static_cast<std::int64_t>(
+        m_file->getNumberOfFrames() * 1'000'000 / m_file->getFormat().sampling_frequency));
 }
 
 }
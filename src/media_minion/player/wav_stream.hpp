@@ -1,22 +1,32 @@
 #ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_WAV_STREAM_HPP_
 #define MEDIA_MINION_INCLUDE_GUARD_PLAYER_WAV_STREAM_HPP_
 
-#include <gbAudio/Data.hpp>
-#include <gbAudio/WavLoader.hpp>
+#include <media_minion/player/mapped_wav_file.hpp>
+#include <media_minion/player/media_source.hpp>
 
-#include <fstream>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
 #include <optional>
 
 namespace media_minion::player {
 
-class WavStream {
+/** Plays a wav file from a memory mapping, without going through ffmpeg.
+ * Samples are converted from the mapping straight into the caller's buffer.
+ */
+class WavStream : public PlaybackSource {
 private:
-    std::ifstream m_fin;
-    GhulbusAudio::WavLoader m_loader;
+    std::optional<MappedWavFile> m_file;
+    std::uint64_t m_position;               ///< in frames
 public:
-    WavStream();
+    explicit WavStream(std::filesystem::path const& filepath);
 
-    std::optional<GhulbusAudio::DataVariant> pull();
+    bool isOpen() const;
+
+    std::uint32_t getSamplingFrequency() const override;
+    std::size_t read(std::span<PlaybackSample> frames) override;
+    bool seek(std::chrono::microseconds position) override;
+    std::optional<std::chrono::microseconds> getDuration() const override;
 };
 
 }
@@ -0,0 +1,285 @@
+#include <media_minion/player/waveform.hpp>
+
+#include <media_minion/common/binary_io.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+#include <variant>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   define MEDIA_MINION_WAVEFORM_USE_SSE2
+#   include <emmintrin.h>
+#endif
+
+namespace media_minion::player {
+
+namespace {
+constexpr std::array<char, 4> g_waveformMagic = { 'M', 'M', 'W', 'F' };
+constexpr std::uint32_t g_waveformVersion = 1;
+constexpr std::size_t g_binSize = 6;
+constexpr std::size_t g_readFrames = 16384;
+
+struct Reduction {
+    std::int16_t min;
+    std::int16_t max;
+    std::uint64_t sum_of_squares;
+};
+
+Reduction reduceSamples(std::int16_t const* samples, std::size_t count)
+{
+    Reduction ret{ std::numeric_limits<std::int16_t>::max(), std::numeric_limits<std::int16_t>::min(), 0 };
+    std::size_t i = 0;
+#ifdef MEDIA_MINION_WAVEFORM_USE_SSE2
+    if (count >= 8) {
+        __m128i const zero = _mm_setzero_si128();
+        __m128i vmin = _mm_set1_epi16(std::numeric_limits<std::int16_t>::max());
+        __m128i vmax = _mm_set1_epi16(std::numeric_limits<std::int16_t>::min());
+        __m128i vsum = _mm_setzero_si128();
+        for (; i + 8 <= count; i += 8) {
+            __m128i const s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(samples + i));
+            vmin = _mm_min_epi16(vmin, s);
+            vmax = _mm_max_epi16(vmax, s);
+            // a sum of two squares is at most 2^31, so it always fits when read as unsigned
+            __m128i const squares = _mm_madd_epi16(s, s);
+            vsum = _mm_add_epi64(vsum, _mm_unpacklo_epi32(squares, zero));
+            vsum = _mm_add_epi64(vsum, _mm_unpackhi_epi32(squares, zero));
+        }
+        std::array<std::int16_t, 8> mins;
+        std::array<std::int16_t, 8> maxs;
+        std::array<std::uint64_t, 2> sums;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mins.data()), vmin);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(maxs.data()), vmax);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sums.data()), vsum);
+        ret.min = *std::min_element(begin(mins), end(mins));
+        ret.max = *std::max_element(begin(maxs), end(maxs));
+        ret.sum_of_squares = sums[0] + sums[1];
+    }
+#endif
+    for (; i < count; ++i) {
+        std::int32_t const s = samples[i];
+        ret.min = std::min(ret.min, samples[i]);
+        ret.max = std::max(ret.max, samples[i]);
+        ret.sum_of_squares += static_cast<std::uint64_t>(s * s);
+    }
+    return ret;
+}
+}
+
+WaveformBuilder::WaveformBuilder()
+    :m_samplingFrequency(0), m_frames(0),
+     m_current{ std::numeric_limits<std::int16_t>::max(), std::numeric_limits<std::int16_t>::min(), 0, 0 },
+     m_currentFrames(0)
+{
+}
+
+void WaveformBuilder::process(GhulbusAudio::DataVariant const& data)
+{
+    std::visit([this](auto const& d) {
+            using SampleType = std::decay_t<decltype(d[0])>;
+            std::size_t const n_frames = d.getNumberOfSamples();
+            if (n_frames == 0) { return; }
+            if (m_samplingFrequency == 0) { m_samplingFrequency = d.getSamplingFrequency(); }
+            // sample structs are tightly packed arrays of their channel values
+            if constexpr (std::is_same_v<SampleType, GhulbusAudio::SampleStereo16Bit> ||
+                          std::is_same_v<SampleType, GhulbusAudio::SampleMono16Bit>)
+            {
+                processSamples(reinterpret_cast<std::int16_t const*>(&d[0]), n_frames,
+                               sizeof(SampleType) / sizeof(std::int16_t));
+            } else {
+                processSamples(reinterpret_cast<std::uint8_t const*>(&d[0]), n_frames, sizeof(SampleType));
+            }
+        }, data);
+}
+
+void WaveformBuilder::process(std::span<PlaybackSample const> frames, std::uint32_t sampling_frequency)
+{
+    if (frames.empty()) { return; }
+    if (m_samplingFrequency == 0) { m_samplingFrequency = sampling_frequency; }
+    processSamples(reinterpret_cast<std::int16_t const*>(frames.data()), frames.size(),
+                   SampleTraits<PlaybackSample>::channels);
+}
+
+void WaveformBuilder::processSamples(std::int16_t const* samples, std::size_t n_frames, std::size_t channels)
+{
+    m_frames += n_frames;
+    while (n_frames > 0) {
+        std::size_t const n = std::min<std::size_t>(n_frames, Waveform::base_frames_per_bin - m_currentFrames);
+        Reduction const r = reduceSamples(samples, n * channels);
+        m_current.min = std::min(m_current.min, r.min);
+        m_current.max = std::max(m_current.max, r.max);
+        m_current.sum_of_squares += r.sum_of_squares;
+        m_current.samples += n * channels;
+        m_currentFrames += static_cast<std::uint32_t>(n);
+        if (m_currentFrames == Waveform::base_frames_per_bin) { finishBin(); }
+        samples += n * channels;
+        n_frames -= n;
+    }
+}
+
+void WaveformBuilder::processSamples(std::uint8_t const* samples, std::size_t n_frames, std::size_t channels)
+{
+    // 8 bit input is rare enough that widening it in blocks is good enough
+    std::array<std::int16_t, 1024> widened;
+    std::size_t const frames_per_block = widened.size() / channels;
+    while (n_frames > 0) {
+        std::size_t const n = std::min(n_frames, frames_per_block);
+        for (std::size_t i = 0; i < n * channels; ++i) {
+            widened[i] = static_cast<std::int16_t>((static_cast<int>(samples[i]) - 128) * 256);
+        }
+        processSamples(widened.data(), n, channels);
+        samples += n * channels;
+        n_frames -= n;
+    }
+}
+
+void WaveformBuilder::finishBin()
+{
+    m_bins.push_back(m_current);
+    m_current = Accumulator{ std::numeric_limits<std::int16_t>::max(), std::numeric_limits<std::int16_t>::min(), 0, 0 };
+    m_currentFrames = 0;
+}
+
+Waveform WaveformBuilder::finish()
+{
+    if (m_currentFrames > 0) { finishBin(); }
+    Waveform ret;
+    ret.sampling_frequency = m_samplingFrequency;
+    ret.frames = m_frames;
+
+    auto const toLevel = [](std::vector<Accumulator> const& accumulators, std::uint32_t frames_per_bin) {
+        WaveformLevel level{ frames_per_bin, {} };
+        level.bins.reserve(accumulators.size());
+        for (auto const& a : accumulators) {
+            double const rms = (a.samples > 0) ?
+                std::sqrt(static_cast<double>(a.sum_of_squares) / static_cast<double>(a.samples)) : 0.0;
+            level.bins.push_back(WaveformBin{ a.min, a.max, static_cast<std::uint16_t>(std::lround(rms)) });
+        }
+        return level;
+    };
+
+    std::vector<Accumulator> accumulators = std::move(m_bins);
+    m_bins.clear();
+    std::uint32_t frames_per_bin = Waveform::base_frames_per_bin;
+    if (accumulators.empty()) { return ret; }
+    ret.levels.push_back(toLevel(accumulators, frames_per_bin));
+    while (accumulators.size() > Waveform::max_coarse_bins) {
+        std::vector<Accumulator> coarser;
+        coarser.reserve((accumulators.size() + Waveform::level_factor - 1) / Waveform::level_factor);
+        for (std::size_t i = 0; i < accumulators.size(); i += Waveform::level_factor) {
+            Accumulator a = accumulators[i];
+            std::size_t const group_end = std::min<std::size_t>(i + Waveform::level_factor, accumulators.size());
+            for (std::size_t j = i + 1; j < group_end; ++j) {
+                a.min = std::min(a.min, accumulators[j].min);
+                a.max = std::max(a.max, accumulators[j].max);
+                a.sum_of_squares += accumulators[j].sum_of_squares;
+                a.samples += accumulators[j].samples;
+            }
+            coarser.push_back(a);
+        }
+        accumulators = std::move(coarser);
+        frames_per_bin *= Waveform::level_factor;
+        ret.levels.push_back(toLevel(accumulators, frames_per_bin));
+    }
+    return ret;
+}
+
+std::optional<Waveform> computeWaveform(std::filesystem::path const& track, FfmpegStreamOptions const& options,
+                                        std::atomic<bool> const* cancel)
+{
+    FfmpegStream stream(track, options);
+    if (!stream.isOpen()) { return std::nullopt; }
+    WaveformBuilder builder;
+    std::vector<PlaybackSample> buffer(g_readFrames);
+    while (std::size_t const n_frames = stream.read(buffer)) {
+        if (cancel && *cancel) { return std::nullopt; }
+        builder.process(std::span<PlaybackSample const>(buffer.data(), n_frames), stream.getSamplingFrequency());
+    }
+    Waveform ret = builder.finish();
+    if (ret.levels.empty()) { return std::nullopt; }
+    return ret;
+}
+
+std::vector<unsigned char> serializeWaveform(Waveform const& waveform)
+{
+    std::size_t n_bins = 0;
+    for (auto const& level : waveform.levels) { n_bins += level.bins.size(); }
+    std::vector<unsigned char> ret;
+    ret.reserve(24 + 8 * waveform.levels.size() + g_binSize * n_bins);
+    ret.insert(end(ret), begin(g_waveformMagic), end(g_waveformMagic));
+    writeLE(ret, g_waveformVersion, 4);
+    writeLE(ret, waveform.sampling_frequency, 4);
+    writeLE(ret, waveform.frames, 8);
+    writeLE(ret, waveform.levels.size(), 4);
+    for (auto const& level : waveform.levels) {
+        writeLE(ret, level.frames_per_bin, 4);
+        writeLE(ret, level.bins.size(), 4);
+    }
+    for (auto const& level : waveform.levels) {
+        for (auto const& bin : level.bins) {
+            writeLE(ret, static_cast<std::uint16_t>(bin.min), 2);
+            writeLE(ret, static_cast<std::uint16_t>(bin.max), 2);
+            writeLE(ret, bin.rms, 2);
+        }
+    }
+    return ret;
+}
+
+std::optional<Waveform> deserializeWaveform(unsigned char const* data, std::size_t size)
+{
+    unsigned char const* it = data;
+    unsigned char const* const end = data + size;
+    if ((size < g_waveformMagic.size()) || (std::memcmp(data, g_waveformMagic.data(), g_waveformMagic.size()) != 0)) {
+        return std::nullopt;
+    }
+    it += g_waveformMagic.size();
+    auto const version = readLE(it, end, 4);
+    if (!version || (*version != g_waveformVersion)) { return std::nullopt; }
+    auto const sampling_frequency = readLE(it, end, 4);
+    auto const frames = readLE(it, end, 8);
+    auto const n_levels = readLE(it, end, 4);
+    if (!sampling_frequency || !frames || !n_levels) { return std::nullopt; }
+
+    Waveform ret;
+    ret.sampling_frequency = static_cast<std::uint32_t>(*sampling_frequency);
+    ret.frames = *frames;
+    std::uint64_t total_bins = 0;
+    for (std::uint64_t i = 0; i < *n_levels; ++i) {
+        auto const frames_per_bin = readLE(it, end, 4);
+        auto const n_bins = readLE(it, end, 4);
+        if (!frames_per_bin || !n_bins) { return std::nullopt; }
+        total_bins += *n_bins;
+        if (total_bins * g_binSize > static_cast<std::uint64_t>(end - it)) { return std::nullopt; }
+        ret.levels.push_back(WaveformLevel{ static_cast<std::uint32_t>(*frames_per_bin), {} });
+        ret.levels.back().bins.resize(static_cast<std::size_t>(*n_bins));
+    }
+    for (auto& level : ret.levels) {
+        for (auto& bin : level.bins) {
+            bin.min = static_cast<std::int16_t>(*readLE(it, end, 2));
+            bin.max = static_cast<std::int16_t>(*readLE(it, end, 2));
+            bin.rms = static_cast<std::uint16_t>(*readLE(it, end, 2));
+        }
+    }
+    return ret;
+}
+
+bool saveWaveform(Waveform const& waveform, std::filesystem::path const& filepath)
+{
+    std::vector<unsigned char> const buffer = serializeWaveform(waveform);
+    // the file may be served while it is being replaced
+    return writeFileAtomically(filepath, buffer.data(), buffer.size());
+}
+
+std::optional<Waveform> loadWaveform(std::filesystem::path const& filepath)
+{
+    std::ifstream fin(filepath, std::ios_base::binary);
+    if (!fin) { return std::nullopt; }
+    std::vector<unsigned char> buffer((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    return deserializeWaveform(buffer.data(), buffer.size());
+}
+
+}
@@ -0,0 +1,90 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_PLAYER_WAVEFORM_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_PLAYER_WAVEFORM_HPP_
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/media_source.hpp>
+
+#include <gbAudio/Data.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace media_minion::player {
+
+/** Summary of the audio in one bin of a waveform, across all channels, in 16 bit sample scale.
+ */
+struct WaveformBin {
+    std::int16_t min;
+    std::int16_t max;
+    std::uint16_t rms;
+};
+
+struct WaveformLevel {
+    std::uint32_t frames_per_bin;
+    std::vector<WaveformBin> bins;
+};
+
+/** Overview of a whole track for drawing and scrubbing.
+ * The levels form a pyramid: the first level has the finest resolution and each following level combines
+ * level_factor bins of its predecessor, down to a level with no more than max_coarse_bins bins.
+ */
+struct Waveform {
+    static constexpr std::uint32_t base_frames_per_bin = 512;
+    static constexpr std::uint32_t level_factor = 4;
+    static constexpr std::size_t max_coarse_bins = 512;
+
+    std::uint32_t sampling_frequency;
+    std::uint64_t frames;
+    std::vector<WaveformLevel> levels;
+};
+
+/** Computes a waveform incrementally from decoded audio.
+ */
+class WaveformBuilder {
+private:
+    struct Accumulator {
+        std::int16_t min;
+        std::int16_t max;
+        std::uint64_t sum_of_squares;
+        std::uint64_t samples;
+    };
+    std::uint32_t m_samplingFrequency;
+    std::uint64_t m_frames;
+    std::vector<Accumulator> m_bins;
+    Accumulator m_current;
+    std::uint32_t m_currentFrames;
+public:
+    WaveformBuilder();
+
+    void process(GhulbusAudio::DataVariant const& data);
+    void process(std::span<PlaybackSample const> frames, std::uint32_t sampling_frequency);
+    Waveform finish();
+private:
+    void processSamples(std::int16_t const* samples, std::size_t n_frames, std::size_t channels);
+    void processSamples(std::uint8_t const* samples, std::size_t n_frames, std::size_t channels);
+    void finishBin();
+};
+
+/** Decodes the whole track and computes its waveform.
+ * @param[in] cancel Optional; computation is aborted once it becomes true.
+ */
+std::optional<Waveform> computeWaveform(std::filesystem::path const& track, FfmpegStreamOptions const& options,
+                                        std::atomic<bool> const* cancel = nullptr);
+
+/** Binary sidecar format; all values are little endian:
+ *   "MMWF", u32 version, u32 sampling frequency, u64 frames, u32 number of levels,
+ *   per level: u32 frames per bin, u32 number of bins,
+ *   then the bins of all levels in order: i16 min, i16 max, u16 rms.
+ */
+std::vector<unsigned char> serializeWaveform(Waveform const& waveform);
+std::optional<Waveform> deserializeWaveform(unsigned char const* data, std::size_t size);
+
+bool saveWaveform(Waveform const& waveform, std::filesystem::path const& filepath);
+std::optional<Waveform> loadWaveform(std::filesystem::path const& filepath);
+
+}
+#endif
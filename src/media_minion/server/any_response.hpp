@@ -6,9 +6,11 @@
 #include <boost/asio/ip/tcp.hpp>
 
 #include <boost/beast/http/message.hpp>
+#include <boost/beast/http/serializer.hpp>
 #include <boost/beast/http/write.hpp>
 
 #include <memory>
+#include <optional>
 
 namespace media_minion::server {
 
@@ -20,6 +22,7 @@ private:
     public:
         virtual ~Concept() = default;
         virtual void async_write(boost::asio::ip::tcp::socket& socket, WriteHandler handler) = 0;
+        virtual void async_write_header(boost::asio::ip::tcp::socket& socket, WriteHandler handler) = 0;
         virtual bool need_eof() const = 0;
     };
 
@@ -27,6 +30,7 @@ private:
     class Model : public Concept {
     private:
         boost::beast::http::response<Body, Fields> m_response;
+        std::optional<boost::beast::http::response_serializer<Body, Fields>> m_serializer;
     public:
         Model(boost::beast::http::response<Body, Fields>&& r)
             :m_response(std::move(r))
@@ -39,6 +43,12 @@ private:
             boost::beast::http::async_write(socket, m_response, std::move(handler));
         }
 
+        void async_write_header(boost::asio::ip::tcp::socket& socket, WriteHandler handler) override
+        {
+            m_serializer.emplace(m_response);
+            boost::beast::http::async_write_header(socket, *m_serializer, std::move(handler));
+        }
+
         bool need_eof() const override
         {
             return m_response.need_eof();
@@ -70,6 +80,13 @@ public:
         m_ptr->async_write(socket, std::move(handler));
     }
 
+    /** Writes everything but the body, as the answer to a HEAD request.
+     */
+    void async_write_header(boost::asio::ip::tcp::socket& socket, WriteHandler handler)
+    {
+        m_ptr->async_write_header(socket, std::move(handler));
+    }
+
     bool need_eof() const {
         return m_ptr->need_eof();
     }
@@ -1,6 +1,18 @@
 #include <media_minion/server/application.hpp>
 
+#include <media_minion/server/clock_service.hpp>
+#include <media_minion/server/duplicate_finder.hpp>
+#include <media_minion/server/http_router.hpp>
 #include <media_minion/server/http_server.hpp>
+#include <media_minion/server/media_file_handler.hpp>
+#include <media_minion/server/player_registry.hpp>
+#include <media_minion/server/track_info_handler.hpp>
+#include <media_minion/server/waveform_handler.hpp>
+#include <media_minion/server/websocket_session.hpp>
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+
+#include <media_minion/common/thread_tuning.hpp>
 
 #include <gbBase/Assert.hpp>
 #include <gbBase/Log.hpp>
@@ -9,10 +21,37 @@
 #include <rapidjson/rapidjson.h>
 
 #include <algorithm>
+#include <array>
 
 namespace media_minion::server {
 namespace {
 
+enum Route : std::size_t {
+    MediaRoute,
+    WaveformRoute,
+    TrackInfoRoute,
+    DuplicatesRoute,
+    PlayersRoute
+};
+
+constexpr MethodSet g_readOnly = methodSet({ boost::beast::http::verb::get });
+
+// indexed by Route
+constexpr std::array g_routes{
+    RouteSpec{ "/media/{path*}", g_readOnly },
+    RouteSpec{ "/waveform/{path*}", g_readOnly },
+    RouteSpec{ "/track_info/{path*}", g_readOnly },
+    RouteSpec{ "/duplicates", g_readOnly },
+    RouteSpec{ "/players", g_readOnly }
+};
+constexpr RouteTable g_routeTable{ g_routes };
+
+// the handlers document their targets; keep them in sync with the table
+static_assert(g_routes[DuplicatesRoute].pattern == DuplicateFinder::target);
+static_assert(g_routes[PlayersRoute].pattern == PlayerRegistry::target);
+static_assert(g_routeTable.match("/media/Artist/Album/01.flac?t=1")->get("path") == "Artist/Album/01.flac");
+static_assert(!g_routeTable.match("/players/1"));
+
 boost::asio::ip::tcp get_protocol(Configuration::Protocol p)
 {
     if (p == Configuration::Protocol::ipv4) {
@@ -25,8 +64,21 @@ boost::asio::ip::tcp get_protocol(Configuration::Protocol p)
 }
 
 Application::Application(Configuration& config)
-    :m_config(config), m_server(std::make_unique<HttpServer>())
+    :m_config(config), m_server(std::make_unique<HttpServer>()), m_router(std::make_unique<HttpRouter>(g_routeTable)),
+     m_playerRegistry(std::make_unique<PlayerRegistry>()),
+     m_clockService(std::make_unique<ClockService>(config.sync_start_delay))
 {
+    if (m_config.media_root) {
+        m_mediaFileHandler = std::make_unique<MediaFileHandler>(*m_config.media_root);
+        player::FfmpegStream::initializeFfmpeg();
+        player::FfmpegStreamOptions const stream_options{
+            player::IOMode::MemoryMapped, m_config.cache_directory, nullptr, m_config.decoder };
+        m_waveformHandler = std::make_unique<WaveformHandler>(*m_config.media_root, m_config.cache_directory,
+                                                              stream_options);
+        m_duplicateFinder = std::make_unique<DuplicateFinder>(*m_config.media_root, m_config.cache_directory,
+                                                              stream_options, m_config.fingerprint_threads);
+        m_trackInfoHandler = std::make_unique<TrackInfoHandler>(*m_config.media_root, stream_options);
+    }
 }
 
 Application::~Application()
@@ -36,13 +88,57 @@ Application::~Application()
 int Application::run()
 {
     GHULBUS_LOG(Info, "Starting Media Minion server...");
+    // the io_context runs on the calling thread
+    tuneCurrentThread("io", m_config.io_thread);
 
     m_server->onError = [](boost::system::error_code const& ec) {
         GHULBUS_LOG(Error, "Error in Http server: " << ec.message());
         return CallbackReturn::Continue;
     };
 
-    m_server->onWebsocketMessage = [](std::string msg) {
+    m_server->onWebsocketMessage = [this](WebsocketSession& sender, std::string msg) {
+        auto const received = std::chrono::steady_clock::now();
+        if (auto response = m_clockService->answerTimeRequest(msg, received); response) {
+            sender.send(std::move(*response));
+            return;
+        }
+        // players and remote controls talk through the server; apart from bookkeeping it only relays
+        m_clockService->scheduleSynchronizedStart(msg);
+        m_playerRegistry->onMessage(sender, msg);
+        m_server->broadcastWebsocketMessage(msg, &sender);
+    };
+    m_server->onWebsocketClosed = [this](WebsocketSession& session) {
+        m_playerRegistry->onSessionClosed(session);
+    };
+    if (m_config.lock_memory) {
+        // only memory mapped at this point gets locked; wait until the listener and its buffers exist
+        m_server->onListening = []() { lockProcessMemory(); };
+    }
+
+    if (m_mediaFileHandler) {
+        GHULBUS_LOG(Info, "Serving media from " << *m_config.media_root);
+        if (m_config.scan_waveforms_on_startup) { m_waveformHandler->scanLibrary(); }
+        if (m_config.scan_fingerprints_on_startup) { m_duplicateFinder->scanLibrary(); }
+    }
+    if (m_mediaFileHandler) {
+        m_router->setHandler(MediaRoute, [this](HttpRouter::Request const& r, RouteMatch const& m) {
+                return m_mediaFileHandler->handleRequest(r, *m.get("path"));
+            });
+        m_router->setHandler(WaveformRoute, [this](HttpRouter::Request const& r, RouteMatch const& m) {
+                return m_waveformHandler->handleRequest(r, *m.get("path"));
+            });
+        m_router->setHandler(TrackInfoRoute, [this](HttpRouter::Request const& r, RouteMatch const& m) {
+                return m_trackInfoHandler->handleRequest(r, *m.get("path"));
+            });
+        m_router->setHandler(DuplicatesRoute, [this](HttpRouter::Request const& r, RouteMatch const&) {
+                return m_duplicateFinder->handleRequest(r);
+            });
+    }
+    m_router->setHandler(PlayersRoute, [this](HttpRouter::Request const& r, RouteMatch const&) {
+            return m_playerRegistry->handleRequest(r);
+        });
+    m_server->onHttpRequest = [this](boost::beast::http::request<boost::beast::http::string_body> const& r) {
+        return m_router->dispatch(r);
     };
 
     return m_server->run(get_protocol(m_config.protocol), m_config.listening_port);
@@ -8,13 +8,27 @@
 
 namespace media_minion::server {
 
+class ClockService;
+class DuplicateFinder;
+class HttpRouter;
 class HttpServer;
+class MediaFileHandler;
+class PlayerRegistry;
+class TrackInfoHandler;
+class WaveformHandler;
 
 class Application {
 private:
     Configuration m_config;
 
     std::unique_ptr<HttpServer> m_server;
+    std::unique_ptr<HttpRouter> m_router;
+    std::unique_ptr<MediaFileHandler> m_mediaFileHandler;
+    std::unique_ptr<PlayerRegistry> m_playerRegistry;
+    std::unique_ptr<ClockService> m_clockService;
+    std::unique_ptr<WaveformHandler> m_waveformHandler;
+    std::unique_ptr<DuplicateFinder> m_duplicateFinder;
+    std::unique_ptr<TrackInfoHandler> m_trackInfoHandler;
 public:
     Application(Configuration& config);
 
@@ -0,0 +1,95 @@
+#include <media_minion/server/clock_service.hpp>
+
+#include <rapidjson/rapidjson.h>
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 5054)
+#endif
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <gbBase/Log.hpp>
+
+#include <cstdint>
+#include <string_view>
+
+namespace media_minion::server {
+
+namespace {
+std::chrono::microseconds toServerTime(std::chrono::steady_clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch());
+}
+}
+
+ClockService::ClockService(std::chrono::milliseconds start_delay)
+    :m_startDelay(start_delay)
+{
+}
+
+std::optional<std::string> ClockService::answerTimeRequest(std::string const& msg,
+                                                           std::chrono::steady_clock::time_point received) const
+{
+    // spares parsing the bulk of the traffic
+    if (msg.find("\"time_request\"") == std::string::npos) { return std::nullopt; }
+    rapidjson::Document doc;
+    doc.Parse(msg.c_str(), msg.size());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("type") || !doc["type"].IsString() ||
+        (std::string_view(doc["type"].GetString()) != "time_request"))
+    {
+        return std::nullopt;
+    }
+    if (!doc.HasMember("t0") || !doc["t0"].IsInt64()) {
+        GHULBUS_LOG(Warning, "Ignoring time request without a valid send time.");
+        return std::nullopt;
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("type");
+    writer.String("time_response");
+    writer.Key("t0");
+    writer.Int64(doc["t0"].GetInt64());
+    writer.Key("t1");
+    writer.Int64(toServerTime(received).count());
+    writer.Key("t2");
+    writer.Int64(now().count());
+    writer.EndObject();
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+void ClockService::scheduleSynchronizedStart(std::string& msg) const
+{
+    if (msg.find("\"synchronized\"") == std::string::npos) { return; }
+    rapidjson::Document doc;
+    doc.Parse(msg.c_str(), msg.size());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("synchronized") ||
+        !doc["synchronized"].IsBool())
+    {
+        return;
+    }
+    bool const synchronized = doc["synchronized"].GetBool();
+    doc.RemoveMember("synchronized");
+    // a start time picked by the sender takes precedence
+    if (synchronized && !doc.HasMember("start_at_us")) {
+        doc.AddMember("start_at_us", static_cast<std::int64_t>((now() + m_startDelay).count()),
+                      doc.GetAllocator());
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    doc.Accept(writer);
+    msg.assign(buffer.GetString(), buffer.GetSize());
+}
+
+std::chrono::microseconds ClockService::now()
+{
+    return toServerTime(std::chrono::steady_clock::now());
+}
+
+}
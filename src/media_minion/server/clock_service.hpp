@@ -0,0 +1,37 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_CLOCK_SERVICE_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_SERVER_CLOCK_SERVICE_HPP_
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace media_minion::server {
+
+/** The common time base of all players connected to the server.
+ * Players measure their offset to the server clock with time requests. Synchronized commands get a start
+ * time on that clock, far enough in the future for the command to reach every player in time.
+ */
+class ClockService {
+private:
+    std::chrono::milliseconds m_startDelay;
+public:
+    explicit ClockService(std::chrono::milliseconds start_delay);
+
+    /** @param[in] received Time at which msg arrived, taken before any other processing.
+     * @return Response for the sender of msg if it is a time request; std::nullopt otherwise.
+     */
+    std::optional<std::string> answerTimeRequest(std::string const& msg,
+                                                 std::chrono::steady_clock::time_point received) const;
+
+    /** Replaces the synchronized flag of a command with a start time on the server clock.
+     * Messages without the flag are left untouched.
+     */
+    void scheduleSynchronizedStart(std::string& msg) const;
+
+    /** Microseconds on the server clock.
+     */
+    static std::chrono::microseconds now();
+};
+
+}
+#endif
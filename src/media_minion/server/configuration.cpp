@@ -14,6 +14,8 @@
 #include <gbBase/Log.hpp>
 
 #include <fstream>
+#include <string>
+#include <string_view>
 
 namespace media_minion::server {
 
@@ -66,6 +68,115 @@ std::optional<Configuration> parseServerConfig(std::filesystem::path const& conf
                       Configuration::Protocol::ipv6 :
                       Configuration::Protocol::ipv4;
 
+    if (config_doc.HasMember("media_root")) {
+        if (!config_doc["media_root"].IsString()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'media_root'");
+            return std::nullopt;
+        }
+        std::string_view const media_root = config_doc["media_root"].GetString();
+        config.media_root = std::filesystem::path(std::u8string(media_root.begin(), media_root.end()));
+    }
+
+    config.cache_directory = "mm_server_cache";
+    if (config_doc.HasMember("cache_directory")) {
+        if (!config_doc["cache_directory"].IsString()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'cache_directory'");
+            return std::nullopt;
+        }
+        config.cache_directory = config_doc["cache_directory"].GetString();
+    }
+
+    config.scan_waveforms_on_startup = false;
+    if (config_doc.HasMember("waveforms")) {
+        auto const& waveforms = config_doc["waveforms"];
+        if (!waveforms.IsObject()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'waveforms'");
+            return std::nullopt;
+        }
+        if (waveforms.HasMember("scan_on_startup")) {
+            if (!waveforms["scan_on_startup"].IsBool()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'waveforms.scan_on_startup'");
+                return std::nullopt;
+            }
+            config.scan_waveforms_on_startup = waveforms["scan_on_startup"].GetBool();
+        }
+    }
+
+    config.scan_fingerprints_on_startup = false;
+    config.fingerprint_threads = 0;
+    if (config_doc.HasMember("fingerprints")) {
+        auto const& fingerprints = config_doc["fingerprints"];
+        if (!fingerprints.IsObject()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'fingerprints'");
+            return std::nullopt;
+        }
+        if (fingerprints.HasMember("scan_on_startup")) {
+            if (!fingerprints["scan_on_startup"].IsBool()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'fingerprints.scan_on_startup'");
+                return std::nullopt;
+            }
+            config.scan_fingerprints_on_startup = fingerprints["scan_on_startup"].GetBool();
+        }
+        if (fingerprints.HasMember("threads")) {
+            if (!fingerprints["threads"].IsUint()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'fingerprints.threads'");
+                return std::nullopt;
+            }
+            config.fingerprint_threads = fingerprints["threads"].GetUint();
+        }
+    }
+
+    if (config_doc.HasMember("decoder")) {
+        if (!config_doc["decoder"].IsObject()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'decoder'");
+            return std::nullopt;
+        }
+        auto opt_decoder = player::parseDecoderOptions(config_doc["decoder"]);
+        if (!opt_decoder) { return std::nullopt; }
+        config.decoder = *opt_decoder;
+    }
+
+    config.sync_start_delay = std::chrono::milliseconds(500);
+    if (config_doc.HasMember("sync")) {
+        auto const& sync = config_doc["sync"];
+        if (!sync.IsObject()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'sync'");
+            return std::nullopt;
+        }
+        if (sync.HasMember("start_delay_ms")) {
+            if (!sync["start_delay_ms"].IsUint()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'sync.start_delay_ms'");
+                return std::nullopt;
+            }
+            config.sync_start_delay = std::chrono::milliseconds(sync["start_delay_ms"].GetUint());
+        }
+    }
+
+    config.lock_memory = false;
+    if (config_doc.HasMember("threads")) {
+        auto const& threads = config_doc["threads"];
+        if (!threads.IsObject()) {
+            GHULBUS_LOG(Error, "Invalid value for option 'threads'");
+            return std::nullopt;
+        }
+        if (threads.HasMember("io")) {
+            if (!threads["io"].IsObject()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'threads.io'");
+                return std::nullopt;
+            }
+            auto opt_tuning = parseThreadTuning(threads["io"], "io");
+            if (!opt_tuning) { return std::nullopt; }
+            config.io_thread = std::move(*opt_tuning);
+        }
+        if (threads.HasMember("lock_memory")) {
+            if (!threads["lock_memory"].IsBool()) {
+                GHULBUS_LOG(Error, "Invalid value for option 'threads.lock_memory'");
+                return std::nullopt;
+            }
+            config.lock_memory = threads["lock_memory"].GetBool();
+        }
+    }
+
     return config;
 }
 
@@ -1,6 +1,11 @@
 #ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_CONFIGURATION_HPP_
 #define MEDIA_MINION_INCLUDE_GUARD_SERVER_CONFIGURATION_HPP_
 
+#include <media_minion/player/ffmpeg_stream.hpp>
+
+#include <media_minion/common/thread_tuning.hpp>
+
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
 #include <optional>
@@ -13,6 +18,24 @@ struct Configuration {
         ipv4,
         ipv6
     } protocol;
+    /** Root directory of the media library. Files below it are served under /media/.
+     */
+    std::optional<std::filesystem::path> media_root;
+    /** Directory for data derived from the media library, like waveform sidecars.
+     */
+    std::filesystem::path cache_directory;
+    bool scan_waveforms_on_startup;         ///< otherwise waveforms are computed on first request
+    bool scan_fingerprints_on_startup;      ///< otherwise the library is fingerprinted when duplicates are requested
+    std::size_t fingerprint_threads;        ///< 0 for one per hardware thread
+    /** For all decoding on the server. With automatic decoder threads, the fingerprint pool keeps its
+     * decoders single threaded as long as it runs more than one thread itself.
+     */
+    player::DecoderOptions decoder;
+    /** How far in the future synchronized commands start, so that they reach all players in time.
+     */
+    std::chrono::milliseconds sync_start_delay;
+    ThreadTuning io_thread;                 ///< handles all http and websocket traffic
+    bool lock_memory;
 };
 
 std::optional<Configuration> parseServerConfig(std::filesystem::path const& config_filepath);
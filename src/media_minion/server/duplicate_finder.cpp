@@ -0,0 +1,238 @@
+#include <media_minion/server/duplicate_finder.hpp>
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/fingerprint.hpp>
+
+#include <media_minion/common/file_signature.hpp>
+
+#include <rapidjson/rapidjson.h>
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 5054)
+#endif
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <gbBase/Log.hpp>
+
+#include <boost/beast/version.hpp>
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+namespace media_minion::server {
+
+DuplicateFinder::DuplicateFinder(std::filesystem::path media_root, std::filesystem::path const& cache_directory,
+                                 player::FfmpegStreamOptions const& stream_options, std::size_t thread_count)
+    :m_mediaRoot(std::move(media_root)), m_sidecarDirectory(cache_directory / "fingerprints"),
+     m_streamOptions(stream_options),
+     m_tracksInProgress(0), m_tracksFailed(0), m_scanRequested(false), m_scanStarted(false),
+     m_isScanningDirectory(false), m_shutdownRequested(false)
+{
+    if (thread_count == 0) { thread_count = std::max(std::thread::hardware_concurrency(), 1u); }
+    // the worker pool already keeps every core busy, additional decoder threads would only compete with it
+    if ((m_streamOptions.decoder.thread_count == 0) && (thread_count > 1)) { m_streamOptions.decoder.thread_count = 1; }
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        m_workers.emplace_back([this]() { workerThread(); });
+    }
+}
+
+DuplicateFinder::~DuplicateFinder()
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_shutdownRequested = true;
+    }
+    m_cvWorker.notify_all();
+    for (auto& w : m_workers) { w.join(); }
+}
+
+void DuplicateFinder::scanLibrary()
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_scanRequested = true;
+        m_scanStarted = true;
+    }
+    m_cvWorker.notify_all();
+}
+
+std::filesystem::path DuplicateFinder::getSidecarPath(std::string const& key) const
+{
+    return m_sidecarDirectory / (key + ".mmfp");
+}
+
+void DuplicateFinder::workerThread()
+{
+    std::unique_lock lk(m_mtx);
+    for (;;) {
+        m_cvWorker.wait(lk, [this]() { return m_shutdownRequested || m_scanRequested || !m_pending.empty(); });
+        if (m_shutdownRequested) { return; }
+        if (m_scanRequested) {
+            m_scanRequested = false;
+            m_isScanningDirectory = true;
+            lk.unlock();
+            scanDirectory();
+            lk.lock();
+            m_isScanningDirectory = false;
+        } else {
+            std::filesystem::path const track = std::move(m_pending.front());
+            m_pending.pop_front();
+            ++m_tracksInProgress;
+            lk.unlock();
+            processTrack(track);
+            lk.lock();
+            --m_tracksInProgress;
+        }
+    }
+}
+
+void DuplicateFinder::scanDirectory()
+{
+    GHULBUS_LOG(Info, "Scanning " << m_mediaRoot << " for duplicates.");
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it(m_mediaRoot,
+                                                     std::filesystem::directory_options::skip_permission_denied, ec);
+    for (; !ec && (it != std::filesystem::recursive_directory_iterator{}); it.increment(ec)) {
+        if (m_shutdownRequested) { return; }
+        std::error_code entry_ec;
+        if (!it->is_regular_file(entry_ec) || !player::FfmpegStream::hasAudioFileExtension(it->path())) { continue; }
+        {
+            std::lock_guard lk(m_mtx);
+            m_pending.push_back(it->path());
+        }
+        m_cvWorker.notify_one();
+    }
+    if (ec) {
+        GHULBUS_LOG(Warning, "Error while scanning " << m_mediaRoot << ": " << ec.message());
+    }
+}
+
+void DuplicateFinder::processTrack(std::filesystem::path const& track)
+{
+    auto const signature = getFileSignature(track);
+    if (!signature) { return; }
+    std::string key = signature->toKey();
+    {
+        std::lock_guard lk(m_mtx);
+        if (!m_knownKeys.insert(key).second) { return; }
+    }
+
+    std::filesystem::path const sidecar_path = getSidecarPath(key);
+    auto fingerprint = player::loadFingerprint(sidecar_path);
+    if (!fingerprint) {
+        fingerprint = player::computeFingerprint(track, m_streamOptions, &m_shutdownRequested);
+        if (m_shutdownRequested) { return; }
+        if (!fingerprint) {
+            GHULBUS_LOG(Warning, "Unable to compute fingerprint for " << track << ".");
+            std::lock_guard lk(m_mtx);
+            ++m_tracksFailed;
+            return;
+        }
+        player::saveFingerprint(*fingerprint, sidecar_path);
+    }
+
+    std::vector<FingerprintIndex::Candidate> candidates;
+    std::vector<std::string> candidate_keys;
+    FingerprintIndex::TrackId track_id;
+    {
+        std::lock_guard lk(m_mtx);
+        candidates = m_index.findCandidates(*fingerprint);
+        for (auto const& c : candidates) { candidate_keys.push_back(m_tracks[c.track].key); }
+        // from here on, tracks processed later find this one; each pair is compared exactly once
+        track_id = static_cast<FingerprintIndex::TrackId>(m_tracks.size());
+        m_tracks.push_back(Track{ track, std::move(key) });
+        m_index.insert(track_id, *fingerprint);
+    }
+
+    // candidates are rare, so their fingerprints are loaded on demand instead of keeping all of them in memory
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        auto const other = player::loadFingerprint(getSidecarPath(candidate_keys[i]));
+        if (!other) { continue; }
+        auto const match = player::compareFingerprints(*fingerprint, *other, candidates[i].offset, 2);
+        if (!match || (match->similarity < min_similarity)) { continue; }
+        std::lock_guard lk(m_mtx);
+        m_matches.push_back(Match{ candidates[i].track, track_id, match->similarity });
+    }
+}
+
+AnyResponse DuplicateFinder::handleRequest(
+    boost::beast::http::request<boost::beast::http::string_body> const& request)
+{
+    namespace http = boost::beast::http;
+    bool start_scan;
+    {
+        std::lock_guard lk(m_mtx);
+        start_scan = !m_scanStarted;
+    }
+    if (start_scan) { scanLibrary(); }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    {
+        std::lock_guard lk(m_mtx);
+        bool const is_scanning = m_scanRequested || m_isScanningDirectory || !m_pending.empty() ||
+                                 (m_tracksInProgress > 0);
+        writer.StartObject();
+        writer.Key("state");
+        writer.String(is_scanning ? "scanning" : "complete");
+        writer.Key("tracks_indexed");
+        writer.Uint64(m_tracks.size());
+        writer.Key("tracks_pending");
+        writer.Uint64(m_pending.size() + m_tracksInProgress);
+        writer.Key("tracks_failed");
+        writer.Uint64(m_tracksFailed);
+
+        // tracks that match each other directly or through a third track form one group
+        std::vector<FingerprintIndex::TrackId> parent(m_tracks.size());
+        std::iota(parent.begin(), parent.end(), FingerprintIndex::TrackId{ 0 });
+        auto const findRoot = [&parent](FingerprintIndex::TrackId t) {
+            while (parent[t] != t) { t = parent[t] = parent[parent[t]]; }
+            return t;
+        };
+        for (auto const& m : m_matches) { parent[findRoot(m.rhs)] = findRoot(m.lhs); }
+        std::map<FingerprintIndex::TrackId, std::vector<FingerprintIndex::TrackId>> groups;
+        std::map<FingerprintIndex::TrackId, double> group_similarity;
+        for (auto const& m : m_matches) {
+            auto const root = findRoot(m.lhs);
+            auto [it, inserted] = group_similarity.try_emplace(root, m.similarity);
+            if (!inserted) { it->second = std::min(it->second, m.similarity); }
+        }
+        for (auto const& [root, similarity] : group_similarity) { groups[root]; }
+        for (FingerprintIndex::TrackId t = 0; t < m_tracks.size(); ++t) {
+            if (auto const it = groups.find(findRoot(t)); it != groups.end()) { it->second.push_back(t); }
+        }
+
+        writer.Key("groups");
+        writer.StartArray();
+        for (auto const& [root, members] : groups) {
+            writer.StartObject();
+            writer.Key("min_similarity");
+            writer.Double(group_similarity[root]);
+            writer.Key("tracks");
+            writer.StartArray();
+            for (auto const t : members) {
+                std::u8string const path = m_tracks[t].path.lexically_relative(m_mediaRoot).generic_u8string();
+                writer.String(reinterpret_cast<char const*>(path.data()), static_cast<rapidjson::SizeType>(path.size()));
+            }
+            writer.EndArray();
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+    }
+
+    http::response<http::string_body> response{ http::status::ok, request.version() };
+    response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    response.set(http::field::content_type, "application/json");
+    response.keep_alive(request.keep_alive());
+    response.body() = std::string(buffer.GetString(), buffer.GetSize());
+    response.prepare_payload();
+    return response;
+}
+
+}
@@ -0,0 +1,89 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_DUPLICATE_FINDER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_SERVER_DUPLICATE_FINDER_HPP_
+
+#include <media_minion/server/any_response.hpp>
+#include <media_minion/server/fingerprint_index.hpp>
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace media_minion::server {
+
+/** Finds tracks in the media library that contain the same recording, regardless of format and tags.
+ * A pool of worker threads fingerprints every track once and keeps the fingerprints as sidecar files in
+ * the cache directory; later scans only load them. Each new fingerprint is looked up in a FingerprintIndex
+ * and only the candidates found there are compared in full.
+ * The duplicates found so far are exposed as json under /duplicates. Requesting them starts a library scan
+ * if none has run yet.
+ */
+class DuplicateFinder {
+private:
+    struct Track {
+        std::filesystem::path path;
+        std::string key;                    ///< file signature key; names the fingerprint sidecar
+    };
+    struct Match {
+        FingerprintIndex::TrackId lhs;
+        FingerprintIndex::TrackId rhs;
+        double similarity;
+    };
+
+    std::filesystem::path m_mediaRoot;
+    std::filesystem::path m_sidecarDirectory;
+    player::FfmpegStreamOptions m_streamOptions;
+
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cvWorker;
+    std::deque<std::filesystem::path> m_pending;
+    std::size_t m_tracksInProgress;
+    std::size_t m_tracksFailed;
+    bool m_scanRequested;
+    bool m_scanStarted;
+    bool m_isScanningDirectory;
+    std::atomic<bool> m_shutdownRequested;
+    std::unordered_set<std::string> m_knownKeys;
+    std::vector<Track> m_tracks;            ///< indexed by TrackId
+    FingerprintIndex m_index;
+    std::vector<Match> m_matches;
+
+    std::vector<std::thread> m_workers;
+public:
+    static constexpr std::string_view target = "/duplicates";
+    static constexpr double min_similarity = 0.85;
+
+    /** @param[in] thread_count Number of worker threads; 0 for one per hardware thread.
+     */
+    DuplicateFinder(std::filesystem::path media_root, std::filesystem::path const& cache_directory,
+                    player::FfmpegStreamOptions const& stream_options, std::size_t thread_count);
+    ~DuplicateFinder();
+
+    DuplicateFinder(DuplicateFinder const&) = delete;
+    DuplicateFinder& operator=(DuplicateFinder const&) = delete;
+
+    /** Fingerprints all audio files below the media root that were not seen before.
+     */
+    void scanLibrary();
+
+    AnyResponse handleRequest(boost::beast::http::request<boost::beast::http::string_body> const& request);
+private:
+    std::filesystem::path getSidecarPath(std::string const& key) const;
+    void workerThread();
+    void scanDirectory();
+    void processTrack(std::filesystem::path const& track);
+};
+
+}
+#endif
@@ -0,0 +1,68 @@
+#include <media_minion/server/fingerprint_index.hpp>
+
+#include <algorithm>
+#include <optional>
+
+namespace media_minion::server {
+
+namespace {
+std::optional<std::uint32_t> getIndexKey(std::uint32_t hash)
+{
+    std::uint32_t const key = hash & player::Fingerprint::frame_bits_mask;
+    // multiplicative hashing spreads the choice of keys evenly over the key space
+    std::uint32_t const mixed = key * 0x9e3779b1u;
+    if ((mixed >> 24) % FingerprintIndex::sampling_divisor != 0) { return std::nullopt; }
+    return key;
+}
+}
+
+void FingerprintIndex::insert(TrackId track, player::Fingerprint const& fingerprint)
+{
+    for (std::size_t i = 0; i < fingerprint.hashes.size(); ++i) {
+        if (auto const key = getIndexKey(fingerprint.hashes[i]); key) {
+            m_postings[*key].push_back(Posting{ track, static_cast<std::uint32_t>(i) });
+        }
+    }
+}
+
+std::vector<FingerprintIndex::Candidate> FingerprintIndex::findCandidates(
+    player::Fingerprint const& fingerprint) const
+{
+    // votes per track and alignment
+    std::unordered_map<std::uint64_t, std::uint32_t> votes;
+    auto const voteKey = [](TrackId track, int offset) {
+        return (static_cast<std::uint64_t>(track) << 32) | static_cast<std::uint32_t>(offset);
+    };
+    for (std::size_t i = 0; i < fingerprint.hashes.size(); ++i) {
+        auto const key = getIndexKey(fingerprint.hashes[i]);
+        if (!key) { continue; }
+        auto const it = m_postings.find(*key);
+        if ((it == m_postings.end()) || (it->second.size() > max_posting_list_length)) { continue; }
+        for (auto const& posting : it->second) {
+            ++votes[voteKey(posting.track, static_cast<int>(posting.position) - static_cast<int>(i))];
+        }
+    }
+
+    // frames of two encodings are rarely aligned exactly, so neighbouring alignments count as well
+    std::unordered_map<TrackId, Candidate> best;
+    for (auto const& [vote_key, count] : votes) {
+        TrackId const track = static_cast<TrackId>(vote_key >> 32);
+        int const offset = static_cast<int>(static_cast<std::uint32_t>(vote_key));
+        std::uint32_t total = count;
+        for (int neighbour : { offset - 1, offset + 1 }) {
+            if (auto const it = votes.find(voteKey(track, neighbour)); it != votes.end()) { total += it->second; }
+        }
+        if (total < min_votes) { continue; }
+        auto [it, inserted] = best.try_emplace(track, Candidate{ track, offset, total });
+        if (!inserted && (total > it->second.votes)) { it->second = Candidate{ track, offset, total }; }
+    }
+
+    std::vector<Candidate> ret;
+    ret.reserve(best.size());
+    for (auto const& [track, candidate] : best) { ret.push_back(candidate); }
+    std::sort(ret.begin(), ret.end(), [](Candidate const& lhs, Candidate const& rhs) { return lhs.votes > rhs.votes; });
+    if (ret.size() > max_candidates) { ret.resize(max_candidates); }
+    return ret;
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_FINGERPRINT_INDEX_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_SERVER_FINGERPRINT_INDEX_HPP_
+
+#include <media_minion/player/fingerprint.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace media_minion::server {
+
+/** Inverted index over the hashes of many fingerprints, for finding near-duplicates of a track without
+ * comparing it against every other track.
+ * Keys are the frame bits of a hash. Only keys from a fixed pseudo-random subset of the key space are
+ * stored, which keeps the index small; because the subset is chosen by value, two copies of the same
+ * audio still have the same keys indexed. Candidates need several keys in common at a consistent alignment.
+ */
+class FingerprintIndex {
+public:
+    using TrackId = std::uint32_t;
+
+    struct Candidate {
+        TrackId track;
+        int offset;                 ///< alignment for compareFingerprints(query, track's fingerprint)
+        std::uint32_t votes;
+    };
+private:
+    struct Posting {
+        TrackId track;
+        std::uint32_t position;
+    };
+    std::unordered_map<std::uint32_t, std::vector<Posting>> m_postings;
+public:
+    static constexpr std::uint32_t sampling_divisor = 16;
+    /** Keys shared by this many hashes stem from silence or noise and carry no information.
+     */
+    static constexpr std::size_t max_posting_list_length = 4096;
+    static constexpr std::uint32_t min_votes = 3;
+    static constexpr std::size_t max_candidates = 32;
+
+    void insert(TrackId track, player::Fingerprint const& fingerprint);
+
+    /** @return The tracks with at least min_votes matching keys, best first.
+     */
+    std::vector<Candidate> findCandidates(player::Fingerprint const& fingerprint) const;
+};
+
+}
+#endif
@@ -0,0 +1,56 @@
+#include <media_minion/server/http_router.hpp>
+
+#include <gbBase/Assert.hpp>
+
+#include <boost/beast/version.hpp>
+
+#include <string>
+
+namespace media_minion::server {
+
+namespace {
+auto responseMethodNotAllowed(HttpRouter::Request const& request, MethodSet allowed)
+{
+    namespace http = boost::beast::http;
+    std::string allow;
+    for (unsigned v = 0; v < 64; ++v) {
+        if ((allowed & (MethodSet(1) << v)) == 0) { continue; }
+        auto const name = http::to_string(static_cast<http::verb>(v));
+        if (!allow.empty()) { allow += ", "; }
+        allow.append(name.data(), name.size());
+    }
+    http::response<http::string_body> response{ http::status::method_not_allowed, request.version() };
+    response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    response.set(http::field::content_type, "text/html");
+    response.set(http::field::allow, allow);
+    response.keep_alive(request.keep_alive());
+    response.body() = "Method Not Allowed: " + std::string(request.method_string());
+    response.prepare_payload();
+    return response;
+}
+}
+
+HttpRouter::HttpRouter(RouteTable const& table)
+    :m_table(table), m_handlers(table.size())
+{
+}
+
+void HttpRouter::setHandler(std::size_t route, Handler handler)
+{
+    GHULBUS_PRECONDITION(route < m_handlers.size());
+    m_handlers[route] = std::move(handler);
+}
+
+std::optional<AnyResponse> HttpRouter::dispatch(Request const& request) const
+{
+    namespace http = boost::beast::http;
+    auto const match = m_table.match(std::string_view(request.target().data(), request.target().size()));
+    if (!match || !m_handlers[match->route()]) { return std::nullopt; }
+
+    MethodSet allowed = match->methods();
+    if (allowed & methodSet({ http::verb::get })) { allowed |= methodSet({ http::verb::head }); }
+    if ((allowed & methodSet({ request.method() })) == 0) { return responseMethodNotAllowed(request, allowed); }
+    return m_handlers[match->route()](request, *match);
+}
+
+}
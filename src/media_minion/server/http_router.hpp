@@ -0,0 +1,274 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_HTTP_ROUTER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_SERVER_HTTP_ROUTER_HPP_
+
+#include <media_minion/server/any_response.hpp>
+
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+#include <boost/beast/http/verb.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace media_minion::server {
+
+/** Set of http methods, one bit per boost::beast::http::verb.
+ */
+using MethodSet = std::uint64_t;
+
+constexpr MethodSet methodSet(std::initializer_list<boost::beast::http::verb> verbs)
+{
+    MethodSet ret = 0;
+    for (auto const v : verbs) { ret |= (MethodSet(1) << static_cast<unsigned>(v)); }
+    return ret;
+}
+
+/** A route of the server.
+ * Patterns consist of segments separated by '/'. Segments are either matched literally or are parameters:
+ *  - {name}        any non-empty segment
+ *  - {name:int}    a segment of decimal digits
+ *  - {name*}       the remainder of the path, slashes included; only allowed as the last segment
+ * Literal segments take precedence over parameters, integer parameters over string parameters.
+ */
+struct RouteSpec {
+    std::string_view pattern;
+    MethodSet methods;
+};
+
+/** Result of matching a request target against a RouteTable.
+ * Parameters refer into the matched target, which must outlive the match.
+ */
+class RouteMatch {
+public:
+    static constexpr std::size_t max_parameters = 4;
+private:
+    friend class RouteTable;
+    std::size_t m_route = 0;
+    MethodSet m_methods = 0;
+    std::array<std::string_view, max_parameters> m_names{};
+    std::array<std::string_view, max_parameters> m_values{};
+    std::size_t m_parameterCount = 0;
+public:
+    /** Index of the route in the specs that the table was built from.
+     */
+    constexpr std::size_t route() const { return m_route; }
+    constexpr MethodSet methods() const { return m_methods; }
+
+    constexpr std::optional<std::string_view> get(std::string_view name) const
+    {
+        for (std::size_t i = 0; i < m_parameterCount; ++i) {
+            if (m_names[i] == name) { return m_values[i]; }
+        }
+        return std::nullopt;
+    }
+
+    /** @return std::nullopt if there is no such parameter or its value does not fit.
+     */
+    constexpr std::optional<std::int64_t> getInt(std::string_view name) const
+    {
+        auto const value = get(name);
+        if (!value || value->empty()) { return std::nullopt; }
+        std::int64_t ret = 0;
+        for (char const c : *value) {
+            if ((c < '0') || (c > '9')) { return std::nullopt; }
+            if (ret > (std::numeric_limits<std::int64_t>::max() - (c - '0')) / 10) { return std::nullopt; }
+            ret = ret * 10 + (c - '0');
+        }
+        return ret;
+    }
+};
+
+/** Maps request targets to routes with a trie over the path segments.
+ * Meant to be built from a constexpr array of specs at compile time, which also turns malformed or
+ * conflicting patterns into compile errors. Matching walks the trie segment by segment and never allocates.
+ */
+class RouteTable {
+public:
+    static constexpr std::size_t max_nodes = 64;
+    static constexpr std::size_t max_routes = 32;
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+private:
+    enum class SegmentKind {
+        Root,
+        Literal,
+        Integer,
+        String,
+        Tail
+    };
+    struct Node {
+        SegmentKind kind = SegmentKind::Root;
+        std::string_view text;                  ///< the literal, or the parameter name
+        std::size_t first_child = npos;
+        std::size_t next_sibling = npos;
+        std::size_t route = npos;
+    };
+    std::array<Node, max_nodes> m_nodes{};
+    std::size_t m_nodeCount = 1;
+    std::array<MethodSet, max_routes> m_methods{};
+    std::size_t m_routeCount = 0;
+public:
+    constexpr explicit RouteTable(std::span<RouteSpec const> routes)
+    {
+        if (routes.size() > max_routes) { throw std::length_error("Too many routes."); }
+        for (auto const& r : routes) { insert(r); }
+    }
+
+    constexpr std::size_t size() const { return m_routeCount; }
+
+    /** @param[in] target Request target; a query string is ignored.
+     */
+    constexpr std::optional<RouteMatch> match(std::string_view target) const
+    {
+        target = target.substr(0, target.find('?'));
+        if (target.empty() || (target.front() != '/')) { return std::nullopt; }
+        RouteMatch ret;
+        std::size_t const route = matchChildren(0, target.substr(1), ret);
+        if (route == npos) { return std::nullopt; }
+        ret.m_route = route;
+        ret.m_methods = m_methods[route];
+        return ret;
+    }
+private:
+    static constexpr bool isInteger(std::string_view segment)
+    {
+        if (segment.empty()) { return false; }
+        for (char const c : segment) {
+            if ((c < '0') || (c > '9')) { return false; }
+        }
+        return true;
+    }
+
+    static constexpr std::pair<SegmentKind, std::string_view> parseSegment(std::string_view segment)
+    {
+        if (segment.empty() || (segment.front() != '{')) {
+            if (segment.find_first_of("{}") != std::string_view::npos) {
+                throw std::invalid_argument("Braces in literal route segment.");
+            }
+            return { SegmentKind::Literal, segment };
+        }
+        if ((segment.size() < 3) || (segment.back() != '}')) {
+            throw std::invalid_argument("Malformed route parameter.");
+        }
+        std::string_view const inner = segment.substr(1, segment.size() - 2);
+        if (inner.back() == '*') { return { SegmentKind::Tail, inner.substr(0, inner.size() - 1) }; }
+        auto const colon = inner.find(':');
+        if (colon == std::string_view::npos) { return { SegmentKind::String, inner }; }
+        if (inner.substr(colon + 1) != "int") { throw std::invalid_argument("Unknown route parameter type."); }
+        return { SegmentKind::Integer, inner.substr(0, colon) };
+    }
+
+    constexpr void insert(RouteSpec const& spec)
+    {
+        if (spec.pattern.empty() || (spec.pattern.front() != '/')) {
+            throw std::invalid_argument("Route patterns start with '/'.");
+        }
+        std::size_t node = 0;
+        std::size_t parameter_count = 0;
+        std::optional<std::string_view> rest = spec.pattern.substr(1);
+        while (rest) {
+            auto const slash = rest->find('/');
+            auto const [kind, text] = parseSegment(rest->substr(0, slash));
+            rest = (slash == std::string_view::npos) ? std::nullopt :
+                                                       std::optional<std::string_view>(rest->substr(slash + 1));
+            if ((kind == SegmentKind::Tail) && rest) {
+                throw std::invalid_argument("Tail parameters end the route pattern.");
+            }
+            if ((kind != SegmentKind::Literal) && (++parameter_count > RouteMatch::max_parameters)) {
+                throw std::length_error("Too many parameters in route pattern.");
+            }
+            node = findOrAddChild(node, kind, text);
+        }
+        if (m_nodes[node].route != npos) { throw std::invalid_argument("Duplicate route pattern."); }
+        m_nodes[node].route = m_routeCount;
+        m_methods[m_routeCount] = spec.methods;
+        ++m_routeCount;
+    }
+
+    constexpr std::size_t findOrAddChild(std::size_t parent, SegmentKind kind, std::string_view text)
+    {
+        std::size_t* link = &m_nodes[parent].first_child;
+        while (*link != npos) {
+            Node const& sibling = m_nodes[*link];
+            if (sibling.kind == kind) {
+                if (sibling.text == text) { return *link; }
+                // the parameter name would depend on which route matched
+                if (kind != SegmentKind::Literal) {
+                    throw std::invalid_argument("Conflicting route parameter names.");
+                }
+            }
+            link = &m_nodes[*link].next_sibling;
+        }
+        if (m_nodeCount == max_nodes) { throw std::length_error("Too many route segments."); }
+        m_nodes[m_nodeCount] = Node{ kind, text, npos, npos, npos };
+        *link = m_nodeCount;
+        return m_nodeCount++;
+    }
+
+    /** @param[in] rest Path after the segment of node; std::nullopt if the path ends with that segment.
+     */
+    constexpr std::size_t matchChildren(std::size_t node, std::optional<std::string_view> rest,
+                                        RouteMatch& match) const
+    {
+        if (!rest) { return m_nodes[node].route; }
+        auto const slash = rest->find('/');
+        std::string_view const segment = rest->substr(0, slash);
+        std::optional<std::string_view> const next = (slash == std::string_view::npos) ? std::nullopt :
+            std::optional<std::string_view>(rest->substr(slash + 1));
+        for (auto const kind : { SegmentKind::Literal, SegmentKind::Integer, SegmentKind::String, SegmentKind::Tail }) {
+            for (std::size_t child = m_nodes[node].first_child; child != npos; child = m_nodes[child].next_sibling) {
+                Node const& c = m_nodes[child];
+                if (c.kind != kind) { continue; }
+                if ((kind == SegmentKind::Literal) && (c.text != segment)) { continue; }
+                if ((kind == SegmentKind::Integer) && !isInteger(segment)) { continue; }
+                if ((kind == SegmentKind::String) && segment.empty()) { continue; }
+                std::size_t const parameter_count = match.m_parameterCount;
+                if (kind != SegmentKind::Literal) {
+                    match.m_names[parameter_count] = c.text;
+                    match.m_values[parameter_count] = (kind == SegmentKind::Tail) ? *rest : segment;
+                    ++match.m_parameterCount;
+                }
+                std::size_t const route = (kind == SegmentKind::Tail) ? c.route : matchChildren(child, next, match);
+                if (route != npos) { return route; }
+                match.m_parameterCount = parameter_count;
+            }
+        }
+        return npos;
+    }
+};
+
+/** Dispatches requests to the handlers of the routes in a RouteTable.
+ * HEAD requests are dispatched to routes that allow GET; the session only sends the header of the response.
+ * Requests with a method that the route does not allow are answered with 405.
+ */
+class HttpRouter {
+public:
+    using Request = boost::beast::http::request<boost::beast::http::string_body>;
+    using Handler = std::function<AnyResponse(Request const&, RouteMatch const&)>;
+private:
+    RouteTable const& m_table;
+    std::vector<Handler> m_handlers;
+public:
+    /** @param[in] table Must outlive the router; usually a constexpr table.
+     */
+    explicit HttpRouter(RouteTable const& table);
+
+    /** Routes without a handler are treated as if they did not exist.
+     */
+    void setHandler(std::size_t route, Handler handler);
+
+    /** @return std::nullopt if no route with a handler matches the target of request.
+     */
+    std::optional<AnyResponse> dispatch(Request const& request) const;
+};
+
+}
+#endif
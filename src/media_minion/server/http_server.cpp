@@ -33,6 +33,7 @@ int HttpServer::run(boost::asio::ip::tcp protocol, std::uint16_t port)
     };
 
     listener.run(protocol, port);
+    if (onListening) { boost::asio::post(m_io_ctx, [this]() { onListening(); }); }
 
     bool is_done = false;
     while (!is_done) {
@@ -62,6 +63,13 @@ void HttpServer::requestShutdown()
     });
 }
 
+void HttpServer::broadcastWebsocketMessage(std::string const& msg, WebsocketSession const* sender)
+{
+    for (auto const& session : m_websocket_sessions) {
+        if (session.get() != sender) { session->send(msg); }
+    }
+}
+
 void HttpServer::waitForShutdown(std::shared_ptr<boost::asio::steady_timer> timer)
 {
     if ((!m_sessions.empty()) || (!m_websocket_sessions.empty())) {
@@ -91,6 +99,12 @@ void HttpServer::createHttpSession(boost::asio::ip::tcp::socket&& s)
         requestRemoveSession(ps);
     };
 
+    session.onRequest = [this](boost::beast::http::request<boost::beast::http::string_body> const& r)
+                            -> std::optional<AnyResponse> {
+        if (!onHttpRequest) { return std::nullopt; }
+        return onHttpRequest(r);
+    };
+
     session.run();
 }
 
@@ -113,7 +127,7 @@ void HttpServer::createWebsocketSession(boost::asio::ip::tcp::socket&& s,
     };
     session.onMessage = [this, ps = &session](std::string msg) {
         if (onWebsocketMessage) {
-            onWebsocketMessage(std::move(msg));
+            onWebsocketMessage(*ps, std::move(msg));
         }
     };
 
@@ -136,6 +150,7 @@ void HttpServer::requestRemoveSession(WebsocketSession* s)
         auto const it = std::find_if(begin(m_websocket_sessions), end(m_websocket_sessions),
             [s](auto const& p) { return p.get() == s; });
         if (it != end(m_websocket_sessions)) {
+            if (onWebsocketClosed) { onWebsocketClosed(**it); }
             m_websocket_sessions.erase(it);
         }
     });
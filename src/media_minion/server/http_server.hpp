@@ -1,6 +1,7 @@
 #ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_HTTP_SERVER_HPP_
 #define MEDIA_MINION_INCLUDE_GUARD_SERVER_HTTP_SERVER_HPP_
 
+#include <media_minion/server/any_response.hpp>
 #include <media_minion/server/callback_return.hpp>
 
 #include <boost/asio/executor_work_guard.hpp>
@@ -13,6 +14,7 @@
 
 #include <functional>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace media_minion::server {
@@ -37,13 +39,26 @@ public:
 
     void requestShutdown();
 
+    /** Sends msg to all open websocket sessions except the sender.
+     * Must be called from within one of the callbacks.
+     */
+    void broadcastWebsocketMessage(std::string const& msg, WebsocketSession const* sender = nullptr);
+
     HttpServer(HttpServer const&) = delete;
     HttpServer& operator=(HttpServer const&) = delete;
     HttpServer(HttpServer&&) = delete;
     HttpServer& operator=(HttpServer&&) = delete;
 
     std::function<CallbackReturn(boost::system::error_code const&)> onError;
-    std::function<void(std::string)> onWebsocketMessage;
+    std::function<void(WebsocketSession&, std::string)> onWebsocketMessage;
+    /** Invoked right before a websocket session is destroyed.
+     */
+    std::function<void(WebsocketSession&)> onWebsocketClosed;
+    /** Invoked on the io thread once the listener is accepting connections.
+     */
+    std::function<void()> onListening;
+    std::function<std::optional<AnyResponse>(
+        boost::beast::http::request<boost::beast::http::string_body> const&)> onHttpRequest;
 private:
     void createHttpSession(boost::asio::ip::tcp::socket&& s);
     void createWebsocketSession(boost::asio::ip::tcp::socket&& s,
@@ -11,24 +11,11 @@
 
 #include <string>
 #include <string_view>
-#include <type_traits>
 
 namespace media_minion::server {
 
 namespace {
 
-template<typename T>
-auto response_bad_request(boost::beast::http::request<T> const& request, std::string_view reason) {
-    boost::beast::http::response<boost::beast::http::string_body> response{ boost::beast::http::status::bad_request,
-                                                                            request.version() };
-    response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
-    response.set(boost::beast::http::field::content_type, "text/html");
-    response.keep_alive(request.keep_alive());
-    response.body() = "Bad Request: " + std::string(reason);
-    response.prepare_payload();
-    return response;
-}
-
 template<typename T>
 auto response_not_found(boost::beast::http::request<T> const& request, std::string_view target) {
     boost::beast::http::response<boost::beast::http::string_body> response{ boost::beast::http::status::not_found,
@@ -84,22 +71,16 @@ void HttpSession::onHttpRead(boost::system::error_code const& ec, std::size_t by
         return;
     }
 
-    auto sendResponse = [this](auto&& response) {
-        using response_t = std::decay_t<decltype(response)>;
-        auto response_ptr = std::make_unique<response_t>(std::forward<decltype(response)>(response));
-        auto& r = *response_ptr;
-        boost::beast::http::async_write(m_socket, r,
-            [this, response_ptr = std::move(response_ptr)](boost::system::error_code const& ec, std::size_t bytes) {
-                onHttpWrite(ec, bytes, response_ptr->need_eof());
-            });
-    };
-
     if (boost::beast::websocket::is_upgrade(m_request)) {
         if (onWebsocketUpgrade) { onWebsocketUpgrade(std::move(m_socket), std::move(m_request)); }
         return;
-    } else if ((m_request.method() != boost::beast::http::verb::get) &&
-               (m_request.method() != boost::beast::http::verb::head)) {
-        sendResponse(response_bad_request(m_request, m_request.method_string().to_string()));
+    }
+
+    if (onRequest) {
+        if (auto response = onRequest(m_request); response) {
+            sendResponse(std::move(*response));
+            return;
+        }
     }
 
     sendResponse(response_not_found(m_request, m_request.target().to_string()));
@@ -109,10 +90,14 @@ void HttpSession::sendResponse(AnyResponse response)
 {
     std::unique_ptr<AnyResponse> ar = std::make_unique<AnyResponse>(std::move(response));
     AnyResponse & resp = *ar;
-    resp.async_write(m_socket,
-        [this, response = std::move(ar)](boost::system::error_code const& ec, std::size_t bytes) {
+    auto handler = [this, response = std::move(ar)](boost::system::error_code const& ec, std::size_t bytes) {
             onHttpWrite(ec, bytes, response->need_eof());
-        });
+        };
+    if (m_request.method() == boost::beast::http::verb::head) {
+        resp.async_write_header(m_socket, std::move(handler));
+    } else {
+        resp.async_write(m_socket, std::move(handler));
+    }
 }
 
 void HttpSession::onHttpWrite(boost::system::error_code const& ec, std::size_t bytes_written, bool close_requested)
@@ -132,6 +117,7 @@ void HttpSession::onHttpWrite(boost::system::error_code const& ec, std::size_t b
         return;
     }
 
+    // pipelined requests that arrived in the meantime are already in m_buffer and get parsed from there
     m_request = {};
     newRead();
 }
@@ -11,6 +11,7 @@
 #include <boost/beast/http/string_body.hpp>
 
 #include <functional>
+#include <optional>
 
 namespace media_minion::server {
 
@@ -36,6 +37,11 @@ public:
     std::function<void(boost::system::error_code const&)> onError;
     std::function<void(boost::asio::ip::tcp::socket&&,
                        boost::beast::http::request<boost::beast::http::string_body>&&)> onWebsocketUpgrade;
+    /** Invoked for all requests except websocket upgrades. Returning std::nullopt answers the request with 404.
+     * Only the header of responses to HEAD requests is sent.
+     */
+    std::function<std::optional<AnyResponse>(
+        boost::beast::http::request<boost::beast::http::string_body> const&)> onRequest;
 private:
     void newRead();
     void onHttpRead(boost::system::error_code const& ec, std::size_t bytes_read);
@@ -0,0 +1,272 @@
+#include <media_minion/server/media_file_handler.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <boost/beast/core/file.hpp>
+#include <boost/beast/http/error.hpp>
+#include <boost/beast/http/file_body.hpp>
+#include <boost/beast/version.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <string>
+#include <utility>
+
+namespace media_minion::server {
+
+namespace {
+/** A byte range of a file as the body of a response.
+ * Like file_body, the file is read piece by piece while the response is being written, so that a large
+ * range does not hold up the other sessions on the io thread.
+ */
+struct RangeFileBody {
+    struct value_type {
+        boost::beast::file file;
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+    };
+
+    static std::uint64_t size(value_type const& body)
+    {
+        return body.length;
+    }
+
+    class writer {
+    private:
+        value_type& m_body;
+        std::uint64_t m_remaining;
+        std::array<char, 64 * 1024> m_buffer;
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template<bool isRequest, typename Fields>
+        writer(boost::beast::http::header<isRequest, Fields>&, value_type& body)
+            :m_body(body), m_remaining(body.length)
+        {}
+
+        void init(boost::beast::error_code& ec)
+        {
+            m_body.file.seek(m_body.offset, ec);
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(boost::beast::error_code& ec)
+        {
+            ec = {};
+            std::size_t const amount = static_cast<std::size_t>(std::min<std::uint64_t>(m_remaining,
+                                                                                         m_buffer.size()));
+            if (amount == 0) { return boost::none; }
+            std::size_t const n = m_body.file.read(m_buffer.data(), amount, ec);
+            if (ec) { return boost::none; }
+            if (n == 0) {
+                // the file shrank since the response header was sent
+                ec = boost::beast::http::error::short_read;
+                return boost::none;
+            }
+            m_remaining -= n;
+            return std::make_pair(const_buffers_type(m_buffer.data(), n), m_remaining > 0);
+        }
+    };
+};
+
+struct ByteRange {
+    std::uint64_t first;
+    std::uint64_t last;     ///< inclusive
+};
+
+enum class RangeParseResult {
+    NoRange,
+    Valid,
+    Unsatisfiable,
+};
+
+std::optional<std::uint64_t> parseNumber(std::string_view str)
+{
+    std::uint64_t ret;
+    auto const [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), ret);
+    if ((ec != std::errc{}) || (ptr != str.data() + str.size()) || str.empty()) { return std::nullopt; }
+    return ret;
+}
+
+RangeParseResult parseRange(std::string_view range_header, std::uint64_t file_size, ByteRange& out_range)
+{
+    constexpr std::string_view prefix = "bytes=";
+    if ((range_header.substr(0, prefix.size()) != prefix) ||
+        (range_header.find(',') != std::string_view::npos))
+    {
+        // unknown unit or multiple ranges; ignoring the header and sending everything is always valid
+        return RangeParseResult::NoRange;
+    }
+    range_header.remove_prefix(prefix.size());
+    auto const dash = range_header.find('-');
+    if (dash == std::string_view::npos) { return RangeParseResult::NoRange; }
+    std::string_view const str_first = range_header.substr(0, dash);
+    std::string_view const str_last = range_header.substr(dash + 1);
+    if (str_first.empty()) {
+        // suffix range: the last n bytes
+        auto const suffix_length = parseNumber(str_last);
+        if (!suffix_length) { return RangeParseResult::NoRange; }
+        if ((*suffix_length == 0) || (file_size == 0)) { return RangeParseResult::Unsatisfiable; }
+        out_range.first = file_size - std::min(*suffix_length, file_size);
+        out_range.last = file_size - 1;
+        return RangeParseResult::Valid;
+    }
+    auto const first = parseNumber(str_first);
+    if (!first) { return RangeParseResult::NoRange; }
+    if (*first >= file_size) { return RangeParseResult::Unsatisfiable; }
+    out_range.first = *first;
+    out_range.last = file_size - 1;
+    if (!str_last.empty()) {
+        auto const last = parseNumber(str_last);
+        if (!last || (*last < *first)) { return RangeParseResult::NoRange; }
+        out_range.last = std::min(*last, file_size - 1);
+    }
+    return RangeParseResult::Valid;
+}
+
+template<typename Body, typename T>
+void setCommonFields(boost::beast::http::response<Body>& response, boost::beast::http::request<T> const& request)
+{
+    response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
+    response.set(boost::beast::http::field::accept_ranges, "bytes");
+    response.keep_alive(request.keep_alive());
+}
+
+template<typename T>
+AnyResponse responseStatus(boost::beast::http::request<T> const& request, boost::beast::http::status status,
+                           std::string_view message)
+{
+    boost::beast::http::response<boost::beast::http::string_body> response{ status, request.version() };
+    setCommonFields(response, request);
+    response.set(boost::beast::http::field::content_type, "text/html");
+    response.body() = std::string(message);
+    response.prepare_payload();
+    return response;
+}
+
+int fromHex(char c)
+{
+    if ((c >= '0') && (c <= '9')) { return c - '0'; }
+    if ((c >= 'a') && (c <= 'f')) { return c - 'a' + 10; }
+    if ((c >= 'A') && (c <= 'F')) { return c - 'A' + 10; }
+    return -1;
+}
+}
+
+std::optional<std::string> decodeUrlPath(std::string_view encoded)
+{
+    std::string ret;
+    ret.reserve(encoded.size());
+    for (std::size_t i = 0; i < encoded.size(); ++i) {
+        if (encoded[i] == '%') {
+            if (i + 2 >= encoded.size()) { return std::nullopt; }
+            int const hi = fromHex(encoded[i + 1]);
+            int const lo = fromHex(encoded[i + 2]);
+            if ((hi < 0) || (lo < 0)) { return std::nullopt; }
+            char const c = static_cast<char>((hi << 4) | lo);
+            if (c == '\0') { return std::nullopt; }
+            ret.push_back(c);
+            i += 2;
+        } else {
+            ret.push_back(encoded[i]);
+        }
+    }
+    return ret;
+}
+
+std::optional<std::filesystem::path> resolveMediaPath(std::filesystem::path const& media_root,
+                                                      std::string_view encoded_relative_path)
+{
+    if (auto const query = encoded_relative_path.find('?'); query != std::string_view::npos) {
+        encoded_relative_path = encoded_relative_path.substr(0, query);
+    }
+    auto const decoded = decodeUrlPath(encoded_relative_path);
+    if (!decoded) { return std::nullopt; }
+    std::filesystem::path const relative_path{ std::u8string(decoded->begin(), decoded->end()) };
+    if (relative_path.empty() || relative_path.has_root_name() || relative_path.has_root_directory()) {
+        return std::nullopt;
+    }
+    for (auto const& component : relative_path) {
+        if (component == "..") { return std::nullopt; }
+    }
+    return media_root / relative_path;
+}
+
+MediaFileHandler::MediaFileHandler(std::filesystem::path media_root)
+    :m_mediaRoot(std::move(media_root))
+{
+}
+
+AnyResponse MediaFileHandler::handleRequest(
+    boost::beast::http::request<boost::beast::http::string_body> const& request, std::string_view relative_path) const
+{
+    namespace http = boost::beast::http;
+    std::string_view const target(request.target().data(), request.target().size());
+    auto const opt_filepath = resolveMediaPath(m_mediaRoot, relative_path);
+    if (!opt_filepath) {
+        return responseStatus(request, http::status::bad_request, "Bad Request: invalid media path");
+    }
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(*opt_filepath, ec)) {
+        return responseStatus(request, http::status::not_found, std::string(target) + " not found.");
+    }
+    std::uint64_t const file_size = std::filesystem::file_size(*opt_filepath, ec);
+    if (ec) {
+        return responseStatus(request, http::status::internal_server_error, "Unable to access file.");
+    }
+
+    ByteRange range{ 0, (file_size > 0) ? (file_size - 1) : 0 };
+    auto const range_header = request[http::field::range];
+    RangeParseResult const range_result =
+        parseRange(std::string_view(range_header.data(), range_header.size()), file_size, range);
+    if (range_result == RangeParseResult::Unsatisfiable) {
+        http::response<http::string_body> response{ http::status::range_not_satisfiable, request.version() };
+        setCommonFields(response, request);
+        response.set(http::field::content_range, "bytes */" + std::to_string(file_size));
+        response.prepare_payload();
+        return response;
+    }
+
+    if (range_result == RangeParseResult::NoRange) {
+        // beast expects utf-8 file names on all platforms
+        std::u8string const u8_filepath = opt_filepath->u8string();
+        std::string const filepath_str(u8_filepath.begin(), u8_filepath.end());
+        http::file_body::value_type body;
+        boost::system::error_code open_ec;
+        body.open(filepath_str.c_str(), boost::beast::file_mode::scan, open_ec);
+        if (open_ec) {
+            return responseStatus(request, http::status::internal_server_error, "Unable to open file.");
+        }
+        http::response<http::file_body> response{ std::piecewise_construct, std::make_tuple(std::move(body)),
+                                                  std::make_tuple(http::status::ok, request.version()) };
+        setCommonFields(response, request);
+        response.set(http::field::content_type, "application/octet-stream");
+        response.prepare_payload();
+        return response;
+    }
+
+    std::uint64_t const range_size = range.last - range.first + 1;
+    std::string const content_range = "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) +
+                                      "/" + std::to_string(file_size);
+    std::u8string const u8_filepath = opt_filepath->u8string();
+    std::string const filepath_str(u8_filepath.begin(), u8_filepath.end());
+    RangeFileBody::value_type body;
+    boost::system::error_code open_ec;
+    body.file.open(filepath_str.c_str(), boost::beast::file_mode::read, open_ec);
+    if (open_ec) {
+        GHULBUS_LOG(Error, "Error opening " << *opt_filepath << " for range " << content_range);
+        return responseStatus(request, http::status::internal_server_error, "Unable to open file.");
+    }
+    body.offset = range.first;
+    body.length = range_size;
+    http::response<RangeFileBody> response{ std::piecewise_construct, std::make_tuple(std::move(body)),
+                                            std::make_tuple(http::status::partial_content, request.version()) };
+    setCommonFields(response, request);
+    response.set(http::field::content_type, "application/octet-stream");
+    response.set(http::field::content_range, content_range);
+    response.prepare_payload();
+    return response;
+}
+
+}
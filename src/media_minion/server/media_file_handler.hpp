@@ -0,0 +1,43 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_MEDIA_FILE_HANDLER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_SERVER_MEDIA_FILE_HANDLER_HPP_
+
+#include <media_minion/server/any_response.hpp>
+
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace media_minion::server {
+
+/** Serves files below the media root directory under /media/<relative path>.
+ * Supports single byte ranges, so that players can stream files without having the library mounted.
+ */
+class MediaFileHandler {
+private:
+    std::filesystem::path m_mediaRoot;
+public:
+    explicit MediaFileHandler(std::filesystem::path media_root);
+
+    /** @param[in] relative_path Url encoded path of the file relative to the media root.
+     */
+    AnyResponse handleRequest(boost::beast::http::request<boost::beast::http::string_body> const& request,
+                              std::string_view relative_path) const;
+};
+
+/** Decodes %xx escapes in the path part of a request target.
+ */
+std::optional<std::string> decodeUrlPath(std::string_view encoded);
+
+/** Maps an url encoded path relative to the media root to a file below the media root.
+ * A query part is ignored.
+ * @return std::nullopt if the path is malformed or points outside of the media root.
+ */
+std::optional<std::filesystem::path> resolveMediaPath(std::filesystem::path const& media_root,
+                                                      std::string_view encoded_relative_path);
+
+}
+#endif
@@ -0,0 +1,90 @@
+#include <media_minion/server/player_registry.hpp>
+
+#include <rapidjson/rapidjson.h>
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 5054)
+#endif
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <gbBase/Log.hpp>
+
+#include <boost/beast/version.hpp>
+
+namespace media_minion::server {
+
+void PlayerRegistry::onMessage(WebsocketSession const& session, std::string const& msg)
+{
+    rapidjson::Document doc;
+    doc.Parse(msg.c_str(), msg.size());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("type") || !doc["type"].IsString()) { return; }
+    std::string_view const type = doc["type"].GetString();
+    if (type == "hello") {
+        if (!doc.HasMember("role") || !doc["role"].IsString() || (std::string_view(doc["role"].GetString()) != "player")) {
+            return;
+        }
+        std::string name = (doc.HasMember("name") && doc["name"].IsString()) ? doc["name"].GetString() : "";
+        GHULBUS_LOG(Info, "Player '" << name << "' connected.");
+        m_players[&session].name = std::move(name);
+        return;
+    }
+
+    auto const it = m_players.find(&session);
+    if (it == m_players.end()) { return; }
+    if (type == "player_state") {
+        it->second.state = msg;
+    } else if (type == "telemetry") {
+        it->second.telemetry = msg;
+        it->second.telemetry_received = std::chrono::steady_clock::now();
+    }
+}
+
+void PlayerRegistry::onSessionClosed(WebsocketSession const& session)
+{
+    auto const it = m_players.find(&session);
+    if (it == m_players.end()) { return; }
+    GHULBUS_LOG(Info, "Player '" << it->second.name << "' disconnected.");
+    m_players.erase(it);
+}
+
+AnyResponse PlayerRegistry::handleRequest(
+    boost::beast::http::request<boost::beast::http::string_body> const& request) const
+{
+    namespace http = boost::beast::http;
+    auto const now = std::chrono::steady_clock::now();
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartArray();
+    for (auto const& [session, player] : m_players) {
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(player.name.c_str(), static_cast<rapidjson::SizeType>(player.name.size()));
+        if (!player.state.empty()) {
+            writer.Key("state");
+            writer.RawValue(player.state.c_str(), player.state.size(), rapidjson::kObjectType);
+        }
+        if (!player.telemetry.empty()) {
+            writer.Key("telemetry");
+            writer.RawValue(player.telemetry.c_str(), player.telemetry.size(), rapidjson::kObjectType);
+            writer.Key("telemetry_age_ms");
+            writer.Int64(std::chrono::duration_cast<std::chrono::milliseconds>(now - player.telemetry_received).count());
+        }
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    http::response<http::string_body> response{ http::status::ok, request.version() };
+    response.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    response.set(http::field::content_type, "application/json");
+    response.keep_alive(request.keep_alive());
+    response.body() = std::string(buffer.GetString(), buffer.GetSize());
+    response.prepare_payload();
+    return response;
+}
+
+}
@@ -0,0 +1,41 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_PLAYER_REGISTRY_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_SERVER_PLAYER_REGISTRY_HPP_
+
+#include <media_minion/server/any_response.hpp>
+
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace media_minion::server {
+
+class WebsocketSession;
+
+/** Keeps track of the players connected through websocket sessions and of what they last reported.
+ * Players identify themselves with a hello message; their latest state and telemetry reports are
+ * exposed as json under /players, so that playback problems can be diagnosed per player.
+ */
+class PlayerRegistry {
+private:
+    struct Player {
+        std::string name;
+        std::string state;          ///< last player_state message, verbatim
+        std::string telemetry;      ///< last telemetry message, verbatim
+        std::chrono::steady_clock::time_point telemetry_received;
+    };
+    std::unordered_map<WebsocketSession const*, Player> m_players;
+public:
+    static constexpr std::string_view target = "/players";
+
+    void onMessage(WebsocketSession const& session, std::string const& msg);
+    void onSessionClosed(WebsocketSession const& session);
+
+    AnyResponse handleRequest(boost::beast::http::request<boost::beast::http::string_body> const& request) const;
+};
+
+}
+#endif
@@ -0,0 +1,201 @@
+#include <media_minion/server/track_info_handler.hpp>
+
+#include <media_minion/server/media_file_handler.hpp>
+
+#include <media_minion/player/track_info.hpp>
+
+#include <media_minion/common/file_signature.hpp>
+
+#include <rapidjson/rapidjson.h>
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 5054)
+#endif
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <gbBase/Log.hpp>
+
+#include <boost/beast/http/empty_body.hpp>
+#include <boost/beast/version.hpp>
+
+#include <string>
+
+namespace media_minion::server {
+
+namespace {
+/// An indexer fetches each result once or revalidates it with its etag; beyond this, the least recently
+/// requested results are dropped.
+constexpr std::size_t g_maxResults = 16 * 1024;
+
+template<typename Body, typename T>
+void setCommonFields(boost::beast::http::response<Body>& response, boost::beast::http::request<T> const& request)
+{
+    response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
+    response.keep_alive(request.keep_alive());
+}
+
+template<typename T>
+AnyResponse responseStatus(boost::beast::http::request<T> const& request, boost::beast::http::status status,
+                           std::string_view message)
+{
+    boost::beast::http::response<boost::beast::http::string_body> response{ status, request.version() };
+    setCommonFields(response, request);
+    response.set(boost::beast::http::field::content_type, "text/html");
+    response.body() = std::string(message);
+    response.prepare_payload();
+    return response;
+}
+
+std::string serializeTrackInfo(player::TrackInfo const& info)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("codec");
+    writer.String(info.codec.c_str());
+    writer.Key("sampling_frequency");
+    writer.Uint(info.sampling_frequency);
+    writer.Key("channels");
+    writer.Uint(info.channels);
+    if (info.frames) {
+        writer.Key("frames");
+        writer.Uint64(*info.frames);
+    }
+    if (info.duration) {
+        writer.Key("duration");
+        writer.Double(static_cast<double>(info.duration->count()) / 1'000'000.0);
+    }
+    writer.Key("tags");
+    writer.StartObject();
+    for (auto const& [key, value] : info.tags) {
+        writer.Key(key.c_str());
+        writer.String(value.c_str());
+    }
+    writer.EndObject();
+    writer.EndObject();
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+}
+
+TrackInfoHandler::TrackInfoHandler(std::filesystem::path media_root, player::FfmpegStreamOptions const& stream_options)
+    :m_mediaRoot(std::move(media_root)), m_streamOptions(stream_options), m_shutdownRequested(false)
+{
+    m_worker = std::thread([this]() { workerThread(); });
+}
+
+TrackInfoHandler::~TrackInfoHandler()
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_shutdownRequested = true;
+    }
+    m_cvWorker.notify_all();
+    m_worker.join();
+}
+
+AnyResponse TrackInfoHandler::handleRequest(
+    boost::beast::http::request<boost::beast::http::string_body> const& request, std::string_view relative_path)
+{
+    namespace http = boost::beast::http;
+    std::string_view const request_target(request.target().data(), request.target().size());
+    auto const opt_filepath = resolveMediaPath(m_mediaRoot, relative_path);
+    if (!opt_filepath) {
+        return responseStatus(request, http::status::bad_request, "Bad Request: invalid media path");
+    }
+    auto const signature = getFileSignature(*opt_filepath);
+    if (!signature) {
+        return responseStatus(request, http::status::not_found, std::string(request_target) + " not found.");
+    }
+
+    // an indexer revisiting the library only has to stat the files that did not change
+    std::string key = signature->toKey();
+    std::string const etag = "\"" + key + "\"";
+    auto const if_none_match = request[http::field::if_none_match];
+    if (std::string_view(if_none_match.data(), if_none_match.size()) == etag) {
+        http::response<http::empty_body> response{ http::status::not_modified, request.version() };
+        setCommonFields(response, request);
+        response.set(http::field::etag, etag);
+        response.set(http::field::cache_control, "no-cache");
+        return response;
+    }
+
+    std::optional<std::string> body;
+    {
+        std::lock_guard lk(m_mtx);
+        if (auto const it = m_resultIndex.find(key); it != m_resultIndex.end()) {
+            m_results.splice(m_results.begin(), m_results, it->second);
+            if (!it->second->json) {
+                return responseStatus(request, http::status::unsupported_media_type,
+                                      "Unable to read " + std::string(request_target) + ".");
+            }
+            body = *it->second->json;
+        }
+    }
+    if (!body) {
+        // reading a file that has no native parser takes a full ffmpeg probe; that must not stall the io thread
+        enqueue(*opt_filepath, std::move(key));
+        http::response<http::string_body> response{ http::status::accepted, request.version() };
+        setCommonFields(response, request);
+        response.set(http::field::retry_after, "1");
+        response.prepare_payload();
+        return response;
+    }
+
+    http::response<http::string_body> response{ http::status::ok, request.version() };
+    setCommonFields(response, request);
+    response.set(http::field::content_type, "application/json");
+    response.set(http::field::etag, etag);
+    response.set(http::field::cache_control, "no-cache");
+    response.body() = std::move(*body);
+    response.prepare_payload();
+    return response;
+}
+
+void TrackInfoHandler::enqueue(std::filesystem::path track, std::string key)
+{
+    {
+        std::lock_guard lk(m_mtx);
+        if (!m_queuedKeys.insert(key).second) { return; }
+        m_pending.push_back(PendingTrack{ std::move(track), std::move(key) });
+    }
+    m_cvWorker.notify_all();
+}
+
+void TrackInfoHandler::workerThread()
+{
+    std::unique_lock lk(m_mtx);
+    for (;;) {
+        m_cvWorker.wait(lk, [this]() { return m_shutdownRequested || !m_pending.empty(); });
+        if (m_shutdownRequested) { return; }
+        PendingTrack const track = std::move(m_pending.front());
+        m_pending.pop_front();
+        lk.unlock();
+        processTrack(track);
+        lk.lock();
+        m_queuedKeys.erase(track.key);
+    }
+}
+
+void TrackInfoHandler::processTrack(PendingTrack const& track)
+{
+    auto const info = player::readTrackInfo(track.path, m_streamOptions);
+    if (!info) { GHULBUS_LOG(Warning, "Unable to read track info of " << track.path << "."); }
+    std::optional<std::string> json = info ? std::optional<std::string>(serializeTrackInfo(*info)) : std::nullopt;
+    std::lock_guard lk(m_mtx);
+    if (auto const it = m_resultIndex.find(track.key); it != m_resultIndex.end()) {
+        m_results.erase(it->second);
+        m_resultIndex.erase(it);
+    }
+    m_results.push_front(Result{ track.key, std::move(json) });
+    m_resultIndex.emplace(track.key, m_results.begin());
+    while (m_results.size() > g_maxResults) {
+        m_resultIndex.erase(m_results.back().key);
+        m_results.pop_back();
+    }
+}
+
+}
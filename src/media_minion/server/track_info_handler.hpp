@@ -0,0 +1,73 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_TRACK_INFO_HANDLER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_SERVER_TRACK_INFO_HANDLER_HPP_
+
+#include <media_minion/server/any_response.hpp>
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace media_minion::server {
+
+/** Serves format, length and tags of files below the media root as json under /track_info/<relative path>.
+ * Meant for clients that index the whole library; most files are answered from their headers alone,
+ * see player::readTrackInfo(). Files are read on a background thread, like the waveforms of WaveformHandler:
+ * requests for a track info that is not available yet are answered with 202 Accepted and queue the read.
+ */
+class TrackInfoHandler {
+private:
+    struct PendingTrack {
+        std::filesystem::path path;
+        std::string key;
+    };
+    struct Result {
+        std::string key;
+        std::optional<std::string> json;        ///< std::nullopt if not readable; retried once the file changes
+    };
+    using ResultList = std::list<Result>;
+
+    std::filesystem::path m_mediaRoot;
+    player::FfmpegStreamOptions m_streamOptions;
+
+    std::mutex m_mtx;
+    std::condition_variable m_cvWorker;
+    std::deque<PendingTrack> m_pending;
+    std::unordered_set<std::string> m_queuedKeys;
+    ResultList m_results;                               ///< most recently requested first
+    std::unordered_map<std::string, ResultList::iterator> m_resultIndex;    ///< by file signature key
+    std::atomic<bool> m_shutdownRequested;
+
+    std::thread m_worker;
+public:
+    TrackInfoHandler(std::filesystem::path media_root, player::FfmpegStreamOptions const& stream_options);
+    ~TrackInfoHandler();
+
+    TrackInfoHandler(TrackInfoHandler const&) = delete;
+    TrackInfoHandler& operator=(TrackInfoHandler const&) = delete;
+
+    /** @param[in] relative_path Url encoded path of the track relative to the media root.
+     */
+    AnyResponse handleRequest(boost::beast::http::request<boost::beast::http::string_body> const& request,
+                              std::string_view relative_path);
+private:
+    void enqueue(std::filesystem::path track, std::string key);
+    void workerThread();
+    void processTrack(PendingTrack const& track);
+};
+
+}
+#endif
@@ -0,0 +1,226 @@
+#include <media_minion/server/waveform_handler.hpp>
+
+#include <media_minion/server/media_file_handler.hpp>
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+#include <media_minion/player/waveform.hpp>
+
+#include <media_minion/common/file_signature.hpp>
+
+#include <gbBase/Log.hpp>
+
+#include <boost/beast/http/empty_body.hpp>
+#include <boost/beast/version.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+namespace media_minion::server {
+
+namespace {
+template<typename Body, typename T>
+void setCommonFields(boost::beast::http::response<Body>& response, boost::beast::http::request<T> const& request)
+{
+    response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
+    response.keep_alive(request.keep_alive());
+}
+
+template<typename T>
+AnyResponse responseStatus(boost::beast::http::request<T> const& request, boost::beast::http::status status,
+                           std::string_view message)
+{
+    boost::beast::http::response<boost::beast::http::string_body> response{ status, request.version() };
+    setCommonFields(response, request);
+    response.set(boost::beast::http::field::content_type, "text/html");
+    response.body() = std::string(message);
+    response.prepare_payload();
+    return response;
+}
+}
+
+WaveformHandler::WaveformHandler(std::filesystem::path media_root, std::filesystem::path const& cache_directory,
+                                 player::FfmpegStreamOptions const& stream_options)
+    :m_mediaRoot(std::move(media_root)), m_sidecarDirectory(cache_directory / "waveforms"),
+     m_streamOptions(stream_options), m_scanRequested(false), m_shutdownRequested(false)
+{
+    m_worker = std::thread([this]() { workerThread(); });
+}
+
+WaveformHandler::~WaveformHandler()
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_shutdownRequested = true;
+    }
+    m_cvWorker.notify_all();
+    m_worker.join();
+}
+
+AnyResponse WaveformHandler::handleRequest(
+    boost::beast::http::request<boost::beast::http::string_body> const& request, std::string_view relative_path)
+{
+    namespace http = boost::beast::http;
+    std::string_view const request_target(request.target().data(), request.target().size());
+    auto const opt_filepath = resolveMediaPath(m_mediaRoot, relative_path);
+    if (!opt_filepath) {
+        return responseStatus(request, http::status::bad_request, "Bad Request: invalid media path");
+    }
+    auto const signature = getFileSignature(*opt_filepath);
+    if (!signature) {
+        return responseStatus(request, http::status::not_found, std::string(request_target) + " not found.");
+    }
+
+    // the key changes whenever the file does, which makes it a strong validator for the waveform
+    std::string key = signature->toKey();
+    std::string const etag = "\"" + key + "\"";
+    std::filesystem::path const sidecar_path = getSidecarPath(key);
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(sidecar_path, ec)) {
+        {
+            std::lock_guard lk(m_mtx);
+            if (m_failedKeys.count(key) > 0) {
+                return responseStatus(request, http::status::unsupported_media_type,
+                                      "Unable to decode " + std::string(request_target) + ".");
+            }
+        }
+        enqueue(*opt_filepath, std::move(key), true);
+        http::response<http::string_body> response{ http::status::accepted, request.version() };
+        setCommonFields(response, request);
+        response.set(http::field::retry_after, "1");
+        response.prepare_payload();
+        return response;
+    }
+
+    auto const if_none_match = request[http::field::if_none_match];
+    if (std::string_view(if_none_match.data(), if_none_match.size()) == etag) {
+        http::response<http::empty_body> response{ http::status::not_modified, request.version() };
+        setCommonFields(response, request);
+        response.set(http::field::etag, etag);
+        response.set(http::field::cache_control, "no-cache");
+        return response;
+    }
+
+    // sidecars are a few kilobytes; reading them whole is cheaper than setting up a file body
+    std::ifstream fin(sidecar_path, std::ios_base::binary);
+    std::string data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    if (!fin.eof() || data.empty()) {
+        return responseStatus(request, http::status::internal_server_error, "Unable to read waveform.");
+    }
+    http::response<http::string_body> response{ http::status::ok, request.version() };
+    setCommonFields(response, request);
+    response.set(http::field::content_type, "application/octet-stream");
+    response.set(http::field::etag, etag);
+    response.set(http::field::cache_control, "no-cache");
+    response.body() = std::move(data);
+    response.prepare_payload();
+    return response;
+}
+
+void WaveformHandler::scanLibrary()
+{
+    {
+        std::lock_guard lk(m_mtx);
+        m_scanRequested = true;
+    }
+    m_cvWorker.notify_all();
+}
+
+std::filesystem::path WaveformHandler::getSidecarPath(std::string const& key) const
+{
+    return m_sidecarDirectory / (key + ".mmwf");
+}
+
+void WaveformHandler::enqueue(std::filesystem::path track, std::string key, bool is_requested)
+{
+    {
+        std::lock_guard lk(m_mtx);
+        if (!m_queuedKeys.insert(key).second) {
+            // a client is waiting for a track that a library scan queued earlier
+            if (!is_requested) { return; }
+            auto const it = std::find_if(begin(m_pending), end(m_pending),
+                                         [&key](PendingTrack const& p) { return p.key == key; });
+            if ((it == end(m_pending)) || (it == begin(m_pending))) { return; }
+            PendingTrack pending = std::move(*it);
+            m_pending.erase(it);
+            m_pending.push_front(std::move(pending));
+        } else if (is_requested) {
+            m_pending.push_front(PendingTrack{ std::move(track), std::move(key) });
+        } else {
+            m_pending.push_back(PendingTrack{ std::move(track), std::move(key) });
+        }
+    }
+    m_cvWorker.notify_all();
+}
+
+void WaveformHandler::workerThread()
+{
+    std::unique_lock lk(m_mtx);
+    for (;;) {
+        m_cvWorker.wait(lk, [this]() { return m_shutdownRequested || m_scanRequested || !m_pending.empty(); });
+        if (m_shutdownRequested) { return; }
+        if (!m_pending.empty()) {
+            PendingTrack const track = std::move(m_pending.front());
+            m_pending.pop_front();
+            lk.unlock();
+            processTrack(track);
+            lk.lock();
+            m_queuedKeys.erase(track.key);
+        } else {
+            m_scanRequested = false;
+            lk.unlock();
+            scanDirectory();
+            lk.lock();
+        }
+    }
+}
+
+void WaveformHandler::scanDirectory()
+{
+    GHULBUS_LOG(Info, "Scanning " << m_mediaRoot << " for missing waveforms.");
+    std::error_code ec;
+    std::filesystem::recursive_directory_iterator it(m_mediaRoot,
+                                                     std::filesystem::directory_options::skip_permission_denied, ec);
+    for (; !ec && (it != std::filesystem::recursive_directory_iterator{}); it.increment(ec)) {
+        if (m_shutdownRequested) { return; }
+        std::error_code entry_ec;
+        if (!it->is_regular_file(entry_ec) || !player::FfmpegStream::hasAudioFileExtension(it->path())) { continue; }
+        auto const signature = getFileSignature(it->path());
+        if (!signature) { continue; }
+        std::string key = signature->toKey();
+        if (std::filesystem::exists(getSidecarPath(key), entry_ec)) { continue; }
+        {
+            std::lock_guard lk(m_mtx);
+            if (m_failedKeys.count(key) > 0) { continue; }
+        }
+        enqueue(it->path(), std::move(key), false);
+    }
+    if (ec) {
+        GHULBUS_LOG(Warning, "Error while scanning " << m_mediaRoot << ": " << ec.message());
+    }
+}
+
+void WaveformHandler::processTrack(PendingTrack const& track)
+{
+    std::filesystem::path const sidecar_path = getSidecarPath(track.key);
+    std::error_code ec;
+    if (std::filesystem::exists(sidecar_path, ec)) { return; }
+
+    auto const t0 = std::chrono::steady_clock::now();
+    auto const waveform = player::computeWaveform(track.path, m_streamOptions, &m_shutdownRequested);
+    if (m_shutdownRequested) { return; }
+    if (!waveform) {
+        GHULBUS_LOG(Warning, "Unable to compute waveform for " << track.path << ".");
+        std::lock_guard lk(m_mtx);
+        m_failedKeys.insert(track.key);
+        return;
+    }
+    auto const t1 = std::chrono::steady_clock::now();
+    if (player::saveWaveform(*waveform, sidecar_path)) {
+        GHULBUS_LOG(Trace, "Computed waveform for " << track.path << " (" <<
+                           std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << "ms).");
+    }
+}
+
+}
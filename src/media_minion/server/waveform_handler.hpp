@@ -0,0 +1,75 @@
+#ifndef MEDIA_MINION_INCLUDE_GUARD_SERVER_WAVEFORM_HANDLER_HPP_
+#define MEDIA_MINION_INCLUDE_GUARD_SERVER_WAVEFORM_HANDLER_HPP_
+
+#include <media_minion/server/any_response.hpp>
+
+#include <media_minion/player/ffmpeg_stream.hpp>
+
+#include <boost/beast/http/message.hpp>
+#include <boost/beast/http/string_body.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+
+namespace media_minion::server {
+
+/** Serves waveform overviews for files below the media root under /waveform/<relative path>.
+ * Waveforms are computed once per file version on a background thread and kept as sidecar files
+ * in the cache directory. Requests for a waveform that is not available yet are answered with
+ * 202 Accepted and queue the computation, so clients retry instead of waiting for a full decode.
+ */
+class WaveformHandler {
+private:
+    struct PendingTrack {
+        std::filesystem::path path;
+        std::string key;
+    };
+
+    std::filesystem::path m_mediaRoot;
+    std::filesystem::path m_sidecarDirectory;
+    player::FfmpegStreamOptions m_streamOptions;
+
+    std::mutex m_mtx;
+    std::condition_variable m_cvWorker;
+    std::deque<PendingTrack> m_pending;
+    std::unordered_set<std::string> m_queuedKeys;
+    std::unordered_set<std::string> m_failedKeys;       ///< not decodable; retried once the file changes
+    bool m_scanRequested;
+    std::atomic<bool> m_shutdownRequested;
+
+    std::thread m_worker;
+public:
+    WaveformHandler(std::filesystem::path media_root, std::filesystem::path const& cache_directory,
+                    player::FfmpegStreamOptions const& stream_options);
+    ~WaveformHandler();
+
+    WaveformHandler(WaveformHandler const&) = delete;
+    WaveformHandler& operator=(WaveformHandler const&) = delete;
+
+    /** @param[in] relative_path Url encoded path of the track relative to the media root.
+     */
+    AnyResponse handleRequest(boost::beast::http::request<boost::beast::http::string_body> const& request,
+                              std::string_view relative_path);
+
+    /** Computes the missing waveforms of all audio files below the media root in the background.
+     */
+    void scanLibrary();
+private:
+    std::filesystem::path getSidecarPath(std::string const& key) const;
+    /** Tracks requested by a client skip ahead of those queued by a library scan.
+     */
+    void enqueue(std::filesystem::path track, std::string key, bool is_requested);
+    void workerThread();
+    void scanDirectory();
+    void processTrack(PendingTrack const& track);
+};
+
+}
+#endif
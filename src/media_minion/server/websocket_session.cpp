@@ -11,6 +11,10 @@ namespace media_minion::server {
 WebsocketSession::WebsocketSession(boost::asio::ip::tcp::socket&& session_socket)
     :m_websocket(std::move(session_socket))
 {
+    // remote control commands are tiny; do not let them wait for more data to coalesce
+    boost::system::error_code ec;
+    m_websocket.next_layer().set_option(boost::asio::ip::tcp::no_delay(true), ec);
+    m_websocket.text(true);
 }
 
 WebsocketSession::~WebsocketSession()
@@ -37,6 +41,24 @@ boost::asio::ip::tcp::socket& WebsocketSession::get_socket()
     return m_websocket.next_layer();
 }
 
+void WebsocketSession::send(std::string msg)
+{
+    if (!m_websocket.is_open()) { return; }
+    m_writeQueue.emplace_back(std::move(msg));
+    if (m_writeQueue.size() == 1) { doWrite(); }
+}
+
+void WebsocketSession::doWrite()
+{
+    m_websocket.async_write(boost::asio::buffer(m_writeQueue.front()),
+        [this](boost::system::error_code const& ec, std::size_t) {
+            // on errors the session may already be gone; the pending read reports the broken connection
+            if (ec) { return; }
+            m_writeQueue.pop_front();
+            if (!m_writeQueue.empty()) { doWrite(); }
+        });
+}
+
 void WebsocketSession::onAccept(boost::system::error_code const& ec)
 {
     if (ec) {
@@ -7,7 +7,9 @@
 #include <boost/beast/http/message.hpp>
 #include <boost/beast/websocket/stream.hpp>
 
+#include <deque>
 #include <functional>
+#include <string>
 
 namespace media_minion::server {
 
@@ -15,6 +17,7 @@ class WebsocketSession {
 private:
     boost::beast::websocket::stream<boost::asio::ip::tcp::socket> m_websocket;
     boost::beast::flat_buffer m_buffer;
+    std::deque<std::string> m_writeQueue;
 public:
     WebsocketSession(boost::asio::ip::tcp::socket&& session_socket);
 
@@ -31,6 +34,10 @@ public:
 
     boost::asio::ip::tcp::socket& get_socket();
 
+    /** Queues a text message for sending. Must be called from the thread running the io_context.
+     */
+    void send(std::string msg);
+
     std::function<void(boost::system::error_code const&)> onError;
     std::function<void()> onOpen;
     std::function<void()> onClose;
@@ -40,6 +47,7 @@ private:
     void onCloseCompleted(boost::system::error_code const& ec);
     void newRead();
     void onWebsocketRead(boost::system::error_code const& ec, std::size_t bytes_read);
+    void doWrite();
 };
 
 }
@@ -0,0 +1,223 @@
+#include <media_minion/player/mapped_wav_file.hpp>
+#include <media_minion/player/track_info.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** Checks the native header parsers of player::readNativeTrackInfo() and player::MappedWavFile against small
+ * fixture files.
+ * The fixtures only contain the headers that the parsers look at; they are written to a temporary directory,
+ * so that each of them can be read next to the code that states what it contains.
+ */
+
+namespace {
+using media_minion::player::MappedWavFile;
+using media_minion::player::TrackInfo;
+using media_minion::player::readNativeTrackInfo;
+
+int g_failures = 0;
+
+#define MM_CHECK(cond) \
+    do { if (!(cond)) { ++g_failures; std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << "\n"; } } \
+    while (false)
+
+class Fixture {
+private:
+    std::vector<unsigned char> m_data;
+public:
+    Fixture& bytes(std::string_view str)
+    {
+        m_data.insert(m_data.end(), str.begin(), str.end());
+        return *this;
+    }
+
+    Fixture& zeros(std::size_t n)
+    {
+        m_data.insert(m_data.end(), n, 0);
+        return *this;
+    }
+
+    Fixture& le(std::uint64_t v, std::size_t n_bytes)
+    {
+        for (std::size_t i = 0; i < n_bytes; ++i) { m_data.push_back(static_cast<unsigned char>(v >> (8 * i))); }
+        return *this;
+    }
+
+    Fixture& be(std::uint64_t v, std::size_t n_bytes)
+    {
+        for (std::size_t i = n_bytes; i-- > 0;) { m_data.push_back(static_cast<unsigned char>(v >> (8 * i))); }
+        return *this;
+    }
+
+    Fixture& append(Fixture const& f)
+    {
+        m_data.insert(m_data.end(), f.m_data.begin(), f.m_data.end());
+        return *this;
+    }
+
+    std::size_t size() const
+    {
+        return m_data.size();
+    }
+
+    std::filesystem::path write(std::string_view filename) const
+    {
+        std::filesystem::path const ret = std::filesystem::temp_directory_path() / "mm_track_info_test" / filename;
+        std::filesystem::create_directories(ret.parent_path());
+        std::ofstream fout(ret, std::ios_base::binary);
+        fout.write(reinterpret_cast<char const*>(m_data.data()), static_cast<std::streamsize>(m_data.size()));
+        return ret;
+    }
+};
+
+std::string getTag(TrackInfo const& info, std::string const& key)
+{
+    auto const it = info.tags.find(key);
+    return (it != info.tags.end()) ? it->second : std::string();
+}
+
+Fixture vorbisComments(std::vector<std::string_view> const& comments)
+{
+    Fixture ret;
+    ret.le(7, 4).bytes("fixture").le(comments.size(), 4);
+    for (auto const& c : comments) { ret.le(c.size(), 4).bytes(c); }
+    return ret;
+}
+
+void testFlac()
+{
+    Fixture const comments = vorbisComments({ "TITLE=Flac Fixture", "TRACKNUMBER=3" });
+    Fixture f;
+    f.bytes("fLaC");
+    // STREAMINFO: block sizes, frame sizes, then 44.1 kHz, 2 channels, 16 bits and 441000 frames in 64 bits
+    f.be(0x00, 1).be(34, 3).be(4096, 2).be(4096, 2).be(0, 3).be(0, 3);
+    f.be((std::uint64_t{ 44100 } << 44) | (std::uint64_t{ 1 } << 41) | (std::uint64_t{ 15 } << 36) | 441000, 8);
+    f.zeros(16);
+    f.be(0x84, 1).be(comments.size(), 3).append(comments);
+
+    auto const info = readNativeTrackInfo(f.write("fixture.flac"));
+    MM_CHECK(info);
+    if (!info) { return; }
+    MM_CHECK(info->codec == "flac");
+    MM_CHECK(info->sampling_frequency == 44100);
+    MM_CHECK(info->channels == 2);
+    MM_CHECK(info->frames == 441000u);
+    MM_CHECK(info->duration == std::chrono::seconds(10));
+    MM_CHECK(getTag(*info, "title") == "Flac Fixture");
+    MM_CHECK(getTag(*info, "track") == "3");
+}
+
+void testMp3XingLame()
+{
+    // MPEG-1 layer 3, 128 kbit/s, 44.1 kHz, stereo: 417 bytes per frame
+    constexpr std::size_t frame_size = 417;
+    Fixture frame;
+    frame.be(0xfffb9000, 4).zeros(32);
+    frame.bytes("Xing").be(0x1, 4).be(100, 4);
+    // LAME extension; encoder delay and padding are the 12 bit fields at offset 21
+    frame.bytes("LAME3.100").zeros(12).be((576 << 12) | 1000, 3);
+    frame.zeros(frame_size - frame.size());
+
+    Fixture f;
+    // ID3v2.4 with a single title frame in ISO-8859-1
+    f.bytes("ID3").be(0x0400, 2).be(0, 1).be(18, 4);
+    f.bytes("TIT2").be(8, 4).be(0, 2).be(0, 1).bytes("Fixture");
+    f.append(frame);
+    f.be(0xfffb9000, 4).zeros(frame_size - 4);
+
+    auto const info = readNativeTrackInfo(f.write("fixture.mp3"));
+    MM_CHECK(info);
+    if (!info) { return; }
+    MM_CHECK(info->codec == "mp3");
+    MM_CHECK(info->sampling_frequency == 44100);
+    MM_CHECK(info->channels == 2);
+    MM_CHECK(info->frames == 100u * 1152u - 576u - 1000u);
+    MM_CHECK(getTag(*info, "title") == "Fixture");
+}
+
+void testRf64()
+{
+    constexpr std::uint64_t data_size = 4000;
+    Fixture list;
+    list.bytes("INFO").bytes("INAM").le(8, 4).bytes("Fixture").zeros(1);
+    Fixture f;
+    f.bytes("RF64").le(0xffffffff, 4).bytes("WAVE");
+    // riff size, data size, sample count, table length
+    f.bytes("ds64").le(28, 4).le(0, 8).le(data_size, 8).le(data_size / 4, 8).le(0, 4);
+    f.bytes("fmt ").le(16, 4).le(0x0001, 2).le(2, 2).le(48000, 4).le(48000 * 4, 4).le(4, 2).le(16, 2);
+    f.bytes("data").le(0xffffffff, 4).zeros(data_size);
+    // tags after the audio data
+    f.bytes("LIST").le(list.size(), 4).append(list);
+
+    auto const filepath = f.write("fixture.wav");
+    auto const wav = MappedWavFile::open(filepath);
+    MM_CHECK(wav);
+    MM_CHECK(wav && (wav->getNumberOfFrames() == data_size / 4) && (wav->getFormat().block_align == 4));
+
+    auto const info = readNativeTrackInfo(filepath);
+    MM_CHECK(info);
+    if (!info) { return; }
+    MM_CHECK(info->codec == "pcm_s16le");
+    MM_CHECK(info->sampling_frequency == 48000);
+    MM_CHECK(info->channels == 2);
+    MM_CHECK(info->frames == data_size / 4);
+    MM_CHECK(getTag(*info, "title") == "Fixture");
+}
+
+Fixture oggPage(std::uint8_t header_type, std::uint64_t granule, std::uint32_t sequence, Fixture const& body)
+{
+    Fixture ret;
+    ret.bytes("OggS").le(0, 1).le(header_type, 1).le(granule, 8).le(0x4d4d, 4).le(sequence, 4).le(0, 4);
+    // the parser ignores the crc; bodies here fit into a single segment
+    ret.le(1, 1).le(body.size(), 1).append(body);
+    return ret;
+}
+
+void testOpus()
+{
+    constexpr std::uint64_t pre_skip = 312;
+    Fixture head;
+    head.bytes("OpusHead").le(1, 1).le(2, 1).le(pre_skip, 2).le(44100, 4).le(0, 2).le(0, 1);
+    Fixture tags;
+    tags.bytes("OpusTags").append(vorbisComments({ "ARTIST=Someone", "METADATA_BLOCK_PICTURE=ignored" }));
+    Fixture audio;
+    audio.zeros(3);
+
+    Fixture f;
+    f.append(oggPage(0x02, 0, 0, head));
+    f.append(oggPage(0x00, 0, 1, tags));
+    f.append(oggPage(0x04, 96000 + pre_skip, 2, audio));
+
+    auto const info = readNativeTrackInfo(f.write("fixture.opus"));
+    MM_CHECK(info);
+    if (!info) { return; }
+    MM_CHECK(info->codec == "opus");
+    MM_CHECK(info->sampling_frequency == 48000);
+    MM_CHECK(info->channels == 2);
+    MM_CHECK(info->frames == 96000u);
+    MM_CHECK(info->duration == std::chrono::seconds(2));
+    MM_CHECK(getTag(*info, "artist") == "Someone");
+    MM_CHECK(getTag(*info, "metadata_block_picture").empty());
+}
+}
+
+int main()
+{
+    testFlac();
+    testMp3XingLame();
+    testRf64();
+    testOpus();
+    std::error_code ec;
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "mm_track_info_test", ec);
+    if (g_failures > 0) {
+        std::cerr << g_failures << " checks failed.\n";
+        return 1;
+    }
+    return 0;
+}